@@ -0,0 +1,826 @@
+//
+// Benchmark.cpp
+// Implementation of Benchmark.
+//
+
+#include "Benchmark.h"
+#include "Phantom.h"
+#include "../Model/Model.h"
+#include "../Model/ImageFilterer.h"
+#include "../Model/DistanceTransform.h"
+#include "../Model/History.h"
+#include "../Model/Journal.h"
+#include "../Model/ImageStore.h"
+#include "../Model/ImageBlockCodec.h"
+#include "../Model/ImageSequence.h"
+#include "../Controller/RenderState.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace Math;
+
+namespace {
+    // Work is repeated until at least this much time has passed so that throughput is 
+    // measured over a meaningful interval
+    const double minBenchmarkSeconds = 0.25;
+
+    typedef std::chrono::steady_clock Clock;
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Unit vector along the centerline at sample i
+    Vec2D centerlineDir(std::vector<CurvePoint>& centerline, size_t i)
+    {
+        size_t iPrev = (i == 0) ? i : i - 1;
+        size_t iNext = (i + 1 == centerline.size()) ? i : i + 1;
+        return (centerline[iNext].pos() - centerline[iPrev].pos()).normalized();
+    }
+}
+
+// 
+// Public
+//
+bool Benchmark::run(std::ostream& out, const std::vector<int>& sizes)
+{
+    out << "VESCL benchmarks" << std::endl;
+    out << std::left << std::setw(18) << "Phantom" << std::setw(26) << "Benchmark" <<
+        std::setw(26) << "Throughput" << "Accuracy" << std::endl;
+
+    bool isAccurate = true;
+    std::string filename = "vescl_benchmark.vscl";
+    Image::DataFormat formats[2] = { Image::DataFormat::UChar, Image::DataFormat::UShort };
+    for (int size : sizes) {
+        for (Image::DataFormat format : formats) {
+            std::ostringstream config;
+            config << size << "x" << size << ((format == Image::DataFormat::UChar) ? " 8-bit" : " 16-bit");
+            Phantom phantom(Phantom::defaultParameters(size, size, format));
+
+            std::vector<Result> results;
+            results.push_back(benchmarkVecToClosestVessel(phantom));
+            results.push_back(benchmarkWidthAtP(phantom));
+            results.push_back(benchmarkFitToNearestVessel(phantom));
+            results.push_back(benchmarkSampledCurvePoints(phantom));
+            results.push_back(benchmarkSmoothing(phantom));
+            results.push_back(benchmarkSelectCurve(phantom));
+            results.push_back(benchmarkDistanceTransform(phantom));
+            results.push_back(benchmarkHistory(phantom));
+            results.push_back(benchmarkImageSequence(phantom));
+            results.push_back(benchmarkPropagation(phantom));
+            results.push_back(benchmarkSnapWhileDrawing(phantom));
+            results.push_back(benchmarkTraceVessel(phantom));
+            benchmarkFileIO(phantom, filename, results);
+            results.push_back(benchmarkJournal(phantom, filename));
+            for (const Result& result : results) {
+                isAccurate &= report(out, config.str(), result);
+            }
+        }
+    }
+    std::remove(filename.c_str());
+    std::remove(Journal::journalFilename(filename).c_str());
+    out << (isAccurate ? "All accuracy checks passed" : "Accuracy checks FAILED") << std::endl;
+    return isAccurate;
+}
+
+// 
+// Private
+//
+Benchmark::Result Benchmark::benchmarkVecToClosestVessel(Phantom& phantom)
+{
+    // Start points are displaced from the true centerline by up to 3/4 of the vessel 
+    // radius and are moved using the iteration of Model::fitSelectedToNearestVessel
+    std::mt19937 generator(2);
+    std::uniform_real_distribution<float> uniform(-0.75f, 0.75f);
+    typedef struct { int idxVessel; Vec2D start; float radius; } TestPoint;
+    std::vector<TestPoint> testPoints;
+    for (int i = 0; i < phantom.numVessels(); i++) {
+        std::vector<CurvePoint>& centerline = phantom.centerline(i);
+        for (size_t j = 0; j < centerline.size(); j += 8) {
+            Vec2D dir = centerlineDir(centerline, j);
+            Vec2D normal(-dir[1], dir[0]);
+            float radius = centerline[j].radius();
+            testPoints.push_back({ i, centerline[j].pos() + uniform(generator) * radius * normal, radius });
+        }
+    }
+
+    ImageFilterer filterer(phantom.image(), phantom.parameters().isDarkOnLight ?
+        ImageFilterer::VesselContrastType::DarkOnLight : ImageFilterer::VesselContrastType::LightOnDark);
+    int numTries = 10;
+    float moveConst = 0.5;
+    std::vector<Vec2D> fitted(testPoints.size());
+    long long numCalls = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        for (size_t i = 0; i < testPoints.size(); i++) {
+            Vec2D p = testPoints[i].start;
+            for (int j = 0; j < numTries; j++) {
+                p += moveConst * filterer.getVecToClosestVessel(p, testPoints[i].radius);
+            }
+            fitted[i] = p;
+        }
+        numCalls += (long long)testPoints.size() * numTries;
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double seconds = secondsSince(start);
+
+    std::vector<double> errors;
+    for (size_t i = 0; i < testPoints.size(); i++) {
+        errors.push_back(phantom.distanceToCenterline(testPoints[i].idxVessel, fitted[i]));
+    }
+    return { "getVecToClosestVessel", "calls/s", numCalls / seconds, 
+        "p95 centerline error (px)", percentile(errors, 0.95), 1 };
+}
+Benchmark::Result Benchmark::benchmarkWidthAtP(Phantom& phantom)
+{
+    // Widths are measured on the true centerline with an expected radius within 20% of
+    // the true radius, as when the cursor roughly matches the vessel
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> uniform(0.8f, 1.2f);
+    typedef struct { Vec2D p; Vec2D dir; float expectedRadius; float radius; } TestPoint;
+    std::vector<TestPoint> testPoints;
+    for (int i = 0; i < phantom.numVessels(); i++) {
+        std::vector<CurvePoint>& centerline = phantom.centerline(i);
+        for (size_t j = 0; j < centerline.size(); j += 4) {
+            float radius = centerline[j].radius();
+            testPoints.push_back({ centerline[j].pos(), centerlineDir(centerline, j), 
+                radius * uniform(generator), radius });
+        }
+    }
+
+    ImageFilterer filterer(phantom.image(), phantom.parameters().isDarkOnLight ?
+        ImageFilterer::VesselContrastType::DarkOnLight : ImageFilterer::VesselContrastType::LightOnDark);
+    std::vector<float> widths(testPoints.size());
+    long long numCalls = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        for (size_t i = 0; i < testPoints.size(); i++) {
+            widths[i] = filterer.getWidthAtP(testPoints[i].p, testPoints[i].dir, testPoints[i].expectedRadius);
+        }
+        numCalls += testPoints.size();
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double seconds = secondsSince(start);
+
+    std::vector<double> errors;
+    for (size_t i = 0; i < testPoints.size(); i++) {
+        errors.push_back(fabs(0.5 * widths[i] - testPoints[i].radius));
+    }
+    return { "getWidthAtP", "calls/s", numCalls / seconds, 
+        "p95 radius error (px)", percentile(errors, 0.95), 0.5 };
+}
+Benchmark::Result Benchmark::benchmarkFitToNearestVessel(Phantom& phantom)
+{
+    // Each vessel is fitted with Model::fitToNearestVessel from points 4 pixels apart
+    // that drift from the true centerline by up to 1.5 times the vessel radius, i.e., 
+    // outside wide vessels, with the radius at the vessel's middle as expected radius
+    RenderState renderState;
+    Model model(&renderState);
+    model.image().copyFrom(*phantom.image());
+    model.setVesselContrast(phantom.parameters().isDarkOnLight ?
+        ImageFilterer::VesselContrastType::DarkOnLight : ImageFilterer::VesselContrastType::LightOnDark);
+    std::vector<std::vector<CurvePoint>> curves(phantom.numVessels());
+    std::vector<float> expectedRadii(phantom.numVessels());
+    for (int i = 0; i < phantom.numVessels(); i++) {
+        std::vector<CurvePoint>& centerline = phantom.centerline(i);
+        for (size_t j = 0; j < centerline.size(); j += 4) {
+            Vec2D dir = centerlineDir(centerline, j);
+            Vec2D normal(-dir[1], dir[0]);
+            float radius = centerline[j].radius();
+            curves[i].push_back(CurvePoint(centerline[j].pos() + 1.5f * radius * sinf(j / 40.0f) * normal, radius));
+        }
+        expectedRadii[i] = centerline[centerline.size() / 2].radius();
+    }
+
+    std::vector<std::vector<CurvePoint>> fitted(curves.size());
+    long long numPoints = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        for (size_t i = 0; i < curves.size(); i++) {
+            fitted[i] = model.fitToNearestVessel(curves[i], expectedRadii[i]);
+            numPoints += curves[i].size();
+        }
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double seconds = secondsSince(start);
+
+    std::vector<double> errors;
+    for (size_t i = 0; i < fitted.size(); i++) {
+        for (const CurvePoint& point : fitted[i]) {
+            errors.push_back(phantom.distanceToCenterline((int)i, point.pos()));
+        }
+    }
+    if (errors.empty()) errors.push_back(1e6);
+    return { "fitToNearestVessel", "points/s", numPoints / seconds,
+        "p95 centerline error (px)", percentile(errors, 0.95), 1 };
+}
+Benchmark::Result Benchmark::benchmarkSampledCurvePoints(Phantom& phantom)
+{
+    // Curves with control points 4 pixels apart are sampled at 1 pixel spacing, as when
+    // rendering at 1:1 zoom. Curves are marked as changed before each sampling so the
+    // sampling is timed rather than the sample cache.
+    Contour contour;
+    std::vector<int> curveIDs = phantom.addCurvesToContour(contour, 4);
+    float maxPointSpacing = 1;
+    std::vector<Curve::PointVector> sampled(curveIDs.size());
+    long long numPoints = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        for (size_t i = 0; i < curveIDs.size(); i++) {
+            Curve* curve = contour.curve(curveIDs[i]);
+            curve->points();
+            sampled[i] = curve->getSampledCurvePoints(maxPointSpacing);
+            numPoints += sampled[i].size();
+        }
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double seconds = secondsSince(start);
+
+    std::vector<double> errors;
+    for (size_t i = 0; i < sampled.size(); i++) {
+        for (size_t j = 0; j < sampled[i].size(); j += 4) {
+            errors.push_back(phantom.distanceToCenterline((int)i, sampled[i][j].pos()));
+        }
+    }
+    return { "getSampledCurvePoints", "points/s", numPoints / seconds, 
+        "p95 centerline error (px)", percentile(errors, 0.95), 0.05 };
+}
+Benchmark::Result Benchmark::benchmarkSmoothing(Phantom& phantom)
+{
+    // Smoothing is applied to fresh copies of the curves each repetition. Only the 
+    // smoothing is timed.
+    Contour contour;
+    std::vector<int> curveIDs = phantom.addCurvesToContour(contour, 4);
+    std::vector<std::list<CurvePoint>> original(curveIDs.size());
+    for (size_t i = 0; i < curveIDs.size(); i++) original[i] = contour.curve(curveIDs[i])->points();
+    long long numPoints = 0;
+    double seconds = 0;
+    do {
+        for (size_t i = 0; i < curveIDs.size(); i++) contour.curve(curveIDs[i])->points() = original[i];
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < curveIDs.size(); i++) {
+            contour.curve(curveIDs[i])->applySmoothing(Curve::SmoothingType::All);
+            numPoints += original[i].size();
+        }
+        seconds += secondsSince(start);
+    } while (seconds < minBenchmarkSeconds);
+
+    std::vector<double> errors;
+    for (size_t i = 0; i < curveIDs.size(); i++) {
+        std::list<CurvePoint>& points = contour.curve(curveIDs[i])->points();
+        for (std::list<CurvePoint>::iterator it = points.begin(); it != points.end(); it++) {
+            errors.push_back(phantom.distanceToCenterline((int)i, it->pos()));
+        }
+    }
+    return { "applySmoothing", "points/s", numPoints / seconds, 
+        "p95 centerline error (px)", percentile(errors, 0.95), 0.5 };
+}
+Benchmark::Result Benchmark::benchmarkSelectCurve(Phantom& phantom)
+{
+    // Queries are within 1 pixel of a random point on a true centerline and should 
+    // select the curve of that vessel
+    Contour contour;
+    std::vector<int> curveIDs = phantom.addCurvesToContour(contour, 4);
+    std::mt19937 generator(4);
+    std::uniform_real_distribution<float> uniform(-0.7f, 0.7f);
+    typedef struct { int idxVessel; Vec2D p; } Query;
+    std::vector<Query> queries;
+    for (int i = 0; i < 1000; i++) {
+        int idxVessel = generator() % phantom.numVessels();
+        std::vector<CurvePoint>& centerline = phantom.centerline(idxVessel);
+        Vec2D p = centerline[generator() % centerline.size()].pos();
+        queries.push_back({ idxVessel, p + Vec2D(uniform(generator), uniform(generator)) });
+    }
+
+    float selectionRadius = 3;
+    int numMisses = 0;
+    long long numQueries = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        numMisses = 0;
+        for (const Query& query : queries) {
+            int idCurve = contour.selectCurve(query.p, selectionRadius);
+            if (idCurve != curveIDs[query.idxVessel]) numMisses++;
+            contour.deselectCurve();
+        }
+        numQueries += queries.size();
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double seconds = secondsSince(start);
+
+    return { "Contour::selectCurve", "queries/s", numQueries / seconds,
+        "miss rate", (double)numMisses / queries.size(), 0.01 };
+}
+Benchmark::Result Benchmark::benchmarkDistanceTransform(Phantom& phantom)
+{
+    // Random seeds over a phantom sized raster. Distances at random pixels are checked 
+    // against a brute force search over all seeds.
+    int width = phantom.image()->width();
+    int height = phantom.image()->height();
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> seedChance(0, 99);
+    std::vector<unsigned char> isSeed((size_t)width * height);
+    std::vector<int> seeds;
+    for (size_t i = 0; i < isSeed.size(); i++) {
+        isSeed[i] = (seedChance(generator) == 0) ? 1 : 0;
+        if (isSeed[i]) seeds.push_back((int)i);
+    }
+
+    long long numPixels = 0;
+    std::vector<float> distances;
+    Clock::time_point start = Clock::now();
+    do {
+        distances = DistanceTransform::distanceToSeeds(isSeed, width, height);
+        numPixels += distances.size();
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double seconds = secondsSince(start);
+
+    std::uniform_int_distribution<int> pixel(0, width * height - 1);
+    double maxError = 0;
+    for (int i = 0; i < 200; i++) {
+        int p = pixel(generator);
+        int x = p % width;
+        int y = p / width;
+        double minDistSqr = std::numeric_limits<double>::max();
+        for (int seed : seeds) {
+            double dx = seed % width - x;
+            double dy = seed / width - y;
+            minDistSqr = std::min(minDistSqr, dx * dx + dy * dy);
+        }
+        maxError = std::max(maxError, fabs(sqrt(minDistSqr) - distances[p]));
+    }
+    return { "distanceToSeeds", "pixels/s", numPixels / seconds, 
+        "max distance error (px)", maxError, 0.001 };
+}
+
+Benchmark::Result Benchmark::benchmarkHistory(Phantom& phantom)
+{
+    // Random local edits (moving a few points, inserting a point or deleting a curve) 
+    // are committed, then undone and redone back to each state. Restored contours must 
+    // match copies of the states taken after each edit. Only the history is timed.
+    Contour contour;
+    phantom.addCurvesToContour(contour, 1);
+    History history;
+    history.commit(contour);
+    typedef std::vector<std::pair<int, std::vector<CurvePoint>>> State;
+    auto copyState = [&contour]() {
+        State state;
+        for (Curve* curve : *contour.curves()) {
+            const std::list<CurvePoint>& points = static_cast<const Curve*>(curve)->points();
+            state.push_back({ curve->id(), std::vector<CurvePoint>(points.begin(), points.end()) });
+        }
+        return state;
+    };
+
+    int numEdits = 200;
+    std::mt19937 generator(5);
+    std::vector<State> states = { copyState() };
+    double seconds = 0;
+    for (int i = 0; i < numEdits; i++) {
+        std::list<Curve*>* curves = contour.curves();
+        if (curves->empty()) break;
+        Curve* curve = *std::next(curves->begin(), generator() % curves->size());
+        std::list<CurvePoint>& points = curve->points();
+        std::list<CurvePoint>::iterator it = std::next(points.begin(), generator() % points.size());
+        int editType = generator() % 10;
+        if (editType == 0 && curves->size() > 1) contour.removeCurve(curve->id());
+        else if (editType < 4) points.insert(it, CurvePoint(it->pos() + Vec2D(0.5, 0.5), it->radius()));
+        else for (int j = 0; j < 5 && it != points.end(); j++, it++) it->setPos(it->pos() + Vec2D(0.25, 0));
+        states.push_back(copyState());
+        Clock::time_point start = Clock::now();
+        history.commit(contour);
+        seconds += secondsSince(start);
+    }
+
+    auto countMismatches = [&contour, &copyState](const State& expected) {
+        State state = copyState();
+        if (state.size() != expected.size()) return 1;
+        for (size_t i = 0; i < state.size(); i++) {
+            if (state[i].first != expected[i].first || state[i].second.size() != expected[i].second.size()) return 1;
+            for (size_t j = 0; j < state[i].second.size(); j++) {
+                const CurvePoint& p = state[i].second[j];
+                const CurvePoint& q = expected[i].second[j];
+                if (p.pos()[0] != q.pos()[0] || p.pos()[1] != q.pos()[1] || p.radius() != q.radius()) return 1;
+            }
+        }
+        return 0;
+    };
+    int numMismatches = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = (int)states.size() - 2; i >= 0; i--) {
+        bool isUndone = history.undo(contour);
+        seconds += secondsSince(start);
+        numMismatches += isUndone ? countMismatches(states[i]) : 1;
+        start = Clock::now();
+    }
+    for (int i = 1; i < (int)states.size(); i++) {
+        bool isRedone = history.redo(contour);
+        seconds += secondsSince(start);
+        numMismatches += isRedone ? countMismatches(states[i]) : 1;
+        start = Clock::now();
+    }
+
+    return { "History", "steps/s", 3.0 * (states.size() - 1) / seconds,
+        "undo/redo mismatch rate", (double)numMismatches / (2.0 * (states.size() - 1)), 0 };
+}
+Benchmark::Result Benchmark::benchmarkImageSequence(Phantom& phantom)
+{
+    // Frames are copies of the phantom with the frame number in the first pixels. They 
+    // are scrubbed forward, backward and forward again, dwelling on each frame as when
+    // viewing, with a cache that holds fewer frames than the sequence. Frames must match
+    // the requested frame. One frame fails to decode and must only be decoded again when
+    // requested. Throughput includes the dwell time.
+    Image* source = phantom.image();
+    int numFrames = 48;
+    int failedFrame = 5;
+    std::atomic<int> numFailedDecodes(0);
+    auto decoder = [source, failedFrame, &numFailedDecodes](int frame, Image& image) {
+        if (frame == failedFrame) {
+            numFailedDecodes++;
+            return false;
+        }
+        if (!image.copyFrom(*source)) return false;
+        memcpy(image.data(), &frame, sizeof(frame));
+        return true;
+    };
+    int numBytesPerPixel = (source->dataFormat() == Image::DataFormat::UChar) ? 1 : 2;
+    size_t frameBytes = numBytesPerPixel * (size_t)source->width() * (size_t)source->height();
+    ImageSequence sequence(numFrames, decoder, 16 * frameBytes);
+
+    std::vector<int> frames;
+    for (int i = 0; i < numFrames; i++) frames.push_back(i);
+    for (int i = numFrames - 2; i >= 0; i--) frames.push_back(i);
+    for (int i = 1; i < numFrames / 2; i++) frames.push_back(i);
+    int numMismatches = 0;
+    int numFailedRequests = 0;
+    Clock::time_point start = Clock::now();
+    for (int frame : frames) {
+        std::shared_ptr<const Image> image = sequence.frame(frame);
+        int value = -1;
+        if (image) memcpy(&value, image->data(), sizeof(value));
+        if (frame == failedFrame) numFailedRequests++;
+        if (value != ((frame == failedFrame) ? -1 : frame)) numMismatches++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    double seconds = secondsSince(start);
+    if (sequence.numCachedBytes() > 16 * frameBytes) numMismatches++;
+    if (numFailedDecodes > numFailedRequests + 1) numMismatches++;
+
+    return { "ImageSequence", "frames/s", frames.size() / seconds,
+        "frame mismatch rate", (double)numMismatches / frames.size(), 0 };
+}
+Benchmark::Result Benchmark::benchmarkPropagation(Phantom& phantom)
+{
+    // Frames are the phantom moving up and down by one pixel per frame, between 0 and 4
+    // pixels, as vessels move with the heart beat. The ground truth contour of the first
+    // frame is propagated through all frames. The centerlines of the last frame must
+    // follow the moved vessels.
+    Image* source = phantom.image();
+    auto shift = [](int frame) { int phase = frame % 8; return (phase <= 4) ? phase : 8 - phase; };
+    auto decoder = [source, &shift](int frame, Image& image) {
+        if (!image.copyFrom(*source)) return false;
+        int numBytesPerPixel = (source->dataFormat() == Image::DataFormat::UChar) ? 1 : 2;
+        size_t rowSize = numBytesPerPixel * (size_t)source->width();
+        size_t numShifted = rowSize * (source->height() - shift(frame));
+        memcpy(image.data() + rowSize * shift(frame), source->data(), numShifted);
+        return true;
+    };
+    int numFrames = 24;
+    RenderState renderState;
+    Model model(&renderState);
+    model.openSequence(numFrames, decoder);
+    model.setVesselContrast(phantom.parameters().isDarkOnLight ?
+        ImageFilterer::VesselContrastType::DarkOnLight : ImageFilterer::VesselContrastType::LightOnDark);
+    phantom.addCurvesToContour(*model.contour(), 4);
+
+    Clock::time_point start = Clock::now();
+    int numPropagated = 0;
+    while (model.propagateToNextFrame()) numPropagated++;
+    double seconds = secondsSince(start);
+
+    std::vector<double> errors;
+    Vec2D offset(0, shift(model.frame()));
+    int idxVessel = 0;
+    for (Curve* curve : *model.contour()->curves()) {
+        for (const CurvePoint& point : static_cast<const Curve*>(curve)->points()) {
+            errors.push_back(phantom.distanceToCenterline(idxVessel, point.pos() - offset));
+        }
+        idxVessel++;
+    }
+    if (numPropagated != numFrames - 1 || errors.empty()) errors.push_back(1e6);
+    return { "propagateToNextFrame", "frames/s", numPropagated / seconds,
+        "p95 centerline error (px)", percentile(errors, 0.95), 1 };
+}
+Benchmark::Result Benchmark::benchmarkSnapWhileDrawing(Phantom& phantom)
+{
+    // Each vessel is drawn once with points 3 pixels apart that drift from the true 
+    // centerline by up to 3/4 of the vessel radius and a cursor radius 30% too large, as
+    // a quick stroke along the vessel. Deferred points are snapped after each update, as
+    // when the event loop becomes idle. The snapped curves must follow the centerlines.
+    RenderState renderState;
+    Model model(&renderState);
+    model.image().copyFrom(*phantom.image());
+    model.setVesselContrast(phantom.parameters().isDarkOnLight ?
+        ImageFilterer::VesselContrastType::DarkOnLight : ImageFilterer::VesselContrastType::LightOnDark);
+    model.setSnapWhileDrawing(true);
+
+    long long numPoints = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < phantom.numVessels(); i++) {
+        std::vector<CurvePoint>& centerline = phantom.centerline(i);
+        model.deselect();
+        for (size_t j = 0; j < centerline.size(); j += 3) {
+            Vec2D dir = centerlineDir(centerline, j);
+            Vec2D normal(-dir[1], dir[0]);
+            float radius = centerline[j].radius();
+            CurvePoint point(centerline[j].pos() + 0.75f * radius * sinf(j / 20.0f) * normal, 1.3f * radius);
+            if (j == 0) model.startDraw(point);
+            else if (j + 3 < centerline.size()) model.updateDraw(point);
+            else model.endDraw(point);
+            model.snapPendingPoints();
+            numPoints++;
+        }
+    }
+    double seconds = secondsSince(start);
+
+    std::vector<double> errors;
+    int idxVessel = 0;
+    for (Curve* curve : *model.contour()->curves()) {
+        for (const CurvePoint& point : static_cast<const Curve*>(curve)->points()) {
+            errors.push_back(phantom.distanceToCenterline(idxVessel, point.pos()));
+        }
+        idxVessel++;
+    }
+    if (idxVessel != phantom.numVessels() || errors.empty()) errors.push_back(1e6);
+    return { "snap while drawing", "points/s", numPoints / seconds,
+        "p95 centerline error (px)", percentile(errors, 0.95), 1 };
+}
+Benchmark::Result Benchmark::benchmarkTraceVessel(Phantom& phantom)
+{
+    // Each vessel is traced between points 5% of its length from either end, i.e., 
+    // almost across the image, with the radius at its middle as the expected radius. 
+    // The traced curves must follow the centerlines.
+    RenderState renderState;
+    Model model(&renderState);
+    model.image().copyFrom(*phantom.image());
+    model.setVesselContrast(phantom.parameters().isDarkOnLight ?
+        ImageFilterer::VesselContrastType::DarkOnLight : ImageFilterer::VesselContrastType::LightOnDark);
+
+    int numTraced = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < phantom.numVessels(); i++) {
+        std::vector<CurvePoint>& centerline = phantom.centerline(i);
+        size_t first = centerline.size() / 20;
+        size_t last = centerline.size() - 1 - first;
+        float expectedRadius = centerline[centerline.size() / 2].radius();
+        if (model.traceVessel(centerline[first].pos(), centerline[last].pos(), expectedRadius)) numTraced++;
+    }
+    double seconds = secondsSince(start);
+
+    std::vector<double> errors;
+    int idxVessel = 0;
+    for (Curve* curve : *model.contour()->curves()) {
+        for (const CurvePoint& point : static_cast<const Curve*>(curve)->points()) {
+            errors.push_back(phantom.distanceToCenterline(idxVessel, point.pos()));
+        }
+        idxVessel++;
+    }
+    if (numTraced != phantom.numVessels() || errors.empty()) errors.push_back(1e6);
+    return { "traceVessel", "traces/s", numTraced / seconds,
+        "p95 centerline error (px)", percentile(errors, 0.95), 1 };
+}
+void Benchmark::benchmarkFileIO(Phantom& phantom, const std::string& filename, 
+    std::vector<Result>& results)
+{
+    // Write the phantom in the .vscl layout written by Model::save, then time loading
+    // it and saving it back. The round trip must reproduce the file exactly.
+    Contour contour;
+    phantom.addCurvesToContour(contour, 4);
+    std::ostringstream reference;
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "VSCL0001" << std::endl;
+        phantom.image()->writeToFile(file);
+        contour.writeToFile(file);
+    }
+    {
+        std::ifstream file(filename, std::ios::binary);
+        reference << file.rdbuf();
+    }
+    double megabytes = reference.str().size() / (1024.0 * 1024.0);
+
+    RenderState renderState;
+    Model model(&renderState);
+    int numLoads = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        std::ifstream file(filename, std::ios::binary);
+        model.load(file);
+        numLoads++;
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double loadSeconds = secondsSince(start);
+
+    int numSaves = 0;
+    start = Clock::now();
+    do {
+        std::ofstream file(filename, std::ios::binary);
+        model.save(file);
+        numSaves++;
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double saveSeconds = secondsSince(start);
+
+    std::ostringstream saved;
+    {
+        std::ifstream file(filename, std::ios::binary);
+        saved << file.rdbuf();
+    }
+    double mismatch = (saved.str() == reference.str()) ? 0 : 1;
+    results.push_back({ "Model::load", "MB/s", numLoads * megabytes / loadSeconds, "", 0, 0 });
+    results.push_back({ "Model::save", "MB/s", numSaves * megabytes / saveSeconds,
+        "round trip mismatch", mismatch, 0 });
+
+    // Save with an image store in the working directory, so the file only references the
+    // image, then time loads, which map the stored image. The loaded image and contour 
+    // must match the embedded file's.
+    model.setImageStore(".");
+    {
+        std::ofstream file(filename, std::ios::binary);
+        model.save(file);
+    }
+    std::string storedFilename = ImageStore(".").filename(ImageStore::key(model.image()));
+    int numStoreLoads = 0;
+    start = Clock::now();
+    do {
+        std::ifstream file(filename, std::ios::binary);
+        model.load(file);
+        numStoreLoads++;
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double storeLoadSeconds = secondsSince(start);
+
+    Image* image = phantom.image();
+    int numBytesPerPixel = (image->dataFormat() == Image::DataFormat::UChar) ? 1 : 2;
+    size_t imageSize = numBytesPerPixel * (size_t)image->width() * (size_t)image->height();
+    std::ostringstream contourData, loadedContourData;
+    contour.writeToFile(contourData);
+    model.contour()->writeToFile(loadedContourData);
+    bool isMatch = model.imageIsValid() && model.imageWidth() == image->width() &&
+        model.imageHeight() == image->height() && model.image().dataFormat() == image->dataFormat() &&
+        memcmp(model.image().data(), image->data(), imageSize) == 0 && contourData.str() == loadedContourData.str();
+    std::remove(storedFilename.c_str());
+    results.push_back({ "Model::load (image store)", "MB/s", numStoreLoads * megabytes / storeLoadSeconds,
+        "round trip mismatch", isMatch ? 0.0 : 1.0, 0 });
+
+    // Save and load with block compressed image data. Throughput is of the uncompressed 
+    // file size. One block is also decoded on its own through the block index.
+    model.setImageStore("");
+    model.setImageCompressed(true);
+    int numCompressedSaves = 0;
+    start = Clock::now();
+    do {
+        std::ofstream file(filename, std::ios::binary);
+        model.save(file);
+        numCompressedSaves++;
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double compressedSaveSeconds = secondsSince(start);
+    double compressedMegabytes = 0;
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        compressedMegabytes = file.tellg() / (1024.0 * 1024.0);
+    }
+    int numCompressedLoads = 0;
+    start = Clock::now();
+    do {
+        std::ifstream file(filename, std::ios::binary);
+        model.load(file);
+        numCompressedLoads++;
+    } while (secondsSince(start) < minBenchmarkSeconds);
+    double compressedLoadSeconds = secondsSince(start);
+
+    std::ostringstream compressedContourData;
+    model.contour()->writeToFile(compressedContourData);
+    isMatch = model.imageIsValid() && model.isImageCompressed() && 
+        memcmp(model.image().data(), image->data(), imageSize) == 0 && contourData.str() == compressedContourData.str();
+    {
+        std::ifstream file(filename, std::ios::binary);
+        std::string line;
+        for (int i = 0; i < 5; i++) std::getline(file, line);
+        ImageBlockCodec::Index index;
+        int block = (image->height() / ImageBlockCodec::defaultRowsPerBlock) / 2;
+        size_t rowSize = numBytesPerPixel * (size_t)image->width();
+        std::vector<unsigned char> rows(ImageBlockCodec::defaultRowsPerBlock * rowSize);
+        isMatch &= ImageBlockCodec::readIndex(file, image->width(), image->height(), numBytesPerPixel, &index) &&
+            ImageBlockCodec::readBlock(file, index, block, rows.data()) &&
+            memcmp(rows.data(), image->data() + block * index.rowsPerBlock * rowSize, rows.size()) == 0;
+    }
+    model.clear();
+    std::ostringstream name;
+    name << "Compressed (" << std::setprecision(2) << megabytes / compressedMegabytes << "x) save";
+    results.push_back({ name.str(), "MB/s", numCompressedSaves * megabytes / compressedSaveSeconds, "", 0, 0 });
+    results.push_back({ "Compressed load", "MB/s", numCompressedLoads * megabytes / compressedLoadSeconds,
+        "round trip mismatch", isMatch ? 0.0 : 1.0, 0 });
+}
+
+Benchmark::Result Benchmark::benchmarkJournal(Phantom& phantom, const std::string& filename)
+{
+    // Random local edits of a saved phantom are journaled. The journal is then replayed
+    // onto the file as after a crash, with a torn record at its end, and again after the
+    // file's contour was rewritten from a checkpoint. Recovered contours must match the 
+    // edited contour to the precision of the file format. Only appends are timed.
+    Contour contour;
+    phantom.addCurvesToContour(contour, 1);
+    long long contourOffset = 0;
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "VSCL0001" << std::endl;
+        phantom.image()->writeToFile(file);
+        contourOffset = (long long)file.tellp();
+        contour.writeToFile(file);
+    }
+    Journal journal;
+    journal.open(filename, contour, false);
+    size_t startBytes = journal.numBytes();
+
+    int numEdits = 100;
+    std::mt19937 generator(6);
+    double seconds = 0;
+    auto edit = [&]() {
+        std::list<Curve*>* curves = contour.curves();
+        Curve* curve = *std::next(curves->begin(), generator() % curves->size());
+        std::list<CurvePoint>& points = curve->points();
+        std::list<CurvePoint>::iterator it = std::next(points.begin(), generator() % points.size());
+        if (generator() % 10 == 0 && curves->size() > 1) contour.removeCurve(curve->id());
+        else it->setPos(it->pos() + Vec2D(0.25, 0.25));
+        Clock::time_point start = Clock::now();
+        journal.append(contour);
+        seconds += secondsSince(start);
+    };
+    for (int i = 0; i < numEdits; i++) edit();
+    double bytesPerEdit = (double)(journal.numBytes() - startBytes) / numEdits;
+
+    auto recoveryError = [&contour, &filename]() {
+        RenderState renderState;
+        Model model(&renderState);
+        std::ifstream file(filename, std::ios::binary);
+        model.load(file);
+        if (model.openJournal(filename, true) <= 0) return 1e6;
+        std::list<Curve*>* recovered = model.contour()->curves();
+        if (recovered->size() != contour.curves()->size()) return 1e6;
+        double maxError = 0;
+        std::list<Curve*>::iterator itCurve = recovered->begin();
+        for (Curve* curve : *contour.curves()) {
+            const std::list<CurvePoint>& expected = static_cast<const Curve*>(curve)->points();
+            const std::list<CurvePoint>& points = static_cast<const Curve*>(*itCurve++)->points();
+            if (points.size() != expected.size()) return 1e6;
+            std::list<CurvePoint>::const_iterator it = points.begin();
+            for (const CurvePoint& p : expected) {
+                maxError = std::max(maxError, (p.pos() - it->pos()).length());
+                maxError = std::max(maxError, (double)std::abs(p.radius() - it->radius()));
+                it++;
+            }
+        }
+        return maxError;
+    };
+
+    // Replay after a crash, with a torn record at the end of the journal
+    journal.close(false);
+    std::ofstream(Journal::journalFilename(filename), std::ios::binary | std::ios::app) << "torn record";
+    double error = recoveryError();
+
+    // Replay after the file's contour was rewritten from a checkpoint, with edits after it
+    journal.open(filename, contour, false);
+    std::string contourData;
+    journal.checkpoint(contour, &contourData);
+    for (int i = 0; i < 5; i++) edit();
+    Journal::writeContourInPlace(filename, contourOffset, contourData);
+    journal.rebase();
+    for (int i = 0; i < 5; i++) edit();
+    journal.close(false);
+    error = std::max(error, recoveryError());
+
+    std::ostringstream name;
+    name << "Journal (" << (int)bytesPerEdit << " B/edit)";
+    return { name.str(), "edits/s", numEdits / seconds, "max recovery error (px)", error, 0.01 };
+}
+double Benchmark::percentile(std::vector<double> values, double fraction)
+{
+    if (values.size() == 0) return 0;
+    size_t idx = std::min(values.size() - 1, (size_t)(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + idx, values.end());
+    return values[idx];
+}
+bool Benchmark::report(std::ostream& out, const std::string& config, const Result& result)
+{
+    std::ostringstream throughput;
+    throughput << std::setprecision(3) << result.throughput << " " << result.units;
+    out << std::left << std::setw(18) << config << std::setw(26) << result.name << 
+        std::setw(26) << throughput.str();
+    bool isAccurate = (result.error <= result.tolerance);
+    if (!result.metric.empty()) {
+        out << result.metric << " " << std::setprecision(3) << result.error << 
+            " (tolerance " << result.tolerance << ")" << (isAccurate ? "" : " FAILED");
+    }
+    out << std::endl;
+    return isAccurate;
+}
@@ -0,0 +1,64 @@
+//
+// Benchmark.h
+// Microbenchmarks of vessel fitting, curve processing, selection and file I/O on 
+// synthetic vessel phantoms. Reports throughput together with accuracy against the
+// phantom ground truth so that speedups that degrade accuracy are caught.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class Phantom;
+
+class Benchmark
+{
+public:
+    // Runs all benchmarks at each phantom size in 8- and 16-bit and writes a report to 
+    // out. Returns false if any accuracy metric exceeds its tolerance.
+    static bool run(std::ostream& out, const std::vector<int>& sizes = { 512, 1024, 2048 });
+
+private:
+    typedef struct {
+        std::string name;
+        std::string units;
+        double throughput;      // units per second
+        std::string metric;     // Accuracy metric, empty if none
+        double error;
+        double tolerance;       // Set with some margin above the current accuracy
+    } Result;
+
+    static Result benchmarkVecToClosestVessel(Phantom& phantom);
+    static Result benchmarkWidthAtP(Phantom& phantom);
+    static Result benchmarkFitToNearestVessel(Phantom& phantom);
+    static Result benchmarkSampledCurvePoints(Phantom& phantom);
+    static Result benchmarkSmoothing(Phantom& phantom);
+    static Result benchmarkSelectCurve(Phantom& phantom);
+    static Result benchmarkDistanceTransform(Phantom& phantom);
+    static Result benchmarkHistory(Phantom& phantom);
+    static Result benchmarkImageSequence(Phantom& phantom);
+    static Result benchmarkPropagation(Phantom& phantom);
+    static Result benchmarkSnapWhileDrawing(Phantom& phantom);
+    static Result benchmarkTraceVessel(Phantom& phantom);
+    static void benchmarkFileIO(Phantom& phantom, const std::string& filename, 
+        std::vector<Result>& results);
+    static Result benchmarkJournal(Phantom& phantom, const std::string& filename);
+
+    static double percentile(std::vector<double> values, double fraction);
+    static bool report(std::ostream& out, const std::string& config, const Result& result);
+};
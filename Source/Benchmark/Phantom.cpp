@@ -0,0 +1,174 @@
+//
+// Phantom.cpp
+// Implementation of Phantom.
+//
+
+#include "Phantom.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace Math;
+
+// 
+// Public
+//
+Phantom::Parameters Phantom::defaultParameters(int width, int height, Image::DataFormat format)
+{
+    Parameters parameters;
+    parameters.width = width;
+    parameters.height = height;
+    parameters.format = format;
+    parameters.numVessels = std::max(1, height / 64);
+    parameters.minRadius = 1.5;
+    parameters.maxRadius = 8;
+    parameters.background = 0.7f;
+    parameters.contrast = 0.4f;
+    parameters.noiseSigma = 0.05f;
+    parameters.isDarkOnLight = true;
+    parameters.seed = 1;
+    return parameters;
+}
+
+Phantom::Phantom(const Parameters& parameters) :
+    m_parameters(parameters),
+    m_image(nullptr)
+{
+    createCenterlines();
+    createImage();
+}
+Phantom::~Phantom()
+{
+    delete m_image;
+}
+
+float Phantom::distanceToCenterline(int idxVessel, Vec2D p, float* radius)
+{
+    // Closest point over the centerline segments
+    std::vector<CurvePoint>& centerline = m_centerlines[idxVessel];
+    float minDist = std::numeric_limits<float>::max();
+    float closestRadius = 0;
+    for (size_t i = 0; i + 1 < centerline.size(); i++) {
+        Vec2D a = centerline[i].pos();
+        Vec2D ab = centerline[i + 1].pos() - a;
+        double t = Vec2D::dotProduct(p - a, ab) / Vec2D::dotProduct(ab, ab);
+        t = std::min(1.0, std::max(0.0, t));
+        float dist = (float)(p - (a + t * ab)).length();
+        if (dist < minDist) {
+            minDist = dist;
+            closestRadius = (1 - t) * centerline[i].radius() + t * centerline[i + 1].radius();
+        }
+    }
+    if (radius) *radius = closestRadius;
+    return minDist;
+}
+
+std::vector<int> Phantom::addCurvesToContour(Contour& contour, float pointSpacing)
+{
+    std::vector<int> curveIDs;
+    int step = std::max(1, (int)(pointSpacing + 0.5));
+    for (std::vector<CurvePoint>& centerline : m_centerlines) {
+        // Curves of centerlines with fewer than 2 points are kept, so IDs stay in vessel
+        // order, but have no end point to add
+        int curveID = contour.addCurve();
+        curveIDs.push_back(curveID);
+        std::list<CurvePoint>& points = contour.curve(curveID)->points();
+        for (size_t i = 0; i < centerline.size(); i += step) {
+            points.push_back(centerline[i]);
+        }
+        if (centerline.size() < 2) continue;
+        if ((centerline.size() - 1) % step != 0) points.push_back(centerline.back());
+    }
+    contour.deselectCurve();
+    return curveIDs;
+}
+
+// 
+// Private
+//
+void Phantom::createCenterlines()
+{
+    // Each vessel is a sinusoid running across the image within its own horizontal band,
+    // with a slowly varying radius. Amplitudes are limited so vessels never touch.
+    std::mt19937 generator(m_parameters.seed);
+    std::uniform_real_distribution<float> uniform(0, 1);
+    const float pi = 3.1415926f;
+    int numVessels = m_parameters.numVessels;
+    float bandHeight = (float)m_parameters.height / numVessels;
+    float margin = m_parameters.maxRadius + 4;
+    float maxAmplitude = std::max(0.0f, 0.5f * bandHeight - m_parameters.maxRadius - 4);
+
+    m_centerlines.resize(numVessels);
+    for (int i = 0; i < numVessels; i++) {
+        float yCenter = (i + 0.5f) * bandHeight;
+        float amplitude = maxAmplitude * (0.3f + 0.7f * uniform(generator));
+        float wavelength = m_parameters.width * (0.2f + 0.6f * uniform(generator));
+        float phase = 2 * pi * uniform(generator);
+        float radiusWavelength = m_parameters.width * (0.3f + 0.7f * uniform(generator));
+        float radiusPhase = 2 * pi * uniform(generator);
+        float radiusMin = m_parameters.minRadius + 
+            (m_parameters.maxRadius - m_parameters.minRadius) * 0.5f * uniform(generator);
+        float radiusMax = radiusMin + 
+            (m_parameters.maxRadius - radiusMin) * uniform(generator);
+
+        std::vector<CurvePoint>& centerline = m_centerlines[i];
+        for (int x = (int)margin; x <= (int)(m_parameters.width - margin); x++) {
+            float y = yCenter + amplitude * sin(2 * pi * x / wavelength + phase);
+            float s = 0.5f + 0.5f * sin(2 * pi * x / radiusWavelength + radiusPhase);
+            centerline.push_back(CurvePoint(Vec2D(x, y), radiusMin + s * (radiusMax - radiusMin)));
+        }
+    }
+}
+void Phantom::createImage()
+{
+    // Rasterize vessel coverage with a 1 pixel antialiased edge. Pixel centers are at 
+    // integer coordinates, matching ImageFilterer. Each centerline segment only touches 
+    // pixels within its bounding box inflated by the radius.
+    int width = m_parameters.width;
+    int height = m_parameters.height;
+    std::vector<float> coverage((size_t)width * height, 0);
+    for (std::vector<CurvePoint>& centerline : m_centerlines) {
+        for (size_t i = 0; i + 1 < centerline.size(); i++) {
+            Vec2D a = centerline[i].pos();
+            Vec2D ab = centerline[i + 1].pos() - a;
+            double abLengthSqr = Vec2D::dotProduct(ab, ab);
+            float ra = centerline[i].radius();
+            float rb = centerline[i + 1].radius();
+            float reach = std::max(ra, rb) + 1;
+            int xMin = std::max(0, (int)floor(std::min(a[0], a[0] + ab[0]) - reach));
+            int xMax = std::min(width - 1, (int)ceil(std::max(a[0], a[0] + ab[0]) + reach));
+            int yMin = std::max(0, (int)floor(std::min(a[1], a[1] + ab[1]) - reach));
+            int yMax = std::min(height - 1, (int)ceil(std::max(a[1], a[1] + ab[1]) + reach));
+            for (int y = yMin; y <= yMax; y++) {
+                float* pCoverage = &coverage[(size_t)y * width];
+                for (int x = xMin; x <= xMax; x++) {
+                    Vec2D p(x, y);
+                    double t = Vec2D::dotProduct(p - a, ab) / abLengthSqr;
+                    t = std::min(1.0, std::max(0.0, t));
+                    float dist = (float)(p - (a + t * ab)).length();
+                    float r = (float)((1 - t) * ra + t * rb);
+                    float c = std::min(1.0f, std::max(0.0f, r - dist + 0.5f));
+                    if (c > pCoverage[x]) pCoverage[x] = c;
+                }
+            }
+        }
+    }
+
+    // Convert to intensities, add noise and quantize to the data format
+    std::mt19937 generator(m_parameters.seed + 1);
+    std::normal_distribution<float> noise(0, m_parameters.noiseSigma);
+    float contrast = m_parameters.isDarkOnLight ? -m_parameters.contrast : m_parameters.contrast;
+    bool isUShort = (m_parameters.format == Image::DataFormat::UShort);
+    float maxValue = isUShort ? 65535.0f : 255.0f;
+    int numBytesPerPixel = isUShort ? 2 : 1;
+    std::vector<unsigned char> data((size_t)width * height * numBytesPerPixel);
+    for (size_t i = 0; i < coverage.size(); i++) {
+        float value = m_parameters.background + contrast * coverage[i] + noise(generator);
+        value = std::min(1.0f, std::max(0.0f, value)) * maxValue + 0.5f;
+        if (isUShort) ((unsigned short*)data.data())[i] = (unsigned short)value;
+        else data[i] = (unsigned char)value;
+    }
+    m_image = new Image(width, height, m_parameters.format, data.data());
+}
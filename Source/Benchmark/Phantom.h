@@ -0,0 +1,78 @@
+//
+// Phantom.h
+// Procedural vessel phantom for benchmarking. Generates an image of tubular vessels with
+// known centerlines and radii plus Gaussian noise, and answers ground truth queries for
+// measuring the accuracy of vessel fitting.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "../Model/Image.h"
+#include "../Model/Contour.h"
+#include "../Model/CurvePoint.h"
+#include "../Model/Math.h"
+
+#include <vector>
+
+class Phantom
+{
+public:
+    // Intensities and noise are normalized to [0, 1], where 1 is the max value for the
+    // data format. Radii are in pixels.
+    typedef struct {
+        int width;
+        int height;
+        Image::DataFormat format;
+        int numVessels;
+        float minRadius;
+        float maxRadius;
+        float background;
+        float contrast;
+        float noiseSigma;
+        bool isDarkOnLight;
+        unsigned int seed;
+    } Parameters;
+    static Parameters defaultParameters(int width, int height, Image::DataFormat format);
+
+    Phantom(const Parameters& parameters);
+    ~Phantom();
+
+    const Parameters& parameters() const { return m_parameters; };
+    Image* image() { return m_image; };
+
+    // Ground truth centerlines sampled at 1 pixel intervals along x. Vessels do not cross.
+    int numVessels() const { return (int)m_centerlines.size(); };
+    std::vector<CurvePoint>& centerline(int idxVessel) { return m_centerlines[idxVessel]; };
+
+    // Distance from p to the centerline of the given vessel. Optionally returns the true
+    // radius at the closest centerline point.
+    float distanceToCenterline(int idxVessel, Math::Vec2D p, float* radius = nullptr);
+
+    // Adds one curve per vessel with control points approximately pointSpacing apart. 
+    // Returns the curve IDs in vessel order.
+    std::vector<int> addCurvesToContour(Contour& contour, float pointSpacing);
+
+    // Make non-copyable
+    Phantom(Phantom const&) = delete;
+    void operator=(Phantom const&) = delete;
+
+private:
+    Parameters m_parameters;
+    Image* m_image;
+    std::vector<std::vector<CurvePoint>> m_centerlines;
+    void createCenterlines();
+    void createImage();
+};
@@ -0,0 +1,399 @@
+//
+// RenderBenchmark.cpp
+// Implementation of RenderBenchmark.
+//
+
+#include "RenderBenchmark.h"
+#include "Phantom.h"
+#include "../View/GL_ImageRenderer.h"
+#include "../View/GL_PixelReader.h"
+#include "../View/GL_Exporter.h"
+#include "../Model/Model.h"
+#include "../Controller/RenderState.h"
+
+#include <QDir>
+#include <QImage>
+#include <QOpenGLFramebufferObject>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+    double msecsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+// 
+// Public
+//
+RenderBenchmark::RenderBenchmark() :
+    m_numRepetitions(3),
+    m_windowSizes({ 512, 1024, 2048 }),
+    m_zoomLevels({ 0.5f, 1, 4 }),
+    m_contourExtent(2048),
+    m_contourSizes({ { 10, 1000 }, { 1000, 100 }, { 10, 100000 }, { 1000, 1000 }, { 100000, 10 } }),
+    m_maxCoverageDifference(0.01f),
+    m_maxMismatchedFraction(0.001f)
+{
+}
+RenderBenchmark::~RenderBenchmark()
+{
+}
+
+bool RenderBenchmark::run(std::ostream& out)
+{
+    if (!setupGL()) return false;
+    m_context.makeCurrent(&m_surface);
+
+    out << "VESCL render benchmarks" << std::endl;
+    out << "OpenGL: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+    out << "Times in msecs, median of " << m_numRepetitions << " runs" << std::endl;
+
+    benchmarkImageRenderer(out);
+
+    GL_ContourRenderer::RendererType types[5] = {
+        GL_ContourRenderer::RendererType::Antialiased, GL_ContourRenderer::RendererType::Centerline,
+        GL_ContourRenderer::RendererType::Binary, GL_ContourRenderer::RendererType::DistToContour,
+        GL_ContourRenderer::RendererType::DistToCenterline };
+    out << std::endl << std::left << std::setw(18) << "Renderer" << std::setw(18) << "Contour" <<
+        std::setw(8) << "Window" << std::setw(6) << "Zoom" << std::setw(12) << "Vertices" << 
+        std::setw(11) << "Geometry" << std::setw(11) << "Draw" << "Readback" << std::endl;
+    for (const ContourSize& size : m_contourSizes) {
+        std::list<Curve::PointVector> curvePoints = syntheticContour(size, 1);
+        for (GL_ContourRenderer::RendererType type : types) {
+            benchmarkContourRenderer(out, type, size, curvePoints);
+        }
+    }
+
+    CPU_ContourRenderer::RendererType cpuTypes[3] = { CPU_ContourRenderer::RendererType::Antialiased,
+        CPU_ContourRenderer::RendererType::Centerline, CPU_ContourRenderer::RendererType::Binary };
+    out << std::endl << "CPU renderer, compared with OpenGL R32F coverage" << std::endl;
+    out << std::left << std::setw(18) << "Renderer" << std::setw(18) << "Contour" << std::setw(8) << 
+        "Window" << std::setw(6) << "Zoom" << std::setw(11) << "CPU" << std::setw(12) << "Max diff" << 
+        "Mismatched" << std::endl;
+    bool isMatched = true;
+    for (const ContourSize& size : m_contourSizes) {
+        std::list<Curve::PointVector> curvePoints = syntheticContour(size, 1);
+        for (CPU_ContourRenderer::RendererType type : cpuTypes) {
+            isMatched &= compareCPURenderer(out, type, size, curvePoints);
+        }
+    }
+    out << (isMatched ? "CPU renderer matches OpenGL" : "CPU renderer does not match OpenGL") << std::endl;
+    m_context.doneCurrent();
+
+    // The exporter makes its own context current
+    isMatched &= compareTiledLabelMap(out);
+    return isMatched;
+}
+
+// 
+// Private
+//
+bool RenderBenchmark::setupGL()
+{
+    // Same setup as GL_Exporter
+    try {
+        m_context.setShareContext(QOpenGLContext::globalShareContext());
+        if (!m_context.create()) {
+            throw std::runtime_error("Can't create GL context.");
+        }
+        m_surface.setFormat(m_context.format());
+        m_surface.create();
+        if (!m_surface.isValid()) {
+            throw std::runtime_error("GL surface not valid.");
+        }
+        if (!m_context.makeCurrent(&m_surface)) {
+            throw std::runtime_error("Can't make GL context current.");
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "Exception " << e.what() << std::endl;
+        return false;
+    }
+
+    initializeOpenGLFunctions();
+    return true;
+}
+
+std::list<Curve::PointVector> RenderBenchmark::syntheticContour(const ContourSize& size, unsigned int seed)
+{
+    // Curves are smooth random walks with 1 pixel steps that reflect off the contour 
+    // bounds, i.e., already sampled for rendering at 1:1 zoom
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> uniform(0, 1);
+    std::normal_distribution<float> turn(0, 0.05f);
+    const float pi = 3.1415926f;
+    float extent = (float)m_contourExtent;
+    std::list<Curve::PointVector> curvePoints;
+    for (int i = 0; i < size.numCurves; i++) {
+        Curve::PointVector points;
+        points.reserve(size.numPointsPerCurve);
+        float x = extent * uniform(generator);
+        float y = extent * uniform(generator);
+        float heading = 2 * pi * uniform(generator);
+        float radius = 1 + 5 * uniform(generator);
+        for (int j = 0; j < size.numPointsPerCurve; j++) {
+            points.push_back(CurvePoint(Math::Vec2D(x, y), radius));
+            heading += turn(generator);
+            x += cos(heading);
+            y += sin(heading);
+            if (x < 0 || x > extent) {
+                heading = pi - heading;
+                x = std::min(extent, std::max(0.0f, x));
+            }
+            if (y < 0 || y > extent) {
+                heading = -heading;
+                y = std::min(extent, std::max(0.0f, y));
+            }
+        }
+        curvePoints.push_back(points);
+    }
+    return curvePoints;
+}
+
+void RenderBenchmark::benchmarkContourRenderer(std::ostream& out, GL_ContourRenderer::RendererType type,
+    const ContourSize& size, const std::list<Curve::PointVector>& curvePoints)
+{
+    GL_ContourRenderer renderer(type);
+    std::ostringstream contour;
+    contour << size.numCurves << "x" << size.numPointsPerCurve;
+    for (int windowSize : m_windowSizes) {
+        for (float zoom : m_zoomLevels) {
+            RenderState renderState;
+            renderState.resetProjectionMatrix(windowSize, windowSize);
+            renderState.centerImageInViewport(m_contourExtent, m_contourExtent);
+            QMatrix4x4 worldToView;
+            worldToView.scale(zoom, zoom, 1);
+            renderState.setWorldToView(worldToView);
+            float windowToContourScale = renderState.windowToContourScale();
+            glViewport(0, 0, windowSize, windowSize);
+
+            // Drawing is timed to completion of the GPU work
+            std::vector<double> geometry, draw, readback;
+            for (int i = 0; i <= m_numRepetitions; i++) {
+                Clock::time_point start = Clock::now();
+                renderer.setGeometry(curvePoints, windowToContourScale);
+                glFinish();
+                double geometryTime = msecsSince(start);
+                start = Clock::now();
+                renderer.render(Qt::white, windowSize, windowSize, renderState.mvpMatrix(), windowToContourScale);
+                glFinish();
+                double drawTime = msecsSince(start);
+                start = Clock::now();
+                QImage image = renderer.renderedImage();
+                double readbackTime = msecsSince(start);
+                if (i == 0) continue;
+                geometry.push_back(geometryTime);
+                draw.push_back(drawTime);
+                readback.push_back(readbackTime);
+            }
+
+            out << std::left << std::setw(18) << typeName(type) << std::setw(18) << contour.str() <<
+                std::setw(8) << windowSize << std::setw(6) << zoom << std::setw(12) << renderer.numVertices() <<
+                std::fixed << std::setprecision(2) << std::setw(11) << median(geometry) << 
+                std::setw(11) << median(draw) << median(readback) << std::defaultfloat << std::endl;
+        }
+    }
+}
+void RenderBenchmark::benchmarkImageRenderer(std::ostream& out)
+{
+    // Upload covers the whole image, so it is timed once per image
+    out << std::endl << std::left << std::setw(18) << "Image" << std::setw(8) << "Window" << 
+        std::setw(6) << "Zoom" << std::setw(11) << "Upload" << std::setw(11) << "Draw" << 
+        "Readback" << std::endl;
+    Image::DataFormat formats[2] = { Image::DataFormat::UChar, Image::DataFormat::UShort };
+    for (Image::DataFormat format : formats) {
+        Phantom phantom(Phantom::defaultParameters(m_contourExtent, m_contourExtent, format));
+        Image* image = phantom.image();
+        std::ostringstream imageName;
+        imageName << image->width() << "x" << image->height() << 
+            ((format == Image::DataFormat::UChar) ? " 8-bit" : " 16-bit");
+
+        GL_ImageRenderer renderer;
+        std::vector<double> upload;
+        for (int i = 0; i <= m_numRepetitions; i++) {
+            Clock::time_point start = Clock::now();
+            renderer.setImage(*image);
+            renderer.finishUpload();
+            glFinish();
+            if (i > 0) upload.push_back(msecsSince(start));
+        }
+
+        for (int windowSize : m_windowSizes) {
+            for (float zoom : m_zoomLevels) {
+                RenderState renderState;
+                renderState.setWindowingRange(image->normalizedMinValue(), image->normalizedMaxValue());
+                renderState.setDefaultWindowing();
+                renderState.resetProjectionMatrix(windowSize, windowSize);
+                renderState.centerImageInViewport(image->width(), image->height());
+                QMatrix4x4 worldToView;
+                worldToView.scale(zoom, zoom, 1);
+                renderState.setWorldToView(worldToView);
+                glViewport(0, 0, windowSize, windowSize);
+
+                std::vector<double> draw, readback;
+                for (int i = 0; i <= m_numRepetitions; i++) {
+                    Clock::time_point start = Clock::now();
+                    renderer.update(windowSize, windowSize, &renderState);
+                    glFinish();
+                    double drawTime = msecsSince(start);
+                    start = Clock::now();
+                    QImage renderedImage = renderer.renderedImage();
+                    double readbackTime = msecsSince(start);
+                    if (i == 0) continue;
+                    draw.push_back(drawTime);
+                    readback.push_back(readbackTime);
+                }
+
+                out << std::left << std::setw(18) << imageName.str() << std::setw(8) << windowSize << 
+                    std::setw(6) << zoom << std::fixed << std::setprecision(2) << std::setw(11) << 
+                    median(upload) << std::setw(11) << median(draw) << median(readback) << 
+                    std::defaultfloat << std::endl;
+            }
+        }
+    }
+}
+
+bool RenderBenchmark::compareCPURenderer(std::ostream& out, CPU_ContourRenderer::RendererType type,
+    const ContourSize& size, const std::list<Curve::PointVector>& curvePoints)
+{
+    GL_ContourRenderer::RendererType glType = GL_ContourRenderer::RendererType::Binary;
+    if (type == CPU_ContourRenderer::RendererType::Antialiased) glType = GL_ContourRenderer::RendererType::Antialiased;
+    else if (type == CPU_ContourRenderer::RendererType::Centerline) glType = GL_ContourRenderer::RendererType::Centerline;
+    GL_ContourRenderer glRenderer(glType, GL_ContourRenderer::TargetFormat::R32F);
+    CPU_ContourRenderer cpuRenderer(type);
+    std::ostringstream contour;
+    contour << size.numCurves << "x" << size.numPointsPerCurve;
+
+    bool isMatched = true;
+    int windowSize = 1024;
+    for (float zoom : m_zoomLevels) {
+        RenderState renderState;
+        renderState.resetProjectionMatrix(windowSize, windowSize);
+        renderState.centerImageInViewport(m_contourExtent, m_contourExtent);
+        QMatrix4x4 worldToView;
+        worldToView.scale(zoom, zoom, 1);
+        renderState.setWorldToView(worldToView);
+        float windowToContourScale = renderState.windowToContourScale();
+        glViewport(0, 0, windowSize, windowSize);
+        glRenderer.update(curvePoints, Qt::white, windowSize, windowSize, renderState.mvpMatrix(), 
+            windowToContourScale);
+        std::vector<float> glCoverage;
+        glCoverage.reserve((size_t)windowSize * windowSize);
+        GL_PixelReader reader;
+        glRenderer.framebuffer()->bind();
+        reader.read(windowSize, windowSize, GL_PixelReader::PixelType::Float32, [&](const void* row) {
+            glCoverage.insert(glCoverage.end(), (const float*)row, (const float*)row + windowSize);
+            return true;
+        });
+        glRenderer.framebuffer()->release();
+
+        // The zoom scales the contour about the window center
+        float contourToPixelScale = zoom * windowSize / m_contourExtent;
+        float offset = 0.5f * windowSize - 0.5f * contourToPixelScale * m_contourExtent;
+        std::vector<double> cpuTimes;
+        for (int i = 0; i <= m_numRepetitions; i++) {
+            Clock::time_point start = Clock::now();
+            cpuRenderer.update(curvePoints, windowSize, windowSize, contourToPixelScale, offset, offset);
+            if (i > 0) cpuTimes.push_back(msecsSince(start));
+        }
+
+        float maxDifference = 0;
+        size_t numMismatched = 0;
+        const std::vector<float>& cpuCoverage = cpuRenderer.coverage();
+        for (size_t i = 0; i < glCoverage.size() && i < cpuCoverage.size(); i++) {
+            float difference = fabs(glCoverage[i] - cpuCoverage[i]);
+            maxDifference = std::max(maxDifference, difference);
+            if (difference > m_maxCoverageDifference) numMismatched++;
+        }
+        float mismatchedFraction = (float)numMismatched / ((float)windowSize * windowSize);
+        bool isWithinTolerance = (glCoverage.size() == cpuCoverage.size()) && 
+            (mismatchedFraction <= m_maxMismatchedFraction);
+        isMatched &= isWithinTolerance;
+
+        out << std::left << std::setw(18) << typeName(type) << std::setw(18) << contour.str() <<
+            std::setw(8) << windowSize << std::setw(6) << zoom << std::fixed << std::setprecision(2) << 
+            std::setw(11) << median(cpuTimes) << std::setprecision(4) << std::setw(12) << maxDifference << 
+            std::setprecision(5) << mismatchedFraction << std::defaultfloat << 
+            (isWithinTolerance ? "" : "  FAILED") << std::endl;
+    }
+    return isMatched;
+}
+
+bool RenderBenchmark::compareTiledLabelMap(std::ostream& out)
+{
+    // Tiles are small enough that most curves are culled from most tiles
+    Phantom phantom(Phantom::defaultParameters(1024, 768, Image::DataFormat::UChar));
+    RenderState renderState;
+    Model model(&renderState);
+    model.image().copyFrom(*phantom.image());
+    phantom.addCurvesToContour(*model.contour(), 4);
+
+    std::string untiledFilename = QDir::temp().filePath("vescl_labels_untiled.raw").toStdString();
+    std::string tiledFilename = QDir::temp().filePath("vescl_labels_tiled.raw").toStdString();
+    GL_Exporter exporter(&model);
+    exporter.exportSegmentation(untiledFilename.c_str(), 1, GL_Exporter::ExportType::LabelMap);
+    exporter.setTileSize(128);
+    exporter.exportSegmentation(tiledFilename.c_str(), 1, GL_Exporter::ExportType::LabelMap);
+
+    size_t numPixels = (size_t)model.imageWidth() * model.imageHeight();
+    std::vector<uint16_t> untiled, tiled;
+    bool isRead = readRawLabels(untiledFilename, numPixels, untiled) && readRawLabels(tiledFilename, numPixels, tiled);
+    std::remove(untiledFilename.c_str());
+    std::remove(tiledFilename.c_str());
+    size_t numMismatched = 0;
+    if (isRead) {
+        for (size_t i = 0; i < numPixels; i++) numMismatched += (untiled[i] != tiled[i]) ? 1 : 0;
+    }
+    bool isMatched = isRead && numMismatched == 0;
+
+    out << std::endl << "Tiled label map, " << exporter.numTiles() << " tiles, " << exporter.numSkippedTiles() <<
+        " skipped: ";
+    if (!isRead) out << "export failed" << std::endl;
+    else out << numMismatched << " pixels differ from the untiled export" << std::endl;
+    return isMatched;
+}
+bool RenderBenchmark::readRawLabels(const std::string& filename, size_t numPixels, std::vector<uint16_t>& labels)
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+    labels.resize(numPixels);
+    file.read((char*)labels.data(), numPixels * sizeof(uint16_t));
+    return file.gcount() == (std::streamsize)(numPixels * sizeof(uint16_t));
+}
+
+double RenderBenchmark::median(std::vector<double> values)
+{
+    if (values.size() == 0) return 0;
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+const char* RenderBenchmark::typeName(GL_ContourRenderer::RendererType type)
+{
+    switch (type) {
+    case GL_ContourRenderer::RendererType::Centerline: return "Centerline";
+    case GL_ContourRenderer::RendererType::Binary: return "Binary";
+    case GL_ContourRenderer::RendererType::DistToContour: return "DistToContour";
+    case GL_ContourRenderer::RendererType::DistToCenterline: return "DistToCenterline";
+    case GL_ContourRenderer::RendererType::Antialiased: return "Antialiased";
+    case GL_ContourRenderer::RendererType::Default:
+    default: return "Default";
+    }
+}
+const char* RenderBenchmark::typeName(CPU_ContourRenderer::RendererType type)
+{
+    switch (type) {
+    case CPU_ContourRenderer::RendererType::Centerline: return "CPU Centerline";
+    case CPU_ContourRenderer::RendererType::Binary: return "CPU Binary";
+    case CPU_ContourRenderer::RendererType::Antialiased:
+    default: return "CPU Antialiased";
+    }
+}
@@ -0,0 +1,86 @@
+//
+// RenderBenchmark.h
+// Headless stress benchmark of the OpenGL image and contour renderers. Renders
+// synthetic contours of up to 100k curves and 1M sampled points into an offscreen 
+// surface and times geometry creation, drawing and readback for each renderer type at
+// several window sizes and zoom levels.
+// 
+// Runs on any OpenGL 2.1+ driver, including Mesa llvmpipe on machines without a GPU 
+// (e.g., LIBGL_ALWAYS_SOFTWARE=1 under Xvfb, or with -platform offscreen).
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "../Model/Curve.h"
+#include "../View/GL_ContourRenderer.h"
+#include "../View/CPU_ContourRenderer.h"
+
+#include <QOpenGLFunctions>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+class RenderBenchmark : protected QOpenGLFunctions
+{
+public:
+    RenderBenchmark();
+    ~RenderBenchmark();
+
+    // Writes the report to out. Returns false if OpenGL could not be set up, the CPU
+    // renderer does not match the OpenGL renderer or a tiled label map does not match an
+    // untiled one. A QGuiApplication must exist.
+    bool run(std::ostream& out);
+
+private:
+    bool setupGL();
+    QOpenGLContext m_context;
+    QOffscreenSurface m_surface;
+
+    // Timings are the median of m_numRepetitions runs after a warm-up run
+    int m_numRepetitions;
+    std::vector<int> m_windowSizes;
+    std::vector<float> m_zoomLevels;
+    int m_contourExtent;
+
+    typedef struct {
+        int numCurves;
+        int numPointsPerCurve;
+    } ContourSize;
+    std::vector<ContourSize> m_contourSizes;
+    std::list<Curve::PointVector> syntheticContour(const ContourSize& size, unsigned int seed);
+
+    void benchmarkContourRenderer(std::ostream& out, GL_ContourRenderer::RendererType type,
+        const ContourSize& size, const std::list<Curve::PointVector>& curvePoints);
+    void benchmarkImageRenderer(std::ostream& out);
+
+    // CPU coverage may differ from OpenGL coverage by rounding, which can flip binary 
+    // pixels exactly on stroke edges
+    float m_maxCoverageDifference;
+    float m_maxMismatchedFraction;
+    bool compareCPURenderer(std::ostream& out, CPU_ContourRenderer::RendererType type,
+        const ContourSize& size, const std::list<Curve::PointVector>& curvePoints);
+
+    // Label maps exported in tiles must match the same export rendered in one pass
+    bool compareTiledLabelMap(std::ostream& out);
+    static bool readRawLabels(const std::string& filename, size_t numPixels, std::vector<uint16_t>& labels);
+    static double median(std::vector<double> values);
+    static const char* typeName(GL_ContourRenderer::RendererType type);
+    static const char* typeName(CPU_ContourRenderer::RendererType type);
+};
@@ -0,0 +1,166 @@
+//
+// TraceReplay.cpp
+// Implementation of TraceReplay.
+//
+
+#include "TraceReplay.h"
+#include "../Controller/InteractionTrace.h"
+#include "../Controller/RenderState.h"
+#include "../Model/Model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+    double usecsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+}
+
+// 
+// Public
+//
+bool TraceReplay::run(const std::vector<std::string>& filenames, std::ostream& out, int numRepetitions)
+{
+    bool isOK = true;
+    out << "VESCL interaction trace replay" << std::endl;
+    for (const std::string& filename : filenames) {
+        InteractionTrace trace;
+        if (!trace.load(QString::fromStdString(filename))) {
+            out << filename << ": can't load trace" << std::endl;
+            isOK = false;
+            continue;
+        }
+        const std::vector<InteractionTrace::Event>& events = trace.events();
+        double duration = events.empty() ? 0 : events.back().time / 1.0e6;
+        out << std::endl << filename << ": " << events.size() << " events, " << 
+            std::fixed << std::setprecision(1) << duration << " s recorded, " << 
+            numRepetitions << " replays" << std::defaultfloat << std::endl;
+
+        // Replays must be deterministic
+        std::vector<double> latencies[NumOperations];
+        std::string firstContour;
+        bool isDeterministic = true;
+        for (int i = 0; i < numRepetitions; i++) {
+            std::string contour = replay(trace, latencies);
+            if (i == 0) firstContour = contour;
+            else if (contour != firstContour) isDeterministic = false;
+        }
+        if (!isDeterministic) {
+            out << "Replays gave different contours" << std::endl;
+            isOK = false;
+        }
+
+        out << std::left << std::setw(14) << "Operation" << std::setw(10) << "Count" <<
+            std::setw(10) << "p50 us" << std::setw(10) << "p90 us" << std::setw(10) << 
+            "p99 us" << "max us" << std::endl;
+        for (int op = 0; op < NumOperations; op++) {
+            std::vector<double>& values = latencies[op];
+            if (values.empty()) continue;
+            out << std::left << std::setw(14) << operationName(op) << std::setw(10) << 
+                values.size() / numRepetitions << std::fixed << std::setprecision(1) << 
+                std::setw(10) << percentile(values, 0.5) << std::setw(10) << 
+                percentile(values, 0.9) << std::setw(10) << percentile(values, 0.99) << 
+                percentile(values, 1.0) << std::defaultfloat << std::endl;
+        }
+    }
+    return isOK;
+}
+
+// 
+// Private
+//
+const char* TraceReplay::operationName(int operation)
+{
+    switch (operation) {
+    case StartDraw: return "startDraw";
+    case UpdateDraw: return "updateDraw";
+    case EndDraw: return "endDraw";
+    case Select: return "select";
+    default: return "";
+    }
+}
+
+std::string TraceReplay::replay(const InteractionTrace& trace, std::vector<double> latencies[NumOperations])
+{
+    RenderState renderState;
+    Model model(&renderState);
+    if (!trace.initialContour().empty()) {
+        std::istringstream contourStream(trace.initialContour());
+        model.contour()->readFromFile(contourStream);
+    }
+    renderState.centerImageInViewport(trace.imageWidth(), trace.imageHeight());
+
+    // Mirrors the mapping of mouse input to model operations in GL_View. Pan, zoom and
+    // windowing only change the view, which is restored from the recorded view events.
+    enum class Action { None, Draw, View };
+    Action action = Action::None;
+    QSize windowSize;
+    float cursorRadius = 0;
+    for (const InteractionTrace::Event& event : trace.events()) {
+        if (event.type == InteractionTrace::EventType::View) {
+            if (event.windowSize != windowSize) {
+                windowSize = event.windowSize;
+                renderState.resetProjectionMatrix(windowSize.width(), windowSize.height());
+            }
+            renderState.setWorldToView(event.worldToView);
+            cursorRadius = event.cursorRadius;
+            continue;
+        }
+        if (event.type == InteractionTrace::EventType::Wheel) continue;
+
+        QVector3D pWindow((float)event.pos.x(), (float)(windowSize.height() - event.pos.y()), 0);
+        QVector3D pImage = renderState.convertWindowToImage(pWindow);
+        CurvePoint point(Math::Vec2D(pImage[0], pImage[1]), cursorRadius * renderState.windowToContourScale());
+        Clock::time_point start = Clock::now();
+        switch (event.type) {
+        case InteractionTrace::EventType::Press:
+            if ((event.buttons & InteractionTrace::LeftButton) && event.modifiers) {
+                action = Action::View;
+            }
+            else if (event.buttons & InteractionTrace::LeftButton) {
+                action = Action::Draw;
+                model.startDraw(point);
+                latencies[StartDraw].push_back(usecsSince(start));
+            }
+            else if (event.buttons & InteractionTrace::RightButton) {
+                action = Action::None;
+                float p[2] = { pImage[0], pImage[1] };
+                model.select(p);
+                latencies[Select].push_back(usecsSince(start));
+            }
+            break;
+        case InteractionTrace::EventType::Move:
+            if (action == Action::Draw) {
+                model.updateDraw(point);
+                latencies[UpdateDraw].push_back(usecsSince(start));
+            }
+            break;
+        case InteractionTrace::EventType::Release:
+            if (action == Action::Draw) {
+                model.endDraw(point);
+                latencies[EndDraw].push_back(usecsSince(start));
+            }
+            action = Action::None;
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::ostringstream contourStream;
+    model.contour()->writeToFile(contourStream);
+    return contourStream.str();
+}
+
+double TraceReplay::percentile(std::vector<double>& values, double fraction)
+{
+    if (values.size() == 0) return 0;
+    size_t idx = std::min(values.size() - 1, (size_t)(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + idx, values.end());
+    return values[idx];
+}
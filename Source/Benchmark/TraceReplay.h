@@ -0,0 +1,45 @@
+//
+// TraceReplay.h
+// Replays recorded interaction traces (see InteractionTrace) into a headless Model and 
+// reports the latency of the model updates triggered by each event type. Events are 
+// replayed as fast as possible, so results don't depend on the recorded timing.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class InteractionTrace;
+
+class TraceReplay
+{
+public:
+    // Replays each trace numRepetitions times and writes a report to out. Returns false 
+    // if a trace can't be loaded or if repeated replays give different contours.
+    static bool run(const std::vector<std::string>& filenames, std::ostream& out, 
+        int numRepetitions = 5);
+
+private:
+    enum Operation { StartDraw, UpdateDraw, EndDraw, Select, NumOperations };
+    static const char* operationName(int operation);
+
+    // Appends the latency of each operation in usecs and returns the final contour in
+    // the .vscl contour format
+    static std::string replay(const InteractionTrace& trace, std::vector<double> latencies[NumOperations]);
+    static double percentile(std::vector<double>& values, double fraction);
+};
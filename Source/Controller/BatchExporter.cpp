@@ -0,0 +1,201 @@
+//
+// BatchExporter.cpp
+// Implementation of BatchExporter.
+//
+
+#include "BatchExporter.h"
+#include "RenderState.h"
+#include "../Model/Model.h"
+#include "../Util/Parallel.h"
+
+#include <QThread>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+	double msecsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+}
+
+//
+// Public
+//
+bool BatchExporter::parseArguments(const std::vector<std::string>& args, Spec* spec,
+	std::vector<std::string>* filenames, std::ostream& out)
+{
+	try {
+		for (size_t i = 0; i < args.size(); i++) {
+			const std::string& arg = args[i];
+			if (arg.compare(0, 2, "--") != 0) {
+				filenames->push_back(arg);
+				continue;
+			}
+			if (i + 1 >= args.size() && arg != "--exact" && arg != "--cpu") {
+				throw std::runtime_error("Missing value for " + arg);
+			}
+			if (arg == "--type") {
+				const std::string& type = args[++i];
+				if (type == "binary") spec->type = GL_Exporter::ExportType::Binary;
+				else if (type == "antialiased") spec->type = GL_Exporter::ExportType::AntialiasedMask;
+				else if (type == "vessel-distance") spec->type = GL_Exporter::ExportType::DistToVesselEdge;
+				else if (type == "centerline-distance") spec->type = GL_Exporter::ExportType::DistToCenterline;
+				else if (type == "all") spec->type = GL_Exporter::ExportType::AllProducts;
+				else if (type == "labels") spec->type = GL_Exporter::ExportType::LabelMap;
+				else if (type == "image") spec->type = GL_Exporter::ExportType::SourceImage;
+				else throw std::runtime_error("Unknown export type " + type);
+			}
+			else if (arg == "--bits") {
+				const std::string& bits = args[++i];
+				if (bits == "8") spec->format = GL_Exporter::PixelFormat::RGBA8;
+				else if (bits == "16") spec->format = GL_Exporter::PixelFormat::UInt16;
+				else if (bits == "32") spec->format = GL_Exporter::PixelFormat::Float32;
+				else throw std::runtime_error("Unsupported bits per pixel " + bits);
+			}
+			else if (arg == "--scale") spec->imageToExportScale = std::stof(args[++i]);
+			else if (arg == "--max-distance") spec->maxDistance = std::stof(args[++i]);
+			else if (arg == "--workers") spec->numWorkers = std::stoi(args[++i]);
+			else if (arg == "--output") spec->outputDirectory = args[++i];
+			else if (arg == "--exact") spec->isExactDistance = true;
+			else if (arg == "--cpu") spec->backend = GL_Exporter::Backend::CPU;
+			else throw std::runtime_error("Unknown option " + arg);
+		}
+		if (filenames->empty()) {
+			throw std::runtime_error("No files to export.");
+		}
+		if (spec->imageToExportScale <= 0 || spec->maxDistance <= 0) {
+			throw std::runtime_error("Scale and max distance must be positive.");
+		}
+	}
+	catch (const std::exception& e) {
+		out << "Exception " << e.what() << std::endl;
+		printUsage(out);
+		return false;
+	}
+	return true;
+}
+
+bool BatchExporter::run(const Spec& spec, const std::vector<std::string>& filenames, std::ostream& out)
+{
+	int numFiles = (int)filenames.size();
+	int numWorkers = (spec.numWorkers > 0) ? spec.numWorkers : Parallel::numThreads();
+	numWorkers = std::max(1, std::min(numWorkers, numFiles));
+	out << "VESCL batch export: " << numFiles << " files, " << numWorkers << " workers" << std::endl;
+	if (!spec.outputDirectory.empty()) QDir().mkpath(QString::fromStdString(spec.outputDirectory));
+
+	// Offscreen surfaces must be created on the main thread, so each exporter creates its
+	// context here and then hands it to its worker. Workers take the next unexported file
+	// until none remain and give the context back when done.
+	std::atomic<int> nextFile(0);
+	std::vector<char> isExported(numFiles, 0);
+	std::vector<double> exportTimes(numFiles, 0);
+	std::vector<GL_Exporter*> exporters;
+	std::vector<QThread*> threads;
+	QThread* mainThread = QThread::currentThread();
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < numWorkers; i++) {
+		GL_Exporter* exporter = new GL_Exporter(nullptr);
+		exporter->setBackend(spec.backend);
+		exporter->setMaxDistance(spec.maxDistance);
+		exporter->setExactDistances(spec.isExactDistance);
+		if (!exporter->initialize() && spec.backend == GL_Exporter::Backend::Auto) {
+			if (i == 0) out << "OpenGL is not available. Exporting with the CPU renderer." << std::endl;
+			exporter->setBackend(GL_Exporter::Backend::CPU);
+		}
+		QThread* thread = QThread::create([&, exporter]() {
+			for (int idx = nextFile++; idx < numFiles; idx = nextFile++) {
+				Clock::time_point fileStart = Clock::now();
+				isExported[idx] = exportFile(exporter, spec, filenames[idx]);
+				exportTimes[idx] = msecsSince(fileStart);
+			}
+			exporter->releaseResources();
+			exporter->moveToThread(mainThread);
+		});
+		exporter->moveToThread(thread);
+		exporters.push_back(exporter);
+		threads.push_back(thread);
+	}
+	double setupTime = msecsSince(start);
+	for (QThread* thread : threads) thread->start();
+	for (QThread* thread : threads) thread->wait();
+	double totalTime = msecsSince(start);
+	for (QThread* thread : threads) delete thread;
+	for (GL_Exporter* exporter : exporters) delete exporter;
+
+	int numFailed = 0;
+	for (int i = 0; i < numFiles; i++) {
+		if (isExported[i]) continue;
+		out << filenames[i] << ": export failed" << std::endl;
+		numFailed++;
+	}
+	std::vector<double> times = exportTimes;
+	std::sort(times.begin(), times.end());
+	out << std::fixed << std::setprecision(1) << "Exported " << numFiles - numFailed << " of " <<
+		numFiles << " files in " << totalTime / 1000 << " s (" << setupTime << " ms setup), " <<
+		numFiles / std::max(1e-3, totalTime / 1000) << " files/s, median " << times[times.size() / 2] <<
+		" ms per file" << std::defaultfloat << std::endl;
+	return (numFailed == 0);
+}
+
+//
+// Private
+//
+std::string BatchExporter::outputFilename(const Spec& spec, const std::string& filename)
+{
+	QFileInfo info(QString::fromStdString(filename));
+	QString directory = spec.outputDirectory.empty() ? info.path() : QString::fromStdString(spec.outputDirectory);
+	QString suffix = (spec.format == GL_Exporter::PixelFormat::Float32) ? "tif" : "png";
+	return QDir(directory).filePath(info.completeBaseName() + "." + suffix).toStdString();
+}
+std::vector<std::string> BatchExporter::expectedFiles(const Spec& spec, const std::string& outputFilename)
+{
+	if (spec.type != GL_Exporter::ExportType::AllProducts) return { outputFilename };
+	return { GL_Exporter::productFilename(outputFilename.c_str(), "binary"),
+		GL_Exporter::productFilename(outputFilename.c_str(), "vessel_distance"),
+		GL_Exporter::productFilename(outputFilename.c_str(), "centerline_distance") };
+}
+
+bool BatchExporter::exportFile(GL_Exporter* exporter, const Spec& spec, const std::string& filename)
+{
+	RenderState renderState;
+	Model model(&renderState);
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	model.load(file);
+	if (!model.imageIsValid()) return false;
+
+	// The exporter reports errors without returning them, so outputs are removed first
+	// and checked afterwards
+	std::string output = outputFilename(spec, filename);
+	std::vector<std::string> outputs = expectedFiles(spec, output);
+	for (const std::string& name : outputs) QFile::remove(QString::fromStdString(name));
+	exporter->setModel(&model);
+	exporter->exportSegmentation(output.c_str(), spec.imageToExportScale, spec.type, spec.format);
+	exporter->setModel(nullptr);
+	for (const std::string& name : outputs) {
+		QFileInfo info(QString::fromStdString(name));
+		if (!info.exists() || info.size() == 0) return false;
+	}
+	return true;
+}
+
+void BatchExporter::printUsage(std::ostream& out)
+{
+	out << "Usage: VESCL --batch-export [options] file.vscl ..." << std::endl <<
+		"  --type binary|antialiased|vessel-distance|centerline-distance|all|labels|image" << std::endl <<
+		"  --bits 8|16|32       8- and 16-bit PNG, or 32-bit float TIFF" << std::endl <<
+		"  --scale s            export size relative to the image size (default 1)" << std::endl <<
+		"  --max-distance d     distance range in image pixels (default 10)" << std::endl <<
+		"  --exact              exact, unbounded distances computed on the CPU" << std::endl <<
+		"  --cpu                render with the CPU instead of OpenGL" << std::endl <<
+		"  --workers n          worker threads (default one per hardware thread)" << std::endl <<
+		"  --output dir         output directory (default next to each file)" << std::endl;
+}
@@ -0,0 +1,60 @@
+//
+// BatchExporter.h
+// Exports segmentations of many .vscl files without opening the user interface. Files 
+// are shared between worker threads, each holding one persistent GL_Exporter whose 
+// offscreen context, shader programs and render targets are reused across files.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "../View/GL_Exporter.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class BatchExporter
+{
+public:
+    // Export parameters shared by all files. Zero workers uses one per hardware thread.
+    struct Spec {
+        GL_Exporter::ExportType type = GL_Exporter::ExportType::Binary;
+        GL_Exporter::PixelFormat format = GL_Exporter::PixelFormat::RGBA8;
+        GL_Exporter::Backend backend = GL_Exporter::Backend::Auto;
+        float imageToExportScale = 1;
+        float maxDistance = 10;
+        bool isExactDistance = false;
+        int numWorkers = 0;
+        std::string outputDirectory;
+    };
+
+    // Parses the arguments following --batch-export, i.e., options and then .vscl files. 
+    // Writes usage to out and returns false if the arguments are invalid.
+    static bool parseArguments(const std::vector<std::string>& args, Spec* spec, 
+        std::vector<std::string>* filenames, std::ostream& out);
+
+    // Writes a report to out. Returns false if any file could not be exported. A 
+    // QGuiApplication must exist. On Linux servers without a display, run with 
+    // -platform offscreen, or -platform eglfs for surfaceless EGL contexts.
+    static bool run(const Spec& spec, const std::vector<std::string>& filenames, std::ostream& out);
+
+private:
+    // Outputs are named after the input file, with the extension chosen by pixel format
+    static std::string outputFilename(const Spec& spec, const std::string& filename);
+    static std::vector<std::string> expectedFiles(const Spec& spec, const std::string& outputFilename);
+    static bool exportFile(GL_Exporter* exporter, const Spec& spec, const std::string& filename);
+    static void printUsage(std::ostream& out);
+};
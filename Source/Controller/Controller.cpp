@@ -1,423 +1,831 @@
-//
-// Controller.cpp
-// Implementation of Controller.
-// 
-
-#include "Controller.h"
-#include "ExportDialog.h"
-#include "RenderState.h"
-#include "../View/GL_View.h"
-#include "../View/GL_Exporter.h"
-#include "../Model/Model.h"
-#include "../Model/ImageFilterer.h"
-#include "../Model/ImageConverter.h"
-
-#include<iostream>
-#include<fstream>
-
-// 
-// Public
-//
-Controller::Controller(QWidget* parent) :
-	QMainWindow(parent),
-	m_model(nullptr),
-	m_view(nullptr) 
-{
-	try {
-		// Create the model and the view 
-		m_model = new Model(&m_renderState);
-		m_view = new GL_View(m_model, &m_renderState);
-
-		// Create the main window for the controller
-		createMainWindow(m_view);
-
-		// Set initial colors for the contour and cursor
-		QColor contorColor(253, 223, 103, 150);
-		setContourColors(contorColor);
-	}
-	catch (const std::exception& e) {
-		std::cout << "Exception " << "Error creating main window." << e.what() << std::endl;
-	}
-}
-Controller::~Controller()
-{
-	delete m_view;
-	delete m_model;
-}
-
-void Controller::createMainWindow(GL_View* view)
-{
-	setWindowTitle(tr("2D Vessel Contouring"));
-	resize(600, 600);
-
-	// Main window components and layouts
-	QWidget* centralWidget = new QWidget;
-	setCentralWidget(centralWidget);
-
-	// OpenGL window
-	QVBoxLayout* centralLayout = new QVBoxLayout(centralWidget);
-	centralLayout->addWidget(m_view);
-
-	// Menu
-	QMenuBar* menuBar = new QMenuBar;
-	setMenuBar(menuBar);
-
-	// File menu
-	QMenu* menuFile = menuBar->addMenu(tr("&File"));
-	m_newAction.setText(tr("New"));
-	m_openAction.setText(tr("Open"));
-	m_saveAction.setText(tr("Save"));
-	m_exportAction.setText(tr("Export"));
-	m_exitAction.setText(tr("Exit"));
-	m_newAction.setShortcut(QKeySequence::New);
-	m_openAction.setShortcut(QKeySequence::Open);
-	m_saveAction.setShortcut(QKeySequence::Save);
-	m_exitAction.setShortcut(QKeySequence(Qt::Key_Escape));
-	menuFile->addAction(&m_newAction);
-	menuFile->addAction(&m_openAction);
-	menuFile->addSeparator();
-	menuFile->addAction(&m_saveAction);
-	menuFile->addAction(&m_exportAction);
-	menuFile->addSeparator();
-	menuFile->addAction(&m_exitAction);
-	connect(&m_newAction, &QAction::triggered, this, &Controller::onNew);
-	connect(&m_openAction, &QAction::triggered, this, &Controller::onOpen);
-	connect(&m_saveAction, &QAction::triggered, this, &Controller::onSave);
-	connect(&m_exportAction, &QAction::triggered, this, &Controller::onExport);
-	connect(&m_exitAction, &QAction::triggered, this, &Controller::onExit);
-
-	// Image menu
-	QMenu* menuImage = menuBar->addMenu(tr("&Image"));
-	m_resetWindowingAction.setText(tr("Reset brightness and contrast"));
-	m_toggleImageInterpolationAction.setCheckable(true);
-	m_toggleImageInterpolationAction.setChecked(false);
-	m_toggleImageInterpolationAction.setText(tr("Image smoothing"));
-	m_toggleImageFormatAction.setCheckable(true);
-	m_toggleImageFormatAction.setChecked(false);
-	m_toggleImageFormatAction.setText(tr("Look for light vessels"));
-	menuImage->addAction(&m_resetWindowingAction);
-	menuImage->addAction(&m_toggleImageInterpolationAction);
-	menuImage->addSeparator();
-	menuImage->addAction(&m_toggleImageFormatAction);
-	connect(&m_resetWindowingAction, &QAction::triggered, this, &Controller::onResetWindowing);
-	connect(&m_toggleImageInterpolationAction, &QAction::triggered, this, &Controller::onToggleImageInterpolation);
-	connect(&m_toggleImageFormatAction, &QAction::triggered, this, &Controller::onToggleImageFormat);
-
-	// Contour menu
-	QMenu* menuContour = menuBar->addMenu(tr("&Contour"));
-	m_deselectAction.setText(tr("Deselect"));
-	m_deleteSelectedAction.setText(tr("Delete selected"));
-	m_clearContourAction.setText(tr("Delete all"));
-	m_setContourColorAction.setText(tr("Set contour color"));
-	m_toggleVisibilityAction.setCheckable(true);
-	m_toggleVisibilityAction.setChecked(true);
-	m_toggleVisibilityAction.setText(tr("Visibility on"));
-	m_fitSelectedToVesselAction.setText(tr("Fit selected to vessel"));
-	m_fitWidthOfSelectedAction.setText(tr("Set width of selected"));
-	m_deselectAction.setShortcut(QKeySequence(Qt::Key_D));
-	m_deleteSelectedAction.setShortcut(QKeySequence::Delete);
-	m_toggleVisibilityAction.setShortcut(QKeySequence(Qt::Key_V));
-	m_fitSelectedToVesselAction.setShortcut(QKeySequence(Qt::Key_F));
-	m_fitWidthOfSelectedAction.setShortcut(QKeySequence(Qt::Key_W));
-	menuContour->addAction(&m_deselectAction);
-	menuContour->addAction(&m_deleteSelectedAction);
-	menuContour->addAction(&m_clearContourAction);
-	menuContour->addSeparator();
-	menuContour->addAction(&m_setContourColorAction);
-	menuContour->addAction(&m_toggleVisibilityAction);
-	menuContour->addSeparator();
-	menuContour->addAction(&m_fitSelectedToVesselAction);
-	menuContour->addAction(&m_fitWidthOfSelectedAction);
-	connect(&m_deselectAction, &QAction::triggered, this, &Controller::onDeselect);
-	connect(&m_deleteSelectedAction, &QAction::triggered, this, &Controller::onDeleteSelected);
-	connect(&m_clearContourAction, &QAction::triggered, this, &Controller::onClearContour);
-	connect(&m_setContourColorAction, &QAction::triggered, this, &Controller::onSetContourColor);
-	connect(&m_toggleVisibilityAction, &QAction::triggered, this, &Controller::onToggleContourVisibility);
-	connect(&m_fitSelectedToVesselAction, &QAction::triggered, this, &Controller::onFitSelectedToVessel);
-	connect(&m_fitWidthOfSelectedAction, &QAction::triggered, this, &Controller::onFitWidthOfSelected);
-
-	// View menu
-	QMenu* menuView = menuBar->addMenu(tr("&View"));
-	m_resetViewAction.setText(tr("Reset view"));
-	m_resetViewAction.setShortcut(QKeySequence(Qt::Key_R));
-	menuView->addAction(&m_resetViewAction);
-	connect(&m_resetViewAction, &QAction::triggered, this, &Controller::onResetView);
-
-	// Help menu
-	QMenu* menuHelp = menuBar->addMenu(tr("&Help"));
-	m_DisplayShortcutKeysAction.setText(tr("Display shortcuts"));
-	menuHelp->addAction(&m_DisplayShortcutKeysAction);
-	connect(&m_DisplayShortcutKeysAction, &QAction::triggered, this, &Controller::onDisplayShortcutKeys);
-}
-
-//
-// Private slots
-//
-void Controller::onNew()
-{
-	// Import the new image
-	QString filename = QFileDialog::getOpenFileName(0, ("New Image"), ("*.jpg;;*.jpeg;;*.png"), QDir::currentPath());
-	if (!filename.isEmpty() && !filename.isNull()) {
-		std::ifstream file(filename.toStdString().c_str(), std::ios::binary);
-		prepareForLoad();
-		QImage inputImage(filename);
-		ImageConverter ic;
-		ic.imageFromQImage(m_model->image(), inputImage);
-		updateForLoaded();
-	}
-}
-void Controller::onOpen()
-{
-	// Load a saved VESCL file
-	QFileDialog dialog(this);
-	dialog.setFileMode(QFileDialog::ExistingFile);
-	QString filename = QFileDialog::getOpenFileName(0, ("Open"), QDir::currentPath(), tr("*.vscl"));
-	if (!filename.isEmpty() && !filename.isNull()) {
-		std::ifstream file(filename.toStdString().c_str(), std::ios::binary);
-		prepareForLoad();
-		m_model->load(file);
-		updateForLoaded();
-	}
-}
-void Controller::onSave()
-{
-	// Finalize any curve drawing or editing before saving
-	m_model->deselect();
-
-	// Save the image and contour in a VESCL file
-	QFileDialog dialog(this);
-	dialog.setFileMode(QFileDialog::AnyFile);
-	QString filename = QFileDialog::getSaveFileName(0, ("Save"), QDir::currentPath(), tr("*.vscl"));
-	if (!filename.isEmpty() && !filename.isNull()) {
-		if (QFileInfo(filename).suffix() != tr("vscl")) filename.append(".vscl");
-		std::ofstream file(filename.toStdString().c_str(), std::ios::binary);
-		m_model->save(file);
-	}
-}
-void Controller::onExport()
-{
-	// Finalize any curve drawing or editing before exporting
-	m_model->deselect();
-
-	// Get export parameters and export the selected format
-	ExportDialog exportDialog(m_model->imageWidth(), m_model->imageHeight());
-	exportDialog.exec();
-	if (exportDialog.result() == QDialog::Accepted) {
-		float imageToExportScale = exportDialog.imageToExportScale();
-		QString filename = exportDialog.filename();
-		GL_Exporter::ExportType exportType = exportDialog.exportType();
-		GL_Exporter exporter(m_model);
-		exporter.exportSegmentation(filename.toStdString().c_str(), imageToExportScale, exportType);
-	}
-}
-void Controller::onExit()
-{
-	close();
-}
-
-// Image menu
-void Controller::onResetWindowing()
-{
-	m_renderState.setDefaultWindowing();
-	m_renderState.setImageNeedsUpdate(true);
-	m_view->update();
-}
-void Controller::onToggleImageInterpolation(bool interpolate)
-{
-	m_renderState.setImageInterpolation(interpolate);
-	m_renderState.setImageNeedsUpdate(true);
-	m_view->update();
-}
-void Controller::onToggleImageFormat()
-{
-	if (m_model->vesselContrast() == ImageFilterer::VesselContrastType::LightOnDark) {
-		m_model->setVesselContrast(ImageFilterer::VesselContrastType::DarkOnLight);
-		m_toggleImageFormatAction.setText(tr("Light vessels"));
-	}
-	else {
-		m_model->setVesselContrast(ImageFilterer::VesselContrastType::LightOnDark);
-		m_toggleImageFormatAction.setText(tr("Dark vessels"));
-	}
-}
-
-// Contour menu
-void Controller::onDeselect()
-{
-	m_model->deselect();
-	m_renderState.setContourNeedsUpdate(true);
-	m_view->update();
-}
-void Controller::onDeleteSelected()
-{
-	m_model->deleteSelected();
-	m_renderState.setContourNeedsUpdate(true);
-	m_view->update();
-}
-void Controller::onClearContour()
-{
-	m_model->contour()->clear();
-	m_renderState.setContourNeedsUpdate(true);
-	m_view->update();
-}
-void Controller::onSetContourColor()
-{
-	QColor color = QColorDialog::getColor(m_renderState.contourColor(),
-		nullptr, "Contour Color", QColorDialog::ShowAlphaChannel);
-	setContourColors(color);
-}
-void Controller::setContourColors(QColor color)
-{
-	// Use the given color for selected curves
-	m_renderState.setActiveCurveColor(color);
-
-	// Mute the color slightly for curves that are not selected
-	QColor contourColor;
-	contourColor.setHsv(color.hue(), color.saturation(), 0.8 * color.value());
-	contourColor.setAlpha(color.alpha());
-	m_renderState.setContourColor(contourColor);
-
-	m_renderState.setContourNeedsUpdate(true);
-	m_view->setCursorColor(contourColor);
-	m_view->update();
-}
-void Controller::onToggleContourVisibility(bool visible)
-{
-	m_renderState.setContourVisible(visible);
-	m_renderState.setContourNeedsUpdate(true);
-	m_view->update();
-}
-void Controller::onFitSelectedToVessel()
-{
-	float expectedRadius = m_view->cursorRadius() * m_renderState.windowToContourScale();
-	m_model->fitSelectedToNearestVessel(expectedRadius);
-	m_renderState.setActiveCurveNeedsUpdate(true);
-	m_view->update();
-}
-void Controller::onFitWidthOfSelected()
-{
-	float expectedRadius = m_view->cursorRadius() * m_renderState.windowToContourScale();
-	m_model->fitSelectedVesselWidth(expectedRadius);
-	m_renderState.setActiveCurveNeedsUpdate(true);
-	m_view->update();
-}
-
-// View menu
-void Controller::onResetView()
-{
-	float prevWindowToContourScale = m_renderState.windowToContourScale();
-	m_renderState.resetWorldToView();
-	float divisor = std::max(std::numeric_limits<float>::epsilon(), m_renderState.windowToContourScale());
-	float scaleDelta = prevWindowToContourScale / divisor;
-	m_view->setCursorRadius(m_view->cursorRadius() * scaleDelta);
-	m_renderState.setNeedsFullUpdate(true);
-	m_view->update();
-}
-
-// Help menu
-void Controller::onDisplayShortcutKeys()
-{
-	QString shortcutText;
-	shortcutText.append("<b>File management</b> <br />");
-	shortcutText.append("Ctrl+N:  Load new image <br />");
-	shortcutText.append("Ctrl+O:  Open existing contouring file <br />");
-	shortcutText.append("Ctrl+S:  Save current contouring file <br />");
-	shortcutText.append("Esc key:  Exit <br />");
-	shortcutText.append("<br />");
-
-	shortcutText.append("<b>Contour drawing</b> <br />");
-	shortcutText.append("LMB+drag:  Draw new curve/overdraw selected curve <br />");
-	shortcutText.append("Mouse wheel:  Modify brush width<br />");
-	shortcutText.append("<br />");
-
-	shortcutText.append("<b>Contour selection</b> <br />");
-	shortcutText.append("RMB click on curve centerline:  Select curve <br />");
-	shortcutText.append("D:  Deselect currently selected curve <br />");
-	shortcutText.append("Del key:  Delete selected curve <br />");
-	shortcutText.append("<br />");
-
-	shortcutText.append("<b>Contour editing</b> <br />");
-	shortcutText.append("F:  Fit the selected curve to nearest vessel <br />");
-	shortcutText.append("W:  Set vessel widths along selected curve <br />");
-	shortcutText.append("V:  Togle contour visibility on/off <br />");
-	shortcutText.append("<br />");
-
-	shortcutText.append("<b>Image transforms and windowing</b> <br />");
-	shortcutText.append("R:  Re-center image <br />");
-	shortcutText.append("Shift+LMB+drag:  Translate image <br />");
-	shortcutText.append("Ctrl+LMB+drag up/down:  Zoom image in/out<br />");
-	shortcutText.append("Alt+LMB+drag:  Adjust brightness/contrast<br />");
-	shortcutText.append("<br />");
-
-	shortcutText.append("<b>Key:</b> <br />");
-	shortcutText.append("LMB = left mouse button <br />");
-	shortcutText.append("RMB = right mouse button <br />");
-
-	QMessageBox helpSheet;
-	helpSheet.setWindowTitle("Keyboard Shortcuts and Mouse Input");
-	helpSheet.setTextFormat(Qt::RichText);
-	helpSheet.setText(shortcutText);
-	helpSheet.setStandardButtons(QMessageBox::Ok);
-	helpSheet.exec();
-}
-
-
-//
-// Private
-//
-void Controller::prepareForLoad()
-{
-	if (m_model->imageIsValid()) {
-		QMessageBox::StandardButton save = saveQuery();
-		if (save == QMessageBox::Cancel) {
-			return;
-		}
-		else if (save == QMessageBox::Yes) {
-			onSave();
-		}
-	}
-	m_model->clear();
-}
-void Controller::updateForLoaded()
-{
-	// Reset image windowing for rendering
-	float minValue = m_model->imageNormalizedMin();
-	float maxValue = m_model->imageNormalizedMax();
-	m_renderState.setWindowingRange(minValue, maxValue);
-	m_renderState.setDefaultWindowing();
-
-	// Set contour visibility on
-	m_toggleVisibilityAction.setChecked(true);
-	m_renderState.setContourVisible(true);
-
-	// Initialize transforms to center the view in the viewport
-	m_renderState.centerImageInViewport(m_model->imageWidth(), m_model->imageHeight());
-
-	// Update view
-	m_view->initCursor();
-	m_view->setImage(m_model->image());
-	m_renderState.setNeedsFullUpdate(true);
-	m_view->update();
-}
-QMessageBox::StandardButton Controller::saveQuery()
-{
-	return 	QMessageBox::question(this, "VESCL",
-		tr("Save contour?\n"),
-		QMessageBox::Cancel | QMessageBox::No | QMessageBox::Yes,
-		QMessageBox::Yes);
-}
-
-void Controller::closeEvent(QCloseEvent* event)
-{
-	// Save previous work?
-	QMessageBox::StandardButton save = saveQuery();
-	if (save == QMessageBox::Cancel) {
-		event->ignore();
-	}
-	else if (save == QMessageBox::Yes) {
-		onSave();
-		event->accept();
-	}
-	else {
-		event->accept();
-	}
+//
+// Controller.cpp
+// Implementation of Controller.
+// 
+
+#include "Controller.h"
+#include "ExportDialog.h"
+#include "RenderState.h"
+#include "../View/GL_View.h"
+#include "../View/GL_Exporter.h"
+#include "../Model/Model.h"
+#include "../Model/ImageFilterer.h"
+#include "../Model/ImageConverter.h"
+#include "../Util/Profiler.h"
+
+#include<iostream>
+#include<fstream>
+#include<algorithm>
+
+// 
+// Public
+//
+Controller::Controller(QWidget* parent) :
+	QMainWindow(parent),
+	m_model(nullptr),
+	m_view(nullptr),
+	m_exporter(nullptr),
+	m_imageExporter(nullptr),
+	m_isImageStorageChanged(false),
+	m_isClosePending(false),
+	m_isSaveQueried(false)
+{
+	try {
+		// Create the model and the view 
+		m_model = new Model(&m_renderState);
+		m_view = new GL_View(m_model, &m_renderState);
+
+		// Create the main window for the controller
+		createMainWindow(m_view);
+
+		// Set initial colors for the contour and cursor
+		QColor contorColor(253, 223, 103, 150);
+		setContourColors(contorColor);
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << "Error creating main window." << e.what() << std::endl;
+	}
+}
+Controller::~Controller()
+{
+	m_jobs.cancelAll();
+	m_jobs.waitForAll();
+	delete m_exporter;
+	delete m_imageExporter;
+	delete m_view;
+	delete m_model;
+}
+
+void Controller::createMainWindow(GL_View* view)
+{
+	setWindowTitle(tr("2D Vessel Contouring"));
+	resize(600, 600);
+
+	// Main window components and layouts
+	QWidget* centralWidget = new QWidget;
+	setCentralWidget(centralWidget);
+
+	// OpenGL window
+	QVBoxLayout* centralLayout = new QVBoxLayout(centralWidget);
+	centralLayout->addWidget(m_view);
+
+	// Frame slider, shown for image sequences
+	m_frameSlider.setOrientation(Qt::Horizontal);
+	m_frameSlider.setVisible(false);
+	centralLayout->addWidget(&m_frameSlider);
+	connect(&m_frameSlider, &QSlider::valueChanged, this, &Controller::onFrameChanged);
+
+	// Menu
+	QMenuBar* menuBar = new QMenuBar;
+	setMenuBar(menuBar);
+
+	// File menu
+	QMenu* menuFile = menuBar->addMenu(tr("&File"));
+	m_newAction.setText(tr("New"));
+	m_openAction.setText(tr("Open"));
+	m_openSequenceAction.setText(tr("Open image sequence"));
+	m_saveAction.setText(tr("Save"));
+	m_exportAction.setText(tr("Export"));
+	m_exitAction.setText(tr("Exit"));
+	m_useImageStoreAction.setCheckable(true);
+	m_useImageStoreAction.setChecked(false);
+	m_useImageStoreAction.setText(tr("Store images in a shared folder"));
+	m_compressImageAction.setCheckable(true);
+	m_compressImageAction.setChecked(false);
+	m_compressImageAction.setText(tr("Compress saved images"));
+	m_newAction.setShortcut(QKeySequence::New);
+	m_openAction.setShortcut(QKeySequence::Open);
+	m_saveAction.setShortcut(QKeySequence::Save);
+	m_exitAction.setShortcut(QKeySequence(Qt::Key_Escape));
+	menuFile->addAction(&m_newAction);
+	menuFile->addAction(&m_openAction);
+	menuFile->addAction(&m_openSequenceAction);
+	menuFile->addSeparator();
+	menuFile->addAction(&m_saveAction);
+	menuFile->addAction(&m_exportAction);
+	menuFile->addAction(&m_useImageStoreAction);
+	menuFile->addAction(&m_compressImageAction);
+	menuFile->addSeparator();
+	menuFile->addAction(&m_exitAction);
+	connect(&m_newAction, &QAction::triggered, this, &Controller::onNew);
+	connect(&m_openAction, &QAction::triggered, this, &Controller::onOpen);
+	connect(&m_openSequenceAction, &QAction::triggered, this, &Controller::onOpenSequence);
+	connect(&m_saveAction, &QAction::triggered, this, &Controller::onSave);
+	connect(&m_exportAction, &QAction::triggered, this, &Controller::onExport);
+	connect(&m_exitAction, &QAction::triggered, this, &Controller::onExit);
+	connect(&m_useImageStoreAction, &QAction::triggered, this, &Controller::onToggleImageStore);
+	connect(&m_compressImageAction, &QAction::triggered, this, &Controller::onToggleImageCompression);
+
+	// Edit menu
+	QMenu* menuEdit = menuBar->addMenu(tr("&Edit"));
+	m_undoAction.setText(tr("Undo"));
+	m_redoAction.setText(tr("Redo"));
+	m_undoAction.setShortcut(QKeySequence::Undo);
+	m_redoAction.setShortcut(QKeySequence::Redo);
+	menuEdit->addAction(&m_undoAction);
+	menuEdit->addAction(&m_redoAction);
+	connect(&m_undoAction, &QAction::triggered, this, &Controller::onUndo);
+	connect(&m_redoAction, &QAction::triggered, this, &Controller::onRedo);
+
+	// Image menu
+	QMenu* menuImage = menuBar->addMenu(tr("&Image"));
+	m_resetWindowingAction.setText(tr("Reset brightness and contrast"));
+	m_toggleImageInterpolationAction.setCheckable(true);
+	m_toggleImageInterpolationAction.setChecked(false);
+	m_toggleImageInterpolationAction.setText(tr("Image smoothing"));
+	m_toggleImageFormatAction.setCheckable(true);
+	m_toggleImageFormatAction.setChecked(false);
+	m_toggleImageFormatAction.setText(tr("Look for light vessels"));
+	m_nextFrameAction.setText(tr("Next frame"));
+	m_previousFrameAction.setText(tr("Previous frame"));
+	m_nextFrameAction.setShortcut(QKeySequence(Qt::Key_Period));
+	m_previousFrameAction.setShortcut(QKeySequence(Qt::Key_Comma));
+	menuImage->addAction(&m_resetWindowingAction);
+	menuImage->addAction(&m_toggleImageInterpolationAction);
+	menuImage->addSeparator();
+	menuImage->addAction(&m_toggleImageFormatAction);
+	menuImage->addSeparator();
+	menuImage->addAction(&m_nextFrameAction);
+	menuImage->addAction(&m_previousFrameAction);
+	connect(&m_resetWindowingAction, &QAction::triggered, this, &Controller::onResetWindowing);
+	connect(&m_toggleImageInterpolationAction, &QAction::triggered, this, &Controller::onToggleImageInterpolation);
+	connect(&m_toggleImageFormatAction, &QAction::triggered, this, &Controller::onToggleImageFormat);
+	connect(&m_nextFrameAction, &QAction::triggered, this, &Controller::onNextFrame);
+	connect(&m_previousFrameAction, &QAction::triggered, this, &Controller::onPreviousFrame);
+
+	// Contour menu
+	QMenu* menuContour = menuBar->addMenu(tr("&Contour"));
+	m_deselectAction.setText(tr("Deselect"));
+	m_deleteSelectedAction.setText(tr("Delete selected"));
+	m_clearContourAction.setText(tr("Delete all"));
+	m_setContourColorAction.setText(tr("Set contour color"));
+	m_toggleVisibilityAction.setCheckable(true);
+	m_toggleVisibilityAction.setChecked(true);
+	m_toggleVisibilityAction.setText(tr("Visibility on"));
+	m_fitSelectedToVesselAction.setText(tr("Fit selected to vessel"));
+	m_fitWidthOfSelectedAction.setText(tr("Set width of selected"));
+	m_propagateToNextFrameAction.setText(tr("Propagate to next frame"));
+	m_toggleSnapWhileDrawingAction.setCheckable(true);
+	m_toggleSnapWhileDrawingAction.setText(tr("Snap to vessels while drawing"));
+	m_toggleVesselTracingAction.setCheckable(true);
+	m_toggleVesselTracingAction.setText(tr("Trace vessel between two clicks"));
+	m_deselectAction.setShortcut(QKeySequence(Qt::Key_D));
+	m_deleteSelectedAction.setShortcut(QKeySequence::Delete);
+	m_toggleVisibilityAction.setShortcut(QKeySequence(Qt::Key_V));
+	m_fitSelectedToVesselAction.setShortcut(QKeySequence(Qt::Key_F));
+	m_fitWidthOfSelectedAction.setShortcut(QKeySequence(Qt::Key_W));
+	m_toggleSnapWhileDrawingAction.setShortcut(QKeySequence(Qt::Key_S));
+	m_toggleVesselTracingAction.setShortcut(QKeySequence(Qt::Key_T));
+	m_propagateToNextFrameAction.setShortcut(QKeySequence(Qt::Key_P));
+	menuContour->addAction(&m_deselectAction);
+	menuContour->addAction(&m_deleteSelectedAction);
+	menuContour->addAction(&m_clearContourAction);
+	menuContour->addSeparator();
+	menuContour->addAction(&m_setContourColorAction);
+	menuContour->addAction(&m_toggleVisibilityAction);
+	menuContour->addSeparator();
+	menuContour->addAction(&m_fitSelectedToVesselAction);
+	menuContour->addAction(&m_fitWidthOfSelectedAction);
+	menuContour->addAction(&m_toggleSnapWhileDrawingAction);
+	menuContour->addAction(&m_toggleVesselTracingAction);
+	menuContour->addSeparator();
+	menuContour->addAction(&m_propagateToNextFrameAction);
+	connect(&m_deselectAction, &QAction::triggered, this, &Controller::onDeselect);
+	connect(&m_deleteSelectedAction, &QAction::triggered, this, &Controller::onDeleteSelected);
+	connect(&m_clearContourAction, &QAction::triggered, this, &Controller::onClearContour);
+	connect(&m_setContourColorAction, &QAction::triggered, this, &Controller::onSetContourColor);
+	connect(&m_toggleVisibilityAction, &QAction::triggered, this, &Controller::onToggleContourVisibility);
+	connect(&m_fitSelectedToVesselAction, &QAction::triggered, this, &Controller::onFitSelectedToVessel);
+	connect(&m_fitWidthOfSelectedAction, &QAction::triggered, this, &Controller::onFitWidthOfSelected);
+	connect(&m_toggleSnapWhileDrawingAction, &QAction::triggered, this, &Controller::onToggleSnapWhileDrawing);
+	connect(&m_toggleVesselTracingAction, &QAction::triggered, this, &Controller::onToggleVesselTracing);
+	connect(&m_propagateToNextFrameAction, &QAction::triggered, this, &Controller::onPropagateToNextFrame);
+
+	// View menu
+	QMenu* menuView = menuBar->addMenu(tr("&View"));
+	m_resetViewAction.setText(tr("Reset view"));
+	m_resetViewAction.setShortcut(QKeySequence(Qt::Key_R));
+	menuView->addAction(&m_resetViewAction);
+	connect(&m_resetViewAction, &QAction::triggered, this, &Controller::onResetView);
+	m_toggleTraceRecordingAction.setCheckable(true);
+	m_toggleTraceRecordingAction.setChecked(false);
+	m_toggleTraceRecordingAction.setText(tr("Record interaction trace"));
+	menuView->addSeparator();
+	menuView->addAction(&m_toggleTraceRecordingAction);
+	connect(&m_toggleTraceRecordingAction, &QAction::triggered, this, &Controller::onToggleTraceRecording);
+#ifdef VESCL_PROFILING
+	m_toggleProfilerOverlayAction.setCheckable(true);
+	m_toggleProfilerOverlayAction.setChecked(false);
+	m_toggleProfilerOverlayAction.setText(tr("Profiler overlay"));
+	m_toggleProfilerOverlayAction.setShortcut(QKeySequence(Qt::Key_F12));
+	m_saveProfilerTraceAction.setText(tr("Save profiler trace"));
+	menuView->addSeparator();
+	menuView->addAction(&m_toggleProfilerOverlayAction);
+	menuView->addAction(&m_saveProfilerTraceAction);
+	connect(&m_toggleProfilerOverlayAction, &QAction::triggered, this, &Controller::onToggleProfilerOverlay);
+	connect(&m_saveProfilerTraceAction, &QAction::triggered, this, &Controller::onSaveProfilerTrace);
+#endif
+
+	// Help menu
+	QMenu* menuHelp = menuBar->addMenu(tr("&Help"));
+	m_DisplayShortcutKeysAction.setText(tr("Display shortcuts"));
+	menuHelp->addAction(&m_DisplayShortcutKeysAction);
+	connect(&m_DisplayShortcutKeysAction, &QAction::triggered, this, &Controller::onDisplayShortcutKeys);
+
+	// Progress of background jobs, shown while jobs are running
+	m_jobProgressBar.setRange(0, 100);
+	m_jobProgressBar.setMaximumWidth(200);
+	m_cancelJobsButton.setText(tr("Cancel"));
+	statusBar()->addPermanentWidget(&m_jobProgressBar);
+	statusBar()->addPermanentWidget(&m_cancelJobsButton);
+	statusBar()->setVisible(false);
+	m_jobProgressTimer.setInterval(100);
+	connect(&m_cancelJobsButton, &QPushButton::clicked, this, &Controller::onCancelJobs);
+	connect(&m_jobProgressTimer, &QTimer::timeout, this, &Controller::onUpdateJobProgress);
+}
+
+//
+// Private slots
+//
+void Controller::onNew()
+{
+	// Import the new image
+	QString filename = QFileDialog::getOpenFileName(0, ("New Image"), ("*.jpg;;*.jpeg;;*.png"), QDir::currentPath());
+	if (!filename.isEmpty() && !filename.isNull()) {
+		prepareForLoad([this, filename]() {
+			QImage inputImage(filename);
+			ImageConverter ic;
+			ic.imageFromQImage(m_model->image(), inputImage);
+			m_filename.clear();
+			updateForLoaded();
+		});
+	}
+}
+void Controller::onOpen()
+{
+	// Load a saved VESCL file
+	QFileDialog dialog(this);
+	dialog.setFileMode(QFileDialog::ExistingFile);
+	QString filename = QFileDialog::getOpenFileName(0, ("Open"), QDir::currentPath(), tr("*.vscl"));
+	if (!filename.isEmpty() && !filename.isNull()) {
+		prepareForLoad([this, filename]() {
+			// The file is loaded into a separate model in the background, so the view can 
+			// repaint the model, and then moved into the model
+			std::shared_ptr<RenderState> renderState(new RenderState);
+			std::shared_ptr<Model> loaded(new Model(renderState.get()));
+			loaded->setImageStore(m_model->imageStore());
+			setEditingEnabled(false);
+			m_jobs.schedule([loaded, filename](JobScheduler::Job& job) {
+				VESCL_PROFILE_SCOPE("Controller::onOpen", "io");
+				std::ifstream file(filename.toStdString().c_str(), std::ios::binary);
+				loaded->load(file);
+			}, [this, renderState, loaded, filename](bool isCanceled) {
+				setEditingEnabled(true);
+				if (isCanceled) return;
+				m_model->moveFrom(*loaded);
+				m_filename = filename;
+				m_useImageStoreAction.setChecked(!m_model->imageStore().empty());
+				m_compressImageAction.setChecked(m_model->isImageCompressed());
+				m_isImageStorageChanged = false;
+
+				// Recover edits journaled by an interrupted session
+				int numRecovered = m_model->openJournal(filename.toStdString(), true);
+				updateForLoaded();
+				if (numRecovered > 0) {
+					QMessageBox::information(this, "VESCL",
+						tr("Recovered %1 unsaved edits from an interrupted session.").arg(numRecovered));
+				}
+			});
+			showJobProgress();
+		});
+	}
+}
+void Controller::onOpenSequence()
+{
+	// Open the images of a sequence, e.g., exported cine frames, ordered by filename 
+	// with numbers compared by value
+	QStringList filenames = QFileDialog::getOpenFileNames(0, ("Open Image Sequence"), QDir::currentPath(),
+		tr("Images (*.png *.jpg *.jpeg *.tif *.tiff)"));
+	if (filenames.isEmpty()) return;
+	QCollator collator;
+	collator.setNumericMode(true);
+	std::sort(filenames.begin(), filenames.end(), collator);
+
+	// Frames are decoded on demand and prefetched in the background
+	auto decoder = [filenames](int frame, Image& image) {
+		QImage inputImage(filenames[frame]);
+		if (inputImage.isNull()) return false;
+		ImageConverter ic;
+		ic.imageFromQImage(image, inputImage);
+		return image.isValid();
+	};
+	prepareForLoad([this, filenames, decoder]() {
+		if (!m_model->openSequence(filenames.size(), decoder)) {
+			std::cout << "Exception " << "Error reading image sequence." << std::endl;
+		}
+		m_filename.clear();
+		updateForLoaded();
+	});
+}
+void Controller::onSave()
+{
+	// Finalize any curve drawing or editing before saving
+	m_model->deselect();
+
+	// Save the image and contour in a VESCL file
+	QFileDialog dialog(this);
+	dialog.setFileMode(QFileDialog::AnyFile);
+	QString filename = QFileDialog::getSaveFileName(0, ("Save"), 
+		m_filename.isEmpty() ? QDir::currentPath() : m_filename, tr("*.vscl"));
+	if (!filename.isEmpty() && !filename.isNull()) {
+		if (QFileInfo(filename).suffix() != tr("vscl")) filename.append(".vscl");
+
+		// Saving to the open file only rewrites its contour, in the background. Edits are
+		// journaled from then on so they can be recovered after a crash.
+		if (filename == m_filename && !m_isImageStorageChanged && m_model->isJournalOpen() && 
+			m_model->saveIncremental()) return;
+
+		// Full saves run in the background once running jobs are done, without blocking 
+		// meanwhile. The model is only read while editing is disabled.
+		m_jobs.whenAllDone([this, filename]() {
+			setEditingEnabled(false);
+			m_jobs.schedule([this, filename](JobScheduler::Job& job) {
+				std::ofstream file(filename.toStdString().c_str(), std::ios::binary);
+				m_model->save(file);
+			}, [this, filename](bool isCanceled) {
+				setEditingEnabled(true);
+				if (isCanceled) return;
+				m_isImageStorageChanged = false;
+				m_filename = filename;
+				m_model->openJournal(filename.toStdString(), false);
+			});
+			showJobProgress();
+		});
+	}
+}
+void Controller::onExport()
+{
+	// Finalize any curve drawing or editing before exporting
+	m_model->deselect();
+
+	// Get export parameters and export the selected format
+	ExportDialog exportDialog(m_model->imageWidth(), m_model->imageHeight());
+	exportDialog.exec();
+	if (exportDialog.result() == QDialog::Accepted) {
+		float imageToExportScale = exportDialog.imageToExportScale();
+		QString filename = exportDialog.filename();
+		GL_Exporter::ExportType exportType = exportDialog.exportType();
+		GL_Exporter::PixelFormat pixelFormat = exportDialog.pixelFormat();
+
+		// Source images are rendered on this thread from the view's texture rather than
+		// uploaded again. The view's texture may only be used on this thread.
+		if (exportType == GL_Exporter::ExportType::SourceImage) {
+			if (!m_imageExporter) m_imageExporter = new GL_Exporter(m_model);
+			m_imageExporter->setSharedImageTexture(m_view->imageTexture(), m_view->context());
+			m_imageExporter->exportSegmentation(filename.toStdString().c_str(), imageToExportScale, exportType,
+				pixelFormat);
+			return;
+		}
+
+		// Exports run in the background once running jobs are done, without blocking 
+		// meanwhile. The exporter is kept between exports so its context and render 
+		// targets are reused. It runs on worker threads, so its context is in its own share
+		// group, as batch export contexts are, and it uploads its own image texture and 
+		// shader programs.
+		float maxDistance = exportDialog.maxDistance();
+		bool isExactDistance = exportDialog.isExactDistance();
+		m_jobs.whenAllDone([this, filename, imageToExportScale, exportType, pixelFormat, maxDistance, 
+			isExactDistance]() {
+			if (!m_exporter) {
+				m_exporter = new GL_Exporter(m_model);
+				m_exporter->setSharesResources(false);
+			}
+			m_exporter->setMaxDistance(maxDistance);
+			m_exporter->setExactDistances(isExactDistance);
+
+			// The exporter's context is created here because offscreen surfaces must be 
+			// created on the GUI thread. It is released from this thread and taken by the 
+			// worker, which hands it back when done.
+			if (!m_exporter->initialize()) m_exporter->setBackend(GL_Exporter::Backend::CPU);
+			m_exporter->moveToThread(nullptr);
+			QThread* mainThread = QThread::currentThread();
+			GL_Exporter* exporter = m_exporter;
+			setEditingEnabled(false);
+			m_jobs.schedule([exporter, mainThread, filename, imageToExportScale, exportType, pixelFormat](
+				JobScheduler::Job& job) {
+				exporter->moveToThread(QThread::currentThread());
+				exporter->exportSegmentation(filename.toStdString().c_str(), imageToExportScale, exportType,
+					pixelFormat);
+				exporter->moveToThread(mainThread);
+			}, [this](bool isCanceled) {
+				setEditingEnabled(true);
+			});
+			showJobProgress();
+		});
+	}
+}
+void Controller::onExit()
+{
+	close();
+}
+void Controller::onToggleImageStore(bool useStore)
+{
+	// Files saved with an image store hold a reference to the image instead of its data,
+	// so annotations of the same image share one stored copy
+	QString directory;
+	if (useStore) {
+		directory = QFileDialog::getExistingDirectory(this, tr("Image store folder"),
+			QString::fromStdString(m_model->imageStore()));
+	}
+	m_model->setImageStore(directory.toStdString());
+	m_useImageStoreAction.setChecked(!directory.isEmpty());
+	m_isImageStorageChanged = true;
+}
+void Controller::onToggleImageCompression(bool compress)
+{
+	m_model->setImageCompressed(compress);
+	m_isImageStorageChanged = true;
+}
+
+// Image menu
+void Controller::onResetWindowing()
+{
+	m_renderState.setDefaultWindowing();
+	m_renderState.setImageNeedsUpdate(true);
+	m_view->update();
+}
+void Controller::onToggleImageInterpolation(bool interpolate)
+{
+	m_renderState.setImageInterpolation(interpolate);
+	m_renderState.setImageNeedsUpdate(true);
+	m_view->update();
+}
+void Controller::onToggleImageFormat()
+{
+	if (m_model->vesselContrast() == ImageFilterer::VesselContrastType::LightOnDark) {
+		m_model->setVesselContrast(ImageFilterer::VesselContrastType::DarkOnLight);
+		m_toggleImageFormatAction.setText(tr("Light vessels"));
+	}
+	else {
+		m_model->setVesselContrast(ImageFilterer::VesselContrastType::LightOnDark);
+		m_toggleImageFormatAction.setText(tr("Dark vessels"));
+	}
+}
+
+// Edit menu
+void Controller::onUndo()
+{
+	m_model->undo();
+	m_view->update();
+}
+void Controller::onRedo()
+{
+	m_model->redo();
+	m_view->update();
+}
+
+void Controller::onFrameChanged(int frame)
+{
+	// The slider is reset if the frame can't be shown, e.g., while drawing
+	VESCL_PROFILE_SCOPE("Controller::onFrameChanged", "io");
+	if (frame == m_model->frame()) return;
+	m_jobs.cancelAll();
+	m_jobs.whenAllDone([this, frame]() {
+		if (!m_model->setFrame(frame)) {
+			updateFrameSlider();
+			return;
+		}
+
+		// Saving the new frame must write its image, so it is not saved to the file that 
+		// was opened or saved for the previous frame
+		m_filename.clear();
+		m_view->setFrame(frame, m_model->image());
+	});
+}
+void Controller::onNextFrame()
+{
+	if (m_model->numFrames() > 1) m_frameSlider.setValue(m_model->frame() + 1);
+}
+void Controller::onPreviousFrame()
+{
+	if (m_model->numFrames() > 1) m_frameSlider.setValue(m_model->frame() - 1);
+}
+
+// Contour menu
+void Controller::onDeselect()
+{
+	m_model->deselect();
+	m_renderState.setContourNeedsUpdate(true);
+	m_view->update();
+}
+void Controller::onDeleteSelected()
+{
+	m_model->deleteSelected();
+	m_renderState.setContourNeedsUpdate(true);
+	m_view->update();
+}
+void Controller::onClearContour()
+{
+	m_model->clearContour();
+	m_renderState.setContourNeedsUpdate(true);
+	m_view->update();
+}
+void Controller::onSetContourColor()
+{
+	QColor color = QColorDialog::getColor(m_renderState.contourColor(),
+		nullptr, "Contour Color", QColorDialog::ShowAlphaChannel);
+	setContourColors(color);
+}
+void Controller::setContourColors(QColor color)
+{
+	// Use the given color for selected curves
+	m_renderState.setActiveCurveColor(color);
+
+	// Mute the color slightly for curves that are not selected
+	QColor contourColor;
+	contourColor.setHsv(color.hue(), color.saturation(), 0.8 * color.value());
+	contourColor.setAlpha(color.alpha());
+	m_renderState.setContourColor(contourColor);
+
+	m_renderState.setContourNeedsUpdate(true);
+	m_view->setCursorColor(contourColor);
+	m_view->update();
+}
+void Controller::onToggleContourVisibility(bool visible)
+{
+	m_renderState.setContourVisible(visible);
+	m_renderState.setContourNeedsUpdate(true);
+	m_view->update();
+}
+void Controller::onFitSelectedToVessel()
+{
+	// The selected curve is fitted in the background and shown after each try. The fit is
+	// canceled if the curve is edited meanwhile or another fit is started.
+	float expectedRadius = m_view->cursorRadius() * m_renderState.windowToContourScale();
+	int idCurve = m_model->contour()->idActiveCurve();
+	std::shared_ptr<unsigned int> revision(new unsigned int(0));
+	std::vector<CurvePoint> points = m_model->curvePoints(idCurve, revision.get());
+	if (points.empty()) return;
+	if (m_fitJob) m_fitJob->cancel();
+	std::shared_ptr<std::vector<CurvePoint>> fitted(new std::vector<CurvePoint>);
+	m_fitJob = m_jobs.schedule([this, points, expectedRadius, idCurve, revision, fitted](JobScheduler::Job& job) {
+		VESCL_PROFILE_SCOPE("Controller::onFitSelectedToVessel", "fit");
+		*fitted = m_model->fitToNearestVessel(points, expectedRadius, 
+			[this, &job, idCurve, revision](const std::vector<CurvePoint>& partial, float progress) {
+			job.setProgress(progress);
+			job.publish([this, &job, idCurve, revision, partial]() {
+				if (!m_model->setCurvePoints(idCurve, partial, revision.get(), false)) job.cancel();
+				m_view->update();
+			});
+			return !job.isCanceled();
+		});
+	}, [this, idCurve, revision, fitted](bool isCanceled) {
+		if (!isCanceled && !fitted->empty()) m_model->setCurvePoints(idCurve, *fitted, revision.get(), true);
+		m_view->update();
+	});
+	showJobProgress();
+}
+void Controller::onFitWidthOfSelected()
+{
+	float expectedRadius = m_view->cursorRadius() * m_renderState.windowToContourScale();
+	m_model->fitSelectedVesselWidth(expectedRadius);
+	m_renderState.setActiveCurveNeedsUpdate(true);
+	m_view->update();
+}
+void Controller::onToggleSnapWhileDrawing(bool snap)
+{
+	m_model->setSnapWhileDrawing(snap);
+}
+void Controller::onToggleVesselTracing(bool trace)
+{
+	m_view->setVesselTracing(trace);
+}
+void Controller::onPropagateToNextFrame()
+{
+	// The new frame is saved like any other frame change (see onFrameChanged)
+	m_jobs.cancelAll();
+	m_jobs.whenAllDone([this]() {
+		if (!m_model->propagateToNextFrame()) return;
+		m_filename.clear();
+		updateFrameSlider();
+		m_view->setFrame(m_model->frame(), m_model->image());
+	});
+}
+
+// View menu
+void Controller::onResetView()
+{
+	float prevWindowToContourScale = m_renderState.windowToContourScale();
+	m_renderState.resetWorldToView();
+	float divisor = std::max(std::numeric_limits<float>::epsilon(), m_renderState.windowToContourScale());
+	float scaleDelta = prevWindowToContourScale / divisor;
+	m_view->setCursorRadius(m_view->cursorRadius() * scaleDelta);
+	m_renderState.setNeedsFullUpdate(true);
+	m_view->update();
+}
+void Controller::onToggleTraceRecording(bool record)
+{
+	if (record) {
+		m_view->startTraceRecording();
+		return;
+	}
+
+	// Save the recorded trace for replay with --replay
+	QString filename = QFileDialog::getSaveFileName(0, ("Save interaction trace"), QDir::currentPath(), tr("*.vtrace"));
+	if (!filename.isEmpty() && !filename.isNull()) {
+		if (QFileInfo(filename).suffix() != tr("vtrace")) filename.append(".vtrace");
+	}
+	if (!m_view->stopTraceRecording(filename) && !filename.isEmpty()) {
+		std::cout << "Exception " << "Write interaction trace failed." << std::endl;
+	}
+}
+void Controller::onToggleProfilerOverlay(bool visible)
+{
+	m_view->setProfilerOverlayVisible(visible);
+}
+void Controller::onSaveProfilerTrace()
+{
+	// Save recorded timings in the Chrome trace format for chrome://tracing or Perfetto
+	QString filename = QFileDialog::getSaveFileName(0, ("Save profiler trace"), QDir::currentPath(), tr("*.json"));
+	if (!filename.isEmpty() && !filename.isNull()) {
+		if (QFileInfo(filename).suffix() != tr("json")) filename.append(".json");
+		if (!Profiler::instance().writeChromeTrace(filename.toStdString())) {
+			std::cout << "Exception " << "Write profiler trace failed." << std::endl;
+		}
+	}
+}
+
+// Help menu
+void Controller::onDisplayShortcutKeys()
+{
+	QString shortcutText;
+	shortcutText.append("<b>File management</b> <br />");
+	shortcutText.append("Ctrl+N:  Load new image <br />");
+	shortcutText.append("Ctrl+O:  Open existing contouring file <br />");
+	shortcutText.append("Ctrl+S:  Save current contouring file <br />");
+	shortcutText.append("Esc key:  Exit <br />");
+	shortcutText.append("<br />");
+
+	shortcutText.append("<b>Contour drawing</b> <br />");
+	shortcutText.append("LMB+drag:  Draw new curve/overdraw selected curve <br />");
+	shortcutText.append("Mouse wheel:  Modify brush width<br />");
+	shortcutText.append("<br />");
+
+	shortcutText.append("<b>Contour selection</b> <br />");
+	shortcutText.append("RMB click on curve centerline:  Select curve <br />");
+	shortcutText.append("D:  Deselect currently selected curve <br />");
+	shortcutText.append("Del key:  Delete selected curve <br />");
+	shortcutText.append("<br />");
+
+	shortcutText.append("<b>Contour editing</b> <br />");
+	shortcutText.append("Ctrl+Z:  Undo last contour edit <br />");
+	shortcutText.append("Ctrl+Y:  Redo last undone edit <br />");
+	shortcutText.append("F:  Fit the selected curve to nearest vessel <br />");
+	shortcutText.append("W:  Set vessel widths along selected curve <br />");
+	shortcutText.append("S:  Toggle snapping to vessels while drawing <br />");
+	shortcutText.append("T:  Toggle tracing vessels between two LMB clicks <br />");
+	shortcutText.append("P:  Copy contour to next frame of a sequence and fit it there <br />");
+	shortcutText.append("V:  Togle contour visibility on/off <br />");
+	shortcutText.append("<br />");
+
+	shortcutText.append("<b>Image transforms and windowing</b> <br />");
+	shortcutText.append("R:  Re-center image <br />");
+	shortcutText.append("Shift+LMB+drag:  Translate image <br />");
+	shortcutText.append("Ctrl+LMB+drag up/down:  Zoom image in/out<br />");
+	shortcutText.append("Alt+LMB+drag:  Adjust brightness/contrast<br />");
+	shortcutText.append(". and , keys:  Next/previous frame of an image sequence <br />");
+	shortcutText.append("<br />");
+
+	shortcutText.append("<b>Key:</b> <br />");
+	shortcutText.append("LMB = left mouse button <br />");
+	shortcutText.append("RMB = right mouse button <br />");
+
+	QMessageBox helpSheet;
+	helpSheet.setWindowTitle("Keyboard Shortcuts and Mouse Input");
+	helpSheet.setTextFormat(Qt::RichText);
+	helpSheet.setText(shortcutText);
+	helpSheet.setStandardButtons(QMessageBox::Ok);
+	helpSheet.exec();
+}
+
+
+// Background jobs
+void Controller::onCancelJobs()
+{
+	m_jobs.cancelAll();
+}
+void Controller::onUpdateJobProgress()
+{
+	if (m_jobs.numActiveJobs() == 0) {
+		m_jobProgressTimer.stop();
+		statusBar()->setVisible(false);
+		return;
+	}
+	m_jobProgressBar.setValue((int)(100 * m_jobs.progress()));
+}
+
+//
+// Private
+//
+void Controller::prepareForLoad(std::function<void()> load)
+{
+	// Running fits are canceled. The model is cleared and loaded once running jobs, and
+	// a save requested here, are done, without blocking meanwhile.
+	m_jobs.cancelAll();
+	if (m_model->imageIsValid()) {
+		QMessageBox::StandardButton save = saveQuery();
+		if (save == QMessageBox::Cancel) {
+			return;
+		}
+		else if (save == QMessageBox::Yes) {
+			onSave();
+		}
+	}
+	m_jobs.whenAllDone([this, load]() {
+		m_model->clear();
+		load();
+	});
+}
+void Controller::updateForLoaded()
+{
+	// Reset image windowing for rendering
+	float minValue = m_model->imageNormalizedMin();
+	float maxValue = m_model->imageNormalizedMax();
+	m_renderState.setWindowingRange(minValue, maxValue);
+	m_renderState.setDefaultWindowing();
+
+	// Set contour visibility on
+	m_toggleVisibilityAction.setChecked(true);
+	m_renderState.setContourVisible(true);
+
+	// Initialize transforms to center the view in the viewport
+	m_renderState.centerImageInViewport(m_model->imageWidth(), m_model->imageHeight());
+
+	// Update view
+	updateFrameSlider();
+	m_view->initCursor();
+	m_view->setImage(m_model->image());
+	m_renderState.setNeedsFullUpdate(true);
+	m_view->update();
+}
+void Controller::showJobProgress()
+{
+	onUpdateJobProgress();
+	statusBar()->setVisible(true);
+	m_jobProgressTimer.start();
+}
+void Controller::setEditingEnabled(bool isEnabled)
+{
+	// The view keeps repainting while its input is disabled
+	m_view->setEnabled(isEnabled);
+	m_frameSlider.setEnabled(isEnabled);
+	for (QAction* menuAction : menuBar()->actions()) {
+		if (!menuAction->menu()) continue;
+		for (QAction* action : menuAction->menu()->actions()) action->setEnabled(isEnabled);
+	}
+	if (isEnabled) {
+		m_renderState.setNeedsFullUpdate(true);
+		m_view->update();
+	}
+}
+void Controller::updateFrameSlider()
+{
+	QSignalBlocker blocker(&m_frameSlider);
+	m_frameSlider.setRange(0, std::max(0, m_model->numFrames() - 1));
+	m_frameSlider.setValue(m_model->frame());
+	m_frameSlider.setVisible(m_model->numFrames() > 1);
+}
+QMessageBox::StandardButton Controller::saveQuery()
+{
+	return 	QMessageBox::question(this, "VESCL",
+		tr("Save contour?\n"),
+		QMessageBox::Cancel | QMessageBox::No | QMessageBox::Yes,
+		QMessageBox::Yes);
+}
+
+void Controller::closeEvent(QCloseEvent* event)
+{
+	// Finish background jobs, e.g., a running export, then save previous work? Jobs are
+	// finished without blocking, and the window is closed again when they are done.
+	if (m_jobs.numActiveJobs() == 0 && !m_isSaveQueried) {
+		QMessageBox::StandardButton save = saveQuery();
+		if (save == QMessageBox::Cancel) {
+			event->ignore();
+			return;
+		}
+		m_isSaveQueried = true;
+		if (save == QMessageBox::Yes) onSave();
+	}
+	if (m_jobs.numActiveJobs() > 0) {
+		event->ignore();
+		if (!m_isClosePending) {
+			m_isClosePending = true;
+			m_jobs.whenAllDone([this]() {
+				m_isClosePending = false;
+				close();
+			});
+		}
+		return;
+	}
+	event->accept();
 }
\ No newline at end of file
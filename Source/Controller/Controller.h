@@ -1,102 +1,157 @@
-//
-// Controller.h
-// Controller in Model-View-Controller architecture. Implements the main user interface.
-//
-// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
-// 
-// This code is free software : you can redistribute it and /or modify it under
-// the terms of the GNU General Public License as published by the Free Software 
-// Foundation, either version 3 of the License, or (at your option) any later version.
-// 
-// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
-// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
-// PARTICULAR PURPOSE. See the GNU General Public License for more details.
-// 
-// You may have received a copy of the GNU General Public License along with this 
-// program. If not, see < http://www.gnu.org/licenses/>.
-// 
-
-#pragma once
-
-#include <QtWidgets>
-#include "RenderState.h"
-
-class Model;
-class GL_View;
-
-class Controller : public QMainWindow
-{
-	Q_OBJECT
-
-public:
-    Controller(QWidget* parent);
-	~Controller();
-
-private slots:
-    // File menu
-    void onNew();
-    void onOpen();
-    void onSave();
-    void onExport();
-    void onExit();
-
-    // Image menu
-    void onResetWindowing();
-    void onToggleImageInterpolation(bool interpolate);
-    void onToggleImageFormat();
-
-    // Contour menu
-    void onDeselect();
-    void onDeleteSelected();
-    void onClearContour();
-    void onSetContourColor();
-    void onToggleContourVisibility(bool visible);
-    void onFitSelectedToVessel();
-    void onFitWidthOfSelected();
-
-    // View menu
-    void onResetView();
-
-    // Help menu
-    void onDisplayShortcutKeys(); 
-
-private:
-    Model* m_model;
-    GL_View* m_view;
-    RenderState m_renderState;
-    void createMainWindow(GL_View* view);
-
-    // File menu
-    QAction m_newAction;
-    QAction m_openAction;
-    QAction m_saveAction;
-    QAction m_exportAction;
-    QAction m_exitAction;
-    void prepareForLoad();
-    void updateForLoaded();
-    QMessageBox::StandardButton saveQuery();
-
-    // Image menu
-    QAction m_resetWindowingAction;
-    QAction m_toggleImageInterpolationAction;
-    QAction m_toggleImageFormatAction;
-
-    // Contour menu
-    QAction m_deselectAction;
-    QAction m_deleteSelectedAction;
-    QAction m_clearContourAction;
-    QAction m_setContourColorAction;
-    QAction m_toggleVisibilityAction;
-    QAction m_fitSelectedToVesselAction;
-    QAction m_fitWidthOfSelectedAction;
-    void setContourColors(QColor color);
-
-    // View menu
-    QAction m_resetViewAction;
-
-    // Help menu
-    QAction m_DisplayShortcutKeysAction;
-
-    // Overrides
-    void closeEvent(QCloseEvent* event);
+//
+// Controller.h
+// Controller in Model-View-Controller architecture. Implements the main user interface.
+//
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <QtWidgets>
+#include "RenderState.h"
+#include "JobScheduler.h"
+
+class Model;
+class GL_View;
+class GL_Exporter;
+
+class Controller : public QMainWindow
+{
+	Q_OBJECT
+
+public:
+    Controller(QWidget* parent);
+	~Controller();
+
+private slots:
+    // File menu
+    void onNew();
+    void onOpen();
+    void onOpenSequence();
+    void onSave();
+    void onExport();
+    void onExit();
+    void onToggleImageStore(bool useStore);
+    void onToggleImageCompression(bool compress);
+
+    // Edit menu
+    void onUndo();
+    void onRedo();
+
+    // Image menu
+    void onResetWindowing();
+    void onToggleImageInterpolation(bool interpolate);
+    void onToggleImageFormat();
+    void onFrameChanged(int frame);
+    void onNextFrame();
+    void onPreviousFrame();
+
+    // Contour menu
+    void onDeselect();
+    void onDeleteSelected();
+    void onClearContour();
+    void onSetContourColor();
+    void onToggleContourVisibility(bool visible);
+    void onFitSelectedToVessel();
+    void onFitWidthOfSelected();
+    void onToggleSnapWhileDrawing(bool snap);
+    void onToggleVesselTracing(bool trace);
+    void onPropagateToNextFrame();
+
+    // View menu
+    void onResetView();
+    void onToggleTraceRecording(bool record);
+    void onToggleProfilerOverlay(bool visible);
+    void onSaveProfilerTrace();
+
+    // Help menu
+    void onDisplayShortcutKeys(); 
+
+    // Background jobs
+    void onCancelJobs();
+    void onUpdateJobProgress();
+
+private:
+    Model* m_model;
+    GL_View* m_view;
+    GL_Exporter* m_exporter;
+    GL_Exporter* m_imageExporter;
+    RenderState m_renderState;
+    void createMainWindow(GL_View* view);
+
+    // File menu
+    QAction m_newAction;
+    QAction m_openAction;
+    QAction m_openSequenceAction;
+    QAction m_saveAction;
+    QAction m_exportAction;
+    QAction m_exitAction;
+    QAction m_useImageStoreAction;
+    QAction m_compressImageAction;
+    QString m_filename;
+    bool m_isImageStorageChanged;
+    void prepareForLoad(std::function<void()> load);
+    void updateForLoaded();
+    QMessageBox::StandardButton saveQuery();
+
+    // Edit menu
+    QAction m_undoAction;
+    QAction m_redoAction;
+
+    // Image menu
+    QAction m_resetWindowingAction;
+    QAction m_toggleImageInterpolationAction;
+    QAction m_toggleImageFormatAction;
+    QAction m_nextFrameAction;
+    QAction m_previousFrameAction;
+    QSlider m_frameSlider;
+    void updateFrameSlider();
+
+    // Contour menu
+    QAction m_deselectAction;
+    QAction m_deleteSelectedAction;
+    QAction m_clearContourAction;
+    QAction m_setContourColorAction;
+    QAction m_toggleVisibilityAction;
+    QAction m_fitSelectedToVesselAction;
+    QAction m_fitWidthOfSelectedAction;
+    QAction m_toggleSnapWhileDrawingAction;
+    QAction m_toggleVesselTracingAction;
+    QAction m_propagateToNextFrameAction;
+    void setContourColors(QColor color);
+
+    // View menu
+    QAction m_resetViewAction;
+    QAction m_toggleTraceRecordingAction;
+    QAction m_toggleProfilerOverlayAction;
+    QAction m_saveProfilerTraceAction;
+
+    // Help menu
+    QAction m_DisplayShortcutKeysAction;
+
+    // Background jobs. Fitting runs alongside editing. Opening, saving and exporting 
+    // disable editing until they are done, but the view keeps repainting.
+    JobScheduler m_jobs;
+    std::shared_ptr<JobScheduler::Job> m_fitJob;
+    QProgressBar m_jobProgressBar;
+    QPushButton m_cancelJobsButton;
+    QTimer m_jobProgressTimer;
+    void showJobProgress();
+    void setEditingEnabled(bool isEnabled);
+
+    // Overrides. The window is closed again when running jobs are done.
+    bool m_isClosePending;
+    bool m_isSaveQueried;
+    void closeEvent(QCloseEvent* event);
 };
\ No newline at end of file
@@ -0,0 +1,186 @@
+//
+// InteractionTrace.cpp
+// Implementation of InteractionTrace.
+//
+
+#include "InteractionTrace.h"
+#include "../Model/Contour.h"
+
+#include <QFile>
+#include <QDataStream>
+
+#include <cstring>
+#include <sstream>
+
+namespace {
+    // File layout: magic, image size, initial contour, then one record per event. 
+    // Records hold the event type, the time since the previous event in usecs and the
+    // type specific data. All values are little endian.
+    const char traceMagic[8] = { 'V', 'S', 'C', 'L', 'T', 'R', 'C', '1' };
+}
+
+// 
+// Public
+//
+InteractionTrace::InteractionTrace() :
+    m_isRecording(false),
+    m_imageWidth(0),
+    m_imageHeight(0),
+    m_lastViewIndex(-1)
+{
+}
+InteractionTrace::~InteractionTrace()
+{
+}
+
+void InteractionTrace::startRecording(Contour* contour, int imageWidth, int imageHeight)
+{
+    m_events.clear();
+    m_lastViewIndex = -1;
+    m_imageWidth = imageWidth;
+    m_imageHeight = imageHeight;
+    std::ostringstream contourStream;
+    if (contour) contour->writeToFile(contourStream);
+    m_initialContour = contourStream.str();
+    m_timer.start();
+    m_isRecording = true;
+}
+void InteractionTrace::stopRecording()
+{
+    m_isRecording = false;
+}
+
+void InteractionTrace::recordView(QSize windowSize, const QMatrix4x4& worldToView, float cursorRadius)
+{
+    if (!m_isRecording) return;
+    if (m_lastViewIndex >= 0) {
+        const Event& last = m_events[m_lastViewIndex];
+        if (last.windowSize == windowSize && last.worldToView == worldToView && 
+            last.cursorRadius == cursorRadius) return;
+    }
+    Event event = { EventType::View, m_timer.nsecsElapsed() / 1000, QPointF(), 0, 0, 0, 
+        windowSize, worldToView, cursorRadius };
+    m_lastViewIndex = (int)m_events.size();
+    m_events.push_back(event);
+}
+void InteractionTrace::recordMouse(EventType type, QPointF pos, Qt::MouseButtons buttons, 
+    Qt::KeyboardModifiers modifiers)
+{
+    if (!m_isRecording) return;
+    Event event = { type, m_timer.nsecsElapsed() / 1000, pos, buttonBits(buttons), 
+        modifierBits(modifiers), 0, QSize(), QMatrix4x4(), 0 };
+    m_events.push_back(event);
+}
+void InteractionTrace::recordWheel(QPointF pos, int numSteps, Qt::KeyboardModifiers modifiers)
+{
+    if (!m_isRecording) return;
+    Event event = { EventType::Wheel, m_timer.nsecsElapsed() / 1000, pos, 0, 
+        modifierBits(modifiers), numSteps, QSize(), QMatrix4x4(), 0 };
+    m_events.push_back(event);
+}
+
+bool InteractionTrace::save(const QString& filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream.writeRawData(traceMagic, sizeof(traceMagic));
+    stream << (qint32)m_imageWidth << (qint32)m_imageHeight;
+    stream << QByteArray(m_initialContour.data(), (int)m_initialContour.size());
+    stream << (quint32)m_events.size();
+    qint64 prevTime = 0;
+    for (const Event& event : m_events) {
+        stream << (quint8)event.type << (quint32)(event.time - prevTime);
+        prevTime = event.time;
+        if (event.type == EventType::View) {
+            stream << (qint32)event.windowSize.width() << (qint32)event.windowSize.height();
+            const float* m = event.worldToView.constData();
+            for (int i = 0; i < 16; i++) stream << m[i];
+            stream << event.cursorRadius;
+        }
+        else {
+            stream << (float)event.pos.x() << (float)event.pos.y() << (quint8)event.buttons << 
+                (quint8)event.modifiers;
+            if (event.type == EventType::Wheel) stream << (qint16)event.wheelSteps;
+        }
+    }
+    return (stream.status() == QDataStream::Ok);
+}
+bool InteractionTrace::load(const QString& filename)
+{
+    m_events.clear();
+    m_lastViewIndex = -1;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    char magic[sizeof(traceMagic)];
+    if (stream.readRawData(magic, sizeof(magic)) != sizeof(magic) || 
+        memcmp(magic, traceMagic, sizeof(magic)) != 0) return false;
+    qint32 imageWidth, imageHeight;
+    QByteArray contour;
+    quint32 numEvents;
+    stream >> imageWidth >> imageHeight >> contour >> numEvents;
+    m_imageWidth = imageWidth;
+    m_imageHeight = imageHeight;
+    m_initialContour = contour.toStdString();
+
+    qint64 time = 0;
+    for (quint32 i = 0; i < numEvents && stream.status() == QDataStream::Ok; i++) {
+        quint8 type;
+        quint32 deltaTime;
+        stream >> type >> deltaTime;
+        time += deltaTime;
+        Event event = { (EventType)type, time, QPointF(), 0, 0, 0, QSize(), QMatrix4x4(), 0 };
+        if (event.type == EventType::View) {
+            qint32 width, height;
+            float m[16];
+            stream >> width >> height;
+            for (int j = 0; j < 16; j++) stream >> m[j];
+            stream >> event.cursorRadius;
+            event.windowSize = QSize(width, height);
+            event.worldToView = QMatrix4x4(m).transposed();     // m is column-major
+            m_lastViewIndex = (int)m_events.size();
+        }
+        else {
+            float x, y;
+            quint8 buttons, modifiers;
+            stream >> x >> y >> buttons >> modifiers;
+            event.pos = QPointF(x, y);
+            event.buttons = buttons;
+            event.modifiers = modifiers;
+            if (event.type == EventType::Wheel) {
+                qint16 wheelSteps;
+                stream >> wheelSteps;
+                event.wheelSteps = wheelSteps;
+            }
+        }
+        m_events.push_back(event);
+    }
+    return (stream.status() == QDataStream::Ok && m_events.size() == numEvents);
+}
+
+// 
+// Private
+//
+int InteractionTrace::buttonBits(Qt::MouseButtons buttons)
+{
+    int bits = 0;
+    if (buttons & Qt::LeftButton) bits |= LeftButton;
+    if (buttons & Qt::RightButton) bits |= RightButton;
+    if (buttons & Qt::MiddleButton) bits |= MiddleButton;
+    return bits;
+}
+int InteractionTrace::modifierBits(Qt::KeyboardModifiers modifiers)
+{
+    int bits = 0;
+    if (modifiers & Qt::ShiftModifier) bits |= ShiftModifier;
+    if (modifiers & Qt::ControlModifier) bits |= ControlModifier;
+    if (modifiers & Qt::AltModifier) bits |= AltModifier;
+    return bits;
+}
@@ -0,0 +1,84 @@
+//
+// InteractionTrace.h
+// Records timestamped mouse and wheel input from the view, together with the view 
+// transforms and cursor radius, so that drawing sessions can be replayed 
+// deterministically (see TraceReplay). Traces are saved in a compact binary format.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <QPointF>
+#include <QSize>
+#include <QString>
+
+#include <string>
+#include <vector>
+
+class Contour;
+
+class InteractionTrace
+{
+public:
+    InteractionTrace();
+    ~InteractionTrace();
+
+    // View events are recorded whenever the window size, world to view transform or 
+    // cursor radius differ from the last recorded values and so precede the input 
+    // events they apply to
+    enum class EventType { Press, Release, Move, Wheel, View };
+    enum Buttons { LeftButton = 1, RightButton = 2, MiddleButton = 4 };
+    enum Modifiers { ShiftModifier = 1, ControlModifier = 2, AltModifier = 4 };
+    typedef struct {
+        EventType type;
+        qint64 time;                // usecs since recording started
+        QPointF pos;                // Window coordinates, origin at top left
+        int buttons;
+        int modifiers;
+        int wheelSteps;
+        QSize windowSize;           // View events only
+        QMatrix4x4 worldToView;
+        float cursorRadius;
+    } Event;
+
+    // The contour is saved when recording starts so overdrawing can be replayed
+    void startRecording(Contour* contour, int imageWidth, int imageHeight);
+    void stopRecording();
+    bool isRecording() const { return m_isRecording; };
+    void recordView(QSize windowSize, const QMatrix4x4& worldToView, float cursorRadius);
+    void recordMouse(EventType type, QPointF pos, Qt::MouseButtons buttons, Qt::KeyboardModifiers modifiers);
+    void recordWheel(QPointF pos, int numSteps, Qt::KeyboardModifiers modifiers);
+
+    bool save(const QString& filename) const;
+    bool load(const QString& filename);
+
+    int imageWidth() const { return m_imageWidth; };
+    int imageHeight() const { return m_imageHeight; };
+    const std::string& initialContour() const { return m_initialContour; };
+    const std::vector<Event>& events() const { return m_events; };
+
+private:
+    bool m_isRecording;
+    QElapsedTimer m_timer;
+    int m_imageWidth;
+    int m_imageHeight;
+    std::string m_initialContour;   // In the .vscl contour format
+    std::vector<Event> m_events;
+    int m_lastViewIndex;
+    static int buttonBits(Qt::MouseButtons buttons);
+    static int modifierBits(Qt::KeyboardModifiers modifiers);
+};
@@ -0,0 +1,96 @@
+//
+// JobScheduler.cpp
+// Implementation of JobScheduler.
+//
+
+#include "JobScheduler.h"
+
+#include <QCoreApplication>
+#include <QEvent>
+
+
+// 
+// Public
+//
+JobScheduler::JobScheduler(int numThreads)
+{
+	if (numThreads > 0) m_pool.setMaxThreadCount(numThreads);
+}
+JobScheduler::~JobScheduler()
+{
+	cancelAll();
+	m_pool.waitForDone();
+}
+
+std::shared_ptr<JobScheduler::Job> JobScheduler::schedule(std::function<void(Job&)> work,
+	std::function<void(bool isCanceled)> done)
+{
+	std::shared_ptr<Job> job(new Job(this));
+	m_jobs.push_back(job);
+
+	// The job is removed and done is called by an event posted after the work returns, 
+	// so results the work published are applied first
+	m_pool.start([this, job, work, done]() {
+		if (!job->isCanceled()) work(*job);
+		job->setProgress(1);
+		QMetaObject::invokeMethod(this, [this, job, done]() {
+			m_jobs.remove(job);
+			if (done) done(job->isCanceled());
+			runWaiting();
+		}, Qt::QueuedConnection);
+	});
+	return job;
+}
+
+float JobScheduler::progress() const
+{
+	if (m_jobs.empty()) return 1;
+	float sum = 0;
+	for (const std::shared_ptr<Job>& job : m_jobs) sum += job->progress();
+	return sum / m_jobs.size();
+}
+
+void JobScheduler::cancelAll()
+{
+	for (std::shared_ptr<Job>& job : m_jobs) job->cancel();
+}
+void JobScheduler::waitForAll()
+{
+	m_pool.waitForDone();
+	QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+void JobScheduler::whenAllDone(std::function<void()> next)
+{
+	m_waiting.push_back(next);
+	runWaiting();
+}
+
+//
+// Private
+//
+void JobScheduler::runWaiting()
+{
+	while (m_jobs.empty() && !m_waiting.empty()) {
+		std::function<void()> next = m_waiting.front();
+		m_waiting.pop_front();
+		next();
+	}
+}
+
+//
+// Job
+//
+JobScheduler::Job::Job(JobScheduler* scheduler) :
+	m_scheduler(scheduler),
+	m_isCanceled(false),
+	m_progress(0)
+{
+}
+void JobScheduler::Job::publish(std::function<void()> result)
+{
+	// The job outlives its published results because it is only released by the event
+	// that calls done, which is posted after them
+	QMetaObject::invokeMethod(m_scheduler, [this, result]() {
+		if (!isCanceled()) result();
+	}, Qt::QueuedConnection);
+}
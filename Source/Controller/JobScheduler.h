@@ -0,0 +1,90 @@
+//
+// JobScheduler.h
+// Runs long operations, e.g., fitting, file I/O and exports, on a pool of worker threads
+// so the user interface keeps repainting. Jobs can be canceled, report their progress 
+// and publish intermediate results, which are applied on the scheduler's thread.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <QObject>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+
+class JobScheduler : public QObject
+{
+public:
+    // Zero threads uses one per hardware thread
+    JobScheduler(int numThreads = 0);
+    ~JobScheduler();
+
+    class Job
+    {
+    public:
+        // Work should check for cancellation regularly and return when canceled
+        void cancel() { m_isCanceled = true; };
+        bool isCanceled() const { return m_isCanceled; };
+
+        // Progress is in [0, 1]
+        void setProgress(float progress) { m_progress = progress; };
+        float progress() const { return m_progress; };
+
+        // Runs result on the scheduler's thread, in order with other published results
+        // and before the job's done function, unless the job has been canceled by then
+        void publish(std::function<void()> result);
+
+    private:
+        friend class JobScheduler;
+        Job(JobScheduler* scheduler);
+        JobScheduler* m_scheduler;
+        std::atomic<bool> m_isCanceled;
+        std::atomic<float> m_progress;
+    };
+
+    // Runs work on a worker thread. done is called on the scheduler's thread when work
+    // has returned, with whether the job was canceled. Must be called on the scheduler's
+    // thread, usually the GUI thread.
+    std::shared_ptr<Job> schedule(std::function<void(Job&)> work, 
+        std::function<void(bool isCanceled)> done = nullptr);
+
+    // Jobs whose done function has not been called yet, and their mean progress
+    int numActiveJobs() const { return (int)m_jobs.size(); };
+    float progress() const;
+
+    // waitForAll() blocks until all jobs have returned and then applies their published
+    // results and calls their done functions
+    void cancelAll();
+    void waitForAll();
+
+    // Calls next on the scheduler's thread once no jobs are active, i.e., after the done
+    // functions of all jobs, without blocking. Calls are made in order, and jobs 
+    // scheduled by one delay the calls after it until they are done too.
+    void whenAllDone(std::function<void()> next);
+
+    // Make non-copyable
+    JobScheduler(JobScheduler const&) = delete;
+    void operator=(JobScheduler const&) = delete;
+
+private:
+    QThreadPool m_pool;
+    std::list<std::shared_ptr<Job>> m_jobs;
+    std::list<std::function<void()>> m_waiting;
+    void runWaiting();
+};
@@ -0,0 +1,124 @@
+//
+// DistanceTransform.cpp
+// Implementation of DistanceTransform.
+//
+
+#include "DistanceTransform.h"
+#include "../Util/Parallel.h"
+#include "../Util/Profiler.h"
+
+#include <cmath>
+#include <limits>
+
+// Larger than any squared distance in a raster that fits in memory, small enough that 
+// differences of far values stay finite
+const double DistanceTransform::farValue = 1e20;
+
+// 
+// Public
+//
+std::vector<float> DistanceTransform::distanceToSeeds(const std::vector<unsigned char>& isSeed, 
+	int width, int height)
+{
+	VESCL_PROFILE_SCOPE("DistanceTransform::distanceToSeeds", "export");
+	std::vector<float> distance;
+	squaredDistanceToSeeds(isSeed, true, width, height, distance);
+	const float infinity = std::numeric_limits<float>::infinity();
+	Parallel::forRange(0, (int)distance.size(), 1 << 16, [&](int first, int last) {
+		for (int i = first; i < last; i++) {
+			distance[i] = (distance[i] >= farValue) ? infinity : sqrt(distance[i]);
+		}
+	});
+	return distance;
+}
+
+std::vector<float> DistanceTransform::signedDistanceToEdge(const std::vector<unsigned char>& isInside,
+	int width, int height)
+{
+	VESCL_PROFILE_SCOPE("DistanceTransform::signedDistanceToEdge", "export");
+	std::vector<float> distToInside;
+	std::vector<float> distToOutside;
+	squaredDistanceToSeeds(isInside, true, width, height, distToInside);
+	squaredDistanceToSeeds(isInside, false, width, height, distToOutside);
+
+	// Inside pixels are half a pixel further from the boundary than from the nearest 
+	// outside pixel center and vice versa
+	const float infinity = std::numeric_limits<float>::infinity();
+	Parallel::forRange(0, (int)distToInside.size(), 1 << 16, [&](int first, int last) {
+		for (int i = first; i < last; i++) {
+			if (isInside[i]) {
+				distToInside[i] = (distToOutside[i] >= farValue) ? infinity : sqrt(distToOutside[i]) - 0.5f;
+			}
+			else {
+				distToInside[i] = (distToInside[i] >= farValue) ? -infinity : 0.5f - sqrt(distToInside[i]);
+			}
+		}
+	});
+	return distToInside;
+}
+
+// 
+// Private
+//
+void DistanceTransform::squaredDistanceToSeeds(const std::vector<unsigned char>& isSeed, bool seedValue,
+	int width, int height, std::vector<float>& squaredDistance)
+{
+	squaredDistance.assign((size_t)width * height, (float)farValue);
+	if (width <= 0 || height <= 0 || isSeed.size() < squaredDistance.size()) return;
+
+	// Columns, then rows. Column results are kept in double precision for the row pass
+	// because squared distances of large rasters exceed the float mantissa. Only the 
+	// final squared distances are rounded to float.
+	std::vector<double> columns((size_t)width * height);
+	Parallel::forRange(0, width, 64, [&](int first, int last) {
+		std::vector<double> f(height), d(height), z(height + 1);
+		std::vector<int> v(height);
+		for (int x = first; x < last; x++) {
+			for (int y = 0; y < height; y++) {
+				f[y] = ((isSeed[(size_t)y * width + x] != 0) == seedValue) ? 0 : farValue;
+			}
+			transform1D(f.data(), height, d.data(), v.data(), z.data());
+			for (int y = 0; y < height; y++) columns[(size_t)y * width + x] = d[y];
+		}
+	});
+	Parallel::forRange(0, height, 16, [&](int first, int last) {
+		std::vector<double> f(width), d(width), z(width + 1);
+		std::vector<int> v(width);
+		for (int y = first; y < last; y++) {
+			const double* column = &columns[(size_t)y * width];
+			float* row = &squaredDistance[(size_t)y * width];
+			for (int x = 0; x < width; x++) f[x] = (column[x] >= farValue) ? farValue : column[x];
+			transform1D(f.data(), width, d.data(), v.data(), z.data());
+			for (int x = 0; x < width; x++) row[x] = (d[x] >= farValue) ? (float)farValue : (float)d[x];
+		}
+	});
+}
+
+void DistanceTransform::transform1D(const double* f, int n, double* d, int* v, double* z)
+{
+	// Lower envelope of the parabolas rooted at (q, f(q)). v holds the parabola locations
+	// and z the boundaries between them.
+	const double infinity = std::numeric_limits<double>::infinity();
+	int k = 0;
+	v[0] = 0;
+	z[0] = -infinity;
+	z[1] = infinity;
+	for (int q = 1; q < n; q++) {
+		// z[0] is -infinity, so k never drops below 0
+		double s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]));
+		while (s <= z[k]) {
+			k--;
+			s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]));
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = infinity;
+	}
+	k = 0;
+	for (int q = 0; q < n; q++) {
+		while (z[k + 1] < q) k++;
+		double dq = q - v[k];
+		d[q] = dq * dq + f[v[k]];
+	}
+}
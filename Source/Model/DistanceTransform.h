@@ -0,0 +1,45 @@
+//
+// DistanceTransform.h
+// Exact Euclidean distance transforms of binary rasters in linear time, using the lower
+// envelope of parabolas (Felzenszwalb and Huttenlocher) separably over columns and rows.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <vector>
+
+class DistanceTransform
+{
+public:
+	// Distances in pixels from each pixel center to the nearest pixel center where 
+	// isSeed is non-zero. Distances are infinite if there are no seeds.
+	static std::vector<float> distanceToSeeds(const std::vector<unsigned char>& isSeed, int width, 
+		int height);
+
+	// Signed distances in pixels to the boundary of the region where isInside is non-zero,
+	// positive inside. The boundary is taken to lie half way between inside and outside 
+	// pixel centers.
+	static std::vector<float> signedDistanceToEdge(const std::vector<unsigned char>& isInside, int width,
+		int height);
+
+private:
+	// Squared distances, computed in double precision and rounded to float. Pixels 
+	// without a seed in range hold farValue.
+	static void squaredDistanceToSeeds(const std::vector<unsigned char>& isSeed, bool seedValue, 
+		int width, int height, std::vector<float>& squaredDistance);
+	static void transform1D(const double* f, int n, double* d, int* v, double* z);
+	static const double farValue;
+};
@@ -0,0 +1,213 @@
+//
+// History.cpp
+// Implementation of History.
+//
+
+#include "History.h"
+
+#include <unordered_map>
+
+// 
+// Public
+//
+History::History(size_t maxBytes) :
+	m_maxBytes(maxBytes),
+	m_numBytes(0),
+	m_current(0)
+{
+}
+History::~History()
+{
+	clear();
+}
+
+void History::clear()
+{
+	m_entries.clear();
+	m_curveStates.clear();
+	m_current = 0;
+}
+
+void History::commit(Contour& contour)
+{
+	// Unchanged curves share their snapshot with the previous entry
+	Entry entry;
+	std::map<int, CurveState> curveStates;
+	std::list<Curve*>* curves = contour.curves();
+	for (std::list<Curve*>::iterator it = curves->begin(); it != curves->end(); it++) {
+		Curve* curve = *it;
+		std::map<int, CurveState>::iterator itState = m_curveStates.find(curve->id());
+		CurveState state;
+		state.revision = curve->revision();
+		if (itState != m_curveStates.end() && itState->second.revision == curve->revision()) {
+			state.snapshot = itState->second.snapshot;
+		}
+		else {
+			CurveSnapshotPtr previous = (itState != m_curveStates.end()) ? itState->second.snapshot : nullptr;
+			state.snapshot = snapshot(curve, previous);
+		}
+		curveStates[curve->id()] = state;
+		entry.push_back(state.snapshot);
+	}
+	m_curveStates.swap(curveStates);
+
+	// Skip edits that did not change the contour
+	if (!m_entries.empty() && m_entries[m_current] == entry) return;
+
+	// Discard undone entries
+	if (!m_entries.empty()) m_entries.erase(m_entries.begin() + m_current + 1, m_entries.end());
+	m_entries.push_back(entry);
+	m_current = m_entries.size() - 1;
+	trimToBudget();
+}
+
+bool History::undo(Contour& contour)
+{
+	if (!canUndo()) return false;
+	restore(contour, m_entries[--m_current]);
+	return true;
+}
+bool History::redo(Contour& contour)
+{
+	if (!canRedo()) return false;
+	restore(contour, m_entries[++m_current]);
+	return true;
+}
+
+//
+// Private
+//
+History::CurveSnapshotPtr History::snapshot(Curve* curve, const CurveSnapshotPtr& previous)
+{
+	// Chunks of the previous snapshot are reused when their content is unchanged
+	std::unordered_map<unsigned long long, ChunkPtr> previousChunks;
+	if (previous) {
+		for (size_t i = 0; i < previous->chunks.size(); i++) {
+			previousChunks[previous->chunkHashes[i]] = previous->chunks[i];
+		}
+	}
+
+	CurveSnapshot* snapshot = new CurveSnapshot;
+	snapshot->id = curve->id();
+	const std::list<CurvePoint>& points = static_cast<const Curve*>(curve)->points();
+	Chunk chunk;
+	chunk.reserve(maxChunkSize);
+	const unsigned long long fnvOffset = 14695981039346656037ULL;
+	unsigned long long chunkHash = fnvOffset;
+	for (std::list<CurvePoint>::const_iterator it = points.begin(); it != points.end(); it++) {
+		chunk.push_back(*it);
+		chunkHash = hashPoint(*it, chunkHash);
+
+		// Boundaries depend only on the point that ends the chunk, so chunks after an 
+		// edit realign with the previous snapshot's chunks
+		int size = (int)chunk.size();
+		bool isBoundary = (size >= minChunkSize && (hashPoint(*it, fnvOffset) & chunkBoundaryMask) == 0);
+		if (isBoundary || size == maxChunkSize || std::next(it) == points.end()) {
+			ChunkPtr shared;
+			std::unordered_map<unsigned long long, ChunkPtr>::iterator itPrev = previousChunks.find(chunkHash);
+			if (itPrev != previousChunks.end() && itPrev->second->size() == chunk.size() &&
+				std::equal(chunk.begin(), chunk.end(), itPrev->second->begin(),
+				[](const CurvePoint& a, const CurvePoint& b) {
+					return (a.pos()[0] == b.pos()[0] && a.pos()[1] == b.pos()[1] && a.radius() == b.radius());
+				})) {
+				shared = itPrev->second;
+			}
+			else {
+				shared = newChunk(chunk.begin(), chunk.end());
+			}
+			snapshot->chunks.push_back(shared);
+			snapshot->chunkHashes.push_back(chunkHash);
+			chunk.clear();
+			chunkHash = fnvOffset;
+		}
+	}
+
+	// Count the snapshot's chunk table against the budget too
+	size_t tableBytes = sizeof(CurveSnapshot) + snapshot->chunks.size() * (sizeof(ChunkPtr) + sizeof(unsigned long long));
+	m_numBytes += tableBytes;
+	return CurveSnapshotPtr(snapshot, [this, tableBytes](const CurveSnapshot* s) {
+		m_numBytes -= tableBytes;
+		delete s;
+	});
+}
+History::ChunkPtr History::newChunk(Chunk::const_iterator begin, Chunk::const_iterator end)
+{
+	Chunk* chunk = new Chunk(begin, end);
+	size_t chunkBytes = sizeof(Chunk) + chunk->size() * sizeof(CurvePoint);
+	m_numBytes += chunkBytes;
+	return ChunkPtr(chunk, [this, chunkBytes](const Chunk* c) {
+		m_numBytes -= chunkBytes;
+		delete c;
+	});
+}
+
+void History::restore(Contour& contour, const Entry& entry)
+{
+	std::map<int, Curve*> existingCurves;
+	std::list<Curve*>* curves = contour.curves();
+	for (std::list<Curve*>::iterator it = curves->begin(); it != curves->end(); it++) {
+		existingCurves[(*it)->id()] = *it;
+	}
+
+	// Curves that still match the entry's snapshot are kept as they are. Others are
+	// rebuilt from the snapshot's chunks or recreated if they were deleted.
+	std::list<Curve*> restoredCurves;
+	std::map<int, CurveState> curveStates;
+	for (const CurveSnapshotPtr& snapshot : entry) {
+		Curve* curve = nullptr;
+		std::map<int, Curve*>::iterator itCurve = existingCurves.find(snapshot->id);
+		if (itCurve != existingCurves.end()) {
+			curve = itCurve->second;
+			existingCurves.erase(itCurve);
+		}
+		else {
+			curve = new Curve(snapshot->id);
+		}
+
+		std::map<int, CurveState>::iterator itState = m_curveStates.find(snapshot->id);
+		bool isUnchanged = (itState != m_curveStates.end() && itState->second.snapshot == snapshot &&
+			itState->second.revision == curve->revision());
+		if (!isUnchanged) {
+			std::list<CurvePoint>& points = curve->points();
+			points.clear();
+			for (const ChunkPtr& chunk : snapshot->chunks) {
+				points.insert(points.end(), chunk->begin(), chunk->end());
+			}
+		}
+		CurveState state;
+		state.revision = curve->revision();
+		state.snapshot = snapshot;
+		curveStates[snapshot->id] = state;
+		restoredCurves.push_back(curve);
+	}
+	for (std::map<int, Curve*>::iterator it = existingCurves.begin(); it != existingCurves.end(); it++) {
+		delete it->second;
+	}
+	contour.deselectCurve();
+	curves->swap(restoredCurves);
+	m_curveStates.swap(curveStates);
+}
+
+void History::trimToBudget()
+{
+	// The current entry is always kept, even if it alone exceeds the budget
+	size_t numPointerBytes = 0;
+	for (const Entry& entry : m_entries) numPointerBytes += entry.size() * sizeof(CurveSnapshotPtr);
+	while (m_numBytes + numPointerBytes > m_maxBytes && m_current > 0) {
+		numPointerBytes -= m_entries.front().size() * sizeof(CurveSnapshotPtr);
+		m_entries.pop_front();
+		m_current--;
+	}
+}
+
+unsigned long long History::hashPoint(const CurvePoint& point, unsigned long long hash)
+{
+	// FNV-1a over the point's position and radius
+	float values[3] = { (float)point.pos()[0], (float)point.pos()[1], point.radius() };
+	const unsigned char* bytes = (const unsigned char*)values;
+	for (size_t i = 0; i < sizeof(values); i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
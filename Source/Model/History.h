@@ -0,0 +1,95 @@
+//
+// History.h
+// Undo and redo history of contour edits. Each entry is a snapshot of the contour's 
+// curves. Curve points are held in immutable chunks that are shared between entries, so 
+// an entry only stores the chunks that its edit changed. Chunk boundaries are chosen by
+// point content rather than position, so inserting or removing points only changes the
+// chunks around the edit. The oldest entries are dropped to keep the memory held by the
+// history within a budget.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "Contour.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+class History
+{
+public:
+	History(size_t maxBytes = 64 * 1024 * 1024);
+	~History();
+
+	// Clears the history. The next commit becomes the oldest entry.
+	void clear();
+
+	// Adds an entry for the current state of the contour after an edit. Entries that 
+	// were undone are discarded. Only curves that changed since the last commit, undo
+	// or redo are snapshot.
+	void commit(Contour& contour);
+
+	// Restore the contour to the previous or next entry. Only curves that differ from 
+	// the entry are changed. Returns false if there is no entry to restore.
+	bool canUndo() const { return m_current > 0; };
+	bool canRedo() const { return m_current + 1 < m_entries.size(); };
+	bool undo(Contour& contour);
+	bool redo(Contour& contour);
+
+	// Memory held by point chunks and the number of entries
+	size_t numBytes() const { return m_numBytes; };
+	size_t numEntries() const { return m_entries.size(); };
+
+	// Make non-copyable
+	History(History const&) = delete;
+	void operator=(History const&) = delete;
+
+private:
+	// Chunks hold between minChunkSize and maxChunkSize points. Declared before the
+	// entries so chunks can update the byte count when they are deleted.
+	static const int minChunkSize = 8;
+	static const int maxChunkSize = 64;
+	static const unsigned int chunkBoundaryMask = 15;
+	size_t m_maxBytes;
+	size_t m_numBytes;
+
+	typedef std::vector<CurvePoint> Chunk;
+	typedef std::shared_ptr<const Chunk> ChunkPtr;
+	typedef struct {
+		int id;
+		std::vector<ChunkPtr> chunks;
+		std::vector<unsigned long long> chunkHashes;
+	} CurveSnapshot;
+	typedef std::shared_ptr<const CurveSnapshot> CurveSnapshotPtr;
+	typedef std::vector<CurveSnapshotPtr> Entry;
+	std::deque<Entry> m_entries;
+	size_t m_current;
+
+	// Curve revisions and snapshots as of the last commit, undo or redo
+	typedef struct {
+		unsigned int revision;
+		CurveSnapshotPtr snapshot;
+	} CurveState;
+	std::map<int, CurveState> m_curveStates;
+
+	CurveSnapshotPtr snapshot(Curve* curve, const CurveSnapshotPtr& previous);
+	ChunkPtr newChunk(Chunk::const_iterator begin, Chunk::const_iterator end);
+	void restore(Contour& contour, const Entry& entry);
+	void trimToBudget();
+	static unsigned long long hashPoint(const CurvePoint& point, unsigned long long hash);
+};
@@ -1,187 +1,291 @@
-//
-// Image.cpp
-// Implementation of Image.
-//
-
-#include "Image.h"
-
-#include <sstream>
-#include <string> 
-#include <assert.h>
-
-// 
-// Public
-//
-Image::Image() :
-    m_width(0),
-    m_height(0),
-    m_dataFormat(DataFormat::UChar),
-    m_data(nullptr),
-    m_stats({ false, 0, 0 })
-{
-}
-Image::Image(int width, int height, DataFormat format, unsigned char* data) :
-	m_width(width),
-	m_height(height),
-	m_dataFormat(format),
-	m_data(nullptr),
-	m_stats({ false, 0, 0 }) 
-{
-	try {
-		int numBytesPerPixel = (m_dataFormat == DataFormat::UChar) ? 1 : 2;
-		size_t size = numBytesPerPixel * (size_t)m_width * (size_t)m_height;
-		m_data = new unsigned char[size];
-		memcpy(m_data, data, size);
-	}
-	catch (std::bad_alloc& e) {
-		std::cout << "Memory Allocation " << "Error allocating image." << e.what() << std::endl;
-	}
-}
-
-Image::~Image()
-{
-	clear();
-}
-
-float Image::normalizedMinValue()
-{
-	if (!m_stats.isValid) computeStats();
-	return m_stats.minValue; 
-};
-float Image::normalizedMaxValue()
-{ 
-	if (!m_stats.isValid) computeStats();
-	return m_stats.maxValue;
-};
-
-// 
-// Public
-//
-void Image::clear()
-{
-	m_width = 0;
-	m_height = 0;
-	m_dataFormat = DataFormat::UChar;
-	delete m_data;
-	m_data = nullptr;
-	m_stats.isValid = false;
-}
-bool Image::readFromFile(std::ifstream& fstream)
-{
-	try {
-		clear();
-
-		// Read image parameters
-		std::string line;
-		std::getline(fstream, line);
-		if (line != "key_image") {
-			throw std::runtime_error("Error reading image data.");
-		}
-
-		std::getline(fstream, line);
-		m_width = std::stoi(line);
-		std::getline(fstream, line);
-		m_height = std::stoi(line);
-		std::getline(fstream, line);
-		int format = std::stoi(line);
-		switch (format) {
-		case 1:
-			m_dataFormat = DataFormat::UChar;
-			break;
-		case 2:
-			m_dataFormat = DataFormat::UShort;
-			break;
-		default :
-			throw std::runtime_error("Image format not supported.");
-		}
-
-		// Read image data
-		int numBytesPerPixel = (m_dataFormat == DataFormat::UChar) ? 1 : 2;
-		int size = numBytesPerPixel * m_width * m_height;
-		m_data = new unsigned char[size];
-
-		if (!fstream.read((char*)m_data, size)) {
-			throw std::runtime_error("Error reading image data.");
-		}
-
-		computeStats();
-	}
-	catch (std::bad_alloc& e) {
-		std::cout << "Memory Allocation " << "Error allocating image." << e.what() << std::endl;
-		clear();
-		return false;
-	}
-	catch (const std::exception& e) {
-		std::cout << "Exception " << e.what() << std::endl;
-		return false;
-	}
-	return true;
-}
-bool Image::writeToFile(std::ofstream& fstream) const
-{
-	try {
-		if (!(m_dataFormat == DataFormat::UChar || m_dataFormat == DataFormat::UShort)) {
-			throw std::runtime_error("Image format not supported.");
-		}
-
-		std::string key = "key_image";
-		fstream << key << std::endl;
-		fstream << m_width << std::endl;
-		fstream << m_height << std::endl;
-		int format = (m_dataFormat == DataFormat::UChar) ? 1 : ((m_dataFormat == DataFormat::UShort) ? 2 : 0);
-		fstream << format << std::endl;
-
-		// Write image data
-		int numBytesPerPixel = (m_dataFormat == DataFormat::UChar) ? 1 : 2;
-		int size = numBytesPerPixel * m_width * m_height;
-		fstream.write((char*)m_data, size);
-	}
-	catch (const std::exception& e) {
-		std::cout << "Exception " << e.what() << std::endl;
-		return false;
-	}
-	return true;
-}
-
-//
-// Private
-//
-void Image::computeStats()
-{
-	m_stats = { false, 0, 0 };
-	float max = 0;
-	float min = std::numeric_limits<int>::max();
-	int numVals = m_width * m_height;
-
-	assert(m_dataFormat == DataFormat::UChar || m_dataFormat == DataFormat::UShort);
-	switch (m_dataFormat) {
-	case DataFormat::UShort:
-	{
-		unsigned short* pVal = (unsigned short*)m_data;
-		for (int i = 0; i < numVals; i++) {
-			float val = (float)*pVal++;
-			if (val < min) min = val;
-			if (val > max) max = val;
-		}
-		min /= 65535.0;
-		max /= 65535.0;
-		break;
-	}
-	case DataFormat::UChar:
-	{
-		unsigned char* pVal = m_data;
-		for (int i = 0; i < numVals; i++) {
-			float val = (float)*pVal++;
-			if (val < min) min = val;
-			if (val > max) max = val;
-		}
-		min /= 255.0;
-		max /= 255.0;
-		break;
-	}
-	}
-
-	m_stats.minValue = min;
-	m_stats.maxValue = max;
-	m_stats.isValid = true;
-}
+//
+// Image.cpp
+// Implementation of Image.
+//
+
+#include "Image.h"
+#include "ImageBlockCodec.h"
+#include "../Util/MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string> 
+#include <assert.h>
+
+namespace {
+	// Revisions are shared by all images so they are unique
+	std::atomic<unsigned int> lastRevision(0);
+	unsigned int nextRevision() { return ++lastRevision; }
+}
+
+// 
+// Public
+//
+Image::Image() :
+    m_width(0),
+    m_height(0),
+    m_dataFormat(DataFormat::UChar),
+    m_data(nullptr),
+    m_mappedFile(nullptr),
+    m_revision(nextRevision()),
+    m_stats({ false, 0, 0 })
+{
+}
+Image::Image(int width, int height, DataFormat format, unsigned char* data) :
+	m_width(width),
+	m_height(height),
+	m_dataFormat(format),
+	m_data(nullptr),
+	m_mappedFile(nullptr),
+	m_revision(nextRevision()),
+	m_stats({ false, 0, 0 }) 
+{
+	try {
+		int numBytesPerPixel = (m_dataFormat == DataFormat::UChar) ? 1 : 2;
+		size_t size = numBytesPerPixel * (size_t)m_width * (size_t)m_height;
+		m_data = new unsigned char[size];
+		memcpy(m_data, data, size);
+	}
+	catch (std::bad_alloc& e) {
+		std::cout << "Memory Allocation " << "Error allocating image." << e.what() << std::endl;
+	}
+}
+
+Image::~Image()
+{
+	clear();
+}
+
+float Image::normalizedMinValue()
+{
+	if (!m_stats.isValid) computeStats();
+	return m_stats.minValue; 
+};
+float Image::normalizedMaxValue()
+{ 
+	if (!m_stats.isValid) computeStats();
+	return m_stats.maxValue;
+};
+
+// 
+// Public
+//
+void Image::clear()
+{
+	m_width = 0;
+	m_height = 0;
+	m_dataFormat = DataFormat::UChar;
+	if (m_mappedFile) delete m_mappedFile;
+	else delete m_data;
+	m_mappedFile = nullptr;
+	m_data = nullptr;
+	m_revision = nextRevision();
+	m_stats.isValid = false;
+}
+bool Image::copyFrom(const Image& src)
+{
+	try {
+		if (!src.isValid()) {
+			clear();
+			return false;
+		}
+		int numBytesPerPixel = (src.m_dataFormat == DataFormat::UChar) ? 1 : 2;
+		size_t size = numBytesPerPixel * (size_t)src.m_width * (size_t)src.m_height;
+		if (m_mappedFile || src.m_width != m_width || src.m_height != m_height || src.m_dataFormat != m_dataFormat) {
+			clear();
+			m_data = new unsigned char[size];
+			m_width = src.m_width;
+			m_height = src.m_height;
+			m_dataFormat = src.m_dataFormat;
+		}
+		memcpy(m_data, src.m_data, size);
+		m_revision = nextRevision();
+		m_stats = src.m_stats;
+	}
+	catch (std::bad_alloc& e) {
+		std::cout << "Memory Allocation " << "Error allocating image." << e.what() << std::endl;
+		clear();
+		return false;
+	}
+	return true;
+}
+void Image::swap(Image& other)
+{
+	std::swap(m_width, other.m_width);
+	std::swap(m_height, other.m_height);
+	std::swap(m_dataFormat, other.m_dataFormat);
+	std::swap(m_data, other.m_data);
+	std::swap(m_mappedFile, other.m_mappedFile);
+	std::swap(m_revision, other.m_revision);
+	std::swap(m_stats, other.m_stats);
+}
+bool Image::readFromFile(std::ifstream& fstream)
+{
+	try {
+		clear();
+
+		// Read image parameters
+		std::string line;
+		std::getline(fstream, line);
+		bool isCompressed = (line == "key_image_blocks");
+		if (line != "key_image" && !isCompressed) {
+			throw std::runtime_error("Error reading image data.");
+		}
+
+		std::getline(fstream, line);
+		m_width = std::stoi(line);
+		std::getline(fstream, line);
+		m_height = std::stoi(line);
+		std::getline(fstream, line);
+		int format = std::stoi(line);
+		switch (format) {
+		case 1:
+			m_dataFormat = DataFormat::UChar;
+			break;
+		case 2:
+			m_dataFormat = DataFormat::UShort;
+			break;
+		default :
+			throw std::runtime_error("Image format not supported.");
+		}
+
+		// Read image data
+		int numBytesPerPixel = (m_dataFormat == DataFormat::UChar) ? 1 : 2;
+		int size = numBytesPerPixel * m_width * m_height;
+		m_data = new unsigned char[size];
+
+		if (isCompressed) {
+			if (!ImageBlockCodec::read(fstream, m_width, m_height, numBytesPerPixel, m_data)) {
+				throw std::runtime_error("Error reading compressed image data.");
+			}
+		}
+		else if (!fstream.read((char*)m_data, size)) {
+			throw std::runtime_error("Error reading image data.");
+		}
+
+		computeStats();
+	}
+	catch (std::bad_alloc& e) {
+		std::cout << "Memory Allocation " << "Error allocating image." << e.what() << std::endl;
+		clear();
+		return false;
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+bool Image::writeToFile(std::ofstream& fstream) const
+{
+	try {
+		if (!(m_dataFormat == DataFormat::UChar || m_dataFormat == DataFormat::UShort)) {
+			throw std::runtime_error("Image format not supported.");
+		}
+
+		std::string key = "key_image";
+		fstream << key << std::endl;
+		fstream << m_width << std::endl;
+		fstream << m_height << std::endl;
+		int format = (m_dataFormat == DataFormat::UChar) ? 1 : ((m_dataFormat == DataFormat::UShort) ? 2 : 0);
+		fstream << format << std::endl;
+
+		// Write image data
+		int numBytesPerPixel = (m_dataFormat == DataFormat::UChar) ? 1 : 2;
+		int size = numBytesPerPixel * m_width * m_height;
+		fstream.write((char*)m_data, size);
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+bool Image::mapFromFile(const std::string& filename)
+{
+	try {
+		clear();
+		m_mappedFile = new MappedFile;
+		if (!m_mappedFile->open(filename)) {
+			throw std::runtime_error("Error mapping image file.");
+		}
+
+		// Parse the header lines written by writeToFile
+		const char* header = (const char*)m_mappedFile->data();
+		size_t headerSize = std::min(m_mappedFile->size(), (size_t)256);
+		std::istringstream stream(std::string(header, headerSize));
+		std::string line;
+		std::getline(stream, line);
+		if (line != "key_image") {
+			throw std::runtime_error("Error reading image data.");
+		}
+		int width, height, format;
+		stream >> width >> height >> format;
+		stream.get();
+		if (!stream || width <= 0 || height <= 0 || (format != 1 && format != 2)) {
+			throw std::runtime_error("Image format not supported.");
+		}
+
+		int numBytesPerPixel = (format == 1) ? 1 : 2;
+		size_t offset = (size_t)stream.tellg();
+		size_t size = numBytesPerPixel * (size_t)width * (size_t)height;
+		if (offset + size > m_mappedFile->size()) {
+			throw std::runtime_error("Error reading image data.");
+		}
+		m_width = width;
+		m_height = height;
+		m_dataFormat = (format == 1) ? DataFormat::UChar : DataFormat::UShort;
+		m_data = m_mappedFile->data() + offset;
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		m_data = nullptr;
+		clear();
+		return false;
+	}
+	return true;
+}
+
+//
+// Private
+//
+void Image::computeStats()
+{
+	m_stats = { false, 0, 0 };
+	float max = 0;
+	float min = std::numeric_limits<int>::max();
+	int numVals = m_width * m_height;
+
+	assert(m_dataFormat == DataFormat::UChar || m_dataFormat == DataFormat::UShort);
+	switch (m_dataFormat) {
+	case DataFormat::UShort:
+	{
+		unsigned short* pVal = (unsigned short*)m_data;
+		for (int i = 0; i < numVals; i++) {
+			float val = (float)*pVal++;
+			if (val < min) min = val;
+			if (val > max) max = val;
+		}
+		min /= 65535.0;
+		max /= 65535.0;
+		break;
+	}
+	case DataFormat::UChar:
+	{
+		unsigned char* pVal = m_data;
+		for (int i = 0; i < numVals; i++) {
+			float val = (float)*pVal++;
+			if (val < min) min = val;
+			if (val > max) max = val;
+		}
+		min /= 255.0;
+		max /= 255.0;
+		break;
+	}
+	}
+
+	m_stats.minValue = min;
+	m_stats.maxValue = max;
+	m_stats.isValid = true;
+}
@@ -0,0 +1,215 @@
+//
+// ImageBlockCodec.cpp
+// Implementation of ImageBlockCodec.
+//
+
+#include "ImageBlockCodec.h"
+#include "../Util/Parallel.h"
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+
+// 
+// Public
+//
+bool ImageBlockCodec::write(std::ostream& stream, const Image& image, int rowsPerBlock)
+{
+	try {
+		if (!image.isValid()) {
+			throw std::runtime_error("Image not valid.");
+		}
+		int width = image.width();
+		int height = image.height();
+		int bytesPerPixel = (image.dataFormat() == Image::DataFormat::UChar) ? 1 : 2;
+		rowsPerBlock = std::max(1, rowsPerBlock);
+		int numBlocks = (height + rowsPerBlock - 1) / rowsPerBlock;
+		size_t rowSize = (size_t)width * bytesPerPixel;
+
+		// Blocks are independent, so they are filtered and compressed in parallel
+		std::vector<QByteArray> blocks(numBlocks);
+		Parallel::forRange(0, numBlocks, 1, [&](int begin, int end) {
+			std::vector<unsigned char> filtered;
+			for (int block = begin; block < end; block++) {
+				int firstRow = block * rowsPerBlock;
+				int numRows = std::min(rowsPerBlock, height - firstRow);
+				filtered.resize(numRows * rowSize);
+				encodeRows(image.data() + firstRow * rowSize, width, numRows, bytesPerPixel, filtered.data());
+				blocks[block] = qCompress(filtered.data(), (int)filtered.size());
+			}
+		});
+
+		int format = (bytesPerPixel == 1) ? 1 : 2;
+		stream << "key_image_blocks" << std::endl << width << std::endl << height << std::endl <<
+			format << std::endl << rowsPerBlock << std::endl << numBlocks << std::endl;
+		for (const QByteArray& block : blocks) {
+			int64_t size = block.size();
+			stream.write((const char*)&size, sizeof(size));
+		}
+		for (const QByteArray& block : blocks) {
+			if (block.isEmpty()) throw std::runtime_error("Image compression failed.");
+			stream.write(block.constData(), block.size());
+		}
+		if (!stream.good()) throw std::runtime_error("Error writing image data.");
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool ImageBlockCodec::read(std::istream& stream, int width, int height, int bytesPerPixel, unsigned char* data)
+{
+	try {
+		Index index;
+		long long start = (long long)stream.tellg();
+		if (!readIndex(stream, width, height, bytesPerPixel, &index)) {
+			throw std::runtime_error("Error reading image blocks.");
+		}
+
+		// Read the compressed blocks in one piece, then decode them in parallel
+		long long dataStart = index.blockOffsets.front();
+		std::vector<char> compressed((size_t)(index.blockOffsets.back() - dataStart));
+		stream.seekg(dataStart);
+		if (!stream.read(compressed.data(), compressed.size())) {
+			throw std::runtime_error("Error reading image data.");
+		}
+		int numBlocks = (int)index.blockOffsets.size() - 1;
+		size_t rowSize = (size_t)width * bytesPerPixel;
+		std::atomic<bool> isDecoded(true);
+		Parallel::forRange(0, numBlocks, 1, [&](int begin, int end) {
+			for (int block = begin; block < end; block++) {
+				int firstRow = block * index.rowsPerBlock;
+				int numRows = std::min(index.rowsPerBlock, height - firstRow);
+				size_t offset = (size_t)(index.blockOffsets[block] - dataStart);
+				size_t size = (size_t)(index.blockOffsets[block + 1] - index.blockOffsets[block]);
+				if (!decodeBlock((const unsigned char*)compressed.data() + offset, size, width, numRows,
+					bytesPerPixel, data + firstRow * rowSize)) isDecoded = false;
+			}
+		});
+		if (!isDecoded) throw std::runtime_error("Error decompressing image data.");
+	}
+	catch (std::bad_alloc& e) {
+		std::cout << "Memory Allocation " << "Error reading compressed image." << e.what() << std::endl;
+		return false;
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool ImageBlockCodec::readIndex(std::istream& stream, int width, int height, int bytesPerPixel, Index* index)
+{
+	try {
+		std::string line;
+		std::getline(stream, line);
+		int rowsPerBlock = std::stoi(line);
+		std::getline(stream, line);
+		int numBlocks = std::stoi(line);
+		if (rowsPerBlock <= 0 || numBlocks != (height + rowsPerBlock - 1) / rowsPerBlock) {
+			throw std::runtime_error("Bad image block layout.");
+		}
+		std::vector<int64_t> sizes(numBlocks);
+		if (!stream.read((char*)sizes.data(), numBlocks * sizeof(int64_t))) {
+			throw std::runtime_error("Error reading image block index.");
+		}
+
+		index->width = width;
+		index->height = height;
+		index->bytesPerPixel = bytesPerPixel;
+		index->rowsPerBlock = rowsPerBlock;
+		index->blockOffsets.assign(1, (long long)stream.tellg());
+		for (int64_t size : sizes) {
+			if (size <= 0) throw std::runtime_error("Bad image block size.");
+			index->blockOffsets.push_back(index->blockOffsets.back() + size);
+		}
+		stream.seekg(index->blockOffsets.back());
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+bool ImageBlockCodec::readBlock(std::istream& stream, const Index& index, int block, unsigned char* data)
+{
+	int numBlocks = (int)index.blockOffsets.size() - 1;
+	if (block < 0 || block >= numBlocks) return false;
+	std::vector<char> compressed((size_t)(index.blockOffsets[block + 1] - index.blockOffsets[block]));
+	stream.seekg(index.blockOffsets[block]);
+	if (!stream.read(compressed.data(), compressed.size())) return false;
+	int numRows = std::min(index.rowsPerBlock, index.height - block * index.rowsPerBlock);
+	return decodeBlock((const unsigned char*)compressed.data(), compressed.size(), index.width, numRows,
+		index.bytesPerPixel, data);
+}
+
+//
+// Private
+//
+void ImageBlockCodec::encodeRows(const unsigned char* rows, int width, int numRows, int bytesPerPixel,
+	unsigned char* filtered)
+{
+	// Differences from the left neighbor are small in smooth regions, which compresses
+	// well. 16-bit differences are stored as a plane of high bytes, then of low bytes.
+	size_t numPixels = (size_t)width * numRows;
+	if (bytesPerPixel == 1) {
+		for (int j = 0; j < numRows; j++) {
+			const unsigned char* row = rows + (size_t)j * width;
+			unsigned char* dst = filtered + (size_t)j * width;
+			unsigned char prev = 0;
+			for (int i = 0; i < width; i++) {
+				dst[i] = (unsigned char)(row[i] - prev);
+				prev = row[i];
+			}
+		}
+	}
+	else {
+		unsigned char* high = filtered;
+		unsigned char* low = filtered + numPixels;
+		for (int j = 0; j < numRows; j++) {
+			const unsigned short* row = (const unsigned short*)rows + (size_t)j * width;
+			unsigned short prev = 0;
+			for (int i = 0; i < width; i++) {
+				unsigned short delta = (unsigned short)(row[i] - prev);
+				prev = row[i];
+				*high++ = (unsigned char)(delta >> 8);
+				*low++ = (unsigned char)(delta & 0xFF);
+			}
+		}
+	}
+}
+bool ImageBlockCodec::decodeBlock(const unsigned char* compressed, size_t compressedSize, int width, 
+	int numRows, int bytesPerPixel, unsigned char* rows)
+{
+	QByteArray filtered = qUncompress(compressed, (int)compressedSize);
+	size_t numPixels = (size_t)width * numRows;
+	if ((size_t)filtered.size() != numPixels * bytesPerPixel) return false;
+	const unsigned char* src = (const unsigned char*)filtered.constData();
+	if (bytesPerPixel == 1) {
+		for (int j = 0; j < numRows; j++) {
+			unsigned char* row = rows + (size_t)j * width;
+			const unsigned char* deltas = src + (size_t)j * width;
+			unsigned char value = 0;
+			for (int i = 0; i < width; i++) row[i] = value = (unsigned char)(value + deltas[i]);
+		}
+	}
+	else {
+		const unsigned char* high = src;
+		const unsigned char* low = src + numPixels;
+		for (int j = 0; j < numRows; j++) {
+			unsigned short* row = (unsigned short*)rows + (size_t)j * width;
+			unsigned short value = 0;
+			for (int i = 0; i < width; i++) {
+				value = (unsigned short)(value + (((unsigned short)*high++ << 8) | *low++));
+				row[i] = value;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,65 @@
+//
+// ImageBlockCodec.h
+// Compressed encoding of image data for VESCL files. The image is split into blocks of
+// whole rows. Each block is filtered by predicting each pixel from its left neighbor,
+// with the bytes of 16-bit deltas split into high and low byte planes, and compressed 
+// with deflate (qCompress). Blocks are encoded and decoded in parallel, and an index of
+// block sizes allows any block to be read on its own, e.g., to page in image tiles.
+// 
+// Section layout: key_image_blocks, width, height, format, rows per block and number
+// of blocks as text lines, then the compressed size of each block as 64-bit integers, 
+// then the compressed blocks.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "Image.h"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+class ImageBlockCodec
+{
+public:
+	static const int defaultRowsPerBlock = 64;
+
+	// Writes the whole image section, including its key line
+	static bool write(std::ostream& stream, const Image& image, int rowsPerBlock = defaultRowsPerBlock);
+
+	// Reads the blocks of a section whose key, width, height and format lines were read, 
+	// into data, which holds width * height pixels of bytesPerPixel bytes
+	static bool read(std::istream& stream, int width, int height, int bytesPerPixel, unsigned char* data);
+
+	// Random access to blocks. readIndex() reads the section's block layout after its
+	// format line and leaves the stream after the section. readBlock() decodes the rows of
+	// one block into data, which holds rowsPerBlock rows or fewer for the last block.
+	typedef struct {
+		int width;
+		int height;
+		int bytesPerPixel;
+		int rowsPerBlock;
+		std::vector<long long> blockOffsets;	// Stream positions, with the section end last
+	} Index;
+	static bool readIndex(std::istream& stream, int width, int height, int bytesPerPixel, Index* index);
+	static bool readBlock(std::istream& stream, const Index& index, int block, unsigned char* data);
+
+private:
+	static void encodeRows(const unsigned char* rows, int width, int numRows, int bytesPerPixel, 
+		unsigned char* filtered);
+	static bool decodeBlock(const unsigned char* compressed, size_t compressedSize, int width, 
+		int numRows, int bytesPerPixel, unsigned char* rows);
+};
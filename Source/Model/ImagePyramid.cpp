@@ -0,0 +1,126 @@
+//
+// ImagePyramid.cpp
+// Implementation of ImagePyramid.
+//
+
+#include "ImagePyramid.h"
+#include "../Util/Parallel.h"
+
+#include <algorithm>
+
+using Math::Vec2D;
+
+namespace {
+	// Binomial approximation of a Gaussian with a sigma of 1
+	const float filter[5] = { 1 / 16.0f, 4 / 16.0f, 6 / 16.0f, 4 / 16.0f, 1 / 16.0f };
+}
+
+//
+// Public
+//
+ImagePyramid::ImagePyramid() :
+	m_imageRevision(0)
+{
+}
+
+void ImagePyramid::build(const Image& image, int maxLevels)
+{
+	m_levels.clear();
+	m_imageRevision = image.revision();
+	if (!image.isValid()) return;
+	int numImageLevels = numLevels(image.width(), image.height(), maxLevels);
+	m_levels.resize(numImageLevels);
+	m_levels[0].width = image.width();
+	m_levels[0].height = image.height();
+	for (int level = 1; level < numImageLevels; level++) buildLevel(image, level);
+}
+int ImagePyramid::numLevels(int width, int height, int maxLevels)
+{
+	int numImageLevels = 1;
+	while (numImageLevels < maxLevels) {
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+		if (width < minLevelSize || height < minLevelSize) break;
+		numImageLevels++;
+	}
+	return numImageLevels;
+}
+
+float ImagePyramid::valueAtP(int level, Vec2D p) const
+{
+	// Bi-linear interpolation as in ImageFilterer::imageValueAtP
+	const Level& data = m_levels[level];
+	float x = p[0];
+	float y = p[1];
+	int i0 = std::min(data.width - 1, std::max(0, (int)x));
+	int j0 = std::min(data.height - 1, std::max(0, (int)y));
+	int i1 = std::min(data.width - 1, std::max(0, (int)x + 1));
+	int j1 = std::min(data.height - 1, std::max(0, (int)y + 1));
+	const float* row0 = &data.values[(size_t)j0 * data.width];
+	const float* row1 = &data.values[(size_t)j1 * data.width];
+	float s = x - (float)(int)x;
+	float t = y - (float)(int)y;
+	return (1 - s) * (1 - t) * row0[i0] + s * (1 - t) * row0[i1] + (1 - s) * t * row1[i0] + s * t * row1[i1];
+}
+
+//
+// Private
+//
+void ImagePyramid::buildLevel(const Image& image, int level)
+{
+	// Each chunk of output rows filters the input rows it needs horizontally, at even
+	// columns only, and keeps the last five in a ring for the vertical filter. Edge
+	// pixels are repeated beyond the edges.
+	int inWidth = m_levels[level - 1].width;
+	int inHeight = m_levels[level - 1].height;
+	Level& out = m_levels[level];
+	out.width = (inWidth + 1) / 2;
+	out.height = (inHeight + 1) / 2;
+	out.values.resize((size_t)out.width * out.height);
+	Parallel::forRange(0, out.height, 16, [&](int first, int last) {
+		std::vector<float> row(inWidth);
+		std::vector<float> ring(5 * (size_t)out.width);
+		int nextRow = std::max(0, 2 * first - 2);
+		for (int j = first; j < last; j++) {
+			for (; nextRow <= std::min(inHeight - 1, 2 * j + 2); nextRow++) {
+				readRow(image, level - 1, nextRow, row.data());
+				float* filtered = &ring[(nextRow % 5) * (size_t)out.width];
+				for (int i = 0; i < out.width; i++) {
+					if (i > 0 && 2 * i + 2 < inWidth) {
+						const float* in = row.data() + 2 * i - 2;
+						filtered[i] = filter[0] * (in[0] + in[4]) + filter[1] * (in[1] + in[3]) + filter[2] * in[2];
+						continue;
+					}
+					float value = 0;
+					for (int k = 0; k < 5; k++) {
+						int x = std::min(inWidth - 1, std::max(0, 2 * i + k - 2));
+						value += filter[k] * row[x];
+					}
+					filtered[i] = value;
+				}
+			}
+			float* values = &out.values[(size_t)j * out.width];
+			std::fill(values, values + out.width, 0.0f);
+			for (int k = 0; k < 5; k++) {
+				int y = std::min(inHeight - 1, std::max(0, 2 * j + k - 2));
+				const float* filtered = &ring[(y % 5) * (size_t)out.width];
+				for (int i = 0; i < out.width; i++) values[i] += filter[k] * filtered[i];
+			}
+		}
+	});
+}
+void ImagePyramid::readRow(const Image& image, int level, int y, float* row) const
+{
+	if (level > 0) {
+		const float* values = m_levels[level].values.data() + (size_t)y * m_levels[level].width;
+		std::copy(values, values + m_levels[level].width, row);
+	}
+	else if (image.dataFormat() == Image::DataFormat::UShort) {
+		const unsigned short* data = (const unsigned short*)image.data() + (size_t)y * image.width();
+		for (int i = 0; i < image.width(); i++) row[i] = (float)data[i];
+	}
+	else {
+		const unsigned char* data = image.data() + (size_t)y * image.width();
+		for (int i = 0; i < image.width(); i++) row[i] = (float)data[i];
+	}
+}
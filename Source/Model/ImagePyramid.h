@@ -0,0 +1,65 @@
+//
+// ImagePyramid.h
+// Gaussian image pyramid. Each level is the level below smoothed with a 5-tap binomial
+// filter and subsampled by 2, so pixel (i, j) of level l lies at (i, j) * 2^l in the
+// image. Vessels can then be fitted at the level where they are a few pixels wide, with
+// small filters whatever their width.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "Image.h"
+#include "Math.h"
+
+#include <vector>
+
+class ImagePyramid
+{
+public:
+	ImagePyramid();
+
+	// Builds up to maxLevels levels of the image, stopping before either dimension of a
+	// level drops below minLevelSize. Level 0 is the image itself and is not copied.
+	// Values are in the units of the image data.
+	void build(const Image& image, int maxLevels);
+	int numLevels() const { return (int)m_levels.size(); };
+	int width(int level) const { return m_levels[level].width; };
+	int height(int level) const { return m_levels[level].height; };
+	unsigned int imageRevision() const { return m_imageRevision; };
+
+	// Number of levels of a pyramid of an image of the given size
+	static int numLevels(int width, int height, int maxLevels);
+	static const int minLevelSize = 16;
+
+	// Bi-linearly interpolated value at p in the coordinates of the level, for levels
+	// from 1. Positions beyond the level's edges take the edge values.
+	float valueAtP(int level, Math::Vec2D p) const;
+
+	// Make non-copyable
+	ImagePyramid(ImagePyramid const&) = delete;
+	void operator=(ImagePyramid const&) = delete;
+
+private:
+	typedef struct {
+		int width;
+		int height;
+		std::vector<float> values;
+	} Level;
+	std::vector<Level> m_levels;
+	unsigned int m_imageRevision;
+	void buildLevel(const Image& image, int level);
+	void readRow(const Image& image, int level, int y, float* row) const;
+};
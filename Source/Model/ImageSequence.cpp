@@ -0,0 +1,159 @@
+//
+// ImageSequence.cpp
+// Implementation of ImageSequence.
+//
+
+#include "ImageSequence.h"
+
+#include <algorithm>
+
+// 
+// Public
+//
+ImageSequence::ImageSequence(int numFrames, FrameDecoder decoder, size_t maxCacheBytes) :
+	m_numFrames(std::max(0, numFrames)),
+	m_decoder(decoder),
+	m_maxCacheBytes(maxCacheBytes),
+	m_numCachedBytes(0),
+	m_useClock(0),
+	m_currentFrame(0),
+	m_direction(1),
+	m_numAhead(8),
+	m_numBehind(2),
+	m_numHits(0),
+	m_numMisses(0),
+	m_isRunning(true)
+{
+	m_prefetchThread = std::thread(&ImageSequence::prefetch, this);
+}
+ImageSequence::~ImageSequence()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isRunning = false;
+	}
+	m_condition.notify_all();
+	m_prefetchThread.join();
+}
+
+std::shared_ptr<const Image> ImageSequence::frame(int frame)
+{
+	if (frame < 0 || frame >= m_numFrames) return nullptr;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (frame != m_currentFrame) m_direction = (frame > m_currentFrame) ? 1 : -1;
+	m_currentFrame = frame;
+
+	// Wait for the prefetch thread if it is decoding the frame, otherwise decode it here
+	std::shared_ptr<const Image> image;
+	std::map<int, CacheEntry>::iterator it = m_cache.find(frame);
+	if (it == m_cache.end() && m_decodingFrames.count(frame) > 0) {
+		m_condition.wait(lock, [&]() { return m_decodingFrames.count(frame) == 0; });
+		it = m_cache.find(frame);
+	}
+	if (it != m_cache.end()) {
+		it->second.lastUsed = ++m_useClock;
+		image = it->second.image;
+		m_numHits++;
+	}
+	else {
+		m_numMisses++;
+		image = decode(frame, lock);
+	}
+	m_condition.notify_all();
+	return image;
+}
+
+void ImageSequence::setPrefetchRange(int numAhead, int numBehind)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_numAhead = std::max(0, numAhead);
+	m_numBehind = std::max(0, numBehind);
+	m_condition.notify_all();
+}
+size_t ImageSequence::numCachedBytes()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_numCachedBytes;
+}
+
+//
+// Private
+//
+void ImageSequence::prefetch()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (m_isRunning) {
+		int frame = nextFrameToPrefetch();
+		if (frame < 0) {
+			m_condition.wait(lock);
+			continue;
+		}
+		decode(frame, lock);
+	}
+}
+int ImageSequence::nextFrameToPrefetch() const
+{
+	// Nearest uncached frames first, alternating ahead and behind while both remain. 
+	// Prefetching stops when the frames would not fit in the cache with the frames 
+	// nearer the current frame.
+	size_t frameBytes = m_cache.empty() ? 0 : numBytes(*m_cache.begin()->second.image);
+	size_t numWindowBytes = 0;
+	int maxDistance = std::max(m_numAhead, m_numBehind);
+	for (int distance = 0; distance <= maxDistance; distance++) {
+		int candidates[2] = { m_currentFrame + m_direction * distance, m_currentFrame - m_direction * distance };
+		int numCandidates = (distance == 0) ? 1 : 2;
+		for (int i = 0; i < numCandidates; i++) {
+			if (distance > ((i == 0) ? m_numAhead : m_numBehind)) continue;
+			int frame = candidates[i];
+			if (frame < 0 || frame >= m_numFrames) continue;
+			numWindowBytes += frameBytes;
+			if (numWindowBytes > m_maxCacheBytes) return -1;
+			if (m_cache.count(frame) == 0 && m_decodingFrames.count(frame) == 0 && 
+				m_failedFrames.count(frame) == 0) {
+				return frame;
+			}
+		}
+	}
+	return -1;
+}
+std::shared_ptr<const Image> ImageSequence::decode(int frame, std::unique_lock<std::mutex>& lock)
+{
+	// Decode without holding the lock so the caller and the prefetch thread can decode
+	// different frames at the same time
+	m_decodingFrames.insert(frame);
+	lock.unlock();
+	std::shared_ptr<Image> image(new Image);
+	bool isDecoded = m_decoder(frame, *image) && image->isValid();
+	lock.lock();
+	m_decodingFrames.erase(frame);
+	if (isDecoded) {
+		m_failedFrames.erase(frame);
+		m_cache[frame] = { image, ++m_useClock };
+		m_numCachedBytes += numBytes(*image);
+		evict();
+	}
+	else {
+		m_failedFrames.insert(frame);
+	}
+	m_condition.notify_all();
+	return isDecoded ? image : nullptr;
+}
+void ImageSequence::evict()
+{
+	// Least recently used frames are evicted first, but never the current frame
+	while (m_numCachedBytes > m_maxCacheBytes && m_cache.size() > 1) {
+		std::map<int, CacheEntry>::iterator oldest = m_cache.end();
+		for (std::map<int, CacheEntry>::iterator it = m_cache.begin(); it != m_cache.end(); it++) {
+			if (it->first == m_currentFrame) continue;
+			if (oldest == m_cache.end() || it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+		}
+		if (oldest == m_cache.end()) break;
+		m_numCachedBytes -= numBytes(*oldest->second.image);
+		m_cache.erase(oldest);
+	}
+}
+size_t ImageSequence::numBytes(const Image& image)
+{
+	int numBytesPerPixel = (image.dataFormat() == Image::DataFormat::UShort) ? 2 : 1;
+	return numBytesPerPixel * (size_t)image.width() * (size_t)image.height();
+}
@@ -0,0 +1,93 @@
+//
+// ImageSequence.h
+// Frame source for image sequences, e.g., cine angiography runs. Frames are decoded on
+// demand into a cache with a memory budget. A background thread prefetches frames 
+// around the current frame, more of them in the direction the sequence is being 
+// scrubbed, so stepping through frames rarely waits for decoding.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "Image.h"
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+class ImageSequence
+{
+public:
+	// The decoder is called on the caller's and the prefetch thread, so it must be safe
+	// to call concurrently for different frames
+	typedef std::function<bool(int frame, Image& image)> FrameDecoder;
+	ImageSequence(int numFrames, FrameDecoder decoder, size_t maxCacheBytes = 1024 * 1024 * 1024);
+	~ImageSequence();
+
+	int numFrames() const { return m_numFrames; };
+
+	// Returns the frame, decoded now if it is not cached, or nullptr if it can't be 
+	// decoded. Frames are prefetched around it in the background. Frames that fail to
+	// decode are not prefetched again, but are retried when requested.
+	std::shared_ptr<const Image> frame(int frame);
+
+	// Frames prefetched in the scrub direction and against it
+	void setPrefetchRange(int numAhead, int numBehind);
+
+	// Cache statistics
+	size_t numCachedBytes();
+	int numHits() const { return m_numHits; };
+	int numMisses() const { return m_numMisses; };
+
+	// Make non-copyable
+	ImageSequence(ImageSequence const&) = delete;
+	void operator=(ImageSequence const&) = delete;
+
+private:
+	int m_numFrames;
+	FrameDecoder m_decoder;
+	size_t m_maxCacheBytes;
+
+	// Cache and prefetch state, guarded by m_mutex
+	typedef struct {
+		std::shared_ptr<const Image> image;
+		unsigned long long lastUsed;
+	} CacheEntry;
+	std::map<int, CacheEntry> m_cache;
+	size_t m_numCachedBytes;
+	unsigned long long m_useClock;
+	std::set<int> m_decodingFrames;
+	std::set<int> m_failedFrames;
+	int m_currentFrame;
+	int m_direction;
+	int m_numAhead;
+	int m_numBehind;
+	int m_numHits;
+	int m_numMisses;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+
+	bool m_isRunning;
+	std::thread m_prefetchThread;
+	void prefetch();
+	int nextFrameToPrefetch() const;
+	std::shared_ptr<const Image> decode(int frame, std::unique_lock<std::mutex>& lock);
+	void evict();
+	static size_t numBytes(const Image& image);
+};
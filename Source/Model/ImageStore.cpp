@@ -0,0 +1,100 @@
+//
+// ImageStore.cpp
+// Implementation of ImageStore.
+//
+
+#include "ImageStore.h"
+#include "../Util/Sha256.h"
+
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <sstream>
+
+// 
+// Public
+//
+ImageStore::ImageStore(const std::string& directory) :
+	m_directory(directory)
+{
+}
+
+std::string ImageStore::key(const Image& image)
+{
+	int numBytesPerPixel = (image.dataFormat() == Image::DataFormat::UChar) ? 1 : 2;
+	size_t size = numBytesPerPixel * (size_t)image.width() * (size_t)image.height();
+	std::string imageHeader = header(image);
+	Sha256 sha;
+	sha.update(imageHeader.data(), imageHeader.size());
+	sha.update(image.data(), size);
+	return sha.hexDigest();
+}
+
+bool ImageStore::put(const Image& image, const std::string& key)
+{
+	try {
+		if (!image.isValid()) {
+			throw std::runtime_error("Image not valid.");
+		}
+		if (contains(key)) return true;
+
+		// Another writer, in this or another process, may store the same image 
+		// concurrently, so each writer has its own temporary file. Either rename leaves
+		// the same content, and a rename that fails because the other writer's image is 
+		// already in place is a success.
+		std::string tempFilename = filename(key) + "." + tempSuffix() + ".tmp";
+		{
+			std::ofstream file(tempFilename.c_str(), std::ios::binary);
+			if (!file.is_open() || !image.writeToFile(file) || !file.good()) {
+				throw std::runtime_error("Failed to write image to store.");
+			}
+		}
+		if (std::rename(tempFilename.c_str(), filename(key).c_str()) != 0) {
+			std::remove(tempFilename.c_str());
+			if (!contains(key)) throw std::runtime_error("Failed to add image to store.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+bool ImageStore::get(const std::string& key, Image& image) const
+{
+	return image.mapFromFile(filename(key));
+}
+bool ImageStore::contains(const std::string& key) const
+{
+	std::ifstream file(filename(key).c_str(), std::ios::binary);
+	return file.is_open();
+}
+std::string ImageStore::filename(const std::string& key) const
+{
+	std::string directory = m_directory;
+	if (!directory.empty() && directory.back() != '/' && directory.back() != '\\') directory += '/';
+	return directory + key + ".vimg";
+}
+
+//
+// Private
+//
+std::string ImageStore::tempSuffix()
+{
+	// A random ID per process and a counter per writer in the process
+	static const unsigned long long processID = ((unsigned long long)std::random_device()() << 32) ^ 
+		std::random_device()();
+	static std::atomic<unsigned int> numWriters(0);
+	std::ostringstream stream;
+	stream << std::hex << processID << "_" << numWriters++;
+	return stream.str();
+}
+std::string ImageStore::header(const Image& image)
+{
+	// As written by Image::writeToFile
+	std::ostringstream stream;
+	int format = (image.dataFormat() == Image::DataFormat::UChar) ? 1 : 2;
+	stream << "key_image" << std::endl << image.width() << std::endl << image.height() << std::endl <<
+		format << std::endl;
+	return stream.str();
+}
@@ -0,0 +1,48 @@
+//
+// ImageStore.h
+// Content-addressed store of images in a shared directory. Each image is stored once, 
+// as <SHA-256>.vimg with the layout of the image section of a VESCL file, so VESCL files
+// of the same image can hold a reference to it instead of the image data. Stored images
+// are memory mapped when they are loaded.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "Image.h"
+
+#include <string>
+
+class ImageStore
+{
+public:
+	ImageStore(const std::string& directory);
+	~ImageStore() {};
+
+	// Key of an image, the SHA-256 of its stored content
+	static std::string key(const Image& image);
+
+	// Stores the image unless an image with the same key is already stored. Images are 
+	// written to a temporary file and renamed, so readers never see partial images.
+	bool put(const Image& image, const std::string& key);
+	bool get(const std::string& key, Image& image) const;
+	bool contains(const std::string& key) const;
+	std::string filename(const std::string& key) const;
+
+private:
+	std::string m_directory;
+	static std::string header(const Image& image);
+	static std::string tempSuffix();
+};
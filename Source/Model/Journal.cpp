@@ -0,0 +1,405 @@
+//
+// Journal.cpp
+// Implementation of Journal.
+//
+
+#include "Journal.h"
+#include "../Util/RasterFileWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+	const std::string journalMagic = "VSCLJRNL0001\n";
+
+	// Bytes at the end of the VESCL file that identify its contour, with the file size
+	const long long fingerprintBytes = 64 * 1024;
+
+	uint32_t checksum(unsigned char type, const std::string& payload)
+	{
+		uint32_t crc = RasterFileWriter::crc32(0xFFFFFFFFu, &type, 1);
+		crc = RasterFileWriter::crc32(crc, (const unsigned char*)payload.data(), payload.size());
+		return crc ^ 0xFFFFFFFFu;
+	}
+	template <typename T> void put(std::string& s, T value) { s.append((const char*)&value, sizeof(T)); }
+	template <typename T> T get(const std::string& s, size_t& pos)
+	{
+		if (pos + sizeof(T) > s.size()) throw std::runtime_error("Journal record too short.");
+		T value;
+		memcpy(&value, s.data() + pos, sizeof(T));
+		pos += sizeof(T);
+		return value;
+	}
+}
+
+// 
+// Public
+//
+Journal::Journal() :
+	m_numBytes(0),
+	m_checkpointEnd(0),
+	m_nextKey(0)
+{
+}
+Journal::~Journal()
+{
+	close(false);
+}
+
+int Journal::open(const std::string& filename, Contour& contour, bool replay)
+{
+	close(false);
+	m_filename = filename;
+	resetKeys(contour);
+	int numReplayed = 0;
+	try {
+		std::ifstream in(journalFilename(filename).c_str(), std::ios::binary);
+		std::string magic(journalMagic.size(), '\0');
+		if (replay && in.read(&magic[0], magic.size()) && magic == journalMagic) {
+
+			// Records are applied if the journal is based on the file as it is, or after a
+			// checkpoint if the file's contour was rewritten or interrupted while being
+			// rewritten. Replay stops at the first torn or corrupt record.
+			std::string base = baseFingerprint(filename);
+			bool isApplying = false;
+			bool isContinued = false;
+			size_t validEnd = journalMagic.size();
+			RecordType type;
+			std::string payload;
+			std::map<unsigned int, int> curveIDs = keysToIDs();
+			while (readRecord(in, &type, &payload)) {
+				if (type == RecordType::Base) isApplying = isContinued = (payload == base);
+				if (type == RecordType::Checkpoint) isApplying = isContinued = true;
+				if (isApplying && type != RecordType::Base) {
+					if (!applyRecord(type, payload, contour, curveIDs)) break;
+					numReplayed++;
+				}
+				validEnd = (size_t)in.tellg();
+				if (type == RecordType::Checkpoint) m_checkpointEnd = validEnd;
+			}
+			in.close();
+
+			// Continue the journal after its last valid record
+			if (isContinued && truncateFile(journalFilename(filename), validEnd)) {
+				m_file.open(journalFilename(filename).c_str(), std::ios::binary | std::ios::app);
+				m_numBytes = validEnd;
+				for (Curve* curve : *contour.curves()) m_curveStates[curve->id()].revision = curve->revision();
+				contour.deselectCurve();
+				if (!m_file.is_open()) throw std::runtime_error("Failed to open journal.");
+				return numReplayed;
+			}
+			if (numReplayed > 0) throw std::runtime_error("Failed to continue journal.");
+		}
+		in.close();
+		resetKeys(contour);
+		m_checkpointEnd = 0;
+		if (!start()) throw std::runtime_error("Failed to start journal.");
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		close(false);
+		return -1;
+	}
+	return 0;
+}
+void Journal::close(bool removeFile)
+{
+	if (m_file.is_open()) m_file.close();
+	if (removeFile && !m_filename.empty()) std::remove(journalFilename(m_filename).c_str());
+	m_filename.clear();
+	m_numBytes = 0;
+	m_checkpointEnd = 0;
+	m_curveStates.clear();
+	m_order.clear();
+}
+
+bool Journal::append(Contour& contour)
+{
+	if (!isOpen()) return false;
+
+	// Changed curves are written whole. Unchanged curves are skipped by revision.
+	std::map<int, CurveState> curveStates;
+	std::vector<unsigned int> order;
+	bool isWritten = true;
+	for (Curve* curve : *contour.curves()) {
+		std::map<int, CurveState>::iterator it = m_curveStates.find(curve->id());
+		CurveState state;
+		if (it != m_curveStates.end()) state = it->second;
+		else state.key = m_nextKey++;
+		if (it == m_curveStates.end() || state.revision != curve->revision()) {
+			const std::list<CurvePoint>& points = static_cast<const Curve*>(curve)->points();
+			std::string payload;
+			put<uint32_t>(payload, state.key);
+			put<uint32_t>(payload, (uint32_t)points.size());
+			for (const CurvePoint& p : points) {
+				put<float>(payload, (float)p.pos()[0]);
+				put<float>(payload, (float)p.pos()[1]);
+				put<float>(payload, p.radius());
+			}
+			isWritten &= writeRecord(RecordType::SetCurve, payload);
+			state.revision = curve->revision();
+		}
+		curveStates[curve->id()] = state;
+		order.push_back(state.key);
+	}
+
+	// Removed curves, and the order if it differs from the order replay would give
+	std::vector<unsigned int> replayOrder;
+	for (unsigned int key : m_order) {
+		if (std::find(order.begin(), order.end(), key) != order.end()) replayOrder.push_back(key);
+		else {
+			std::string payload;
+			put<uint32_t>(payload, key);
+			isWritten &= writeRecord(RecordType::RemoveCurve, payload);
+		}
+	}
+	for (unsigned int key : order) {
+		if (std::find(m_order.begin(), m_order.end(), key) == m_order.end()) replayOrder.push_back(key);
+	}
+	if (replayOrder != order) {
+		std::string payload;
+		put<uint32_t>(payload, (uint32_t)order.size());
+		for (unsigned int key : order) put<uint32_t>(payload, key);
+		isWritten &= writeRecord(RecordType::Order, payload);
+	}
+	m_curveStates.swap(curveStates);
+	m_order.swap(order);
+	m_file.flush();
+	return isWritten && m_file.good();
+}
+
+bool Journal::checkpoint(Contour& contour, std::string* contourData)
+{
+	if (!append(contour)) return false;
+	std::ostringstream stream;
+	contour.writeToFile(stream);
+	*contourData = stream.str();
+	if (!writeRecord(RecordType::Checkpoint, *contourData)) return false;
+	m_file.flush();
+	m_checkpointEnd = m_numBytes;
+	resetKeys(contour);
+	return m_file.good();
+}
+bool Journal::rebase()
+{
+	if (!isOpen()) return false;
+	try {
+		// Records after the checkpoint are relative to the rewritten contour. They are
+		// copied to a new journal based on the rewritten file, which replaces this one.
+		m_file.close();
+		std::string filename = journalFilename(m_filename);
+		std::string tempFilename = filename + ".tmp";
+		std::ifstream in(filename.c_str(), std::ios::binary);
+		in.seekg(m_checkpointEnd);
+		std::string records((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		in.close();
+
+		m_file.open(tempFilename.c_str(), std::ios::binary | std::ios::trunc);
+		m_numBytes = 0;
+		m_file.write(journalMagic.data(), journalMagic.size());
+		m_numBytes += journalMagic.size();
+		if (!writeRecord(RecordType::Base, baseFingerprint(m_filename))) {
+			throw std::runtime_error("Failed to write journal.");
+		}
+		m_file.write(records.data(), records.size());
+		m_numBytes += records.size();
+		m_file.close();
+		if (!m_file.good()) throw std::runtime_error("Failed to write journal.");
+		std::remove(filename.c_str());
+		if (std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
+			throw std::runtime_error("Failed to replace journal.");
+		}
+		m_file.open(filename.c_str(), std::ios::binary | std::ios::app);
+		m_checkpointEnd = 0;
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return m_file.is_open();
+}
+
+bool Journal::writeContourInPlace(const std::string& filename, long long contourOffset,
+	const std::string& contourData)
+{
+	FILE* file = fopen(filename.c_str(), "r+b");
+	if (!file) return false;
+#ifdef _WIN32
+	bool isWritten = (_fseeki64(file, contourOffset, SEEK_SET) == 0);
+#else
+	bool isWritten = (fseeko(file, contourOffset, SEEK_SET) == 0);
+#endif
+	isWritten = isWritten && (fwrite(contourData.data(), 1, contourData.size(), file) == contourData.size());
+	isWritten = isWritten && (fflush(file) == 0);
+	fclose(file);
+	return isWritten && truncateFile(filename, contourOffset + (long long)contourData.size());
+}
+
+//
+// Private
+//
+void Journal::resetKeys(Contour& contour)
+{
+	m_curveStates.clear();
+	m_order.clear();
+	m_nextKey = 0;
+	for (Curve* curve : *contour.curves()) {
+		CurveState state;
+		state.key = m_nextKey++;
+		state.revision = curve->revision();
+		m_curveStates[curve->id()] = state;
+		m_order.push_back(state.key);
+	}
+}
+
+bool Journal::start()
+{
+	m_file.open(journalFilename(m_filename).c_str(), std::ios::binary | std::ios::trunc);
+	if (!m_file.is_open()) return false;
+	m_file.write(journalMagic.data(), journalMagic.size());
+	m_numBytes = journalMagic.size();
+	bool isWritten = writeRecord(RecordType::Base, baseFingerprint(m_filename));
+	m_file.flush();
+	return isWritten && m_file.good();
+}
+
+bool Journal::writeRecord(RecordType type, const std::string& payload)
+{
+	// Payload size, type, payload and checksum of type and payload
+	std::string record;
+	put<uint32_t>(record, (uint32_t)payload.size());
+	put<unsigned char>(record, (unsigned char)type);
+	record.append(payload);
+	put<uint32_t>(record, checksum((unsigned char)type, payload));
+	m_file.write(record.data(), record.size());
+	m_numBytes += record.size();
+	return m_file.good();
+}
+bool Journal::readRecord(std::istream& stream, RecordType* type, std::string* payload)
+{
+	uint32_t size = 0;
+	unsigned char typeValue = 0;
+	uint32_t crc = 0;
+	if (!stream.read((char*)&size, sizeof(size))) return false;
+	if (!stream.read((char*)&typeValue, sizeof(typeValue))) return false;
+	std::streampos start = stream.tellg();
+	stream.seekg(0, std::ios::end);
+	if (stream.tellg() - start < (std::streamoff)size + (std::streamoff)sizeof(crc)) return false;
+	stream.seekg(start);
+	payload->resize(size);
+	if (size > 0 && !stream.read(&(*payload)[0], size)) return false;
+	if (!stream.read((char*)&crc, sizeof(crc))) return false;
+	if (crc != checksum(typeValue, *payload)) return false;
+	if (typeValue < (unsigned char)RecordType::Base || typeValue > (unsigned char)RecordType::Checkpoint) return false;
+	*type = (RecordType)typeValue;
+	return true;
+}
+std::map<unsigned int, int> Journal::keysToIDs() const
+{
+	std::map<unsigned int, int> curveIDs;
+	for (const std::pair<const int, CurveState>& state : m_curveStates) curveIDs[state.second.key] = state.first;
+	return curveIDs;
+}
+bool Journal::applyRecord(RecordType type, const std::string& payload, Contour& contour,
+	std::map<unsigned int, int>& curveIDs)
+{
+	try {
+		size_t pos = 0;
+		if (type == RecordType::SetCurve) {
+			unsigned int key = get<uint32_t>(payload, pos);
+			uint32_t numPoints = get<uint32_t>(payload, pos);
+			if (payload.size() != pos + numPoints * 3 * sizeof(float)) throw std::runtime_error("Bad curve record.");
+			Curve* curve = (curveIDs.count(key) > 0) ? contour.curve(curveIDs[key]) : nullptr;
+			if (!curve) {
+				curve = contour.curve(contour.addCurve());
+				m_curveStates[curve->id()].key = key;
+				curveIDs[key] = curve->id();
+				m_order.push_back(key);
+				m_nextKey = std::max(m_nextKey, key + 1);
+			}
+			std::list<CurvePoint>& points = curve->points();
+			points.clear();
+			for (uint32_t i = 0; i < numPoints; i++) {
+				float x = get<float>(payload, pos);
+				float y = get<float>(payload, pos);
+				float radius = get<float>(payload, pos);
+				points.push_back(CurvePoint(Math::Vec2D(x, y), radius));
+			}
+		}
+		else if (type == RecordType::RemoveCurve) {
+			unsigned int key = get<uint32_t>(payload, pos);
+			if (curveIDs.count(key) == 0) throw std::runtime_error("Bad curve key.");
+			contour.removeCurve(curveIDs[key]);
+			m_curveStates.erase(curveIDs[key]);
+			curveIDs.erase(key);
+			m_order.erase(std::find(m_order.begin(), m_order.end(), key));
+		}
+		else if (type == RecordType::Order) {
+			uint32_t numCurves = get<uint32_t>(payload, pos);
+			if (numCurves != contour.curves()->size()) throw std::runtime_error("Bad order record.");
+			std::map<int, Curve*> curvesByID;
+			for (Curve* curve : *contour.curves()) curvesByID[curve->id()] = curve;
+			std::list<Curve*> curves;
+			std::vector<unsigned int> order;
+			for (uint32_t i = 0; i < numCurves; i++) {
+				unsigned int key = get<uint32_t>(payload, pos);
+				std::map<int, Curve*>::iterator it = (curveIDs.count(key) > 0) ? curvesByID.find(curveIDs[key]) : curvesByID.end();
+				if (it == curvesByID.end()) throw std::runtime_error("Bad curve key.");
+				curves.push_back(it->second);
+				curvesByID.erase(it);
+				order.push_back(key);
+			}
+			contour.curves()->swap(curves);
+			m_order.swap(order);
+		}
+		else if (type == RecordType::Checkpoint) {
+			std::istringstream stream(payload);
+			if (!contour.readFromFile(stream)) throw std::runtime_error("Bad checkpoint record.");
+			resetKeys(contour);
+			curveIDs = keysToIDs();
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string Journal::baseFingerprint(const std::string& filename)
+{
+	// The file size and a checksum of the end of the file, which holds the contour
+	std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+	long long size = file.is_open() ? (long long)file.tellg() : -1;
+	std::string fingerprint;
+	put<int64_t>(fingerprint, size);
+	if (size > 0) {
+		long long numBytes = std::min(size, fingerprintBytes);
+		std::string tail((size_t)numBytes, '\0');
+		file.seekg(size - numBytes);
+		file.read(&tail[0], numBytes);
+		put<uint32_t>(fingerprint, checksum(0, tail));
+	}
+	return fingerprint;
+}
+bool Journal::truncateFile(const std::string& filename, long long size)
+{
+	FILE* file = fopen(filename.c_str(), "r+b");
+	if (!file) return false;
+#ifdef _WIN32
+	bool isTruncated = (_chsize_s(_fileno(file), size) == 0);
+#else
+	bool isTruncated = (ftruncate(fileno(file), (off_t)size) == 0);
+#endif
+	fclose(file);
+	return isTruncated;
+}
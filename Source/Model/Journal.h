@@ -0,0 +1,95 @@
+//
+// Journal.h
+// Append-only journal of contour edits, kept next to a VESCL file. Records hold whole 
+// curves that were added or changed, removed curves and curve order, each with a CRC-32
+// so a record torn by a crash is detected. Appending costs the size of the edited curves,
+// not the size of the file. Journals left by an interrupted session are replayed when the
+// file is opened again. Checkpoint records hold the whole contour, so the file's contour
+// can be rewritten from them without invalidating the journal.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "Contour.h"
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+class Journal
+{
+public:
+	Journal();
+	~Journal();
+
+	static std::string journalFilename(const std::string& filename) { return filename + ".journal"; };
+
+	// Starts journaling edits of the contour, which was just loaded from or saved to 
+	// filename. If replay is true, valid records left by an interrupted session are first
+	// applied to the contour and journaling continues after them. Returns the number of
+	// replayed edits, or -1 if the journal could not be opened.
+	int open(const std::string& filename, Contour& contour, bool replay);
+	void close(bool removeFile);
+	bool isOpen() const { return m_file.is_open(); };
+	size_t numBytes() const { return m_numBytes; };
+
+	// Appends records for curves that were added, changed or removed since the last 
+	// append, and the curve order if it changed other than by adding curves
+	bool append(Contour& contour);
+
+	// Appends the whole contour, serialized as in the VESCL file, and returns the 
+	// serialization. Once the file's contour is rewritten with it, rebase() restarts the
+	// journal on the rewritten file, keeping records appended after the checkpoint.
+	bool checkpoint(Contour& contour, std::string* contourData);
+	bool rebase();
+
+	// Overwrites the contour at the end of a VESCL file, which starts at contourOffset, and
+	// truncates the file after it. The image data before it is not rewritten.
+	static bool writeContourInPlace(const std::string& filename, long long contourOffset,
+		const std::string& contourData);
+
+	// Make non-copyable
+	Journal(Journal const&) = delete;
+	void operator=(Journal const&) = delete;
+
+private:
+	enum class RecordType : unsigned char { Base = 1, SetCurve, RemoveCurve, Order, Checkpoint };
+	std::string m_filename;
+	std::ofstream m_file;
+	size_t m_numBytes;
+	size_t m_checkpointEnd;
+
+	// Curves are identified by keys that are stable across sessions. The file's curves
+	// have keys 0 to n - 1 in file order, and curves added later get the next keys.
+	typedef struct {
+		unsigned int key;
+		unsigned int revision;
+	} CurveState;
+	std::map<int, CurveState> m_curveStates;
+	std::vector<unsigned int> m_order;
+	unsigned int m_nextKey;
+	void resetKeys(Contour& contour);
+
+	bool start();
+	bool writeRecord(RecordType type, const std::string& payload);
+	static bool readRecord(std::istream& stream, RecordType* type, std::string* payload);
+	std::map<unsigned int, int> keysToIDs() const;
+	bool applyRecord(RecordType type, const std::string& payload, Contour& contour,
+		std::map<unsigned int, int>& curveIDs);
+	static std::string baseFingerprint(const std::string& filename);
+	static bool truncateFile(const std::string& filename, long long size);
+};
@@ -0,0 +1,276 @@
+//
+// MinimalPath.cpp
+// Implementation of MinimalPath.
+//
+
+#include "MinimalPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+using Math::Vec2D;
+
+namespace {
+	// Neighbor offsets of the 8-connected grid. Opposite directions are 4 apart.
+	const int dirX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+	const int dirY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+	const float dirLength[8] = { 1, 1.41421356f, 1, 1.41421356f, 1, 1.41421356f, 1, 1.41421356f };
+
+
+	// Nodes are kept small, with the position packed in 32 bits, to keep the heap compact
+	typedef struct Node {
+		float priority;
+		unsigned int xy;
+		bool operator>(const Node& other) const { return priority > other.priority; }
+	} Node;
+	inline unsigned int pack(int x, int y) { return (unsigned int)x | ((unsigned int)y << 16); }
+}
+
+//
+// Public
+//
+MinimalPath::MinimalPath(Image* image, ImageFilterer::VesselContrastType contrastType, float expectedRadius) :
+	m_image(image),
+	m_imageRevision(image ? image->revision() : 0),
+	m_contrastType(contrastType),
+	m_expectedRadius(expectedRadius),
+	m_sigma(1),
+	m_wideSigma(1),
+	m_minValue(0),
+	m_valueRange(1),
+	m_numVisitedPixels(0),
+	m_numEvaluatedTiles(0),
+	m_numTilesX(0),
+	m_numTilesY(0)
+{
+	// Smoothing suppresses noise. Sigma is narrow wrt the expected width, as in
+	// ImageFilterer::getVecToClosestVessel, so narrow parts of vessels are kept. The wide
+	// sigma spans about half the vessel width.
+	m_sigma = (expectedRadius <= 0.5) ? 0.5f : ((expectedRadius <= 1.5) ? 1.0f : 1.5f);
+	m_wideSigma = std::min(4.0f, std::max(m_sigma, 0.5f * expectedRadius));
+	if (m_image && m_image->isValid()) {
+		m_numTilesX = (m_image->width() + tileSize - 1) / tileSize;
+		m_numTilesY = (m_image->height() + tileSize - 1) / tileSize;
+		m_tiles.assign(m_numTilesX * m_numTilesY, nullptr);
+		m_minValue = m_image->normalizedMinValue();
+		m_valueRange = std::max(1e-6f, m_image->normalizedMaxValue() - m_minValue);
+	}
+}
+MinimalPath::~MinimalPath()
+{
+	for (Tile* tile : m_tiles) delete tile;
+}
+
+bool MinimalPath::isValidFor(const Image* image, ImageFilterer::VesselContrastType contrastType, 
+	float expectedRadius) const
+{
+	return image == m_image && image->revision() == m_imageRevision && contrastType == m_contrastType && 
+		expectedRadius == m_expectedRadius;
+}
+
+std::vector<Vec2D> MinimalPath::trace(Vec2D start, Vec2D end)
+{
+	// Positions are packed in 16 bits each in the heap
+	std::vector<Vec2D> path;
+	if (m_tiles.empty() || m_image->width() > 0xffff || m_image->height() > 0xffff) return path;
+	int w = m_image->width();
+	int h = m_image->height();
+	int xStart = (int)std::lround(start[0]);
+	int yStart = (int)std::lround(start[1]);
+	int xEnd = (int)std::lround(end[0]);
+	int yEnd = (int)std::lround(end[1]);
+	if (xStart < 0 || xStart >= w || yStart < 0 || yStart >= h ||
+		xEnd < 0 || xEnd >= w || yEnd < 0 || yEnd >= h) {
+		return path;
+	}
+
+	// Costs of evaluated tiles are kept between traces
+	for (Tile* evaluated : m_tiles) {
+		if (evaluated) resetSearch(evaluated);
+	}
+
+	// Dijkstra's algorithm with a binary heap, directed to the end by the A* heuristic. 
+	// Costs are at least minCost, so minCost times the 8-connected distance to the end
+	// never overestimates the remaining cost and the path is still minimal. Nodes are
+	// pushed again when their distance drops, and stale entries are skipped when popped.
+	auto heuristic = [this, xEnd, yEnd](int x, int y) {
+		int dx = std::abs(x - xEnd);
+		int dy = std::abs(y - yEnd);
+		return minCost * (std::max(dx, dy) + 0.41421356f * std::min(dx, dy));
+	};
+	m_numVisitedPixels = 0;
+	int mask = tileSize - 1;
+	int dirIdx[8];
+	for (int dir = 0; dir < 8; dir++) dirIdx[dir] = dirX[dir] + dirY[dir] * tileSize;
+	std::priority_queue<Node, std::vector<Node>, std::greater<Node>> front;
+	Tile* startTile = tile(xStart, yStart);
+	startTile->pixels[(xStart & mask) + (yStart & mask) * tileSize].dist = 0;
+	front.push({ heuristic(xStart, yStart), pack(xStart, yStart) });
+	bool isReached = false;
+	while (!front.empty()) {
+		Node node = front.top();
+		front.pop();
+		int nodeX = (int)(node.xy & 0xffff);
+		int nodeY = (int)(node.xy >> 16);
+		Tile* nodeTile = tile(nodeX, nodeY);
+		int idx = (nodeX & mask) + (nodeY & mask) * tileSize;
+		Pixel& pixel = nodeTile->pixels[idx];
+		if (pixel.isDone) continue;
+		pixel.isDone = 1;
+		m_numVisitedPixels++;
+		if (nodeX == xEnd && nodeY == yEnd) {
+			isReached = true;
+			break;
+		}
+
+		// Edge costs are the mean cost of the two pixels times the step length. Neighbors
+		// of pixels inside a tile are in the same tile, so tiles are only looked up again 
+		// on tile borders. Pixels beside the image edge in partial edge tiles are checked
+		// as on tile borders.
+		float nodeDist = pixel.dist;
+		float nodeCost = pixel.cost;
+		bool isInside = (nodeX & mask) != 0 && (nodeX & mask) != mask && (nodeY & mask) != 0 && 
+			(nodeY & mask) != mask && nodeX + 1 < w && nodeY + 1 < h;
+		for (int dir = 0; dir < 8; dir++) {
+			int x = nodeX + dirX[dir];
+			int y = nodeY + dirY[dir];
+			Tile* neighborTile = nodeTile;
+			int neighborIdx = idx + dirIdx[dir];
+			if (!isInside) {
+				if (x < 0 || x >= w || y < 0 || y >= h) continue;
+				neighborTile = tile(x, y);
+				neighborIdx = (x & mask) + (y & mask) * tileSize;
+			}
+			Pixel& neighbor = neighborTile->pixels[neighborIdx];
+			if (neighbor.isDone) continue;
+			float dist = nodeDist + 0.5f * (nodeCost + neighbor.cost) * dirLength[dir];
+			if (dist < neighbor.dist) {
+				neighbor.dist = dist;
+				neighbor.fromDir = (signed char)dir;
+				front.push({ dist + heuristic(x, y), pack(x, y) });
+			}
+		}
+	}
+	if (!isReached) return path;
+
+	// Walk back from the end to the start
+	int x = xEnd;
+	int y = yEnd;
+	path.push_back(Vec2D((float)x, (float)y));
+	while (x != xStart || y != yStart) {
+		int dir = tile(x, y)->pixels[(x & mask) + (y & mask) * tileSize].fromDir;
+		x -= dirX[dir];
+		y -= dirY[dir];
+		path.push_back(Vec2D((float)x, (float)y));
+	}
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+//
+// Private
+//
+MinimalPath::Tile* MinimalPath::tile(int x, int y)
+{
+	int tileX = x >> tileBits;
+	int tileY = y >> tileBits;
+	Tile*& tile = m_tiles[tileX + tileY * m_numTilesX];
+	if (!tile) {
+		tile = new Tile;
+		evaluateTile(tile, tileX, tileY);
+	}
+	return tile;
+}
+void MinimalPath::evaluateTile(Tile* tile, int tileX, int tileY)
+{
+	// Load the tile and a margin for the wider filter, with pixels beyond the image edge
+	// repeating the edge
+	int margin = (int)std::ceil(3 * m_wideSigma);
+	int regionSize = tileSize + 2 * margin;
+	int x0 = tileX * tileSize - margin;
+	int y0 = tileY * tileSize - margin;
+	std::vector<float> region(regionSize * regionSize);
+	for (int j = 0; j < regionSize; j++) {
+		for (int i = 0; i < regionSize; i++) region[i + j * regionSize] = normalizedValue(x0 + i, y0 + j);
+	}
+	std::vector<float> narrow;
+	std::vector<float> wide;
+	smoothRegion(region, margin, m_sigma, narrow);
+	smoothRegion(region, margin, m_wideSigma, wide);
+
+	// Costs rise steeply from the darkest (or brightest) to the background intensities,
+	// so fronts travel far along vessels before they spread into the background. Costs
+	// are the product of the narrowly and widely smoothed images, so thin vessels, which
+	// fade in the wide image, stay cheap, and the centers of wide vessels are cheaper 
+	// than their edges.
+	for (int i = 0; i < tileSize * tileSize; i++) {
+		float value = narrow[i] * wide[i];
+		if (m_contrastType == ImageFilterer::VesselContrastType::LightOnDark) {
+			value = (1 - narrow[i]) * (1 - wide[i]);
+		}
+		value = std::min(1.0f, std::max(0.0f, value));
+		tile->pixels[i].cost = minCost + value * value * value;
+	}
+	resetSearch(tile);
+	m_numEvaluatedTiles++;
+}
+void MinimalPath::smoothRegion(const std::vector<float>& region, int margin, float sigma, 
+	std::vector<float>& smoothed)
+{
+	// Separable Gaussian of the tile in the center of the region
+	int radius = (int)std::ceil(3 * sigma);
+	int filterWidth = 2 * radius + 1;
+	std::vector<float> filter(filterWidth);
+	float sum = 0;
+	for (int i = 0; i < filterWidth; i++) {
+		float d = (float)(i - radius);
+		filter[i] = std::exp(-0.5f * d * d / (sigma * sigma));
+		sum += filter[i];
+	}
+	for (float& weight : filter) weight /= sum;
+
+	int regionSize = tileSize + 2 * margin;
+	int offset = margin - radius;
+	int numRows = tileSize + 2 * radius;
+	std::vector<float> rows(numRows * tileSize);
+	for (int j = 0; j < numRows; j++) {
+		const float* row = &region[(j + offset) * regionSize + margin - radius];
+		for (int i = 0; i < tileSize; i++) {
+			float value = 0;
+			for (int k = 0; k < filterWidth; k++) value += filter[k] * row[i + k];
+			rows[i + j * tileSize] = value;
+		}
+	}
+	smoothed.resize(tileSize * tileSize);
+	for (int j = 0; j < tileSize; j++) {
+		for (int i = 0; i < tileSize; i++) {
+			float value = 0;
+			for (int k = 0; k < filterWidth; k++) value += filter[k] * rows[i + (j + k) * tileSize];
+			smoothed[i + j * tileSize] = value;
+		}
+	}
+}
+void MinimalPath::resetSearch(Tile* tile)
+{
+	for (Pixel& pixel : tile->pixels) {
+		pixel.dist = std::numeric_limits<float>::max();
+		pixel.fromDir = -1;
+		pixel.isDone = 0;
+	}
+}
+float MinimalPath::normalizedValue(int x, int y) const
+{
+	// Image values scaled so the image's minimum is 0 and its maximum is 1
+	x = std::min(m_image->width() - 1, std::max(0, x));
+	y = std::min(m_image->height() - 1, std::max(0, y));
+	size_t idx = x + (size_t)y * m_image->width();
+	float value;
+	if (m_image->dataFormat() == Image::DataFormat::UShort) {
+		value = ((unsigned short*)m_image->data())[idx] / 65535.0f;
+	}
+	else value = m_image->data()[idx] / 255.0f;
+	return (value - m_minValue) / m_valueRange;
+}
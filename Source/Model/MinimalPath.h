@@ -0,0 +1,91 @@
+//
+// MinimalPath.h
+// Minimal-cost paths between two points along vessels. Costs are low on vessels and high
+// elsewhere, so the path follows the vessel connecting the points. Paths are found with
+// Dijkstra's algorithm, directed to the end point as in A*, on the 8-connected pixel 
+// grid. Costs are evaluated lazily, tile by tile, where the front reaches, so traces in
+// large images stay fast.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "Image.h"
+#include "ImageFilterer.h"
+#include "Math.h"
+
+#include <vector>
+
+class MinimalPath
+{
+public:
+	// Costs are computed from the image intensities smoothed with Gaussians scaled to the
+	// expected vessel radius
+	MinimalPath(Image* image, ImageFilterer::VesselContrastType contrastType, float expectedRadius);
+	~MinimalPath();
+
+	// Returns the pixel centers along the path from start to end, both included, or an
+	// empty path if either point is outside the image
+	std::vector<Math::Vec2D> trace(Math::Vec2D start, Math::Vec2D end);
+
+	// Pixels visited by the last trace and tiles evaluated by all traces
+	int numVisitedPixels() const { return m_numVisitedPixels; };
+	int numEvaluatedTiles() const { return m_numEvaluatedTiles; };
+	int numTiles() const { return (int)m_tiles.size(); };
+
+	// Costs are only valid for the image revision, contrast and radius they were 
+	// computed for
+	bool isValidFor(const Image* image, ImageFilterer::VesselContrastType contrastType, float expectedRadius) const;
+
+	// Make non-copyable
+	MinimalPath(MinimalPath const&) = delete;
+	void operator=(MinimalPath const&) = delete;
+
+private:
+	Image* m_image;
+	unsigned int m_imageRevision;
+	ImageFilterer::VesselContrastType m_contrastType;
+	float m_expectedRadius;
+	float m_sigma;
+	float m_wideSigma;
+	float m_minValue;
+	float m_valueRange;
+	int m_numVisitedPixels;
+	int m_numEvaluatedTiles;
+
+	static constexpr float minCost = 0.01f;
+
+	// Per pixel costs and search state, allocated when the front first reaches a tile. 
+	// Each pixel's state is kept together so relaxing a neighbor touches one cache line.
+	static const int tileBits = 5;
+	static const int tileSize = 1 << tileBits;
+	typedef struct {
+		float cost;
+		float dist;
+		signed char fromDir;
+		char isDone;
+	} Pixel;
+	typedef struct {
+		Pixel pixels[tileSize * tileSize];
+	} Tile;
+	int m_numTilesX;
+	int m_numTilesY;
+	std::vector<Tile*> m_tiles;
+	Tile* tile(int x, int y);
+	void evaluateTile(Tile* tile, int tileX, int tileY);
+	void resetSearch(Tile* tile);
+	void smoothRegion(const std::vector<float>& region, int margin, float sigma, std::vector<float>& smoothed);
+	float normalizedValue(int x, int y) const;
+};
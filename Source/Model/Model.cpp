@@ -1,241 +1,687 @@
-//
-// Model.cpp
-// Implementation of Model.
-//
-
-#include "Model.h"
-#include "Image.h"
-#include "Math.h"
-
-// 
-// Public
-//
-Model::Model(RenderState* renderState) :
-    m_renderState(renderState),
-    m_isDrawing(false),
-    m_selectionRadiusInWindowPixels(3),
-    m_minSeparationInWindowPixels(2)
-{
-    m_imageFilterer = new ImageFilterer(&m_image);
-}
-Model::~Model()
-{
-    delete m_imageFilterer;
-}
-
-// 
-// Public
-//
-void Model::clear()
-{
-    m_image.clear();
-    m_contour.clear();
-}
-void Model::save(std::ofstream& file)
-{
-    try {
-        if (!m_image.isValid()) {
-            throw std::runtime_error("Image not valid.");
-        }
-        if (!file.is_open()) {
-            throw std::runtime_error("File not open.");
-        }
-
-        file << m_version << std::endl;
-        if (!m_image.writeToFile(file)) {
-            throw std::runtime_error("Write image failed.");
-        }
-        if (!m_contour.writeToFile(file)) {
-            throw std::runtime_error("Write contour failed.");
-        }
-    }
-    catch (const std::exception& e) {
-        std::cout << "Exception " << e.what() << std::endl;
-    }
-
-    file.close();
-}
-void Model::load(std::ifstream& file)
-{
-    try {
-        if (!file.is_open()) {
-            throw std::runtime_error("File not open.");
-        }
-
-        // Read version identifier
-        std::string line;
-        std::getline(file, line);
-        if (line != m_version) {
-            throw std::runtime_error("Unsupported file.");
-        }
-
-        // Read data
-        if (!m_image.readFromFile(file)) {
-            throw std::runtime_error("Read image failed.");
-        }
-        if (!m_contour.readFromFile(file)) {
-            throw std::runtime_error("Read contour failed.");
-        }
-    }
-    catch (const std::exception& e) {
-    std::cout << "Exception " << e.what() << std::endl;
-    }
-
-    file.close();
-}
-
-void Model::startDraw(CurvePoint pStart)
-{
-    m_isDrawing = false;
-
-    int idActiveCurve = m_contour.idActiveCurve();
-    float minSeparation = m_minSeparationInWindowPixels * m_renderState->windowToContourScale();
-    if (idActiveCurve >= 0) {
-
-        // Begin overdrawing the selected curve
-        m_isDrawing = m_contour.curve(idActiveCurve)->startDrawing(pStart, minSeparation);
-    }
-    if (!m_isDrawing) {
-
-        // Create a new curve and select it to make it active
-        deselect();
-        idActiveCurve = m_contour.addCurve();
-
-        // Begin drawing the new curve
-        m_isDrawing = m_contour.curve(idActiveCurve)->startDrawing(pStart, minSeparation);
-    }
-
-    m_renderState->setContourNeedsUpdate(true);
-    m_renderState->setActiveCurveNeedsUpdate(true);
-}
-void Model::updateDraw(CurvePoint point)
-{
-    if (!m_isDrawing) return;
-    int idActiveCurve = m_contour.idActiveCurve();
-    m_contour.curve(idActiveCurve)->addPoint(point);
-    m_renderState->setActiveCurveNeedsUpdate(true);
-}
-void Model::endDraw(CurvePoint point)
-{
-    updateDraw(point);
-    int idActiveCurve = m_contour.idActiveCurve();
-    m_contour.curve(idActiveCurve)->endDrawing();
-    m_renderState->setActiveCurveNeedsUpdate(true);
-    m_isDrawing = false;
-}
-
-bool Model::select(float pos[2])
-{
-    float selectionRadius = m_selectionRadiusInWindowPixels * m_renderState->windowToContourScale();
-    m_contour.selectCurve(Math::Vec2D(pos[0], pos[1]), selectionRadius);
-    m_renderState->setContourNeedsUpdate(true);
-    m_renderState->setActiveCurveNeedsUpdate(true);
-    if (m_contour.idActiveCurve() >= 0) return true;
-    else return false;
-}
-void Model::deselect()
-{
-    int idActiveCurve = m_contour.idActiveCurve();
-    if (idActiveCurve >= 0) {
-        m_contour.deselectCurve();
-        m_renderState->setContourNeedsUpdate(true);
-        m_renderState->setActiveCurveNeedsUpdate(true);
-    }
-}
-void Model::deleteSelected()
-{
-    int idActiveCurve = m_contour.idActiveCurve();
-    if (idActiveCurve >= 0) {
-        m_contour.removeCurve(idActiveCurve);
-        m_renderState->setContourNeedsUpdate(true);
-        m_renderState->setActiveCurveNeedsUpdate(true);
-    }
-}
-
-ImageFilterer::VesselContrastType Model::vesselContrast() const
-{
-    return m_imageFilterer->vesselContrastType();
-}
-void Model::setVesselContrast(ImageFilterer::VesselContrastType contrastType)
-{
-    m_imageFilterer->setVesselContrastType(contrastType);
-}
-void Model::fitSelectedToNearestVessel(float expectedRadius)
-{
-    try {
-        if (!m_image.isValid()) {
-            throw std::runtime_error("No image available for curve fitting.");
-        }
-
-        Curve* activeCurve = m_contour.curve(m_contour.idActiveCurve());
-        if (!activeCurve) return;
-        std::list<CurvePoint>& points = activeCurve->points();
-        if (points.size() == 0) return;
-
-        // Fit curve points to the nearest vessel. These constants were set by trial 
-        // and error. For a better fit, consider more tries and a smaller moveConst. For
-        // speed, consider fewer tries and a larger moveConst.
-        int numTries = 10;
-        float moveConst = 0.5;  // Set between 0 and 1
-        Math::Vec2D* moveVecs = nullptr;
-        moveVecs = new Math::Vec2D[points.size()];
-        for (int i = 0; i < numTries; i++) {
-            Math::Vec2D* pMoveVecs = moveVecs;
-            for (std::list<CurvePoint>::iterator it = points.begin(); it != points.end(); it++) {
-                // Compute move vector for each curve point
-                *pMoveVecs++ = m_imageFilterer->getVecToClosestVessel(it->pos(), expectedRadius);
-            }
-            pMoveVecs = moveVecs;
-            for (std::list<CurvePoint>::iterator it = points.begin(); it != points.end(); it++) {
-                // Move curve points in direction of centerline
-                it->setPos(it->pos() + moveConst * *pMoveVecs++);
-            }
-        }
-        delete[] moveVecs;
-
-        // Smooth the curve points. This helps prevent kinks in the fitted curve.
-        activeCurve->applySmoothing(Curve::SmoothingType::Points);
-    }
-    catch (std::bad_alloc& e) {
-        std::cout << "Memory Allocation " << "No memory for curve fitting." << e.what() << std::endl;
-    }
-    catch (std::exception & e) {
-        std::cout << "Exception " << e.what() << std::endl;
-    }
-}
-void Model::fitSelectedVesselWidth(float expectedRadius)
-{
-    try {
-        if (!m_image.isValid()) {
-            throw std::runtime_error("No image available for width detection.");
-        }
-
-        Curve* activeCurve = m_contour.curve(m_contour.idActiveCurve());
-        if (!activeCurve) return;
-        std::list<CurvePoint>& points = activeCurve->points();
-        if (points.size() <= 1) return;
-
-        for (std::list<CurvePoint>::iterator it = points.begin(); it != points.end(); it++) {
-            std::list<CurvePoint>::iterator itPrev = (it == points.begin()) ? it : std::prev(it);
-            std::list<CurvePoint>::iterator itNext = (std::next(it) == points.end()) ? it : std::next(it);
-            Math::Vec2D predictedP;
-            Math::Vec2D curveDir = itNext->pos() - itPrev->pos();
-            curveDir.normalize();
-            float width = m_imageFilterer->getWidthAtP(it->pos(), curveDir, expectedRadius);
-            it->setRadius(0.5 * width);
-        }
-
-        // First/last widths may be bad due to bad tangents. Use the widths of adjacent 
-        // points
-        std::list<CurvePoint>::iterator it = std::prev(points.end());
-        it->setRadius(std::prev(it)->radius());
-        it = points.begin();
-        it->setRadius(std::next(it)->radius());
-
-        // Smooth the curve widths
-        activeCurve->applySmoothing(Curve::SmoothingType::Widths);
-    }
-    catch (std::exception& e) {
-        std::cout << "Exception " << e.what() << std::endl;
-    }
-}
+//
+// Model.cpp
+// Implementation of Model.
+//
+
+#include "Model.h"
+#include "Image.h"
+#include "ImageBlockCodec.h"
+#include "ImageStore.h"
+#include "Math.h"
+#include "MinimalPath.h"
+#include "../Util/Parallel.h"
+#include "../Util/Profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// 
+// Public
+//
+Model::Model(RenderState* renderState) :
+    m_renderState(renderState),
+    m_isDrawing(false),
+    m_selectionRadiusInWindowPixels(3),
+    m_minSeparationInWindowPixels(2),
+    m_isSnapWhileDrawing(false),
+    m_snapBudgetMsecs(2),
+    m_contourOffset(-1),
+    m_isCompactionDone(true),
+    m_isCompactionOK(true),
+    m_isImageCompressed(false),
+    m_sequence(nullptr),
+    m_frame(0),
+    m_minimalPath(nullptr)
+{
+    m_imageFilterer = new ImageFilterer(&m_image);
+    m_history.commit(m_contour);
+}
+Model::~Model()
+{
+    closeJournal();
+    delete m_sequence;
+    delete m_minimalPath;
+    delete m_imageFilterer;
+}
+
+// 
+// Public
+//
+void Model::clear()
+{
+    closeJournal();
+    m_image.clear();
+    m_contour.clear();
+    m_contourOffset = -1;
+    m_imageKey.clear();
+    m_history.clear();
+    m_history.commit(m_contour);
+    delete m_sequence;
+    m_sequence = nullptr;
+    m_frame = 0;
+    m_frameContours.clear();
+    delete m_minimalPath;
+    m_minimalPath = nullptr;
+}
+void Model::save(std::ofstream& file)
+{
+    VESCL_PROFILE_SCOPE("Model::save", "io");
+    finishCompaction(true);
+    try {
+        if (!m_image.isValid()) {
+            throw std::runtime_error("Image not valid.");
+        }
+        if (!file.is_open()) {
+            throw std::runtime_error("File not open.");
+        }
+
+        file << m_version << std::endl;
+        if (!m_imageStore.empty()) {
+            if (m_imageKey.empty()) m_imageKey = ImageStore::key(m_image);
+            if (!ImageStore(m_imageStore).put(m_image, m_imageKey)) {
+                throw std::runtime_error("Write image to store failed.");
+            }
+            file << "key_image_ref" << std::endl << m_imageKey << std::endl << m_imageStore << std::endl;
+        }
+        else if (m_isImageCompressed) {
+            if (!ImageBlockCodec::write(file, m_image)) {
+                throw std::runtime_error("Write compressed image failed.");
+            }
+        }
+        else if (!m_image.writeToFile(file)) {
+            throw std::runtime_error("Write image failed.");
+        }
+        m_contourOffset = (long long)file.tellp();
+        if (!m_contour.writeToFile(file)) {
+            throw std::runtime_error("Write contour failed.");
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "Exception " << e.what() << std::endl;
+    }
+
+    file.close();
+}
+void Model::load(std::ifstream& file)
+{
+    VESCL_PROFILE_SCOPE("Model::load", "io");
+    finishCompaction(true);
+    try {
+        if (!file.is_open()) {
+            throw std::runtime_error("File not open.");
+        }
+
+        // Read version identifier
+        std::string line;
+        std::getline(file, line);
+        if (line != m_version) {
+            throw std::runtime_error("Unsupported file.");
+        }
+
+        // Read data. The image is either embedded or referenced in an image store.
+        std::streampos imageStart = file.tellg();
+        std::getline(file, line);
+        if (line == "key_image_ref") {
+            std::string key, directory;
+            std::getline(file, key);
+            std::getline(file, directory);
+            if (!loadStoredImage(key, directory)) {
+                throw std::runtime_error("Stored image not found.");
+            }
+        }
+        else {
+            m_isImageCompressed = (line == "key_image_blocks");
+            file.seekg(imageStart);
+            if (!m_image.readFromFile(file)) {
+                throw std::runtime_error("Read image failed.");
+            }
+            m_imageKey.clear();
+        }
+        m_contourOffset = (long long)file.tellg();
+        if (!m_contour.readFromFile(file)) {
+            throw std::runtime_error("Read contour failed.");
+        }
+    }
+    catch (const std::exception& e) {
+    std::cout << "Exception " << e.what() << std::endl;
+    }
+
+    file.close();
+    m_history.clear();
+    m_history.commit(m_contour);
+}
+void Model::moveFrom(Model& other)
+{
+    clear();
+    other.finishCompaction(true);
+    m_image.swap(other.m_image);
+    m_contour.swap(other.m_contour);
+    m_contourOffset = other.m_contourOffset;
+    m_imageStore = other.m_imageStore;
+    m_imageKey = other.m_imageKey;
+    m_isImageCompressed = other.m_isImageCompressed;
+    other.clear();
+    m_history.clear();
+    m_history.commit(m_contour);
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+}
+
+bool Model::openSequence(int numFrames, ImageSequence::FrameDecoder decoder)
+{
+    clear();
+    if (numFrames <= 0) return false;
+    m_sequence = new ImageSequence(numFrames, decoder);
+    m_frame = -1;
+    return setFrame(0);
+}
+bool Model::setFrame(int frame)
+{
+    VESCL_PROFILE_SCOPE("Model::setFrame", "io");
+    if (!m_sequence || m_isDrawing || frame < 0 || frame >= m_sequence->numFrames()) return false;
+    if (frame == m_frame) return true;
+    std::shared_ptr<const Image> image = m_sequence->frame(frame);
+    if (!image || !m_image.copyFrom(*image)) return false;
+
+    // The journal and file offsets refer to the frame that was loaded or saved
+    closeJournal();
+    m_contourOffset = -1;
+    m_imageKey.clear();
+
+    // Keep the contour of the previous frame and restore the contour of the new frame
+    deselect();
+    if (m_frame >= 0) m_contour.swap(m_frameContours[m_frame]);
+    m_contour.clear();
+    std::map<int, Contour>::iterator it = m_frameContours.find(frame);
+    if (it != m_frameContours.end()) {
+        m_contour.swap(it->second);
+        m_frameContours.erase(it);
+    }
+    m_frame = frame;
+    m_history.clear();
+    m_history.commit(m_contour);
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+    return true;
+}
+bool Model::propagateToNextFrame()
+{
+    VESCL_PROFILE_SCOPE("Model::propagateToNextFrame", "fit");
+    if (!m_sequence || m_isDrawing || m_frame + 1 >= m_sequence->numFrames()) return false;
+    deselect();
+    std::vector<std::vector<CurvePoint>> curvePoints;
+    for (Curve* curve : *m_contour.curves()) {
+        const std::list<CurvePoint>& points = static_cast<const Curve*>(curve)->points();
+        curvePoints.push_back(std::vector<CurvePoint>(points.begin(), points.end()));
+    }
+    if (!setFrame(m_frame + 1)) return false;
+
+    // Curves are added in order and then fitted in parallel, one curve per task. The 
+    // pyramid is built first so the fits don't wait on one another for it.
+    float maxRadius = 0;
+    for (const std::vector<CurvePoint>& points : curvePoints) {
+        for (const CurvePoint& point : points) maxRadius = std::max(maxRadius, point.radius());
+    }
+    m_imageFilterer->preparePyramid(maxRadius);
+    m_contour.clear();
+    std::vector<Curve*> curves;
+    for (size_t i = 0; i < curvePoints.size(); i++) {
+        curves.push_back(m_contour.curve(m_contour.addCurve()));
+    }
+    m_contour.deselectCurve();
+    Parallel::forRange(0, (int)curves.size(), 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) fitPropagatedCurve(curves[i], curvePoints[i]);
+    });
+    commitEdit();
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+    return true;
+}
+
+void Model::startDraw(CurvePoint pStart)
+{
+    m_isDrawing = false;
+
+    int idActiveCurve = m_contour.idActiveCurve();
+    float minSeparation = m_minSeparationInWindowPixels * m_renderState->windowToContourScale();
+    if (idActiveCurve >= 0) {
+
+        // Begin overdrawing the selected curve
+        m_isDrawing = m_contour.curve(idActiveCurve)->startDrawing(pStart, minSeparation);
+    }
+    if (!m_isDrawing) {
+
+        // Create a new curve and select it to make it active
+        deselect();
+        idActiveCurve = m_contour.addCurve();
+
+        // Begin drawing the new curve
+        m_isDrawing = m_contour.curve(idActiveCurve)->startDrawing(pStart, minSeparation);
+    }
+    if (m_isDrawing && m_isSnapWhileDrawing && m_image.isValid()) {
+        m_contour.curve(idActiveCurve)->setPointFitter([this](Curve::FitType type, CurvePoint& point,
+            Math::Vec2D dir) { return snapDrawnPoint(type, point, dir); });
+    }
+
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+}
+void Model::updateDraw(CurvePoint point)
+{
+    VESCL_PROFILE_SCOPE("Model::updateDraw", "filter");
+    if (!m_isDrawing) return;
+    int idActiveCurve = m_contour.idActiveCurve();
+    setSnapDeadline(m_snapBudgetMsecs);
+    m_contour.curve(idActiveCurve)->addPoint(point);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+}
+void Model::endDraw(CurvePoint point)
+{
+    updateDraw(point);
+    int idActiveCurve = m_contour.idActiveCurve();
+    Curve* curve = m_contour.curve(idActiveCurve);
+    setSnapDeadline(-1);
+    curve->fitPendingPoints(true);
+    curve->setPointFitter(nullptr);
+    curve->endDrawing();
+    m_renderState->setActiveCurveNeedsUpdate(true);
+    m_isDrawing = false;
+    commitEdit();
+}
+
+bool Model::snapPendingPoints()
+{
+    VESCL_PROFILE_SCOPE("Model::snapPendingPoints", "fit");
+    if (!m_isDrawing) return false;
+    Curve* curve = m_contour.curve(m_contour.idActiveCurve());
+    if (!curve || !curve->hasPendingPoints()) return false;
+    setSnapDeadline(m_snapBudgetMsecs);
+    bool hasPending = curve->fitPendingPoints(false);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+    return hasPending;
+}
+bool Model::hasPendingSnaps()
+{
+    if (!m_isDrawing) return false;
+    Curve* curve = m_contour.curve(m_contour.idActiveCurve());
+    return curve && curve->hasPendingPoints();
+}
+
+bool Model::select(float pos[2])
+{
+    float selectionRadius = m_selectionRadiusInWindowPixels * m_renderState->windowToContourScale();
+    m_contour.selectCurve(Math::Vec2D(pos[0], pos[1]), selectionRadius);
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+    if (m_contour.idActiveCurve() >= 0) return true;
+    else return false;
+}
+void Model::deselect()
+{
+    int idActiveCurve = m_contour.idActiveCurve();
+    if (idActiveCurve >= 0) {
+        m_contour.deselectCurve();
+        m_renderState->setContourNeedsUpdate(true);
+        m_renderState->setActiveCurveNeedsUpdate(true);
+    }
+}
+void Model::deleteSelected()
+{
+    int idActiveCurve = m_contour.idActiveCurve();
+    if (idActiveCurve >= 0) {
+        m_contour.removeCurve(idActiveCurve);
+        m_renderState->setContourNeedsUpdate(true);
+        m_renderState->setActiveCurveNeedsUpdate(true);
+        commitEdit();
+    }
+}
+bool Model::traceVessel(Math::Vec2D start, Math::Vec2D end, float expectedRadius)
+{
+    VESCL_PROFILE_SCOPE("Model::traceVessel", "fit");
+    try {
+        if (!m_image.isValid()) {
+            throw std::runtime_error("No image available for vessel tracing.");
+        }
+        if (m_isDrawing) return false;
+        // Tile costs are kept between traces of the same image with the same radius
+        ImageFilterer::VesselContrastType contrastType = m_imageFilterer->vesselContrastType();
+        if (!m_minimalPath || !m_minimalPath->isValidFor(&m_image, contrastType, expectedRadius)) {
+            delete m_minimalPath;
+            m_minimalPath = new MinimalPath(&m_image, contrastType, expectedRadius);
+        }
+        std::vector<Math::Vec2D> path = m_minimalPath->trace(start, end);
+        if (path.size() < 2) return false;
+
+        // Take points about pointSpacing apart along the pixel path, and the end point
+        float pointSpacing = 3;
+        std::vector<CurvePoint> points;
+        points.push_back(CurvePoint(path.front(), expectedRadius));
+        float length = 0;
+        for (size_t i = 1; i < path.size(); i++) {
+            length += (path[i] - path[i - 1]).length();
+            if (length >= pointSpacing || i == path.size() - 1) {
+                points.push_back(CurvePoint(path[i], expectedRadius));
+                length = 0;
+            }
+        }
+
+        // Pixel paths cut corners and wander within wide vessels, so the points are fitted
+        // to the centerline before the widths are measured
+        points = fitToNearestVessel(points, expectedRadius);
+        if (points.size() < 2) return false;
+        deselect();
+        Curve* curve = m_contour.curve(m_contour.addCurve());
+        curve->points().assign(points.begin(), points.end());
+        fitWidthsFromRadii(curve);
+        m_renderState->setContourNeedsUpdate(true);
+        m_renderState->setActiveCurveNeedsUpdate(true);
+        commitEdit();
+    }
+    catch (std::exception& e) {
+        std::cout << "Exception " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+void Model::clearContour()
+{
+    m_contour.clear();
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+    commitEdit();
+}
+
+void Model::undo()
+{
+    if (m_isDrawing || !m_history.undo(m_contour)) return;
+    if (m_journal.isOpen()) m_journal.append(m_contour);
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+}
+void Model::redo()
+{
+    if (m_isDrawing || !m_history.redo(m_contour)) return;
+    if (m_journal.isOpen()) m_journal.append(m_contour);
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+}
+
+int Model::openJournal(const std::string& filename, bool replay)
+{
+    closeJournal();
+    if (m_contourOffset < 0) return -1;
+    m_filename = filename;
+    int numReplayed = m_journal.open(filename, m_contour, replay);
+    if (numReplayed > 0) {
+        m_history.clear();
+        m_history.commit(m_contour);
+        m_renderState->setContourNeedsUpdate(true);
+        m_renderState->setActiveCurveNeedsUpdate(true);
+    }
+    return numReplayed;
+}
+bool Model::saveIncremental()
+{
+    // The contour is checkpointed in the journal before the file's contour is rewritten, 
+    // so an interrupted rewrite is recovered from the journal. Edits made during the 
+    // rewrite are journaled after the checkpoint.
+    VESCL_PROFILE_SCOPE("Model::saveIncremental", "io");
+    finishCompaction(true);
+    std::string contourData;
+    if (!m_journal.isOpen() || !m_journal.checkpoint(m_contour, &contourData)) return false;
+    m_isCompactionDone = false;
+    m_compaction = std::thread([this, contourData]() {
+        m_isCompactionOK = Journal::writeContourInPlace(m_filename, m_contourOffset, contourData);
+        m_isCompactionDone = true;
+    });
+    return true;
+}
+void Model::closeJournal()
+{
+    finishCompaction(true);
+    m_journal.close(true);
+    m_filename.clear();
+}
+
+ImageFilterer::VesselContrastType Model::vesselContrast() const
+{
+    return m_imageFilterer->vesselContrastType();
+}
+void Model::setVesselContrast(ImageFilterer::VesselContrastType contrastType)
+{
+    m_imageFilterer->setVesselContrastType(contrastType);
+}
+void Model::fitSelectedToNearestVessel(float expectedRadius)
+{
+    VESCL_PROFILE_SCOPE("Model::fitSelectedToNearestVessel", "fit");
+    int idActiveCurve = m_contour.idActiveCurve();
+    unsigned int revision = 0;
+    std::vector<CurvePoint> points = curvePoints(idActiveCurve, &revision);
+    if (points.empty()) return;
+    points = fitToNearestVessel(points, expectedRadius);
+    if (!points.empty()) setCurvePoints(idActiveCurve, points, &revision, true);
+}
+void Model::fitSelectedVesselWidth(float expectedRadius)
+{
+    VESCL_PROFILE_SCOPE("Model::fitSelectedVesselWidth", "fit");
+    try {
+        if (!m_image.isValid()) {
+            throw std::runtime_error("No image available for width detection.");
+        }
+
+        Curve* activeCurve = m_contour.curve(m_contour.idActiveCurve());
+        if (!activeCurve) return;
+        std::list<CurvePoint>& points = activeCurve->points();
+        if (points.size() <= 1) return;
+
+        for (std::list<CurvePoint>::iterator it = points.begin(); it != points.end(); it++) {
+            std::list<CurvePoint>::iterator itPrev = (it == points.begin()) ? it : std::prev(it);
+            std::list<CurvePoint>::iterator itNext = (std::next(it) == points.end()) ? it : std::next(it);
+            Math::Vec2D predictedP;
+            Math::Vec2D curveDir = itNext->pos() - itPrev->pos();
+            curveDir.normalize();
+            float width = m_imageFilterer->getWidthAtP(it->pos(), curveDir, expectedRadius);
+            it->setRadius(0.5 * width);
+        }
+
+        // First/last widths may be bad due to bad tangents. Use the widths of adjacent 
+        // points
+        std::list<CurvePoint>::iterator it = std::prev(points.end());
+        it->setRadius(std::prev(it)->radius());
+        it = points.begin();
+        it->setRadius(std::next(it)->radius());
+
+        // Smooth the curve widths
+        activeCurve->applySmoothing(Curve::SmoothingType::Widths);
+        commitEdit();
+    }
+    catch (std::exception& e) {
+        std::cout << "Exception " << e.what() << std::endl;
+    }
+}
+
+std::vector<CurvePoint> Model::curvePoints(int idCurve, unsigned int* revision)
+{
+    Curve* curve = m_contour.curve(idCurve);
+    if (!curve) return std::vector<CurvePoint>();
+    const std::list<CurvePoint>& points = static_cast<const Curve*>(curve)->points();
+    if (revision) *revision = curve->revision();
+    return std::vector<CurvePoint>(points.begin(), points.end());
+}
+std::vector<CurvePoint> Model::fitToNearestVessel(std::vector<CurvePoint> points, float expectedRadius,
+    const FitProgress& progress) const
+{
+    try {
+        if (!m_image.isValid()) {
+            throw std::runtime_error("No image available for curve fitting.");
+        }
+        if (points.size() == 0) return points;
+
+        // Fit curve points to the nearest vessel. These constants were set by trial 
+        // and error. For a better fit, consider more tries and a smaller moveConst. For
+        // speed, consider fewer tries and a larger moveConst.
+        int numTries = 10;
+        float moveConst = 0.5;  // Set between 0 and 1
+        std::vector<Math::Vec2D> moveVecs(points.size());
+
+        // Tries are spread evenly from the coarse to the fine pyramid level, so wide 
+        // vessels are captured at the coarse levels and the fit is refined at the finer
+        int coarseLevel, fineLevel;
+        m_imageFilterer->getFittingLevels(expectedRadius, &coarseLevel, &fineLevel);
+        int numLevels = coarseLevel - fineLevel + 1;
+        for (int i = 0; i < numTries; i++) {
+            int level = coarseLevel - (i * numLevels) / numTries;
+            for (size_t j = 0; j < points.size(); j++) {
+                // Compute move vector for each curve point
+                moveVecs[j] = m_imageFilterer->getVecToClosestVessel(points[j].pos(), expectedRadius, level);
+            }
+            for (size_t j = 0; j < points.size(); j++) {
+                // Move curve points in direction of centerline
+                points[j].setPos(points[j].pos() + moveConst * moveVecs[j]);
+            }
+            if (progress && !progress(points, (float)(i + 1) / numTries)) return std::vector<CurvePoint>();
+        }
+
+        // Smooth the curve points. This helps prevent kinks in the fitted curve.
+        Curve curve(-1);
+        curve.points().assign(points.begin(), points.end());
+        curve.applySmoothing(Curve::SmoothingType::Points);
+        const std::list<CurvePoint>& smoothed = static_cast<const Curve&>(curve).points();
+        points.assign(smoothed.begin(), smoothed.end());
+    }
+    catch (std::bad_alloc& e) {
+        std::cout << "Memory Allocation " << "No memory for curve fitting." << e.what() << std::endl;
+        points.clear();
+    }
+    catch (std::exception & e) {
+        std::cout << "Exception " << e.what() << std::endl;
+        points.clear();
+    }
+    return points;
+}
+bool Model::setCurvePoints(int idCurve, const std::vector<CurvePoint>& points, unsigned int* revision, 
+    bool commit)
+{
+    Curve* curve = m_contour.curve(idCurve);
+    if (!curve || m_isDrawing || curve->revision() != *revision) return false;
+    curve->points().assign(points.begin(), points.end());
+    *revision = curve->revision();
+    m_renderState->setContourNeedsUpdate(true);
+    m_renderState->setActiveCurveNeedsUpdate(true);
+    if (commit) commitEdit();
+    return true;
+}
+
+// 
+// Private
+//
+void Model::fitPropagatedCurve(Curve* curve, const std::vector<CurvePoint>& previous)
+{
+    // Vessels move little between frames, so points start close to the centerline and
+    // need fewer tries than fitSelectedToNearestVessel. Each point stops once its moves
+    // become small. The previous radius of each point is its expected radius.
+    int maxTries = 5;
+    float moveConst = 0.5;
+    float minMove = 0.05f;
+    std::list<CurvePoint>& points = curve->points();
+    points.assign(previous.begin(), previous.end());
+    for (CurvePoint& point : points) {
+        for (int i = 0; i < maxTries; i++) {
+            Math::Vec2D move = moveConst * m_imageFilterer->getVecToClosestVessel(point.pos(), point.radius());
+            point.setPos(point.pos() + move);
+            if (move.length() < minMove) break;
+        }
+    }
+    curve->applySmoothing(Curve::SmoothingType::Points);
+    fitWidthsFromRadii(curve);
+}
+void Model::fitWidthsFromRadii(Curve* curve)
+{
+    // Measure widths as in fitSelectedVesselWidth, with the radius of each point as its
+    // expected radius. Points keep their radius where no width is found.
+    std::list<CurvePoint>& points = curve->points();
+    if (points.size() <= 1) return;
+    for (std::list<CurvePoint>::iterator it = points.begin(); it != points.end(); it++) {
+        std::list<CurvePoint>::iterator itPrev = (it == points.begin()) ? it : std::prev(it);
+        std::list<CurvePoint>::iterator itNext = (std::next(it) == points.end()) ? it : std::next(it);
+        Math::Vec2D curveDir = itNext->pos() - itPrev->pos();
+        curveDir.normalize();
+        float width = m_imageFilterer->getWidthAtP(it->pos(), curveDir, it->radius());
+        if (width > 0) it->setRadius(0.5 * width);
+    }
+    std::list<CurvePoint>::iterator it = std::prev(points.end());
+    it->setRadius(std::prev(it)->radius());
+    it = points.begin();
+    it->setRadius(std::next(it)->radius());
+    curve->applySmoothing(Curve::SmoothingType::Widths);
+}
+void Model::setSnapDeadline(double msecs)
+{
+    // A negative budget snaps all points
+    typedef std::chrono::steady_clock Clock;
+    if (msecs < 0) m_snapDeadline = Clock::time_point::max();
+    else m_snapDeadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(msecs));
+}
+bool Model::snapDrawnPoint(Curve::FitType type, CurvePoint& point, Math::Vec2D dir)
+{
+    // Points are fitted as in fitPropagatedCurve, except that drawn points may start 
+    // further from the centerline and thus get as many tries as fitSelectedToNearestVessel
+    if (std::chrono::steady_clock::now() > m_snapDeadline) return false;
+    if (type == Curve::FitType::Centerline) {
+        int maxTries = 10;
+        float moveConst = 0.5;
+        float minMove = 0.05f;
+        for (int i = 0; i < maxTries; i++) {
+            Math::Vec2D move = moveConst * m_imageFilterer->getVecToClosestVessel(point.pos(), point.radius());
+            point.setPos(point.pos() + move);
+            if (move.length() < minMove) break;
+        }
+    }
+    else if (dir.length() > std::numeric_limits<float>::epsilon()) {
+        // Single point strokes have no direction to measure the width across, so they
+        // are only snapped to the centerline and keep their radius
+        float width = m_imageFilterer->getWidthAtP(point.pos(), dir, point.radius());
+        if (width > 0) point.setRadius(0.5 * width);
+    }
+    return true;
+}
+bool Model::loadStoredImage(const std::string& key, const std::string& directory)
+{
+    std::vector<std::string> directories = { directory, m_imageStore };
+    const char* environmentStore = std::getenv("VESCL_IMAGE_STORE");
+    if (environmentStore) directories.push_back(environmentStore);
+    for (const std::string& storeDirectory : directories) {
+        ImageStore store(storeDirectory);
+        if (storeDirectory.empty() || !store.contains(key)) continue;
+        if (!store.get(key, m_image)) return false;
+        m_imageStore = storeDirectory;
+        m_imageKey = key;
+        return true;
+    }
+    return false;
+}
+void Model::commitEdit()
+{
+    m_history.commit(m_contour);
+    if (m_journal.isOpen()) {
+        finishCompaction(false);
+        m_journal.append(m_contour);
+    }
+}
+void Model::finishCompaction(bool wait)
+{
+    if (!m_compaction.joinable() || (!wait && !m_isCompactionDone)) return;
+    m_compaction.join();
+    try {
+        if (!m_isCompactionOK) {
+            throw std::runtime_error("Incremental save failed. Edits remain in the journal.");
+        }
+        if (!m_journal.rebase()) {
+            throw std::runtime_error("Journal rebase failed.");
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "Exception " << e.what() << std::endl;
+    }
+}
@@ -1,73 +1,195 @@
-//
-// Model.h
-// Specific to this application. Contains a contour and its reference image.
-// 
-// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
-// 
-// This code is free software : you can redistribute it and /or modify it under
-// the terms of the GNU General Public License as published by the Free Software 
-// Foundation, either version 3 of the License, or (at your option) any later version.
-// 
-// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
-// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
-// PARTICULAR PURPOSE. See the GNU General Public License for more details.
-// 
-// You may have received a copy of the GNU General Public License along with this 
-// program. If not, see < http://www.gnu.org/licenses/>.
-// 
-
-#pragma once
-
-#include "Image.h"
-#include "Contour.h"
-#include "ImageFilterer.h"
-#include "../Controller/RenderState.h"
-
-class Model
-{
-public:
-    Model(RenderState* renderState);
-    ~Model();
-
-    void clear();
-    void save(std::ofstream& file);
-    void load(std::ifstream& file);
-
-    Contour* contour() { return &m_contour; };
-    void startDraw(CurvePoint pStart);
-    void updateDraw(CurvePoint point);
-    void endDraw(CurvePoint point);
-
-    bool select(float pos[2]);
-    void deselect();
-    void deleteSelected();
-    void fitSelectedToNearestVessel(float expectedRadius);
-    void fitSelectedVesselWidth(float expectedRadius);
-
-    Image& image() { return m_image; };
-    bool imageIsValid() const { return m_image.isValid(); };
-    int imageWidth() const { return m_image.width(); };
-    int imageHeight() const { return m_image.height(); };
-    float imageNormalizedMin() { return m_image.normalizedMinValue(); };
-    float imageNormalizedMax() { return m_image.normalizedMaxValue(); };
-    ImageFilterer::VesselContrastType vesselContrast() const;
-    void setVesselContrast(ImageFilterer::VesselContrastType contrastType);
-
-    // Make non-copyable
-    Model(Model const&) = delete;
-    void operator=(Model const&) = delete;
-
-private:
-    Image m_image;
-    Contour m_contour;
-    RenderState* m_renderState; 
-    ImageFilterer* m_imageFilterer;
-
-    // Version number for saving and loading
-    std::string m_version = "VSCL0001";
-
-    // Drawing and editing
-    bool m_isDrawing;
-    float m_minSeparationInWindowPixels;
-    float m_selectionRadiusInWindowPixels;
+//
+// Model.h
+// Specific to this application. Contains a contour and its reference image.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "Image.h"
+#include "Contour.h"
+#include "ImageFilterer.h"
+#include "History.h"
+#include "Journal.h"
+#include "ImageSequence.h"
+#include "../Controller/RenderState.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <vector>
+#include <thread>
+
+class MinimalPath;
+
+class Model
+{
+public:
+    Model(RenderState* renderState);
+    ~Model();
+
+    void clear();
+    void save(std::ofstream& file);
+    void load(std::ifstream& file);
+
+    // Takes the image and contour of another model, e.g., one loaded on a worker thread,
+    // with their file and image storage state. The other model is cleared.
+    void moveFrom(Model& other);
+
+    // With an image store, save() stores the image once in the store's directory and the
+    // file only references it. Files that reference a stored image are loaded by mapping
+    // it from the referenced directory, the image store or $VESCL_IMAGE_STORE, and set
+    // the image store to where it was found. An empty directory embeds images.
+    void setImageStore(const std::string& directory) { m_imageStore = directory; };
+    const std::string& imageStore() const { return m_imageStore; };
+
+    // Embedded images are saved as compressed blocks (see ImageBlockCodec) if set. Set
+    // when a file with a compressed image is loaded.
+    void setImageCompressed(bool isCompressed) { m_isImageCompressed = isCompressed; };
+    bool isImageCompressed() const { return m_isImageCompressed; };
+
+    // Image sequences, e.g., cine runs, are decoded frame by frame (see ImageSequence). 
+    // Each frame has its own contour, which is kept while other frames are shown. The 
+    // history is reset when the frame changes. Only the current frame and its contour 
+    // are saved.
+    bool openSequence(int numFrames, ImageSequence::FrameDecoder decoder);
+    bool setFrame(int frame);
+    int numFrames() const { return m_sequence ? m_sequence->numFrames() : 0; };
+    int frame() const { return m_frame; };
+
+    // Copies the contour to the next frame and fits it there, starting from the curves'
+    // positions and widths in the current frame. Curves are fitted in parallel. Replaces
+    // the contour of the next frame, which is restored by undo.
+    bool propagateToNextFrame();
+
+    Contour* contour() { return &m_contour; };
+    void startDraw(CurvePoint pStart);
+    void updateDraw(CurvePoint point);
+    void endDraw(CurvePoint point);
+
+    // Snapping while drawing. Drawn points are fitted to the nearest vessel centerline 
+    // and width as they are added (see Curve::setPointFitter), within a time budget per
+    // update. Points that do not fit in the budget are snapped by snapPendingPoints(), 
+    // e.g., when the event loop is idle, which returns true while points remain pending.
+    // Remaining points are snapped when drawing ends.
+    void setSnapWhileDrawing(bool snap) { m_isSnapWhileDrawing = snap; };
+    bool isSnapWhileDrawing() const { return m_isSnapWhileDrawing; };
+    void setSnapBudget(double msecsPerUpdate) { m_snapBudgetMsecs = msecsPerUpdate; };
+    bool snapPendingPoints();
+    bool hasPendingSnaps();
+
+    bool select(float pos[2]);
+    void deselect();
+    void deleteSelected();
+    void fitSelectedToNearestVessel(float expectedRadius);
+    void fitSelectedVesselWidth(float expectedRadius);
+    void clearContour();
+
+    // Adds a curve along the vessel connecting two points, found as a minimal-cost path
+    // (see MinimalPath) and fitted to the vessel centerline and widths. The new curve is
+    // selected. Returns false if no path was found.
+    bool traceVessel(Math::Vec2D start, Math::Vec2D end, float expectedRadius);
+
+    // Fitting in the background, e.g., as a job (see JobScheduler). Points copied with 
+    // curvePoints() are fitted by fitToNearestVessel(), which can run on any thread while
+    // the image is unchanged. progress is called after each try with the points so far 
+    // and the fraction done, and fitting stops early if it returns false. setCurvePoints()
+    // sets the points of the curve unless the curve was edited since its revision was 
+    // taken, and updates the revision. It commits an edit if commit is set.
+    typedef std::function<bool(const std::vector<CurvePoint>& points, float progress)> FitProgress;
+    std::vector<CurvePoint> curvePoints(int idCurve, unsigned int* revision);
+    std::vector<CurvePoint> fitToNearestVessel(std::vector<CurvePoint> points, float expectedRadius,
+        const FitProgress& progress = nullptr) const;
+    bool setCurvePoints(int idCurve, const std::vector<CurvePoint>& points, unsigned int* revision, bool commit);
+
+    // Undo and redo contour edits. Edits are committed when they are completed, e.g.,
+    // when drawing ends. The history is reset when an image or file is loaded.
+    bool canUndo() const { return m_history.canUndo(); };
+    bool canRedo() const { return m_history.canRedo(); };
+    void undo();
+    void redo();
+
+    // Edits of a file that was loaded or saved are journaled next to it. openJournal()
+    // replays edits left by an interrupted session if replay is true, and returns their
+    // number. saveIncremental() saves the edits to the journaled file by rewriting only
+    // its contour, in the background. closeJournal() discards the journal.
+    int openJournal(const std::string& filename, bool replay);
+    bool saveIncremental();
+    void closeJournal();
+    bool isJournalOpen() const { return m_journal.isOpen(); };
+
+    Image& image() { return m_image; };
+    bool imageIsValid() const { return m_image.isValid(); };
+    int imageWidth() const { return m_image.width(); };
+    int imageHeight() const { return m_image.height(); };
+    float imageNormalizedMin() { return m_image.normalizedMinValue(); };
+    float imageNormalizedMax() { return m_image.normalizedMaxValue(); };
+    ImageFilterer::VesselContrastType vesselContrast() const;
+    void setVesselContrast(ImageFilterer::VesselContrastType contrastType);
+
+    // Make non-copyable
+    Model(Model const&) = delete;
+    void operator=(Model const&) = delete;
+
+private:
+    Image m_image;
+    Contour m_contour;
+    RenderState* m_renderState; 
+    ImageFilterer* m_imageFilterer;
+    History m_history;
+    void commitEdit();
+
+    // Journaling. The contour is at the end of the file, after the image data.
+    Journal m_journal;
+    std::string m_filename;
+    long long m_contourOffset;
+    std::thread m_compaction;
+    std::atomic<bool> m_isCompactionDone;
+    bool m_isCompactionOK;
+    void finishCompaction(bool wait);
+
+    // Version number for saving and loading
+    std::string m_version = "VSCL0001";
+
+    // Image store and the key of the current image in it, computed when first needed
+    std::string m_imageStore;
+    std::string m_imageKey;
+    bool m_isImageCompressed;
+    bool loadStoredImage(const std::string& key, const std::string& directory);
+
+    // Image sequence and the contours of frames other than the current frame
+    ImageSequence* m_sequence;
+    int m_frame;
+    std::map<int, Contour> m_frameContours;
+    void fitPropagatedCurve(Curve* curve, const std::vector<CurvePoint>& previous);
+    void fitWidthsFromRadii(Curve* curve);
+
+    // Minimal path of the last trace, whose tile costs are reused by traces of the same
+    // image with the same expected radius
+    MinimalPath* m_minimalPath;
+
+    // Drawing and editing
+    bool m_isDrawing;
+    float m_minSeparationInWindowPixels;
+    float m_selectionRadiusInWindowPixels;
+
+    // Snapping while drawing. Points are fitted until the deadline.
+    bool m_isSnapWhileDrawing;
+    double m_snapBudgetMsecs;
+    std::chrono::steady_clock::time_point m_snapDeadline;
+    void setSnapDeadline(double msecs);
+    bool snapDrawnPoint(Curve::FitType type, CurvePoint& point, Math::Vec2D dir);
 };
\ No newline at end of file
@@ -0,0 +1,77 @@
+//
+// MappedFile.cpp
+// Implementation of MappedFile.
+//
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 
+// Public
+//
+MappedFile::MappedFile() :
+	m_data(nullptr),
+	m_size(0)
+#ifdef _WIN32
+	, m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr)
+#endif
+{
+}
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+#ifdef _WIN32
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER size;
+	if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+		close();
+		return false;
+	}
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (m_mapping) m_data = (unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0);
+	m_size = (size_t)size.QuadPart;
+#else
+	int file = ::open(filename.c_str(), O_RDONLY);
+	struct stat status;
+	if (file >= 0 && fstat(file, &status) == 0 && status.st_size > 0) {
+		void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED) {
+			m_data = (unsigned char*)data;
+			m_size = (size_t)status.st_size;
+		}
+	}
+	if (file >= 0) ::close(file);
+#endif
+	if (!m_data) close();
+	return isOpen();
+}
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data) UnmapViewOfFile(m_data);
+	if (m_mapping) CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data) munmap(m_data, m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
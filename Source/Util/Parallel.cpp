@@ -0,0 +1,57 @@
+//
+// Parallel.cpp
+// Implementation of Parallel.
+//
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+	// Set on threads running chunks so nested loops don't oversubscribe the cores
+	thread_local bool isInForRange = false;
+}
+
+//
+// Public
+//
+int Parallel::numThreads()
+{
+	static const int numThreads = std::max(1u, std::thread::hardware_concurrency());
+	return numThreads;
+}
+
+void Parallel::forRange(int begin, int end, int grainSize, const std::function<void(int, int)>& body)
+{
+	int numItems = end - begin;
+	if (numItems <= 0) return;
+	grainSize = std::max(1, grainSize);
+
+	// Use a few chunks per thread so uneven chunks are balanced. Threads take the next 
+	// unprocessed chunk until none remain.
+	int numChunks = std::max(1, std::min((numItems + grainSize - 1) / grainSize, 4 * numThreads()));
+	int chunkSize = (numItems + numChunks - 1) / numChunks;
+	numChunks = (numItems + chunkSize - 1) / chunkSize;
+	int numWorkers = std::min(numThreads(), numChunks);
+	if (numWorkers == 1 || isInForRange) {
+		body(begin, end);
+		return;
+	}
+
+	std::atomic<int> nextChunk(0);
+	auto worker = [&]() {
+		isInForRange = true;
+		for (int chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++) {
+			int chunkBegin = begin + chunk * chunkSize;
+			body(chunkBegin, std::min(end, chunkBegin + chunkSize));
+		}
+		isInForRange = false;
+	};
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numWorkers; i++) threads.push_back(std::thread(worker));
+	worker();
+	for (std::thread& thread : threads) thread.join();
+}
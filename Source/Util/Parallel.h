@@ -0,0 +1,35 @@
+//
+// Parallel.h
+// Minimal data parallelism for CPU-bound loops over rows, columns or bands of an image.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <functional>
+
+namespace Parallel
+{
+	// Number of worker threads used by forRange, at least 1
+	int numThreads();
+
+	// Splits [begin, end) into contiguous chunks of at least grainSize items and calls
+	// body(chunkBegin, chunkEnd) for each chunk. Threads are created for each call, up 
+	// to numThreads() including the calling thread, and joined before it returns, so
+	// loops should be large enough to amortize thread creation. Calls nested in the body
+	// of another forRange run on the calling thread rather than creating more threads.
+	// body must be safe to call concurrently for disjoint chunks.
+	void forRange(int begin, int end, int grainSize, const std::function<void(int, int)>& body);
+};
@@ -0,0 +1,131 @@
+//
+// Profiler.cpp
+// Implementation of Profiler.
+//
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+//
+// Public
+//
+Profiler& Profiler::instance()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+long long Profiler::now() const
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+void Profiler::addEvent(const char* name, const char* category, long long start, long long duration, 
+	int threadID)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events[m_next] = { name, category, start, duration, threadID };
+	m_next++;
+	if (m_next == m_capacity) {
+		m_next = 0;
+		m_isFull = true;
+	}
+}
+void Profiler::addEvent(const char* name, const char* category, long long start, long long duration)
+{
+	addEvent(name, category, start, duration, currentThreadID());
+}
+
+std::vector<Profiler::Event> Profiler::events() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::vector<Event> events;
+	if (m_isFull) {
+		events.insert(events.end(), m_events.begin() + m_next, m_events.end());
+	}
+	events.insert(events.end(), m_events.begin(), m_events.begin() + m_next);
+	return events;
+}
+
+void Profiler::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_next = 0;
+	m_isFull = false;
+}
+
+std::vector<Profiler::Summary> Profiler::summarize(int maxEventsPerName) const
+{
+	// Walk backwards from the newest event so only the most recent events are averaged
+	std::vector<Event> allEvents = events();
+	std::vector<Summary> summaries;
+	std::map<std::string, size_t> summaryIndex;
+	for (std::vector<Event>::reverse_iterator it = allEvents.rbegin(); it != allEvents.rend(); it++) {
+		std::map<std::string, size_t>::iterator index = summaryIndex.find(it->name);
+		if (index == summaryIndex.end()) {
+			summaryIndex[it->name] = summaries.size();
+			summaries.push_back({ it->name, it->category, (double)it->duration, 1 });
+		}
+		else {
+			Summary& summary = summaries[index->second];
+			if (summary.count >= maxEventsPerName) continue;
+			summary.meanDuration += it->duration;
+			summary.count++;
+		}
+	}
+	for (Summary& summary : summaries) summary.meanDuration /= summary.count;
+	std::sort(summaries.begin(), summaries.end(), [](const Summary& a, const Summary& b) {
+		return std::string(a.name) < std::string(b.name);
+	});
+	return summaries;
+}
+
+bool Profiler::writeChromeTrace(const std::string& filename) const
+{
+	std::ofstream file(filename);
+	if (!file.is_open()) return false;
+
+	// Complete ("X") events, one per line. GPU timings are placed on their own track.
+	std::vector<Event> allEvents = events();
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << gpuThreadID << 
+		",\"args\":{\"name\":\"GPU\"}}";
+	for (const Event& event : allEvents) {
+		file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << 
+			"\",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.duration << 
+			",\"pid\":1,\"tid\":" << event.threadID << "}";
+	}
+	file << "\n]}\n";
+	file.close();
+	return !file.fail();
+}
+
+//
+// Private
+//
+Profiler::Profiler() :
+	m_startTime(std::chrono::steady_clock::now()),
+	m_capacity(16384),
+	m_next(0),
+	m_isFull(false)
+{
+	m_events.resize(m_capacity);
+}
+Profiler::~Profiler() {}
+
+int Profiler::currentThreadID()
+{
+	// Thread IDs are numbered in order of first use, starting after the GPU track
+	static std::mutex idMutex;
+	static int numThreads = 0;
+	thread_local int id = -1;
+	if (id < 0) {
+		std::lock_guard<std::mutex> lock(idMutex);
+		id = gpuThreadID + 1 + numThreads++;
+	}
+	return id;
+}
@@ -0,0 +1,105 @@
+//
+// Profiler.h
+// Lightweight instrumentation. Records scoped CPU timings and GPU pass timings into a
+// ring buffer that can be displayed in an overlay or saved as a Chrome trace file.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Instrumentation is compiled in only when VESCL_PROFILING is defined. Otherwise the
+// profiling macros expand to nothing and timing has no cost.
+#define VESCL_PROFILE_CONCAT_INNER(a, b) a##b
+#define VESCL_PROFILE_CONCAT(a, b) VESCL_PROFILE_CONCAT_INNER(a, b)
+#ifdef VESCL_PROFILING
+#define VESCL_PROFILE_SCOPE(name, category) \
+	Profiler::ScopedTimer VESCL_PROFILE_CONCAT(profileScope, __LINE__)(name, category)
+#else
+#define VESCL_PROFILE_SCOPE(name, category)
+#endif
+
+class Profiler
+{
+public:
+	static Profiler& instance();
+
+	// Times are in microseconds since the profiler was created
+	typedef struct {
+		const char* name;		// Must be a string literal or otherwise outlive the profiler
+		const char* category;
+		long long start;
+		long long duration;
+		int threadID;			// Small integer IDs; GPU timings use gpuThreadID
+	} Event;
+	static const int gpuThreadID = 0;
+
+	long long now() const;
+	void addEvent(const char* name, const char* category, long long start, long long duration, 
+		int threadID);
+	void addEvent(const char* name, const char* category, long long start, long long duration);
+
+	// Returns recorded events, oldest first
+	std::vector<Event> events() const;
+	void clear();
+
+	// Mean duration of the most recent events with each name, for display
+	typedef struct {
+		const char* name;
+		const char* category;
+		double meanDuration;
+		int count;
+	} Summary;
+	std::vector<Summary> summarize(int maxEventsPerName) const;
+
+	// Saves the events in the Chrome trace event format (chrome://tracing, Perfetto)
+	bool writeChromeTrace(const std::string& filename) const;
+
+	// Records the lifetime of the timer
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(const char* name, const char* category) :
+			m_name(name), m_category(category), m_start(Profiler::instance().now()) {};
+		~ScopedTimer() {
+			Profiler& profiler = Profiler::instance();
+			profiler.addEvent(m_name, m_category, m_start, profiler.now() - m_start);
+		};
+	private:
+		const char* m_name;
+		const char* m_category;
+		long long m_start;
+	};
+
+	// Make non-copyable
+	Profiler(Profiler const&) = delete;
+	void operator=(Profiler const&) = delete;
+
+private:
+	Profiler();
+	~Profiler();
+
+	std::chrono::steady_clock::time_point m_startTime;
+	mutable std::mutex m_mutex;
+	std::vector<Event> m_events;
+	size_t m_capacity;
+	size_t m_next;
+	bool m_isFull;
+	int currentThreadID();
+};
@@ -0,0 +1,320 @@
+//
+// RasterFileWriter.cpp
+// Implementation of RasterFileWriter.
+//
+
+#include "RasterFileWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+	bool isLittleEndianHost()
+	{
+		const uint16_t value = 1;
+		unsigned char firstByte;
+		memcpy(&firstByte, &value, 1);
+		return firstByte == 1;
+	}
+	std::string lowerCaseSuffix(const std::string& filename)
+	{
+		size_t dot = filename.find_last_of('.');
+		if (dot == std::string::npos) return std::string();
+		std::string suffix = filename.substr(dot + 1);
+		std::transform(suffix.begin(), suffix.end(), suffix.begin(),
+			[](unsigned char c) { return (char) tolower(c); });
+		return suffix;
+	}
+}
+
+//
+// Public
+//
+RasterFileWriter::RasterFileWriter() :
+	m_container(Container::NotSupported),
+	m_format(SampleFormat::UInt8),
+	m_width(0),
+	m_height(0),
+	m_numRowsWritten(0),
+	m_bytesPerSample(1),
+	m_adler(1)
+{
+}
+RasterFileWriter::~RasterFileWriter()
+{
+	if (m_file.is_open()) close();
+}
+
+RasterFileWriter::Container RasterFileWriter::containerForFilename(const std::string& filename)
+{
+	std::string suffix = lowerCaseSuffix(filename);
+	if (suffix == "png") return Container::PNG;
+	if (suffix == "tif" || suffix == "tiff") return Container::TIFF;
+	if (suffix == "raw") return Container::Raw;
+	return Container::NotSupported;
+}
+bool RasterFileWriter::isSupported(Container container, SampleFormat format)
+{
+	switch (container) {
+	case Container::PNG:
+		return (format == SampleFormat::UInt8 || format == SampleFormat::UInt16);
+	case Container::TIFF:
+	case Container::Raw:
+		return true;
+	case Container::NotSupported:
+	default:
+		return false;
+	}
+}
+
+bool RasterFileWriter::open(const std::string& filename, int width, int height, SampleFormat format)
+{
+	try {
+		if (m_file.is_open()) {
+			throw std::runtime_error("Raster file is already open.");
+		}
+		if (width <= 0 || height <= 0) {
+			throw std::runtime_error("Invalid raster size.");
+		}
+		m_container = containerForFilename(filename);
+		if (!isSupported(m_container, format)) {
+			throw std::runtime_error("Raster file type does not support the sample format.");
+		}
+		m_format = format;
+		m_width = width;
+		m_height = height;
+		m_numRowsWritten = 0;
+		m_bytesPerSample = (format == SampleFormat::UInt8) ? 1 : (format == SampleFormat::UInt16) ? 2 : 4;
+
+		// Uncompressed TIFF offsets are 32-bit
+		if (m_container == Container::TIFF &&
+			(uint64_t)width * height * m_bytesPerSample > 0xFFFFFF00ull) {
+			throw std::runtime_error("Raster is too large for a TIFF file.");
+		}
+
+		m_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!m_file.is_open()) {
+			throw std::runtime_error("Can't open raster file.");
+		}
+		if (m_container == Container::PNG) writePNGHeader();
+		else if (m_container == Container::TIFF) writeTIFFHeader();
+		if (!m_file.good()) {
+			throw std::runtime_error("Can't write raster file.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		if (m_file.is_open()) m_file.close();
+		return false;
+	}
+	return true;
+}
+
+bool RasterFileWriter::writeRow(const void* samples)
+{
+	if (!m_file.is_open() || m_numRowsWritten >= m_height) return false;
+	if (m_container == Container::PNG) {
+		writePNGRow(samples);
+	}
+	else {
+		m_file.write((const char*) samples, (std::streamsize) m_width * m_bytesPerSample);
+	}
+	m_numRowsWritten++;
+	return m_file.good();
+}
+
+bool RasterFileWriter::close()
+{
+	if (!m_file.is_open()) return false;
+	bool isComplete = (m_numRowsWritten == m_height);
+	if (isComplete) {
+		if (m_container == Container::PNG) writePNGEnd();
+		else if (m_container == Container::TIFF) writeTIFFDirectory();
+	}
+	bool isGood = m_file.good();
+	m_file.close();
+	if (!isComplete) {
+		std::cout << "Exception " << "Raster file closed before all rows were written." << std::endl;
+	}
+	return isComplete && isGood;
+}
+
+//
+// Private
+//
+// PNG. Rows are written as stored (uncompressed) deflate blocks so that the zlib stream
+// can be produced incrementally without a compression library. Samples are big-endian.
+void RasterFileWriter::writePNGHeader()
+{
+	static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	m_file.write((const char*) signature, 8);
+
+	unsigned char header[13];
+	uint32_t width = m_width;
+	uint32_t height = m_height;
+	for (int i = 0; i < 4; i++) {
+		header[i] = (width >> (24 - 8 * i)) & 0xFF;
+		header[4 + i] = (height >> (24 - 8 * i)) & 0xFF;
+	}
+	header[8] = 8 * m_bytesPerSample;	// Bit depth
+	header[9] = 0;						// Grayscale
+	header[10] = 0;						// Deflate
+	header[11] = 0;						// Adaptive filtering, only filter type 0 is used
+	header[12] = 0;						// Not interlaced
+	writePNGChunk("IHDR", header, 13);
+
+	// zlib header for deflate with a 32K window and no preset dictionary
+	const unsigned char zlibHeader[2] = { 0x78, 0x01 };
+	writePNGChunk("IDAT", zlibHeader, 2);
+	m_adler = 1;
+}
+void RasterFileWriter::writePNGRow(const void* samples)
+{
+	// Filter type byte followed by the big-endian samples
+	size_t rowSize = 1 + (size_t) m_width * m_bytesPerSample;
+	std::vector<unsigned char> row(rowSize);
+	row[0] = 0;
+	if (m_format == SampleFormat::UInt16) {
+		const uint16_t* src = (const uint16_t*) samples;
+		for (int i = 0; i < m_width; i++) {
+			row[1 + 2 * i] = src[i] >> 8;
+			row[2 + 2 * i] = src[i] & 0xFF;
+		}
+	}
+	else {
+		memcpy(&row[1], samples, m_width);
+	}
+	m_adler = adler32(m_adler, row.data(), rowSize);
+
+	// Split the row into stored blocks of at most 65535 bytes. The last block of the
+	// last row ends the deflate stream.
+	const size_t maxBlockSize = 65535;
+	size_t numBlocks = (rowSize + maxBlockSize - 1) / maxBlockSize;
+	m_rowBuffer.resize(rowSize + 5 * numBlocks);
+	unsigned char* dst = m_rowBuffer.data();
+	bool isLastRow = (m_numRowsWritten == m_height - 1);
+	for (size_t offset = 0; offset < rowSize; offset += maxBlockSize) {
+		uint16_t blockSize = (uint16_t) std::min(maxBlockSize, rowSize - offset);
+		bool isFinal = isLastRow && (offset + blockSize == rowSize);
+		*dst++ = isFinal ? 1 : 0;
+		*dst++ = blockSize & 0xFF;
+		*dst++ = blockSize >> 8;
+		*dst++ = ~blockSize & 0xFF;
+		*dst++ = (~blockSize >> 8) & 0xFF;
+		memcpy(dst, &row[offset], blockSize);
+		dst += blockSize;
+	}
+	writePNGChunk("IDAT", m_rowBuffer.data(), m_rowBuffer.size());
+}
+void RasterFileWriter::writePNGChunk(const char type[4], const unsigned char* data, size_t size)
+{
+	writeUInt32BE((uint32_t) size);
+	m_file.write(type, 4);
+	if (size > 0) m_file.write((const char*) data, size);
+	uint32_t crc = crc32(0xFFFFFFFFu, (const unsigned char*) type, 4);
+	crc = crc32(crc, data, size);
+	writeUInt32BE(crc ^ 0xFFFFFFFFu);
+}
+void RasterFileWriter::writePNGEnd()
+{
+	unsigned char checksum[4];
+	for (int i = 0; i < 4; i++) checksum[i] = (m_adler >> (24 - 8 * i)) & 0xFF;
+	writePNGChunk("IDAT", checksum, 4);
+	writePNGChunk("IEND", nullptr, 0);
+}
+
+// TIFF. The header, image data and directory are written in the host's byte order,
+// with the directory following the single uncompressed strip.
+void RasterFileWriter::writeTIFFHeader()
+{
+	const char* byteOrder = isLittleEndianHost() ? "II" : "MM";
+	uint16_t magic = 42;
+	uint32_t directoryOffset = 8 + (uint32_t) m_width * m_height * m_bytesPerSample;
+	directoryOffset += directoryOffset & 1;	// Directories start on a word boundary
+	m_file.write(byteOrder, 2);
+	m_file.write((const char*) &magic, 2);
+	m_file.write((const char*) &directoryOffset, 4);
+}
+void RasterFileWriter::writeTIFFDirectory()
+{
+	uint32_t dataSize = (uint32_t) m_width * m_height * m_bytesPerSample;
+	if (dataSize & 1) m_file.put(0);
+
+	struct Entry { uint16_t tag; uint16_t type; uint32_t value; };
+	const uint16_t typeShort = 3;
+	const uint16_t typeLong = 4;
+	uint16_t sampleFormat = (m_format == SampleFormat::Float32) ? 3 : 1;
+	const Entry entries[] = {
+		{ 256, typeLong, (uint32_t) m_width },					// ImageWidth
+		{ 257, typeLong, (uint32_t) m_height },					// ImageLength
+		{ 258, typeShort, (uint32_t) 8 * m_bytesPerSample },	// BitsPerSample
+		{ 259, typeShort, 1 },									// Compression: none
+		{ 262, typeShort, 1 },									// Photometric: black is zero
+		{ 273, typeLong, 8 },									// StripOffsets
+		{ 277, typeShort, 1 },									// SamplesPerPixel
+		{ 278, typeLong, (uint32_t) m_height },					// RowsPerStrip
+		{ 279, typeLong, dataSize },							// StripByteCounts
+		{ 284, typeShort, 1 },									// PlanarConfiguration: chunky
+		{ 339, typeShort, sampleFormat }						// SampleFormat
+	};
+	uint16_t numEntries = sizeof(entries) / sizeof(Entry);
+	m_file.write((const char*) &numEntries, 2);
+	for (int i = 0; i < numEntries; i++) {
+		uint32_t count = 1;
+		m_file.write((const char*) &entries[i].tag, 2);
+		m_file.write((const char*) &entries[i].type, 2);
+		m_file.write((const char*) &count, 4);
+		if (entries[i].type == typeShort) {
+			// Short values are left justified in the 4-byte value field
+			uint16_t value[2] = { (uint16_t) entries[i].value, 0 };
+			m_file.write((const char*) value, 4);
+		}
+		else {
+			m_file.write((const char*) &entries[i].value, 4);
+		}
+	}
+	uint32_t nextDirectoryOffset = 0;
+	m_file.write((const char*) &nextDirectoryOffset, 4);
+}
+
+void RasterFileWriter::writeUInt32BE(uint32_t value)
+{
+	unsigned char bytes[4];
+	for (int i = 0; i < 4; i++) bytes[i] = (value >> (24 - 8 * i)) & 0xFF;
+	m_file.write((const char*) bytes, 4);
+}
+
+uint32_t RasterFileWriter::crc32(uint32_t crc, const unsigned char* data, size_t size)
+{
+	static const std::vector<uint32_t> table = []() {
+		std::vector<uint32_t> t(256);
+		for (uint32_t n = 0; n < 256; n++) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			t[n] = c;
+		}
+		return t;
+	}();
+	for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+uint32_t RasterFileWriter::adler32(uint32_t adler, const unsigned char* data, size_t size)
+{
+	// Sums are reduced every 5552 bytes, the most that can be added without overflow
+	const uint32_t base = 65521;
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+	while (size > 0) {
+		size_t n = std::min(size, (size_t) 5552);
+		size -= n;
+		while (n--) {
+			a += *data++;
+			b += a;
+		}
+		a %= base;
+		b %= base;
+	}
+	return (b << 16) | a;
+}
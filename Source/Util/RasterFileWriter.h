@@ -0,0 +1,78 @@
+//
+// RasterFileWriter.h
+// Streams single-channel rasters to disk one row at a time, so large exports never 
+// need a full image in memory. Writes 8- or 16-bit grayscale PNG (stored deflate 
+// blocks, i.e., uncompressed), 8-bit, 16-bit or 32-bit float grayscale TIFF 
+// (uncompressed, single strip), or headerless raw files in native byte order.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class RasterFileWriter
+{
+public:
+	enum class SampleFormat { UInt8, UInt16, Float32 };
+	enum class Container { PNG, TIFF, Raw, NotSupported };
+
+	RasterFileWriter();
+	~RasterFileWriter();
+
+	// Container is chosen from the filename suffix: .png, .tif/.tiff or .raw
+	static Container containerForFilename(const std::string& filename);
+	static bool isSupported(Container container, SampleFormat format);
+
+	// Running CRC-32 as used by PNG. Start with 0xFFFFFFFF and invert the result.
+	static uint32_t crc32(uint32_t crc, const unsigned char* data, size_t size);
+
+	// Rows are written top to bottom. Each row holds width samples in native byte 
+	// order. close() is called by the destructor but only reports errors if called
+	// explicitly.
+	bool open(const std::string& filename, int width, int height, SampleFormat format);
+	bool writeRow(const void* samples);
+	bool close();
+
+	// Make non-copyable
+	RasterFileWriter(RasterFileWriter const&) = delete;
+	void operator=(RasterFileWriter const&) = delete;
+
+private:
+	std::ofstream m_file;
+	Container m_container;
+	SampleFormat m_format;
+	int m_width;
+	int m_height;
+	int m_numRowsWritten;
+	int m_bytesPerSample;
+	std::vector<unsigned char> m_rowBuffer;
+
+	// PNG state. Image data is a single zlib stream split over one IDAT chunk per row.
+	uint32_t m_adler;
+	void writePNGHeader();
+	void writePNGRow(const void* samples);
+	void writePNGChunk(const char type[4], const unsigned char* data, size_t size);
+	void writePNGEnd();
+
+	void writeTIFFHeader();
+	void writeTIFFDirectory();
+
+	void writeUInt32BE(uint32_t value);
+	static uint32_t adler32(uint32_t adler, const unsigned char* data, size_t size);
+};
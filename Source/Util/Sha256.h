@@ -0,0 +1,42 @@
+//
+// Sha256.h
+// SHA-256 digest (FIPS 180-4) for content addressing, e.g., of images in an image store.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class Sha256
+{
+public:
+	Sha256();
+	~Sha256() {};
+
+	// Data can be added in any number of pieces. hexDigest() finishes the digest and
+	// returns it as 64 lowercase hex characters.
+	void update(const void* data, size_t size);
+	std::string hexDigest();
+	static std::string hexDigest(const void* data, size_t size);
+
+private:
+	uint32_t m_state[8];
+	unsigned char m_block[64];
+	size_t m_blockSize;
+	uint64_t m_numBytes;
+	void processBlock(const unsigned char* block);
+};
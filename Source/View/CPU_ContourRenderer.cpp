@@ -0,0 +1,251 @@
+//
+// CPU_ContourRenderer.cpp
+// Implementation of CPU_ContourRenderer.
+//
+
+#include "CPU_ContourRenderer.h"
+#include "ContourTessellator.h"
+#include "../Util/Parallel.h"
+#include "../Util/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VESCL_CPU_RENDERER_SSE2
+#endif
+
+namespace {
+	// Rows per band. Bands are rasterized in parallel.
+	const int bandHeight = 32;
+}
+
+// 
+// Public
+//
+CPU_ContourRenderer::CPU_ContourRenderer(RendererType type) :
+	m_type(type),
+	m_antialiasingFilterWidth(0.8f),
+	m_centerlineRadius(2),
+	m_width(0),
+	m_height(0)
+{
+}
+CPU_ContourRenderer::~CPU_ContourRenderer()
+{
+}
+
+void CPU_ContourRenderer::update(const std::list<Curve::PointVector>& curvePoints, int width, int height,
+	float contourToPixelScale, float offsetX, float offsetY)
+{
+	VESCL_PROFILE_SCOPE("CPU_ContourRenderer::update", "render");
+	m_width = std::max(0, width);
+	m_height = std::max(0, height);
+	try {
+		m_coverage.assign((size_t)m_width * m_height, 0.0f);
+	}
+	catch (const std::bad_alloc& e) {
+		std::cout << "Memory Allocation " << "failure: " << e.what() << std::endl;
+		m_width = m_height = 0;
+		return;
+	}
+	if (m_width == 0 || m_height == 0 || contourToPixelScale <= 0 || curvePoints.size() == 0) return;
+
+	// Same cell geometry and shader constants as GL_ContourRenderer, in contour units
+	float pixelToContourScale = 1.0f / contourToPixelScale;
+	float filterWidth = m_antialiasingFilterWidth * pixelToContourScale;
+	float centerlineRadius = m_centerlineRadius * pixelToContourScale;
+	float radiusOffset = (m_type == RendererType::Binary) ? 0 : filterWidth;
+	std::vector<float> vertices;
+	int numVertices = 0;
+	try {
+		numVertices = ContourTessellator::tessellate(curvePoints, radiusOffset, vertices);
+	}
+	catch (const std::bad_alloc& e) {
+		std::cout << "Memory Allocation " << "failure: " << e.what() << std::endl;
+		return;
+	}
+
+	// Bin triangles by the bands their bounding boxes overlap. Triangles are set up when
+	// their band is rasterized, so the only per-triangle storage is the bin index.
+	int numBands = (m_height + bandHeight - 1) / bandHeight;
+	std::vector<std::vector<int>> bands(numBands);
+	const int stride = ContourTessellator::numFloatsPerVertex;
+	for (int i = 0; i + 2 < numVertices; i += 3) {
+		const float* v = &vertices[(size_t)i * stride];
+		float minY = contourToPixelScale * std::min(v[1], std::min(v[stride + 1], v[2 * stride + 1])) + offsetY;
+		float maxY = contourToPixelScale * std::max(v[1], std::max(v[stride + 1], v[2 * stride + 1])) + offsetY;
+		int minRow = std::max(0, (int)ceil(minY - 0.5f));
+		int maxRow = std::min(m_height - 1, (int)floor(maxY - 0.5f));
+		for (int band = minRow / bandHeight; minRow <= maxRow && band <= maxRow / bandHeight; band++) {
+			bands[band].push_back(i);
+		}
+	}
+
+	Parallel::forRange(0, numBands, 1, [&](int firstBand, int lastBand) {
+		for (int band = firstBand; band < lastBand; band++) {
+			int firstRow = band * bandHeight;
+			int lastRow = std::min(m_height - 1, firstRow + bandHeight - 1);
+			rasterizeBand(firstRow, lastRow, vertices, bands[band], contourToPixelScale, offsetX, offsetY,
+				filterWidth, centerlineRadius);
+		}
+	});
+}
+
+std::vector<float> CPU_ContourRenderer::takeCoverage()
+{
+	std::vector<float> coverage;
+	coverage.swap(m_coverage);
+	m_width = m_height = 0;
+	return coverage;
+}
+
+// 
+// Private
+//
+bool CPU_ContourRenderer::setupTriangle(const float* vertices, float scale, float offsetX, float offsetY,
+	Triangle* triangle)
+{
+	const int stride = ContourTessellator::numFloatsPerVertex;
+	float x[3];
+	float y[3];
+	float minX = std::numeric_limits<float>::max();
+	float maxX = -std::numeric_limits<float>::max();
+	float minY = minX;
+	float maxY = maxX;
+	for (int i = 0; i < 3; i++) {
+		x[i] = scale * vertices[i * stride] + offsetX;
+		y[i] = scale * vertices[i * stride + 1] + offsetY;
+		minX = std::min(minX, x[i]);
+		maxX = std::max(maxX, x[i]);
+		minY = std::min(minY, y[i]);
+		maxY = std::max(maxY, y[i]);
+	}
+
+	// Pixel centers are at half-integer coordinates
+	triangle->minRow = std::max(0, (int)ceil(minY - 0.5f));
+	triangle->maxRow = std::min(m_height - 1, (int)floor(maxY - 0.5f));
+	if (triangle->minRow > triangle->maxRow || maxX < 0.5f || minX > m_width - 0.5f) return false;
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (fabs(area) <= std::numeric_limits<float>::epsilon()) return false;
+
+	// Edge i is opposite vertex i. Its equation, scaled by the area, is the barycentric 
+	// coordinate of vertex i, so the data planes are weighted sums of the edge equations.
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+		triangle->edge[i][0] = (y[j] - y[k]) / area;
+		triangle->edge[i][1] = (x[k] - x[j]) / area;
+		triangle->edge[i][2] = (x[j] * y[k] - x[k] * y[j]) / area;
+	}
+	for (int d = 0; d < 3; d++) {
+		for (int c = 0; c < 3; c++) {
+			triangle->data[d][c] = 0;
+			for (int i = 0; i < 3; i++) {
+				triangle->data[d][c] += triangle->edge[i][c] * vertices[i * stride + 2 + d];
+			}
+		}
+	}
+	return true;
+}
+
+void CPU_ContourRenderer::rasterizeBand(int firstRow, int lastRow, const std::vector<float>& vertices,
+	const std::vector<int>& triangles, float scale, float offsetX, float offsetY, float filterWidth,
+	float centerlineRadius)
+{
+	float invFilterWidth = 1.0f / filterWidth;
+	for (std::vector<int>::const_iterator it = triangles.begin(); it != triangles.end(); it++) {
+		Triangle triangle;
+		const float* triangleVertices = &vertices[(size_t)(*it) * ContourTessellator::numFloatsPerVertex];
+		if (!setupTriangle(triangleVertices, scale, offsetX, offsetY, &triangle)) continue;
+		int rowBegin = std::max(firstRow, triangle.minRow);
+		int rowEnd = std::min(lastRow, triangle.maxRow);
+		for (int row = rowBegin; row <= rowEnd; row++) {
+			// Find the span of pixel centers where all barycentric coordinates are 
+			// non-negative. Pixels on shared edges may be covered twice, which is harmless
+			// because coverage is combined with max.
+			float y = row + 0.5f;
+			float xMin = 0.5f;
+			float xMax = m_width - 0.5f;
+			bool isEmpty = false;
+			for (int i = 0; i < 3 && !isEmpty; i++) {
+				float a = triangle.edge[i][0];
+				float rowValue = triangle.edge[i][1] * y + triangle.edge[i][2];
+				if (a > 0) xMin = std::max(xMin, -rowValue / a);
+				else if (a < 0) xMax = std::min(xMax, -rowValue / a);
+				else isEmpty = (rowValue < 0);
+			}
+			if (isEmpty) continue;
+			int x0 = std::max(0, (int)ceil(xMin - 0.5f));
+			int x1 = std::min(m_width - 1, (int)floor(xMax - 0.5f));
+			if (x0 > x1) continue;
+			fillSpan(&m_coverage[(size_t)row * m_width], x0, x1, y, triangle, invFilterWidth, centerlineRadius);
+		}
+	}
+}
+
+void CPU_ContourRenderer::fillSpan(float* coverage, int x0, int x1, float y, const Triangle& triangle,
+	float invFilterWidth, float centerlineRadius)
+{
+	// Data is linear along the span. Centerline strokes have a constant radius.
+	float aDx = triangle.data[0][0];
+	float cDx = triangle.data[0][1] * y + triangle.data[0][2];
+	float aDy = triangle.data[1][0];
+	float cDy = triangle.data[1][1] * y + triangle.data[1][2];
+	float aR = triangle.data[2][0];
+	float cR = triangle.data[2][1] * y + triangle.data[2][2];
+	if (m_type == RendererType::Centerline) {
+		aR = 0;
+		cR = centerlineRadius;
+	}
+	bool isBinary = (m_type == RendererType::Binary);
+
+	int x = x0;
+#ifdef VESCL_CPU_RENDERER_SSE2
+	// Four pixels at a time
+	const __m128 pixelCenters = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 invWidth = _mm_set1_ps(invFilterWidth);
+	const __m128 aDx4 = _mm_set1_ps(aDx), cDx4 = _mm_set1_ps(cDx);
+	const __m128 aDy4 = _mm_set1_ps(aDy), cDy4 = _mm_set1_ps(cDy);
+	const __m128 aR4 = _mm_set1_ps(aR), cR4 = _mm_set1_ps(cR);
+	for (; x + 3 <= x1; x += 4) {
+		__m128 xc = _mm_add_ps(_mm_set1_ps((float)x), pixelCenters);
+		__m128 dx = _mm_add_ps(_mm_mul_ps(aDx4, xc), cDx4);
+		__m128 dy = _mm_add_ps(_mm_mul_ps(aDy4, xc), cDy4);
+		__m128 r = _mm_add_ps(_mm_mul_ps(aR4, xc), cR4);
+		__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+		__m128 distToEdge = _mm_sub_ps(r, len);
+		__m128 value;
+		if (isBinary) {
+			value = _mm_and_ps(_mm_cmpge_ps(distToEdge, zero), one);
+		}
+		else {
+			value = _mm_add_ps(half, _mm_mul_ps(distToEdge, invWidth));
+			value = _mm_min_ps(one, _mm_max_ps(zero, value));
+		}
+		_mm_storeu_ps(coverage + x, _mm_max_ps(_mm_loadu_ps(coverage + x), value));
+	}
+#endif
+	for (; x <= x1; x++) {
+		float xc = x + 0.5f;
+		float dx = aDx * xc + cDx;
+		float dy = aDy * xc + cDy;
+		float r = aR * xc + cR;
+		float distToEdge = r - sqrt(dx * dx + dy * dy);
+		float value;
+		if (isBinary) {
+			value = (distToEdge >= 0) ? 1.0f : 0.0f;
+		}
+		else {
+			value = std::min(1.0f, std::max(0.0f, 0.5f + distToEdge * invFilterWidth));
+		}
+		coverage[x] = std::max(coverage[x], value);
+	}
+}
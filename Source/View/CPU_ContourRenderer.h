@@ -0,0 +1,74 @@
+//
+// CPU_ContourRenderer.h
+// Renders a contour into a coverage raster without OpenGL, e.g., for exports on servers
+// without a GPU or display. Rasterizes the same cells as GL_ContourRenderer and evaluates
+// the same per-pixel coverage as its shaders, so results match to within rounding.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "../Model/Curve.h"
+
+#include <list>
+#include <vector>
+
+class CPU_ContourRenderer
+{
+public:
+	enum class RendererType { Antialiased, Centerline, Binary };
+
+	CPU_ContourRenderer(RendererType type);
+	~CPU_ContourRenderer();
+
+	// Contour points map to pixels as contourToPixelScale * (x, y) + (offsetX, offsetY), 
+	// with pixel (0, 0) at the top left corner. Coverage is in [0, 1].
+	void update(const std::list<Curve::PointVector>& curvePoints, int width, int height,
+		float contourToPixelScale, float offsetX, float offsetY);
+	RendererType type() const { return m_type; };
+	int width() const { return m_width; };
+	int height() const { return m_height; };
+	const float* row(int y) const { return &m_coverage[(size_t)y * m_width]; };
+	const std::vector<float>& coverage() const { return m_coverage; };
+
+	// Moves the coverage out of the renderer, e.g., to avoid copying large exports
+	std::vector<float> takeCoverage();
+
+private:
+	RendererType m_type;
+
+	// Same defaults as GL_ContourRenderer, in pixels
+	float m_antialiasingFilterWidth;
+	float m_centerlineRadius;
+
+	int m_width;
+	int m_height;
+	std::vector<float> m_coverage;
+
+	// Triangle barycentric coordinates and interpolated data, (dx, dy, r), stored as plane
+	// equations a * x + b * y + c over the pixel grid
+	typedef struct {
+		float edge[3][3];
+		float data[3][3];
+		int minRow;
+		int maxRow;
+	} Triangle;
+	bool setupTriangle(const float* vertices, float scale, float offsetX, float offsetY, Triangle* triangle);
+	void rasterizeBand(int firstRow, int lastRow, const std::vector<float>& vertices, 
+		const std::vector<int>& triangles, float scale, float offsetX, float offsetY, float filterWidth,
+		float centerlineRadius);
+	void fillSpan(float* coverage, int x0, int x1, float y, const Triangle& triangle, float invFilterWidth,
+		float centerlineRadius);
+};
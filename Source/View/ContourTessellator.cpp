@@ -0,0 +1,92 @@
+//
+// ContourTessellator.cpp
+// Implementation of ContourTessellator.
+//
+
+#include "ContourTessellator.h"
+#include "../Model/CurvePoint.h"
+
+#include <cmath>
+#include <limits>
+
+// 
+// Public
+//
+int ContourTessellator::tessellate(const std::list<Curve::PointVector>& curvePoints, float radiusOffset,
+	std::vector<float>& vertices, std::vector<float>* labels)
+{
+	// Get the number of curve points for buffer allocation
+	int numPoints = 0;
+	for (std::list<Curve::PointVector>::const_iterator it = curvePoints.begin(); it != curvePoints.end(); it++) {
+		numPoints += it->size();
+	}
+	int numFloatsPerCell = numFloatsPerVertex * numVerticesPerCell;
+	int maxNumCells = 2 * numPoints;
+	vertices.resize((size_t)maxNumCells * numFloatsPerCell);
+
+	// Compute cell vertices
+	float* pV = vertices.data();
+	int numCells = 0;
+	int curveLabel = 0;
+	if (labels) labels->clear();
+
+	for (std::list<Curve::PointVector>::const_iterator it = curvePoints.begin(); it != curvePoints.end(); it++) {
+		curveLabel++;
+		if (it->size() < 1) continue;
+		int firstCell = numCells;
+
+		// Create the line cells. Line cells enclose the stroke between each pair of points. 
+		Curve::PointVector::const_iterator itPoint = (*it).begin();
+		float x0 = itPoint->pos()[0];
+		float y0 = itPoint->pos()[1];
+		float r0 = itPoint->radius();
+		for (++itPoint; itPoint != (*it).end(); ++itPoint) {
+			float x1 = itPoint->pos()[0];
+			float y1 = itPoint->pos()[1];
+			float r1 = itPoint->radius();
+			float dir[2] = { x1 - x0, y1 - y0 };
+			float len = dir[0] * dir[0] + dir[1] * dir[1];
+			if (len <= std::numeric_limits<float>::epsilon()) continue;
+			len = sqrt(len);
+			float perpDir[2] = { -dir[1] / len, dir[0] / len };
+			float x[6] = { x0, x1, x1, x0, x1, x0 };
+			float y[6] = { y0, y1, y1, y0, y1, y0 };
+			float r[6] = { r0, r1, r1, r0, r1, r0 };
+			float dX[6] = { -perpDir[0], -perpDir[0], perpDir[0], -perpDir[0], perpDir[0], perpDir[0] };
+			float dY[6] = { -perpDir[1], -perpDir[1], perpDir[1], -perpDir[1], perpDir[1], perpDir[1] };
+			for (int idx = 0; idx < 6; idx++) {
+				*pV++ = x[idx] + dX[idx] * (r[idx] + radiusOffset);	// Vertex x-component
+				*pV++ = y[idx] + dY[idx] * (r[idx] + radiusOffset);	// Vertex y-component
+				*pV++ = -dX[idx] * (r[idx] + radiusOffset);			// dx to curve centerline
+				*pV++ = -dY[idx] * (r[idx] + radiusOffset);			// dy to curve centerline
+				*pV++ = r[idx];										// Curve radius
+			}
+			numCells++;
+			x0 = x1;
+			y0 = y1;
+			r0 = r1;
+		}
+
+		// Create point cells. Point cells are axis aligned squares that enclose each point.
+		for (Curve::PointVector::const_iterator itPoint = (*it).begin(); itPoint != (*it).end(); ++itPoint) {
+			float x = itPoint->pos()[0];
+			float y = itPoint->pos()[1];
+			float r = itPoint->radius();
+			float dX[6] = { -1, 1, 1, -1, 1, -1 };
+			float dY[6] = { -1, -1, 1, -1, 1, 1 };
+			for (int idx = 0; idx < 6; idx++) {
+				*pV++ = x + dX[idx] * (r + radiusOffset);	// Vertex x-component
+				*pV++ = y + dY[idx] * (r + radiusOffset);	// Vertex y-component
+				*pV++ = -dX[idx] * (r + radiusOffset);		// dx to point
+				*pV++ = -dY[idx] * (r + radiusOffset);		// dy to point
+				*pV++ = r;									// Curve radius
+			}
+			numCells++;
+		}
+		if (labels) labels->insert(labels->end(), (size_t)(numCells - firstCell) * numVerticesPerCell, (float)curveLabel);
+	}
+
+	int numVertices = numCells * numVerticesPerCell;
+	vertices.resize((size_t)numVertices * numFloatsPerVertex);
+	return numVertices;
+}
@@ -0,0 +1,45 @@
+//
+// ContourTessellator.h
+// Builds the cells that cover contour strokes. Shared by the OpenGL and CPU contour 
+// renderers so that both rasterize the same geometry.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "../Model/Curve.h"
+
+#include <list>
+#include <vector>
+
+class ContourTessellator
+{
+public:
+	// Each vertex has 5 components, (x, y, dx, dy, r), where (x, y) is the position of the 
+	// vertex, (dx, dy) is the vector distance from the vertex to the stroke centerline and 
+	// r is the stroke radius. Points and vertices are specified in contour coordinates. A 
+	// curve is covered by a set of line and corner cells. Corner cells are constructed at
+	// each point along the curve. Line cells are constructed between each pair of points
+	// along the curve. Line and corner cells each have 2 triangles and 6 vertices. Cells 
+	// extend radiusOffset beyond the stroke edge.
+	static const int numFloatsPerVertex = 5;
+	static const int numVerticesPerCell = 6;
+
+	// Replaces the contents of vertices and returns the number of vertices. If labels is
+	// given, it is replaced with one label per vertex, i.e., the position of the vertex's
+	// curve in curvePoints plus one.
+	static int tessellate(const std::list<Curve::PointVector>& curvePoints, float radiusOffset,
+		std::vector<float>& vertices, std::vector<float>* labels = nullptr);
+};
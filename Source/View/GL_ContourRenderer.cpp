@@ -1,325 +1,421 @@
-//
-// GL_ContourRenderer.cpp
-// Implementation of GL_ContourRenderer.
-//
-
-#include "GL_ContourRenderer.h"
-#include "../Model/Contour.h"
-#include "../Model/Curve.h"
-#include "../Model/CurvePoint.h"
-
-#include <QOpenGLFramebufferObject>
-#include <QOpenGLTexture>
-#include <QOpenGLShaderProgram>
-
-#include <limits>
-#include <assert.h>
-
-// 
-// Public
-//
-GL_ContourRenderer::GL_ContourRenderer(RendererType type) :
-	m_type(type),
-	m_antialiasingFilterWidth(0.8),
-	m_centerlineRadius(2),
-	m_maxDistFieldDistance(10),
-	m_fboWidth(0),
-	m_fboHeight(0),
-	m_numVertices(0),
-	m_fbo(nullptr),
-	m_shaderProgram(nullptr)
-{
-	const char* vertexShader;
-	const char* fragmentShader;
-	switch (m_type) {
-	case RendererType::Centerline:
-		vertexShader = vertexShader_contourCenterline;
-		fragmentShader = fragmentShader_contourCenterline;
-		break;
-	case RendererType::Binary:
-		vertexShader = vertexShader_binaryContour;
-		fragmentShader = fragmentShader_binaryContour;
-		break;
-	case RendererType::DistToContour:
-		vertexShader = vertexShader_distToContour;
-		fragmentShader = fragmentShader_distToContour;
-		break;
-	case RendererType::DistToCenterline:
-		vertexShader = vertexShader_distToCenterline;
-		fragmentShader = fragmentShader_distToCenterline;
-		break;
-	case RendererType::Antialiased:
-	case RendererType::Default:
-	default:
-		vertexShader = vertexShader_antialiasedContour;
-		fragmentShader = fragmentShader_antialiasedContour;
-		break;
-	}
-
-	// Set up the shader programs
-	try {
-		m_shaderProgram = new QOpenGLShaderProgram;
-		if (!m_shaderProgram) {
-			throw std::runtime_error("Can't create GL shader program.");
-		}
-		m_shaderProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader);
-		m_shaderProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader);
-		if (!m_shaderProgram->link()) {
-			throw std::runtime_error("GL shader program failed to link.");
-		}
-	}
-	catch (const std::exception& e) {
-		std::cout << "Exception " << e.what() << std::endl;
-		delete m_shaderProgram;
-		m_shaderProgram = nullptr;
-		return;
-	}
-
-	// Set up OpenGL
-	initializeOpenGLFunctions();
-}
-GL_ContourRenderer::~GL_ContourRenderer()
-{
-	m_vertexBuffer.destroy();
-	delete m_shaderProgram;
-	delete m_fbo;
-}
-
-// Get the texture ID of the fbo's color buffer. Return's false if the fbo is invalid.
-bool GL_ContourRenderer::textureID(GLuint* textureID)
-{
-	if (m_fbo) {
-		*textureID = m_fbo->texture();
-		return true;
-	}
-	return false;
-}
-QImage GL_ContourRenderer::renderedImage()
-{
-	return(m_fbo->toImage(true));
-}
-
-// Updates the fbo's color buffer 
-void GL_ContourRenderer::update(std::list<Curve::PointVector> curvePoints, QColor contourColor,
-	int winWidth, int winHeight, QMatrix4x4 mvpMatrix, float windowToContourScale)
-{
-	// Update the FBO if the requested size has changed
-	if (winWidth != m_fboWidth || winHeight != m_fboHeight) {
-		delete m_fbo;
-		m_fboWidth = winWidth;
-		m_fboHeight = winHeight;
-		m_fbo = new QOpenGLFramebufferObject(m_fboWidth, m_fboHeight, GL_TEXTURE_2D);
-	}
-
-	m_fbo->bind();
-	glClearColor(0, 0, 0, 0);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-
-	// Check for required data
-	if (!m_shaderProgram) return;
-
-	// Create the contour geometry
-	setVertexBuffer(curvePoints, windowToContourScale);
-	if (m_numVertices == 0) return;
-
-	// Set the model view projection matrix
-	m_shaderProgram->bind();
-	int mvpLocation = m_shaderProgram->uniformLocation("u_mvpMatrix");
-	assert(mvpLocation != -1);
-	m_shaderProgram->setUniformValue(mvpLocation, mvpMatrix);
-
-	// Set shader-specific data
-	setShaderData(contourColor, windowToContourScale);
-
-	// Tell OpenGL programmable pipeline how to locate the vertex data
-	m_vertexBuffer.bind();
-	quintptr offset = 0;
-	int numFloatsPerPos = 2;
-	int numFloatsPerData = 3;
-	int stride = (numFloatsPerPos + numFloatsPerData) * sizeof(float);
-
-	int posLocation = m_shaderProgram->attributeLocation("a_position");
-	assert(posLocation != -1);
-	m_shaderProgram->enableAttributeArray(posLocation);
-	m_shaderProgram->setAttributeBuffer(posLocation, GL_FLOAT, offset, numFloatsPerPos, stride);
-
-	offset += numFloatsPerPos * sizeof(float);
-	int dataLocation = m_shaderProgram->attributeLocation("a_data");
-	assert(dataLocation != -1);
-	m_shaderProgram->enableAttributeArray(dataLocation);
-	m_shaderProgram->setAttributeBuffer(dataLocation, GL_FLOAT, offset, numFloatsPerData, stride);
-
-	// Perform the rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_DST_ALPHA, GL_SRC_ALPHA);
-	glBlendEquation(GL_MAX);
-	glDrawArrays(GL_TRIANGLES, 0, m_numVertices);
-	glDisable(GL_BLEND);
-	m_vertexBuffer.release();
-	m_shaderProgram->release();
-	m_fbo->release();
-}
-
-// 
-// Private
-//
-void GL_ContourRenderer::setShaderData(QColor contourColor, float windowToContourScale) {
-	float filterWidth = m_antialiasingFilterWidth * windowToContourScale;
-	switch (m_type) {
-	case RendererType::Centerline:
-	{
-		m_shaderProgram->setUniformValue("u_color", contourColor);
-		m_shaderProgram->setUniformValue("u_filterWidth", filterWidth);
-		float centerlineRadius = m_centerlineRadius * windowToContourScale;
-		m_shaderProgram->setUniformValue("u_radius", centerlineRadius);
-		break;
-	}
-	case RendererType::Binary:
-	{
-		m_shaderProgram->setUniformValue("u_color", contourColor);
-		break;
-	}
-	case RendererType::DistToContour:
-	case RendererType::DistToCenterline:
-	{
-		m_shaderProgram->setUniformValue("u_color", contourColor);
-		m_shaderProgram->setUniformValue("u_maxDist", m_maxDistFieldDistance);
-		break;
-	}
-	case RendererType::Antialiased:
-	case RendererType::Default:
-	default:
-	{
-		m_shaderProgram->setUniformValue("u_color", contourColor);
-		m_shaderProgram->setUniformValue("u_filterWidth", filterWidth);
-		break;
-	}
-	}
-}
-void GL_ContourRenderer::setVertexBuffer(std::list<Curve::PointVector> curvePoints, 
-	float windowToContourScale)
-{
-	// Make sure there is something to render
-	m_numVertices = 0;
-	if (curvePoints.size() == 0) return;
-
-	// Determine render type dependent constants
-	float radiusOffset = 0;
-	switch (m_type) {
-	case RendererType::Binary:
-	{
-		break;
-	}
-	case RendererType::DistToContour:
-	case RendererType::DistToCenterline:
-	{
-		radiusOffset += m_maxDistFieldDistance;
-		break;
-	}
-	case RendererType::Antialiased:
-	case RendererType::Centerline:
-	case RendererType::Default:
-	default:
-	{
-		float filterWidth = m_antialiasingFilterWidth * windowToContourScale;
-		radiusOffset += filterWidth;
-		break;
-	}
-	}
-
-	// Get the number of curve points for buffer allocation
-	int numPoints = 0;
-	for (std::list<Curve::PointVector>::iterator it = curvePoints.begin(); it != curvePoints.end(); it++) {
-		numPoints += it->size();
-	}
-
-	// Allocate space for cell vertices. Each vertex has 5 components, (x, y, dx, dy, r), 
-	// where (x, y) is the position of the vertex, (dx, dy) is the vector distance from 
-	// the vertex to the stroke boundary and r is the stroke radius. Points and vertices 
-	// are specified in contour coordinates. Vertex data is packed into a contiguous array. 
-	// A curve is rendered as a set of line and corner cells. Corner cells are constructed
-	// at each point along the curve. Line cells are constructed between each pair of 
-	// points along the curve. Line and corner cells each have 2 triangles and 6 vertices.
-	int numFloatsPerVertex = 5;
-	int numVerticesPerCell = 6;
-	int numFloatsPerCell = numFloatsPerVertex * numVerticesPerCell;
-	int maxNumCells = 2 * numPoints;
-	GLfloat* vertices = nullptr;
-	try {
-		vertices = new GLfloat[(double)maxNumCells * numFloatsPerCell];
-	}
-	catch (const std::bad_alloc& e) {
-		std::cout << "Memory Allocation " << "failure: " << e.what() << std::endl;
-		return;
-	}
-
-	// Compute cell vertices
-	GLfloat* pV = vertices;
-	int numCells = 0;
-
-	for (std::list<Curve::PointVector>::iterator it = curvePoints.begin(); it != curvePoints.end(); it++) {
-		if (it->size() < 1) continue;
-
-		// Create the line cells. Line cells enclose the stroke between each pair of points. 
-		Curve::PointVector::iterator itPoint = (*it).begin();
-		float x0 = itPoint->pos()[0];
-		float y0 = itPoint->pos()[1];
-		float r0 = itPoint->radius();
-		for (++itPoint; itPoint != (*it).end(); ++itPoint) {
-			float x1 = itPoint->pos()[0];
-			float y1 = itPoint->pos()[1];
-			float r1 = itPoint->radius();
-			float dir[2] = { x1 - x0, y1 - y0 };
-			float len = dir[0] * dir[0] + dir[1] * dir[1];
-			if (len <= std::numeric_limits<float>::epsilon()) continue;
-			len = sqrt(len);
-			float perpDir[2] = { -dir[1] / len, dir[0] / len };
-			float x[6] = { x0, x1, x1, x0, x1, x0 };
-			float y[6] = { y0, y1, y1, y0, y1, y0 };
-			float r[6] = { r0, r1, r1, r0, r1, r0 };
-			float dX[6] = { -perpDir[0], -perpDir[0], perpDir[0], -perpDir[0], perpDir[0], perpDir[0] };
-			float dY[6] = { -perpDir[1], -perpDir[1], perpDir[1], -perpDir[1], perpDir[1], perpDir[1] };
-			for (int idx = 0; idx < 6; idx++) {
-				*pV++ = x[idx] + dX[idx] * (r[idx] + radiusOffset);	// Vertex x-component
-				*pV++ = y[idx] + dY[idx] * (r[idx] + radiusOffset);	// Vertex y-component
-				*pV++ = -dX[idx] * (r[idx] + radiusOffset);			// dx to curve centerline
-				*pV++ = -dY[idx] * (r[idx] + radiusOffset);			// dy to curve centerline
-				*pV++ = r[idx];										// Curve radius
-			}
-			numCells++;
-			x0 = x1;
-			y0 = y1;
-			r0 = r1;
-		}
-
-		// Create point cells. Point cells are axis aligned squares that enclose each point.
-		for (Curve::PointVector::iterator itPoint = (*it).begin(); itPoint != (*it).end(); ++itPoint) {
-			float x = itPoint->pos()[0];
-			float y = itPoint->pos()[1];
-			float r = itPoint->radius();
-			float dX[6] = { -1, 1, 1, -1, 1, -1 };
-			float dY[6] = { -1, -1, 1, -1, 1, 1 };
-			for (int idx = 0; idx < 6; idx++) {
-				*pV++ = x + dX[idx] * (r + radiusOffset);	// Vertex x-component
-				*pV++ = y + dY[idx] * (r + radiusOffset);	// Vertex y-component
-				*pV++ = -dX[idx] * (r + radiusOffset);		// dx to point
-				*pV++ = -dY[idx] * (r + radiusOffset);		// dy to point
-				*pV++ = r;									// Curve radius
-			}
-			numCells++;
-		}
-	}
-
-	// Create the vertex buffer
-	int numStrokeVertices = numCells * numVerticesPerCell;
-	int sizeVertices = sizeof(GLfloat) * numFloatsPerVertex * numStrokeVertices;
-	if (!m_vertexBuffer.isCreated()) {
-		m_vertexBuffer.create();
-	}
-	m_vertexBuffer.bind();
-	m_vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-	m_vertexBuffer.allocate(vertices, sizeVertices);
-	m_vertexBuffer.release();
-	delete[] vertices;
-	m_numVertices = numStrokeVertices;
-}
+//
+// GL_ContourRenderer.cpp
+// Implementation of GL_ContourRenderer.
+//
+
+#include "GL_ContourRenderer.h"
+#include "GL_ResourceManager.h"
+#include "ContourTessellator.h"
+#include "../Model/Contour.h"
+#include "../Model/Curve.h"
+#include "../Model/CurvePoint.h"
+#include "../Util/Profiler.h"
+
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTexture>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLExtraFunctions>
+
+#include <algorithm>
+#include <limits>
+#include <assert.h>
+
+// Sized single-channel formats are core in OpenGL 3.0 but may be missing from older headers
+#ifndef GL_R16
+#define GL_R16 0x822A
+#endif
+#ifndef GL_R32F
+#define GL_R32F 0x822E
+#endif
+#ifndef GL_MAX_DRAW_BUFFERS
+#define GL_MAX_DRAW_BUFFERS 0x8824
+#endif
+#ifndef GL_MAX_COLOR_ATTACHMENTS
+#define GL_MAX_COLOR_ATTACHMENTS 0x8CDF
+#endif
+
+// 
+// Public
+//
+GL_ContourRenderer::GL_ContourRenderer(RendererType type, TargetFormat format) :
+	m_type(type),
+	m_targetFormat(format),
+	m_antialiasingFilterWidth(0.8),
+	m_centerlineRadius(2),
+	m_maxDistFieldDistance(10),
+	m_fboWidth(0),
+	m_fboHeight(0),
+	m_numVertices(0),
+	m_fbo(nullptr),
+	m_shaderProgram(nullptr),
+	m_mvpLocation(-1),
+	m_posLocation(-1),
+	m_dataLocation(-1),
+	m_colorLocation(-1),
+	m_filterWidthLocation(-1),
+	m_radiusLocation(-1),
+	m_maxDistLocation(-1),
+	m_labelLocation(-1),
+	m_maxRadius(0)
+{
+	const char* vertexShader;
+	const char* fragmentShader;
+	bool isSingleChannel = (m_targetFormat != TargetFormat::RGBA8);
+	bool isUnnormalized = (m_targetFormat == TargetFormat::R32F);
+	switch (m_type) {
+	case RendererType::Centerline:
+		vertexShader = vertexShader_contourCenterline;
+		fragmentShader = isSingleChannel ? fragmentShader_centerlineCoverage : 
+			fragmentShader_contourCenterline;
+		break;
+	case RendererType::Binary:
+		vertexShader = vertexShader_binaryContour;
+		fragmentShader = isSingleChannel ? fragmentShader_binaryMask : fragmentShader_binaryContour;
+		break;
+	case RendererType::DistToContour:
+		vertexShader = vertexShader_distToContour;
+		fragmentShader = isUnnormalized ? fragmentShader_signedDistToContour : 
+			isSingleChannel ? fragmentShader_normalizedDistToContour : fragmentShader_distToContour;
+		break;
+	case RendererType::DistToCenterline:
+		vertexShader = vertexShader_distToCenterline;
+		fragmentShader = isUnnormalized ? fragmentShader_unsignedDistToCenterline :
+			isSingleChannel ? fragmentShader_normalizedDistToCenterline : fragmentShader_distToCenterline;
+		break;
+	case RendererType::Labels:
+		assert(isUnnormalized);
+		vertexShader = vertexShader_labels;
+		fragmentShader = fragmentShader_labels;
+		break;
+	case RendererType::Products:
+		assert(isSingleChannel);
+		vertexShader = vertexShader_distToContour;
+		fragmentShader = isUnnormalized ? fragmentShader_unnormalizedProducts : 
+			fragmentShader_normalizedProducts;
+		break;
+	case RendererType::Antialiased:
+	case RendererType::Default:
+	default:
+		vertexShader = vertexShader_antialiasedContour;
+		fragmentShader = isSingleChannel ? fragmentShader_antialiasedCoverage : 
+			fragmentShader_antialiasedContour;
+		break;
+	}
+
+	// Set up OpenGL
+	initializeOpenGLFunctions();
+
+	// Get the shader program and its variable locations from the shared resources. 
+	// Uniforms that are not used by this type's shaders have location -1.
+	GL_ResourceManager* resources = GL_ResourceManager::instance();
+	if (!resources) return;
+	m_shaderProgram = resources->program(vertexShader, fragmentShader);
+	if (!m_shaderProgram) return;
+	m_mvpLocation = resources->uniformLocation(m_shaderProgram, "u_mvpMatrix");
+	m_posLocation = resources->attributeLocation(m_shaderProgram, "a_position");
+	m_dataLocation = resources->attributeLocation(m_shaderProgram, "a_data");
+	m_colorLocation = resources->uniformLocation(m_shaderProgram, "u_color");
+	m_filterWidthLocation = resources->uniformLocation(m_shaderProgram, "u_filterWidth");
+	m_radiusLocation = resources->uniformLocation(m_shaderProgram, "u_radius");
+	m_maxDistLocation = resources->uniformLocation(m_shaderProgram, "u_maxDist");
+	m_labelLocation = resources->attributeLocation(m_shaderProgram, "a_label");
+	assert(m_mvpLocation != -1);
+	assert(m_posLocation != -1);
+	assert(m_dataLocation != -1);
+}
+GL_ContourRenderer::~GL_ContourRenderer()
+{
+	// The shader program is owned by the resource manager
+	m_vertexBuffer.destroy();
+	m_labelBuffer.destroy();
+	delete m_fbo;
+}
+
+bool GL_ContourRenderer::isProductsSupported()
+{
+	QOpenGLContext* context = QOpenGLContext::currentContext();
+	if (!context) return false;
+	GLint maxDrawBuffers = 0;
+	GLint maxColorAttachments = 0;
+	context->functions()->glGetIntegerv(GL_MAX_DRAW_BUFFERS, &maxDrawBuffers);
+	context->functions()->glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &maxColorAttachments);
+	return (maxDrawBuffers >= numProductTargets && maxColorAttachments >= numProductTargets);
+}
+
+// Get the texture ID of the fbo's color buffer. Return's false if the fbo is invalid.
+bool GL_ContourRenderer::textureID(GLuint* textureID)
+{
+	if (m_fbo) {
+		*textureID = m_fbo->texture();
+		return true;
+	}
+	return false;
+}
+QImage GL_ContourRenderer::renderedImage()
+{
+	if (!m_fbo || m_targetFormat != TargetFormat::RGBA8) return QImage();
+	return(m_fbo->toImage(true));
+}
+
+// Updates the fbo's color buffer 
+void GL_ContourRenderer::update(const std::list<Curve::PointVector>& curvePoints, QColor contourColor,
+	int winWidth, int winHeight, QMatrix4x4 mvpMatrix, float windowToContourScale)
+{
+	VESCL_PROFILE_SCOPE("GL_ContourRenderer::update", "render");
+	setGeometry(curvePoints, windowToContourScale);
+	render(contourColor, winWidth, winHeight, mvpMatrix, windowToContourScale);
+}
+void GL_ContourRenderer::setGeometry(const std::list<Curve::PointVector>& curvePoints, 
+	float windowToContourScale)
+{
+	// Create the contour geometry
+	if (!m_shaderProgram) return;
+	setVertexBuffer(curvePoints, windowToContourScale);
+}
+void GL_ContourRenderer::render(QColor contourColor, int winWidth, int winHeight, 
+	QMatrix4x4 mvpMatrix, float windowToContourScale)
+{
+	// Update the FBO if the requested size has changed
+	if (winWidth != m_fboWidth || winHeight != m_fboHeight) {
+		delete m_fbo;
+		m_fboWidth = winWidth;
+		m_fboHeight = winHeight;
+		if (m_targetFormat == TargetFormat::RGBA8) {
+			m_fbo = new QOpenGLFramebufferObject(m_fboWidth, m_fboHeight, GL_TEXTURE_2D);
+		}
+		else {
+			QOpenGLFramebufferObjectFormat format;
+			format.setTextureTarget(GL_TEXTURE_2D);
+			format.setInternalTextureFormat(m_targetFormat == TargetFormat::R16 ? GL_R16 : GL_R32F);
+			if (m_type == RendererType::Labels) format.setAttachment(QOpenGLFramebufferObject::Depth);
+			m_fbo = new QOpenGLFramebufferObject(m_fboWidth, m_fboHeight, format);
+			if (m_type == RendererType::Products) {
+				for (int i = 1; i < numProductTargets; i++) {
+					m_fbo->addColorAttachment(m_fboWidth, m_fboHeight, format.internalTextureFormat());
+				}
+			}
+		}
+		if (!m_fbo->isValid()) {
+			std::cout << "Exception " << "Can't create contour render target." << std::endl;
+		}
+	}
+
+	// Unnormalized distances are cleared to the far value of the distance field
+	m_fbo->bind();
+	float clearValue = 0;
+	if (m_targetFormat == TargetFormat::R32F) {
+		if (m_type == RendererType::DistToContour) clearValue = -m_maxDistFieldDistance;
+		else if (m_type == RendererType::DistToCenterline) clearValue = m_maxDistFieldDistance;
+	}
+	if (m_type == RendererType::Products) {
+		clearProductTargets();
+	}
+	else {
+		glClearColor(clearValue, clearValue, clearValue, clearValue);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	}
+
+	// Check for required data
+	if (!m_shaderProgram || m_numVertices == 0) {
+		m_fbo->release();
+		return;
+	}
+
+	// Set the model view projection matrix
+	m_shaderProgram->bind();
+	m_shaderProgram->setUniformValue(m_mvpLocation, mvpMatrix);
+
+	// Set shader-specific data
+	setShaderData(contourColor, windowToContourScale);
+
+	// Tell OpenGL programmable pipeline how to locate the vertex data
+	m_vertexBuffer.bind();
+	quintptr offset = 0;
+	int numFloatsPerPos = 2;
+	int numFloatsPerData = 3;
+	int stride = (numFloatsPerPos + numFloatsPerData) * sizeof(float);
+
+	m_shaderProgram->enableAttributeArray(m_posLocation);
+	m_shaderProgram->setAttributeBuffer(m_posLocation, GL_FLOAT, offset, numFloatsPerPos, stride);
+
+	offset += numFloatsPerPos * sizeof(float);
+	m_shaderProgram->enableAttributeArray(m_dataLocation);
+	m_shaderProgram->setAttributeBuffer(m_dataLocation, GL_FLOAT, offset, numFloatsPerData, stride);
+
+	// Labels are per vertex in a separate buffer
+	if (m_type == RendererType::Labels) {
+		m_labelBuffer.bind();
+		m_shaderProgram->enableAttributeArray(m_labelLocation);
+		m_shaderProgram->setAttributeBuffer(m_labelLocation, GL_FLOAT, 0, 1, sizeof(float));
+		m_labelBuffer.release();
+	}
+
+	// Perform the rendering. Labels are not blended but kept for the nearest centerline.
+	if (m_type == RendererType::Labels) {
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+		glDrawArrays(GL_TRIANGLES, 0, m_numVertices);
+		glDisable(GL_DEPTH_TEST);
+		m_shaderProgram->disableAttributeArray(m_labelLocation);
+	}
+	else {
+		glEnable(GL_BLEND);
+		setBlending();
+		glDrawArrays(GL_TRIANGLES, 0, m_numVertices);
+		glDisable(GL_BLEND);
+	}
+	m_vertexBuffer.release();
+	m_shaderProgram->release();
+	m_fbo->release();
+}
+
+// 
+// Private
+//
+void GL_ContourRenderer::setShaderData(QColor contourColor, float windowToContourScale) {
+	float filterWidth = m_antialiasingFilterWidth * windowToContourScale;
+	switch (m_type) {
+	case RendererType::Centerline:
+	{
+		m_shaderProgram->setUniformValue(m_colorLocation, contourColor);
+		m_shaderProgram->setUniformValue(m_filterWidthLocation, filterWidth);
+		float centerlineRadius = m_centerlineRadius * windowToContourScale;
+		m_shaderProgram->setUniformValue(m_radiusLocation, centerlineRadius);
+		break;
+	}
+	case RendererType::Binary:
+	{
+		m_shaderProgram->setUniformValue(m_colorLocation, contourColor);
+		break;
+	}
+	case RendererType::DistToContour:
+	case RendererType::DistToCenterline:
+	{
+		m_shaderProgram->setUniformValue(m_colorLocation, contourColor);
+		m_shaderProgram->setUniformValue(m_maxDistLocation, std::max(m_maxDistFieldDistance, 1e-6f));
+		break;
+	}
+	case RendererType::Products:
+	{
+		m_shaderProgram->setUniformValue(m_maxDistLocation, std::max(m_maxDistFieldDistance, 1e-6f));
+		break;
+	}
+	case RendererType::Labels:
+	{
+		m_shaderProgram->setUniformValue(m_maxDistLocation, std::max(m_maxRadius, 1e-6f));
+		break;
+	}
+	case RendererType::Antialiased:
+	case RendererType::Default:
+	default:
+	{
+		m_shaderProgram->setUniformValue(m_colorLocation, contourColor);
+		m_shaderProgram->setUniformValue(m_filterWidthLocation, filterWidth);
+		break;
+	}
+	}
+}
+void GL_ContourRenderer::clearProductTargets()
+{
+	// Each attachment is cleared to its own far value, then all attachments are enabled
+	// for drawing. The framebuffer must be bound.
+	QOpenGLExtraFunctions* functions = QOpenGLContext::currentContext()->extraFunctions();
+	bool isUnnormalized = (m_targetFormat == TargetFormat::R32F);
+	float clearValues[numProductTargets] = { 0, isUnnormalized ? -m_maxDistFieldDistance : 0,
+		isUnnormalized ? -m_maxDistFieldDistance : 0 };
+	GLenum drawBuffers[numProductTargets];
+	for (int i = 0; i < numProductTargets; i++) {
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		functions->glDrawBuffers(1, &drawBuffers[i]);
+		glClearColor(clearValues[i], clearValues[i], clearValues[i], clearValues[i]);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+	functions->glDrawBuffers(numProductTargets, drawBuffers);
+}
+void GL_ContourRenderer::setBlending()
+{
+	// Overlapping cells keep the maximum coverage or distance value, except for 
+	// unnormalized distances to centerlines, which keep the nearest distance
+	glBlendFunc(GL_DST_ALPHA, GL_SRC_ALPHA);
+	if (m_targetFormat == TargetFormat::R32F && m_type == RendererType::DistToCenterline) {
+		glBlendEquation(GL_MIN);
+	}
+	else {
+		glBlendEquation(GL_MAX);
+	}
+}
+void GL_ContourRenderer::setVertexBuffer(const std::list<Curve::PointVector>& curvePoints, 
+	float windowToContourScale)
+{
+	VESCL_PROFILE_SCOPE("GL_ContourRenderer::setVertexBuffer", "tessellate");
+
+	// Make sure there is something to render
+	m_numVertices = 0;
+	if (curvePoints.size() == 0) return;
+
+	// Determine render type dependent constants
+	float radiusOffset = 0;
+	switch (m_type) {
+	case RendererType::Binary:
+	case RendererType::Labels:
+	{
+		break;
+	}
+	case RendererType::DistToContour:
+	case RendererType::DistToCenterline:
+	case RendererType::Products:
+	{
+		radiusOffset += m_maxDistFieldDistance;
+		break;
+	}
+	case RendererType::Antialiased:
+	case RendererType::Centerline:
+	case RendererType::Default:
+	default:
+	{
+		float filterWidth = m_antialiasingFilterWidth * windowToContourScale;
+		radiusOffset += filterWidth;
+		break;
+	}
+	}
+
+	// Compute cell vertices
+	std::vector<GLfloat> vertices;
+	std::vector<GLfloat> labels;
+	bool isLabeled = (m_type == RendererType::Labels);
+	int numStrokeVertices = 0;
+	try {
+		numStrokeVertices = ContourTessellator::tessellate(curvePoints, radiusOffset, vertices, 
+			isLabeled ? &labels : nullptr);
+	}
+	catch (const std::bad_alloc& e) {
+		std::cout << "Memory Allocation " << "failure: " << e.what() << std::endl;
+		return;
+	}
+
+	// Create the vertex buffer
+	int sizeVertices = sizeof(GLfloat) * ContourTessellator::numFloatsPerVertex * numStrokeVertices;
+	if (!m_vertexBuffer.isCreated()) {
+		m_vertexBuffer.create();
+	}
+	m_vertexBuffer.bind();
+	m_vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	m_vertexBuffer.allocate(vertices.data(), sizeVertices);
+	m_vertexBuffer.release();
+	m_numVertices = numStrokeVertices;
+
+	// Label depths are distances to centerlines scaled by the largest stroke radius
+	if (isLabeled) {
+		m_maxRadius = 0;
+		for (size_t i = 4; i < vertices.size(); i += ContourTessellator::numFloatsPerVertex) {
+			m_maxRadius = std::max(m_maxRadius, vertices[i]);
+		}
+		if (!m_labelBuffer.isCreated()) {
+			m_labelBuffer.create();
+		}
+		m_labelBuffer.bind();
+		m_labelBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+		m_labelBuffer.allocate(labels.data(), sizeof(GLfloat) * numStrokeVertices);
+		m_labelBuffer.release();
+	}
+}
@@ -1,183 +1,340 @@
-//
-// GL_ContourRenderer.h
-// Renders a contour onto the texture of an OpenGL framebuffer object.
-// 
-// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
-// 
-// This code is free software : you can redistribute it and /or modify it under
-// the terms of the GNU General Public License as published by the Free Software 
-// Foundation, either version 3 of the License, or (at your option) any later version.
-// 
-// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
-// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
-// PARTICULAR PURPOSE. See the GNU General Public License for more details.
-// 
-// You may have received a copy of the GNU General Public License along with this 
-// program. If not, see < http://www.gnu.org/licenses/>.
-// 
-
-#pragma once
-
-#include "../Controller/RenderState.h"
-#include "../Model/Contour.h"
-
-#include <QObject>
-#include <QOpenGLFunctions>
-#include <QOpenGLBuffer>
-#include <QMatrix4x4>
-
-class QOpenGLTexture;
-class QOpenGLFramebufferObject;
-class QOpenGLShaderProgram;
-
-class GL_ContourRenderer : public QObject, protected QOpenGLFunctions
-{
-	Q_OBJECT
-
-public:
-	enum class RendererType { Default, Antialiased, Centerline, Binary, DistToContour, DistToCenterline };
-
-	GL_ContourRenderer(RendererType type);
-	~GL_ContourRenderer();
-
-	// OpenGL context must be set prior to update
-	void update(std::list<Curve::PointVector> curvePoints, QColor contourColor,
-		int winWidth, int winHeight, QMatrix4x4 mvpMatrix, float windowToContourScale);
-	bool textureID(GLuint* textureID);
-	QImage renderedImage();
-
-private:
-	// Could consider sub-classing this renderer for different render types
-	RendererType m_type;
-
-	// Type specific state. Currently uses default values but could consider setting these.
-	float m_antialiasingFilterWidth;
-	float m_centerlineRadius;
-	float m_maxDistFieldDistance;
-
-	// OpenGL rendering
-	int m_fboWidth;
-	int m_fboHeight;
-	QOpenGLFramebufferObject* m_fbo;
-	QOpenGLShaderProgram* m_shaderProgram;
-	QOpenGLBuffer m_vertexBuffer;
-	int m_numVertices;
-	void setShaderData(QColor contourColor, float windowToContourScale);
-	void setVertexBuffer(std::list<Curve::PointVector> curvePoints, float windowToContourScale);
-
-	// OpenGL shaders for rendering contours with antialiased edges
-	const char* const vertexShader_antialiasedContour =
-		"attribute vec2 a_position;\n"
-		"attribute vec3 a_data;\n"
-		"varying vec2 v_vecDist;\n"
-		"varying float v_radius;\n"
-		"uniform mat4 u_mvpMatrix;\n"
-		"void main() {\n"
-		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
-		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
-		"   v_radius = a_data.z;\n"
-		"}\n";
-	const char* const fragmentShader_antialiasedContour =
-		"varying vec2 v_vecDist;\n"
-		"varying float v_radius;\n"
-		"uniform vec4 u_color;\n"
-		"uniform float u_filterWidth;\n"
-		"void main() {\n"
-		"   float distToEdge = v_radius - length(v_vecDist);\n"
-		"	float profile = clamp(0.5 + distToEdge / u_filterWidth, 0.0, 1.0);\n"
-		"	gl_FragColor = u_color;\n"
-		" 	gl_FragColor.a *= profile;\n"
-		"}\n";
-
-	// OpenGL shaders for rendering contour centerlines 
-	const char* const vertexShader_contourCenterline =
-		"attribute vec2 a_position;\n"
-		"attribute vec3 a_data;\n"
-		"varying vec2 v_vecDist;\n"
-		"uniform mat4 u_mvpMatrix;\n"
-		"void main() {\n"
-		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
-		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
-		"}\n";
-	const char* const fragmentShader_contourCenterline =
-		"varying vec2 v_vecDist;\n"
-		"uniform vec4 u_color;\n"
-		"uniform float u_radius;\n"
-		"uniform float u_filterWidth;\n"
-		"void main() {\n"
-		"   float distToEdge = u_radius - length(v_vecDist);\n"
-		"	float profile = clamp(0.5 + distToEdge / u_filterWidth, 0.0, 1.0);\n"
-		"	gl_FragColor = u_color;\n"
-		" 	gl_FragColor.a *= profile;\n"
-		"}\n";
-
-	// OpenGL shaders for rendering as a binary segmentation
-	const char* const vertexShader_binaryContour =
-		"attribute vec2 a_position;\n"
-		"attribute vec3 a_data;\n"
-		"varying vec2 v_vecDist;\n"
-		"varying float v_radius;\n"
-		"uniform mat4 u_mvpMatrix;\n"
-		"void main() {\n"
-		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
-		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
-		"   v_radius = a_data.z;\n"
-		"}\n";
-	const char* const fragmentShader_binaryContour =
-		"varying vec2 v_vecDist;\n"
-		"varying float v_radius;\n"
-		"uniform vec4 u_color;\n"
-		"void main() {\n"
-		"   float distToEdge = v_radius - length(v_vecDist);\n"
-		"	if (distToEdge >= 0) gl_FragColor = u_color;\n"
-		"	else gl_FragColor = vec4(0, 0, 0, 0);\n"
-		"}\n";
-
-	// OpenGL shaders to encode signed distances to contour edges
-	const char* const vertexShader_distToContour =
-		"attribute vec2 a_position;\n"
-		"attribute vec3 a_data;\n"
-		"varying vec2 v_vecDist;\n"
-		"varying float v_radius;\n"
-		"uniform mat4 u_mvpMatrix;\n"
-		"void main() {\n"
-		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
-		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
-		"   v_radius = a_data.z;\n"
-		"}\n";
-	const char* const fragmentShader_distToContour =
-		"varying vec2 v_vecDist;\n"
-		"varying float v_radius;\n"
-		"uniform vec4 u_color;\n"
-		"uniform float u_maxDist;\n"
-		"void main() {\n"
-		"   float distToEdge = v_radius - length(v_vecDist);\n"
-		"	float profile = clamp(0.5 + 0.5 * distToEdge/u_maxDist, 0.0, 1.0);\n"
-		"	gl_FragColor = u_color;\n"
-		" 	gl_FragColor.a *= profile;\n"
-		"}\n";
-
-	// OpenGL shaders to encode distances to contours centerlines
-	const char* const vertexShader_distToCenterline =
-		"attribute vec2 a_position;\n"
-		"attribute vec3 a_data;\n"
-		"varying vec2 v_vecDist;\n"
-		"varying float v_radius;\n"
-		"uniform mat4 u_mvpMatrix;\n"
-		"void main() {\n"
-		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
-		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
-		"   v_radius = a_data.z;\n"
-		"}\n";
-	const char* const fragmentShader_distToCenterline =
-		"varying vec2 v_vecDist;\n"
-		"varying float v_radius;\n"
-		"uniform vec4 u_color;\n"
-		"uniform float u_maxDist;\n"
-		"void main() {\n"
-		"   float distToCenterline = length(v_vecDist);\n"
-		"	float scaledDist = clamp(1 - (distToCenterline/u_maxDist), 0.0, 1.0);\n"
-		"	gl_FragColor = u_color;\n"
-		"	gl_FragColor.a = scaledDist;\n"
-		"}\n";
+//
+// GL_ContourRenderer.h
+// Renders a contour onto the texture of an OpenGL framebuffer object.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "../Controller/RenderState.h"
+#include "../Model/Contour.h"
+
+#include <QObject>
+#include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <QMatrix4x4>
+
+class QOpenGLTexture;
+class QOpenGLFramebufferObject;
+class QOpenGLShaderProgram;
+
+class GL_ContourRenderer : public QObject, protected QOpenGLFunctions
+{
+	Q_OBJECT
+
+public:
+	enum class RendererType { Default, Antialiased, Centerline, Binary, DistToContour, DistToCenterline, 
+		Products, Labels };
+
+	// RGBA8 targets hold the contour color with coverage or encoded distance in alpha. 
+	// Single-channel targets hold the value only. R16 values are normalized as for the
+	// alpha of RGBA8 targets. R32F targets hold coverage for Antialiased, Centerline and 
+	// Binary renderers, and unnormalized distances in contour units for the distance 
+	// renderers, i.e., signed distances to vessel edges (positive inside) clamped to 
+	// [-maxDist, inf) and distances to centerlines clamped to [0, maxDist].
+	enum class TargetFormat { RGBA8, R16, R32F };
+
+	// Products renderers draw the binary mask, the distance to vessel edges and the 
+	// distance to centerlines in a single pass into three single-channel color attachments
+	// in this order. Values are as for the separate renderers, except that R32F distances 
+	// to centerlines are negated so that all attachments keep the maximum when blending.
+	// Requires OpenGL 2.0 draw buffers and single-channel targets.
+	static const int numProductTargets = 3;
+	static bool isProductsSupported();
+
+	// Labels renderers draw the position of each pixel's curve in the curve list plus one,
+	// or zero for background, into an R32F target, which holds labels exactly up to 2^24.
+	// Where strokes overlap, the curve with the nearest centerline is kept using a depth
+	// buffer, and ties keep the curve that comes first.
+
+	GL_ContourRenderer(RendererType type, TargetFormat format = TargetFormat::RGBA8);
+	~GL_ContourRenderer();
+
+	// OpenGL context must be set prior to update. update() is equivalent to setGeometry()
+	// followed by render(), which can also be called separately, e.g., to re-render
+	// unchanged geometry or to time the stages.
+	void update(const std::list<Curve::PointVector>& curvePoints, QColor contourColor,
+		int winWidth, int winHeight, QMatrix4x4 mvpMatrix, float windowToContourScale);
+	void setGeometry(const std::list<Curve::PointVector>& curvePoints, float windowToContourScale);
+	void render(QColor contourColor, int winWidth, int winHeight, QMatrix4x4 mvpMatrix, 
+		float windowToContourScale);
+	RendererType type() const { return m_type; };
+	TargetFormat targetFormat() const { return m_targetFormat; };
+	int numVertices() const { return m_numVertices; };
+	bool textureID(GLuint* textureID);
+	QOpenGLFramebufferObject* framebuffer() const { return m_fbo; };
+
+	// Only available for RGBA8 targets. Use GL_PixelReader for single-channel targets.
+	QImage renderedImage();
+
+	// Distances are clamped to maxDist in contour units. Call before setGeometry(). A 
+	// max distance of 0 gives normalized distances a step at the vessel edge or centerline.
+	float maxDistFieldDistance() const { return m_maxDistFieldDistance; };
+	void setMaxDistFieldDistance(float maxDist) { m_maxDistFieldDistance = maxDist; };
+
+private:
+	// Could consider sub-classing this renderer for different render types
+	RendererType m_type;
+	TargetFormat m_targetFormat;
+
+	// Type specific state. Currently uses default values but could consider setting these.
+	float m_antialiasingFilterWidth;
+	float m_centerlineRadius;
+	float m_maxDistFieldDistance;
+
+	// OpenGL rendering
+	int m_fboWidth;
+	int m_fboHeight;
+	QOpenGLFramebufferObject* m_fbo;
+	QOpenGLShaderProgram* m_shaderProgram;
+	int m_mvpLocation;
+	int m_posLocation;
+	int m_dataLocation;
+	int m_colorLocation;
+	int m_filterWidthLocation;
+	int m_radiusLocation;
+	int m_maxDistLocation;
+	int m_labelLocation;
+	QOpenGLBuffer m_vertexBuffer;
+	QOpenGLBuffer m_labelBuffer;
+	float m_maxRadius;
+	int m_numVertices;
+	void setShaderData(QColor contourColor, float windowToContourScale);
+	void setBlending();
+	void clearProductTargets();
+	void setVertexBuffer(const std::list<Curve::PointVector>& curvePoints, float windowToContourScale);
+
+	// OpenGL shaders for rendering contours with antialiased edges
+	const char* const vertexShader_antialiasedContour =
+		"attribute vec2 a_position;\n"
+		"attribute vec3 a_data;\n"
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform mat4 u_mvpMatrix;\n"
+		"void main() {\n"
+		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
+		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
+		"   v_radius = a_data.z;\n"
+		"}\n";
+	const char* const fragmentShader_antialiasedContour =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform vec4 u_color;\n"
+		"uniform float u_filterWidth;\n"
+		"void main() {\n"
+		"   float distToEdge = v_radius - length(v_vecDist);\n"
+		"	float profile = clamp(0.5 + distToEdge / u_filterWidth, 0.0, 1.0);\n"
+		"	gl_FragColor = u_color;\n"
+		" 	gl_FragColor.a *= profile;\n"
+		"}\n";
+
+	// OpenGL shaders for rendering contour centerlines 
+	const char* const vertexShader_contourCenterline =
+		"attribute vec2 a_position;\n"
+		"attribute vec3 a_data;\n"
+		"varying vec2 v_vecDist;\n"
+		"uniform mat4 u_mvpMatrix;\n"
+		"void main() {\n"
+		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
+		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
+		"}\n";
+	const char* const fragmentShader_contourCenterline =
+		"varying vec2 v_vecDist;\n"
+		"uniform vec4 u_color;\n"
+		"uniform float u_radius;\n"
+		"uniform float u_filterWidth;\n"
+		"void main() {\n"
+		"   float distToEdge = u_radius - length(v_vecDist);\n"
+		"	float profile = clamp(0.5 + distToEdge / u_filterWidth, 0.0, 1.0);\n"
+		"	gl_FragColor = u_color;\n"
+		" 	gl_FragColor.a *= profile;\n"
+		"}\n";
+
+	// OpenGL shaders for rendering as a binary segmentation
+	const char* const vertexShader_binaryContour =
+		"attribute vec2 a_position;\n"
+		"attribute vec3 a_data;\n"
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform mat4 u_mvpMatrix;\n"
+		"void main() {\n"
+		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
+		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
+		"   v_radius = a_data.z;\n"
+		"}\n";
+	const char* const fragmentShader_binaryContour =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform vec4 u_color;\n"
+		"void main() {\n"
+		"   float distToEdge = v_radius - length(v_vecDist);\n"
+		"	if (distToEdge >= 0) gl_FragColor = u_color;\n"
+		"	else gl_FragColor = vec4(0, 0, 0, 0);\n"
+		"}\n";
+
+	// OpenGL shaders to encode signed distances to contour edges
+	const char* const vertexShader_distToContour =
+		"attribute vec2 a_position;\n"
+		"attribute vec3 a_data;\n"
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform mat4 u_mvpMatrix;\n"
+		"void main() {\n"
+		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
+		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
+		"   v_radius = a_data.z;\n"
+		"}\n";
+	const char* const fragmentShader_distToContour =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform vec4 u_color;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   float distToEdge = v_radius - length(v_vecDist);\n"
+		"	float profile = clamp(0.5 + 0.5 * distToEdge/u_maxDist, 0.0, 1.0);\n"
+		"	gl_FragColor = u_color;\n"
+		" 	gl_FragColor.a *= profile;\n"
+		"}\n";
+
+	// OpenGL shaders to encode distances to contours centerlines
+	const char* const vertexShader_distToCenterline =
+		"attribute vec2 a_position;\n"
+		"attribute vec3 a_data;\n"
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform mat4 u_mvpMatrix;\n"
+		"void main() {\n"
+		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
+		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
+		"   v_radius = a_data.z;\n"
+		"}\n";
+	const char* const fragmentShader_distToCenterline =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform vec4 u_color;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   float distToCenterline = length(v_vecDist);\n"
+		"	float scaledDist = clamp(1 - (distToCenterline/u_maxDist), 0.0, 1.0);\n"
+		"	gl_FragColor = u_color;\n"
+		"	gl_FragColor.a = scaledDist;\n"
+		"}\n";
+
+	// OpenGL fragment shaders for single-channel render targets. The value is written to
+	// all channels and the vertex shaders above are reused.
+	const char* const fragmentShader_antialiasedCoverage =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform float u_filterWidth;\n"
+		"void main() {\n"
+		"   float distToEdge = v_radius - length(v_vecDist);\n"
+		"	gl_FragColor = vec4(clamp(0.5 + distToEdge / u_filterWidth, 0.0, 1.0));\n"
+		"}\n";
+	const char* const fragmentShader_centerlineCoverage =
+		"varying vec2 v_vecDist;\n"
+		"uniform float u_radius;\n"
+		"uniform float u_filterWidth;\n"
+		"void main() {\n"
+		"   float distToEdge = u_radius - length(v_vecDist);\n"
+		"	gl_FragColor = vec4(clamp(0.5 + distToEdge / u_filterWidth, 0.0, 1.0));\n"
+		"}\n";
+	const char* const fragmentShader_binaryMask =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"void main() {\n"
+		"   float distToEdge = v_radius - length(v_vecDist);\n"
+		"	gl_FragColor = vec4(distToEdge >= 0.0 ? 1.0 : 0.0);\n"
+		"}\n";
+	const char* const fragmentShader_normalizedDistToContour =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   float distToEdge = v_radius - length(v_vecDist);\n"
+		"	gl_FragColor = vec4(clamp(0.5 + 0.5 * distToEdge/u_maxDist, 0.0, 1.0));\n"
+		"}\n";
+	const char* const fragmentShader_normalizedDistToCenterline =
+		"varying vec2 v_vecDist;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   float distToCenterline = length(v_vecDist);\n"
+		"	gl_FragColor = vec4(clamp(1.0 - (distToCenterline/u_maxDist), 0.0, 1.0));\n"
+		"}\n";
+	const char* const fragmentShader_signedDistToContour =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   float distToEdge = v_radius - length(v_vecDist);\n"
+		"	gl_FragColor = vec4(max(distToEdge, -u_maxDist));\n"
+		"}\n";
+	const char* const fragmentShader_unsignedDistToCenterline =
+		"varying vec2 v_vecDist;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   gl_FragColor = vec4(min(length(v_vecDist), u_maxDist));\n"
+		"}\n";
+
+	// OpenGL shaders for rendering curve labels with depth as the distance to centerlines
+	const char* const vertexShader_labels =
+		"attribute vec2 a_position;\n"
+		"attribute vec3 a_data;\n"
+		"attribute float a_label;\n"
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"varying float v_label;\n"
+		"uniform mat4 u_mvpMatrix;\n"
+		"void main() {\n"
+		"   gl_Position = u_mvpMatrix * vec4(a_position, 0.0, 1.0);\n"
+		"   v_vecDist = vec2(a_data.x, a_data.y); \n"
+		"   v_radius = a_data.z;\n"
+		"   v_label = a_label;\n"
+		"}\n";
+	const char* const fragmentShader_labels =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"varying float v_label;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   float distToCenterline = length(v_vecDist);\n"
+		"	if (distToCenterline > v_radius) discard;\n"
+		"	gl_FragColor = vec4(floor(v_label + 0.5));\n"
+		"	gl_FragDepth = clamp(distToCenterline / u_maxDist, 0.0, 1.0);\n"
+		"}\n";
+
+	// OpenGL fragment shaders for rendering all products into multiple render targets
+	const char* const fragmentShader_normalizedProducts =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   float distToCenterline = length(v_vecDist);\n"
+		"   float distToEdge = v_radius - distToCenterline;\n"
+		"	gl_FragData[0] = vec4(distToEdge >= 0.0 ? 1.0 : 0.0);\n"
+		"	gl_FragData[1] = vec4(clamp(0.5 + 0.5 * distToEdge/u_maxDist, 0.0, 1.0));\n"
+		"	gl_FragData[2] = vec4(clamp(1.0 - (distToCenterline/u_maxDist), 0.0, 1.0));\n"
+		"}\n";
+	const char* const fragmentShader_unnormalizedProducts =
+		"varying vec2 v_vecDist;\n"
+		"varying float v_radius;\n"
+		"uniform float u_maxDist;\n"
+		"void main() {\n"
+		"   float distToCenterline = length(v_vecDist);\n"
+		"   float distToEdge = v_radius - distToCenterline;\n"
+		"	gl_FragData[0] = vec4(distToEdge >= 0.0 ? 1.0 : 0.0);\n"
+		"	gl_FragData[1] = vec4(max(distToEdge, -u_maxDist));\n"
+		"	gl_FragData[2] = vec4(-min(distToCenterline, u_maxDist));\n"
+		"}\n";
 };
\ No newline at end of file
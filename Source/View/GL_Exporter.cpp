@@ -1,138 +1,747 @@
-//
-// GL_Exporter.cpp
-// Implementation of GL_Exporter.
-//
-
-#include "GL_Exporter.h"
-
-#include "GL_ImageRenderer.h"
-#include "GL_ContourRenderer.h"
-#include "../Model/Model.h"
-#include "../Controller/RenderState.h"
-
-#include <QScreen>
-#include <QImage>
-#include <QOpenGLFramebufferObject>
-
-#include <iostream>
-
-// 
-// Public
-//
-GL_Exporter::GL_Exporter(Model* model) :
-	m_model(model),
-	m_isGLSetup(false)
-{
-}
-GL_Exporter::~GL_Exporter()
-{
-}
-
-void GL_Exporter::exportSegmentation(const char* filename, float imageToExportScale, ExportType type)
-{
-	if (!m_isGLSetup) {
-		if (!setupGL()) return;
-	}
-	m_isGLSetup = true;
-	
-	// Clear the offscreen surface viewport
-	int imageWidth = m_model->imageWidth();
-	int imageHeight = m_model->imageHeight();
-	int exportWidth = (int) imageWidth * imageToExportScale;
-	int  exportHeight = (int) imageHeight * imageToExportScale;
-	m_context.makeCurrent(&m_surface);
-	glViewport(0, 0, exportWidth, exportHeight);
-
-	glClearColor(1, 0, 0, 1);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-
-	// Set renderstate for export
-	RenderState renderState;
-	renderState.resetProjectionMatrix(exportWidth, exportHeight);
-	renderState.centerImageInViewport(imageWidth, imageHeight);
-
-		// Render the image to the appropriate renderer
-	QImage renderedImage;
-	if (type == ExportType::SourceImage) {
-		GL_ImageRenderer renderer;
-		renderer.setImage(m_model->image());
-		renderer.update(exportWidth, exportHeight, &renderState);
-		renderedImage = renderer.renderedImage();
-	}
-	else {
-		GL_ContourRenderer::RendererType renderType;
-		switch (type)
-		{
-		case ExportType::DistToCenterline:
-			renderType = GL_ContourRenderer::RendererType::DistToCenterline;
-			break;
-		case ExportType::DistToVesselEdge:
-			renderType = GL_ContourRenderer::RendererType::DistToContour;
-			break;
-		default:
-		case ExportType::Binary:
-			renderType = GL_ContourRenderer::RendererType::Binary;
-			break;
-
-		}
-		GL_ContourRenderer renderer(renderType);
-		std::list<Curve*>* curves = m_model->contour()->curves();
-		std::list<Curve::PointVector> curvePoints;
-		float maxPointSpacing = renderState.maxPointSpacing() * renderState.windowToContourScale();
-		for (std::list<Curve*>::iterator it = curves->begin(); it != curves->end(); it++) {
-			Curve::PointVector pv = (*it)->getSampledCurvePoints(maxPointSpacing);
-			curvePoints.push_back(pv);
-		}
-		renderer.update(curvePoints, Qt::white, exportWidth, exportHeight, 
-			renderState.mvpMatrix(), renderState.windowToContourScale());
-		renderedImage = renderer.renderedImage();
-	}
-
-	for (int y = 0; y < renderedImage.height(); ++y) {
-		QRgb* ptr = reinterpret_cast<QRgb*>(renderedImage.scanLine(y));
-		for (int x = 0; x < renderedImage.width(); ++x) {
-			float alpha = ((float)qAlpha(*ptr)) / 255.0;
-			float red = ((float)qRed(*ptr)) * alpha;
-			float green = ((float)qGreen(*ptr)) * alpha;
-			float blue = ((float)qBlue(*ptr)) * alpha;
-			*ptr++ = qRgba((int)red, (int)green, (int)blue, 255);
-		}
-	}
-
-	try {
-		if (!renderedImage.save(filename, nullptr, -1)) {
-			throw std::runtime_error("Can't save image to export file.");
-		}
-	}
-	catch (const std::exception& e) {
-		std::cout << "Exception " << e.what() << std::endl;
-	}
-	m_context.doneCurrent();
-}
-
-// 
-// Private
-//
-bool GL_Exporter::setupGL()
-{
-	try {
-		if (!m_context.create()) {
-			throw std::runtime_error("Can't create GL context.");
-		}
-		m_surface.setFormat(m_context.format());
-		m_surface.create();
-		if (!m_surface.isValid()) {
-			throw std::runtime_error("GL surface not valid.");
-		}
-		if (!m_context.makeCurrent(&m_surface)) {
-			throw std::runtime_error("Can't make GL context current.");
-		}
-	}
-	catch (const std::exception& e) {
-		std::cout << "Exception " << e.what() << std::endl;
-		return false;
-	}
-
-	initializeOpenGLFunctions();
-	return true;
-}
+//
+// GL_Exporter.cpp
+// Implementation of GL_Exporter.
+//
+
+#include "GL_Exporter.h"
+
+#include "GL_ImageRenderer.h"
+#include "GL_ContourRenderer.h"
+#include "GL_PixelReader.h"
+#include "CPU_ContourRenderer.h"
+#include "../Model/Model.h"
+#include "../Model/DistanceTransform.h"
+#include "../Controller/RenderState.h"
+#include "../Util/Profiler.h"
+#include "../Util/RasterFileWriter.h"
+
+#include <QScreen>
+#include <QImage>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLExtraFunctions>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string>
+
+// 
+// Public
+//
+GL_Exporter::GL_Exporter(Model* model) :
+	m_model(model),
+	m_maxDistance(10),
+	m_backend(Backend::Auto),
+	m_isExactDistance(false),
+	m_tileSize(2048),
+	m_numTiles(0),
+	m_numSkippedTiles(0),
+	m_sharedImageTexture(nullptr),
+	m_sharedImageContext(nullptr),
+	m_isGLSetup(false),
+	m_isSharingResources(true)
+{
+}
+GL_Exporter::~GL_Exporter()
+{
+	releaseResources();
+}
+
+bool GL_Exporter::initialize()
+{
+	if (m_backend != Backend::CPU && !m_isGLSetup) m_isGLSetup = setupGL();
+	if (m_isGLSetup) m_context.doneCurrent();
+	return m_isGLSetup;
+}
+void GL_Exporter::moveToThread(QThread* thread)
+{
+	m_context.doneCurrent();
+	m_context.moveToThread(thread);
+}
+void GL_Exporter::setSharedImageTexture(QOpenGLTexture* texture, QOpenGLContext* owner)
+{
+	m_sharedImageTexture = texture;
+	m_sharedImageContext = owner;
+}
+void GL_Exporter::releaseResources()
+{
+	if (m_renderers.empty()) return;
+	m_context.makeCurrent(&m_surface);
+	for (auto& renderer : m_renderers) delete renderer.second;
+	m_renderers.clear();
+	m_context.doneCurrent();
+}
+
+void GL_Exporter::exportSegmentation(const char* filename, float imageToExportScale, ExportType type,
+	PixelFormat format)
+{
+	VESCL_PROFILE_SCOPE("GL_Exporter::exportSegmentation", "export");
+	if (type == ExportType::SourceImage && format != PixelFormat::RGBA8) {
+		std::cout << "Exception " << "Source images can only be exported with 8-bit precision." << std::endl;
+		return;
+	}
+	if (type == ExportType::AllProducts) {
+		exportAllProducts(filename, imageToExportScale, format);
+		return;
+	}
+	if (type == ExportType::LabelMap) {
+		if (m_model->contour()->curves()->size() > std::numeric_limits<uint16_t>::max()) {
+			std::cout << "Exception " << "Too many curves for a 16-bit label map." << std::endl;
+			return;
+		}
+		format = PixelFormat::UInt16;
+	}
+
+	// Distances are exact when computed on the CPU
+	bool isDistance = (type == ExportType::DistToCenterline || type == ExportType::DistToVesselEdge);
+	bool useCPU = (m_backend == Backend::CPU) || (isDistance && m_isExactDistance);
+	if (!useCPU && !m_isGLSetup) {
+		m_isGLSetup = setupGL();
+		if (!m_isGLSetup) {
+			if (m_backend != Backend::Auto || !isCPUExportSupported(type)) return;
+			std::cout << "OpenGL is not available. Exporting with the CPU renderer." << std::endl;
+			useCPU = true;
+		}
+	}
+	if (useCPU && !isCPUExportSupported(type)) {
+		std::cout << "Exception " << "Export type is not supported by the CPU renderer." << std::endl;
+		return;
+	}
+	
+	// Exports larger than a tile are rendered in tiles and streamed to the file, except 
+	// for exact distances, which need the whole raster, and source images
+	int imageWidth = m_model->imageWidth();
+	int imageHeight = m_model->imageHeight();
+	int exportWidth = (int) imageWidth * imageToExportScale;
+	int  exportHeight = (int) imageHeight * imageToExportScale;
+	bool isExact = useCPU && isDistance;
+	bool isTiled = (exportWidth > m_tileSize || exportHeight > m_tileSize) && 
+		type != ExportType::SourceImage && !isExact;
+	if (isTiled) {
+		exportTiled(filename, imageToExportScale, type, format, useCPU);
+		return;
+	}
+	if (useCPU) {
+		exportWithCPU(filename, imageToExportScale, type, format);
+		return;
+	}
+
+	// Clear the offscreen surface viewport
+	m_context.makeCurrent(&m_surface);
+	glViewport(0, 0, exportWidth, exportHeight);
+
+	glClearColor(1, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+	// Set renderstate for export
+	RenderState renderState;
+	renderState.resetProjectionMatrix(exportWidth, exportHeight);
+	renderState.centerImageInViewport(imageWidth, imageHeight);
+
+		// Render the image to the appropriate renderer
+	QImage renderedImage;
+	if (type == ExportType::SourceImage) {
+		GL_ImageRenderer renderer;
+		if (m_sharedImageTexture && m_sharedImageContext && 
+			QOpenGLContext::areSharing(&m_context, m_sharedImageContext)) {
+			renderer.setSharedImage(m_model->image(), m_sharedImageTexture);
+		}
+		else {
+			renderer.setImage(m_model->image());
+			renderer.finishUpload();
+		}
+		renderer.update(exportWidth, exportHeight, &renderState);
+		renderedImage = renderer.renderedImage();
+	}
+	else {
+		GL_ContourRenderer::RendererType renderType;
+		switch (type)
+		{
+		case ExportType::DistToCenterline:
+			renderType = GL_ContourRenderer::RendererType::DistToCenterline;
+			break;
+		case ExportType::DistToVesselEdge:
+			renderType = GL_ContourRenderer::RendererType::DistToContour;
+			break;
+		case ExportType::AntialiasedMask:
+			renderType = GL_ContourRenderer::RendererType::Antialiased;
+			break;
+		case ExportType::LabelMap:
+			renderType = GL_ContourRenderer::RendererType::Labels;
+			break;
+		default:
+		case ExportType::Binary:
+			renderType = GL_ContourRenderer::RendererType::Binary;
+			break;
+
+		}
+		GL_ContourRenderer::TargetFormat targetFormat = GL_ContourRenderer::TargetFormat::RGBA8;
+		if (format == PixelFormat::UInt16) targetFormat = GL_ContourRenderer::TargetFormat::R16;
+		if (format == PixelFormat::Float32 || type == ExportType::LabelMap) {
+			targetFormat = GL_ContourRenderer::TargetFormat::R32F;
+		}
+		GL_ContourRenderer& renderer = *contourRenderer(renderType, targetFormat);
+		renderer.setMaxDistFieldDistance(m_maxDistance);
+		float maxPointSpacing = renderState.maxPointSpacing() * renderState.windowToContourScale();
+		std::list<Curve::PointVector> curvePoints = sampledCurves(maxPointSpacing);
+		renderer.update(curvePoints, Qt::white, exportWidth, exportHeight, 
+			renderState.mvpMatrix(), renderState.windowToContourScale());
+
+		// High precision targets are streamed to the file without conversion
+		if (format != PixelFormat::RGBA8) {
+			saveRenderTarget(&renderer, filename, exportWidth, exportHeight, format);
+			m_context.doneCurrent();
+			return;
+		}
+		renderedImage = renderer.renderedImage();
+	}
+
+	for (int y = 0; y < renderedImage.height(); ++y) {
+		QRgb* ptr = reinterpret_cast<QRgb*>(renderedImage.scanLine(y));
+		for (int x = 0; x < renderedImage.width(); ++x) {
+			float alpha = ((float)qAlpha(*ptr)) / 255.0;
+			float red = ((float)qRed(*ptr)) * alpha;
+			float green = ((float)qGreen(*ptr)) * alpha;
+			float blue = ((float)qBlue(*ptr)) * alpha;
+			*ptr++ = qRgba((int)red, (int)green, (int)blue, 255);
+		}
+	}
+
+	try {
+		if (!renderedImage.save(filename, nullptr, -1)) {
+			throw std::runtime_error("Can't save image to export file.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+	}
+	m_context.doneCurrent();
+}
+
+bool GL_Exporter::isCPUExportSupported(ExportType type)
+{
+	return (type != ExportType::SourceImage && type != ExportType::LabelMap);
+}
+
+// 
+// Private
+//
+std::list<Curve::PointVector> GL_Exporter::sampledCurves(float maxPointSpacing)
+{
+	std::list<Curve*>* curves = m_model->contour()->curves();
+	std::list<Curve::PointVector> curvePoints;
+	for (std::list<Curve*>::iterator it = curves->begin(); it != curves->end(); it++) {
+		Curve::PointVector pv = (*it)->getSampledCurvePoints(maxPointSpacing);
+		curvePoints.push_back(pv);
+	}
+	return curvePoints;
+}
+
+void GL_Exporter::exportWithCPU(const char* filename, float imageToExportScale, ExportType type,
+	PixelFormat format)
+{
+	VESCL_PROFILE_SCOPE("GL_Exporter::exportWithCPU", "export");
+	try {
+		if (!isCPUExportSupported(type)) {
+			throw std::runtime_error("Export type is not supported by the CPU renderer.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return;
+	}
+
+	int exportWidth, exportHeight;
+	float imageToPixelScale, offsetX, offsetY;
+	exportTransform(imageToExportScale, &exportWidth, &exportHeight, &imageToPixelScale, &offsetX, &offsetY);
+
+	RenderState renderState;
+	float maxPointSpacing = renderState.maxPointSpacing() / imageToPixelScale;
+	std::list<Curve::PointVector> curvePoints = sampledCurves(maxPointSpacing);
+	std::vector<float> values;
+	if (type == ExportType::Binary || type == ExportType::AntialiasedMask) {
+		CPU_ContourRenderer::RendererType renderType = (type == ExportType::AntialiasedMask) ?
+			CPU_ContourRenderer::RendererType::Antialiased : CPU_ContourRenderer::RendererType::Binary;
+		CPU_ContourRenderer renderer(renderType);
+		renderer.update(curvePoints, exportWidth, exportHeight, imageToPixelScale, offsetX, offsetY);
+		values = renderer.takeCoverage();
+	}
+	else {
+		values = exactDistances(type, curvePoints, exportWidth, exportHeight, imageToPixelScale, 
+			offsetX, offsetY);
+
+		// Normalize as the OpenGL distance shaders do, i.e., 0.5 at vessel edges or 1 on 
+		// centerlines, falling off over the max distance. Normalization is skipped when 
+		// the max distance is 0, and values then only depend on the distance's sign.
+		if (format != PixelFormat::Float32) {
+			bool isEdge = (type == ExportType::DistToVesselEdge);
+			for (float& value : values) {
+				if (m_maxDistance > 0) {
+					value = isEdge ? 0.5f + 0.5f * value / m_maxDistance : 1.0f - value / m_maxDistance;
+				}
+				else {
+					value = isEdge ? ((value > 0) ? 1.0f : (value < 0) ? 0.0f : 0.5f) : ((value > 0) ? 0.0f : 1.0f);
+				}
+				value = std::min(1.0f, std::max(0.0f, value));
+			}
+		}
+	}
+	if (values.size() != (size_t)exportWidth * exportHeight) return;
+	saveValues(filename, exportWidth, exportHeight, values.data(), format);
+}
+
+std::vector<float> GL_Exporter::exactDistances(ExportType type, std::list<Curve::PointVector>& curvePoints,
+	int width, int height, float imageToPixelScale, float offsetX, float offsetY)
+{
+	// Rasterize the vessels, or the centerlines as strokes one pixel wide, and compute 
+	// distances to them in export pixels
+	bool isEdge = (type == ExportType::DistToVesselEdge);
+	if (!isEdge) {
+		float centerlineRadius = 0.5f / imageToPixelScale;
+		for (std::list<Curve::PointVector>::iterator it = curvePoints.begin(); it != curvePoints.end(); it++) {
+			for (Curve::PointVector::iterator itPoint = it->begin(); itPoint != it->end(); itPoint++) {
+				itPoint->setRadius(centerlineRadius);
+			}
+		}
+	}
+	CPU_ContourRenderer renderer(CPU_ContourRenderer::RendererType::Binary);
+	renderer.update(curvePoints, width, height, imageToPixelScale, offsetX, offsetY);
+	const std::vector<float>& coverage = renderer.coverage();
+	std::vector<unsigned char> mask(coverage.size());
+	for (size_t i = 0; i < coverage.size(); i++) mask[i] = (coverage[i] >= 0.5f) ? 1 : 0;
+	std::vector<float> distances = isEdge ? DistanceTransform::signedDistanceToEdge(mask, width, height) :
+		DistanceTransform::distanceToSeeds(mask, width, height);
+
+	// Convert to source image pixels
+	float pixelToImageScale = 1.0f / imageToPixelScale;
+	for (float& distance : distances) distance *= pixelToImageScale;
+	return distances;
+}
+
+void GL_Exporter::saveValues(const char* filename, int width, int height, const float* values,
+	PixelFormat format)
+{
+	// Values in [0, 1] are written as gray levels, matching the un-premultiplied OpenGL 
+	// exports. Float values are written unchanged.
+	try {
+		if (format == PixelFormat::RGBA8) {
+			QImage image(width, height, QImage::Format_RGB32);
+			for (int y = 0; y < height; y++) {
+				const float* row = values + (size_t)y * width;
+				QRgb* ptr = reinterpret_cast<QRgb*>(image.scanLine(y));
+				for (int x = 0; x < width; x++) {
+					int gray = (int)(255 * row[x] + 0.5f);
+					*ptr++ = qRgb(gray, gray, gray);
+				}
+			}
+			if (!image.save(filename, nullptr, -1)) {
+				throw std::runtime_error("Can't save image to export file.");
+			}
+			return;
+		}
+
+		RasterFileWriter writer;
+		RasterFileWriter::SampleFormat sampleFormat = (format == PixelFormat::UInt16) ?
+			RasterFileWriter::SampleFormat::UInt16 : RasterFileWriter::SampleFormat::Float32;
+		if (!writer.open(filename, width, height, sampleFormat)) return;
+		std::vector<uint16_t> row16(format == PixelFormat::UInt16 ? width : 0);
+		bool isWritten = true;
+		for (int y = 0; y < height && isWritten; y++) {
+			const float* row = values + (size_t)y * width;
+			if (format == PixelFormat::UInt16) {
+				for (int x = 0; x < width; x++) row16[x] = (uint16_t)(65535 * row[x] + 0.5f);
+				isWritten = writer.writeRow(row16.data());
+			}
+			else {
+				isWritten = writer.writeRow(row);
+			}
+		}
+		if (!writer.close() || !isWritten) {
+			throw std::runtime_error("Can't save image to export file.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+	}
+}
+
+void GL_Exporter::exportAllProducts(const char* filename, float imageToExportScale, PixelFormat format)
+{
+	VESCL_PROFILE_SCOPE("GL_Exporter::exportAllProducts", "export");
+	const ExportType types[GL_ContourRenderer::numProductTargets] = { 
+		ExportType::Binary, ExportType::DistToVesselEdge, ExportType::DistToCenterline };
+	std::string filenames[GL_ContourRenderer::numProductTargets] = { 
+		productFilename(filename, "binary"), productFilename(filename, "vessel_distance"), 
+		productFilename(filename, "centerline_distance") };
+
+	// Products are rendered in a single pass when OpenGL supports enough draw buffers 
+	// and the export fits in one tile. Otherwise each product is exported separately.
+	int exportWidth = (int) m_model->imageWidth() * imageToExportScale;
+	int exportHeight = (int) m_model->imageHeight() * imageToExportScale;
+	bool isSinglePass = (m_backend != Backend::CPU) && !m_isExactDistance && 
+		exportWidth <= m_tileSize && exportHeight <= m_tileSize;
+	if (isSinglePass && !m_isGLSetup) m_isGLSetup = setupGL();
+	if (isSinglePass && m_isGLSetup) {
+		m_context.makeCurrent(&m_surface);
+		isSinglePass = GL_ContourRenderer::isProductsSupported();
+		if (!isSinglePass) m_context.doneCurrent();
+	}
+	else {
+		isSinglePass = false;
+	}
+	if (!isSinglePass) {
+		for (int i = 0; i < GL_ContourRenderer::numProductTargets; i++) {
+			exportSegmentation(filenames[i].c_str(), imageToExportScale, types[i], format);
+		}
+		return;
+	}
+
+	// Sample, tessellate and render all products once
+	glViewport(0, 0, exportWidth, exportHeight);
+	RenderState renderState;
+	renderState.resetProjectionMatrix(exportWidth, exportHeight);
+	renderState.centerImageInViewport(m_model->imageWidth(), m_model->imageHeight());
+	GL_ContourRenderer& renderer = *contourRenderer(GL_ContourRenderer::RendererType::Products, (format == PixelFormat::Float32) ?
+		GL_ContourRenderer::TargetFormat::R32F : GL_ContourRenderer::TargetFormat::R16);
+	renderer.setMaxDistFieldDistance(m_maxDistance);
+	float maxPointSpacing = renderState.maxPointSpacing() * renderState.windowToContourScale();
+	std::list<Curve::PointVector> curvePoints = sampledCurves(maxPointSpacing);
+	renderer.update(curvePoints, Qt::white, exportWidth, exportHeight, renderState.mvpMatrix(), 
+		renderState.windowToContourScale());
+	QOpenGLFramebufferObject* fbo = renderer.framebuffer();
+	if (!fbo || !fbo->isValid()) {
+		m_context.doneCurrent();
+		return;
+	}
+
+	// Read back and save each attachment in turn
+	QOpenGLExtraFunctions* functions = m_context.extraFunctions();
+	std::vector<float> values((size_t)exportWidth * exportHeight);
+	GL_PixelReader reader;
+	fbo->bind();
+	for (int i = 0; i < GL_ContourRenderer::numProductTargets; i++) {
+		functions->glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
+		int row = 0;
+		bool isRead = reader.read(exportWidth, exportHeight, GL_PixelReader::PixelType::Float32, 
+			[&](const void* rowValues) {
+			const float* src = (const float*)rowValues;
+			std::copy(src, src + exportWidth, values.begin() + (size_t)(row++) * exportWidth);
+			return true;
+		});
+		if (!isRead) {
+			std::cout << "Exception " << "Can't read export render target." << std::endl;
+			break;
+		}
+
+		// Unnormalized distances to centerlines are rendered negated
+		if (types[i] == ExportType::DistToCenterline && format == PixelFormat::Float32) {
+			for (float& value : values) value = -value;
+		}
+		saveValues(filenames[i].c_str(), exportWidth, exportHeight, values.data(), format);
+	}
+	functions->glReadBuffer(GL_COLOR_ATTACHMENT0);
+	fbo->release();
+	m_context.doneCurrent();
+}
+std::string GL_Exporter::productFilename(const char* filename, const char* product)
+{
+	// Inserts the product name before the file extension, e.g., seg.png -> seg_binary.png
+	std::string name(filename);
+	size_t dirEnd = name.find_last_of("/\\");
+	size_t extStart = name.find_last_of('.');
+	if (extStart == std::string::npos || (dirEnd != std::string::npos && extStart < dirEnd)) {
+		extStart = name.size();
+	}
+	return name.substr(0, extStart) + "_" + product + name.substr(extStart);
+}
+
+void GL_Exporter::exportTransform(float imageToExportScale, int* width, int* height, 
+	float* imageToPixelScale, float* offsetX, float* offsetY)
+{
+	// Same image to export transform as the render state used for OpenGL exports, i.e., 
+	// the image is scaled to fit the export and centered
+	int imageWidth = m_model->imageWidth();
+	int imageHeight = m_model->imageHeight();
+	*width = (int) imageWidth * imageToExportScale;
+	*height = (int) imageHeight * imageToExportScale;
+	*imageToPixelScale = (float)std::max(*width, *height) / (float)std::max(1, std::max(imageWidth, imageHeight));
+	*offsetX = 0.5f * (*width - *imageToPixelScale * imageWidth);
+	*offsetY = 0.5f * (*height - *imageToPixelScale * imageHeight);
+}
+
+void GL_Exporter::exportTiled(const char* filename, float imageToExportScale, ExportType type,
+	PixelFormat format, bool useCPU)
+{
+	VESCL_PROFILE_SCOPE("GL_Exporter::exportTiled", "export");
+	int exportWidth, exportHeight;
+	float imageToPixelScale, offsetX, offsetY;
+	exportTransform(imageToExportScale, &exportWidth, &exportHeight, &imageToPixelScale, &offsetX, &offsetY);
+
+	// Tiles are limited by the OpenGL texture and viewport sizes
+	int tileSize = m_tileSize;
+	if (!useCPU) {
+		m_context.makeCurrent(&m_surface);
+		GLint maxTextureSize = 0;
+		GLint maxViewportDims[2] = { 0, 0 };
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+		glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewportDims);
+		tileSize = std::max(1, std::min(tileSize, std::min((int)maxTextureSize, 
+			(int)std::min(maxViewportDims[0], maxViewportDims[1]))));
+	}
+
+	// Curves are culled per tile with bounding boxes in export pixels. The halo covers 
+	// antialiasing and, for distance types, the max distance around each stroke.
+	float pixelToImageScale = 1.0f / imageToPixelScale;
+	RenderState renderState;
+	std::list<Curve::PointVector> curvePoints = sampledCurves(renderState.maxPointSpacing() * pixelToImageScale);
+	bool isDistance = (type == ExportType::DistToCenterline || type == ExportType::DistToVesselEdge);
+	float halo = 2 + (isDistance ? m_maxDistance * imageToPixelScale : 0);
+	std::vector<Bounds> bounds = curveBounds(curvePoints, imageToPixelScale, offsetX, offsetY, halo);
+
+	// Values of pixels with no contour in range
+	float emptyValue = 0;
+	if (format == PixelFormat::Float32 && type == ExportType::DistToVesselEdge) emptyValue = -m_maxDistance;
+	else if (format == PixelFormat::Float32 && type == ExportType::DistToCenterline) emptyValue = m_maxDistance;
+
+	RasterFileWriter writer;
+	RasterFileWriter::SampleFormat sampleFormat = (format == PixelFormat::Float32) ? 
+		RasterFileWriter::SampleFormat::Float32 : (format == PixelFormat::UInt16) ? 
+		RasterFileWriter::SampleFormat::UInt16 : RasterFileWriter::SampleFormat::UInt8;
+	try {
+		if (!RasterFileWriter::isSupported(RasterFileWriter::containerForFilename(filename), sampleFormat)) {
+			throw std::runtime_error("Large exports must be saved as PNG, TIFF or raw files.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		if (!useCPU) m_context.doneCurrent();
+		return;
+	}
+	if (!writer.open(filename, exportWidth, exportHeight, sampleFormat)) {
+		if (!useCPU) m_context.doneCurrent();
+		return;
+	}
+
+	// Rows of tiles are assembled in a strip and then written
+	GL_ContourRenderer* glRenderer = nullptr;
+	if (!useCPU) {
+		GL_ContourRenderer::RendererType renderType = GL_ContourRenderer::RendererType::Binary;
+		if (type == ExportType::DistToCenterline) renderType = GL_ContourRenderer::RendererType::DistToCenterline;
+		else if (type == ExportType::DistToVesselEdge) renderType = GL_ContourRenderer::RendererType::DistToContour;
+		else if (type == ExportType::AntialiasedMask) renderType = GL_ContourRenderer::RendererType::Antialiased;
+		else if (type == ExportType::LabelMap) renderType = GL_ContourRenderer::RendererType::Labels;
+		glRenderer = contourRenderer(renderType, (format == PixelFormat::Float32 || type == ExportType::LabelMap) ? 
+			GL_ContourRenderer::TargetFormat::R32F : GL_ContourRenderer::TargetFormat::R16);
+		glRenderer->setMaxDistFieldDistance(m_maxDistance);
+		glViewport(0, 0, tileSize, tileSize);
+	}
+	std::vector<float> strip;
+	bool isWritten = true;
+	m_numTiles = 0;
+	m_numSkippedTiles = 0;
+	for (int tileY = 0; tileY < exportHeight && isWritten; tileY += tileSize) {
+		int stripHeight = std::min(tileSize, exportHeight - tileY);
+		strip.assign((size_t)stripHeight * exportWidth, emptyValue);
+		for (int tileX = 0; tileX < exportWidth; tileX += tileSize) {
+			int width = std::min(tileSize, exportWidth - tileX);
+			m_numTiles++;
+			// Labels are positions in the curve list, so culled curves keep their place 
+			// in label maps
+			std::list<Curve::PointVector> tileCurves;
+			int numInRegion = curvesInRegion(curvePoints, bounds, (float)tileX, (float)tileY, 
+				(float)(tileX + width), (float)(tileY + stripHeight), type == ExportType::LabelMap, tileCurves);
+			if (numInRegion == 0) {
+				m_numSkippedTiles++;
+				continue;
+			}
+			VESCL_PROFILE_SCOPE("GL_Exporter::renderTile", "export");
+			if (useCPU) {
+				CPU_ContourRenderer renderer((type == ExportType::AntialiasedMask) ?
+					CPU_ContourRenderer::RendererType::Antialiased : CPU_ContourRenderer::RendererType::Binary);
+				renderer.update(tileCurves, width, stripHeight, imageToPixelScale, offsetX - tileX, 
+					offsetY - tileY);
+				for (int y = 0; y < stripHeight; y++) {
+					std::copy(renderer.row(y), renderer.row(y) + width, strip.begin() + (size_t)y * exportWidth + tileX);
+				}
+				continue;
+			}
+
+			// The tile occupies the bottom left corner of the render target, so reading 
+			// width x stripHeight pixels from the origin returns the tile rows top first
+			QMatrix4x4 mvp;
+			mvp.ortho((float)tileX, (float)(tileX + tileSize), (float)(tileY + stripHeight), 
+				(float)(tileY + stripHeight - tileSize), -1, 1);
+			mvp.translate(offsetX, offsetY, 0);
+			mvp.scale(imageToPixelScale, imageToPixelScale, 1);
+			glRenderer->update(tileCurves, Qt::white, tileSize, tileSize, mvp, pixelToImageScale);
+			if (!glRenderer->framebuffer()) continue;
+			GL_PixelReader reader;
+			int row = 0;
+			glRenderer->framebuffer()->bind();
+			reader.read(width, stripHeight, GL_PixelReader::PixelType::Float32, [&](const void* values) {
+				const float* tileRow = (const float*)values;
+				std::copy(tileRow, tileRow + width, strip.begin() + (size_t)(row++) * exportWidth + tileX);
+				return true;
+			});
+			glRenderer->framebuffer()->release();
+		}
+		isWritten = writeRows(writer, strip.data(), stripHeight, exportWidth, format, type == ExportType::LabelMap);
+	}
+	if (!useCPU) m_context.doneCurrent();
+
+	bool isSaved = writer.close();
+	try {
+		if (!isWritten || !isSaved) {
+			throw std::runtime_error("Can't save image to export file.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return;
+	}
+}
+
+std::vector<GL_Exporter::Bounds> GL_Exporter::curveBounds(const std::list<Curve::PointVector>& curvePoints,
+	float imageToPixelScale, float offsetX, float offsetY, float halo)
+{
+	std::vector<Bounds> bounds;
+	bounds.reserve(curvePoints.size());
+	for (std::list<Curve::PointVector>::const_iterator it = curvePoints.begin(); it != curvePoints.end(); it++) {
+		Bounds b = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+			-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+		for (Curve::PointVector::const_iterator itPoint = it->begin(); itPoint != it->end(); itPoint++) {
+			float x = imageToPixelScale * itPoint->pos()[0] + offsetX;
+			float y = imageToPixelScale * itPoint->pos()[1] + offsetY;
+			float r = imageToPixelScale * itPoint->radius() + halo;
+			b.minX = std::min(b.minX, x - r);
+			b.minY = std::min(b.minY, y - r);
+			b.maxX = std::max(b.maxX, x + r);
+			b.maxY = std::max(b.maxY, y + r);
+		}
+		bounds.push_back(b);
+	}
+	return bounds;
+}
+int GL_Exporter::curvesInRegion(const std::list<Curve::PointVector>& curvePoints, 
+	const std::vector<Bounds>& bounds, float minX, float minY, float maxX, float maxY, bool keepPositions,
+	std::list<Curve::PointVector>& curves)
+{
+	curves.clear();
+	int numInRegion = 0;
+	std::vector<Bounds>::const_iterator itBounds = bounds.begin();
+	for (std::list<Curve::PointVector>::const_iterator it = curvePoints.begin(); it != curvePoints.end(); 
+		it++, itBounds++) {
+		if (itBounds->maxX < minX || itBounds->minX > maxX || itBounds->maxY < minY || itBounds->minY > maxY) {
+			if (keepPositions) curves.push_back(Curve::PointVector());
+			continue;
+		}
+		curves.push_back(*it);
+		numInRegion++;
+	}
+	return numInRegion;
+}
+
+bool GL_Exporter::writeRows(RasterFileWriter& writer, const float* values, int numRows, int width, 
+	PixelFormat format, bool isLabel)
+{
+	// Values in [0, 1] are scaled to the integer range, except for labels. Float values 
+	// are written unchanged.
+	std::vector<uint8_t> row8(format == PixelFormat::RGBA8 ? width : 0);
+	std::vector<uint16_t> row16(format == PixelFormat::UInt16 ? width : 0);
+	for (int y = 0; y < numRows; y++) {
+		const float* row = values + (size_t)y * width;
+		bool isWritten;
+		if (format == PixelFormat::RGBA8) {
+			for (int x = 0; x < width; x++) row8[x] = (uint8_t)(255 * std::min(1.0f, std::max(0.0f, row[x])) + 0.5f);
+			isWritten = writer.writeRow(row8.data());
+		}
+		else if (format == PixelFormat::UInt16) {
+			for (int x = 0; x < width; x++) {
+				row16[x] = isLabel ? (uint16_t)(row[x] + 0.5f) : 
+					(uint16_t)(65535 * std::min(1.0f, std::max(0.0f, row[x])) + 0.5f);
+			}
+			isWritten = writer.writeRow(row16.data());
+		}
+		else {
+			isWritten = writer.writeRow(row);
+		}
+		if (!isWritten) return false;
+	}
+	return true;
+}
+
+bool GL_Exporter::saveRenderTarget(GL_ContourRenderer* renderer, const char* filename, int width,
+	int height, PixelFormat format)
+{
+	VESCL_PROFILE_SCOPE("GL_Exporter::saveRenderTarget", "export");
+	// Labels are read as floats and converted to integers
+	bool isLabel = (renderer->type() == GL_ContourRenderer::RendererType::Labels);
+	RasterFileWriter::SampleFormat sampleFormat = (format == PixelFormat::UInt16) ?
+		RasterFileWriter::SampleFormat::UInt16 : RasterFileWriter::SampleFormat::Float32;
+	GL_PixelReader::PixelType pixelType = (format == PixelFormat::UInt16 && !isLabel) ?
+		GL_PixelReader::PixelType::UInt16 : GL_PixelReader::PixelType::Float32;
+
+	QOpenGLFramebufferObject* fbo = renderer->framebuffer();
+	if (!fbo || !fbo->isValid()) return false;
+	RasterFileWriter writer;
+	if (!writer.open(filename, width, height, sampleFormat)) return false;
+
+	GL_PixelReader reader;
+	fbo->bind();
+	bool isRead = reader.read(width, height, pixelType, [&](const void* row) { 
+		if (isLabel) return writeRows(writer, (const float*)row, 1, width, format, true);
+		return writer.writeRow(row); 
+	});
+	fbo->release();
+	bool isSaved = writer.close();
+	try {
+		if (!isRead || !isSaved) {
+			throw std::runtime_error("Can't save image to export file.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+GL_ContourRenderer* GL_Exporter::contourRenderer(GL_ContourRenderer::RendererType type, 
+	GL_ContourRenderer::TargetFormat format)
+{
+	// Renderers keep their framebuffer and vertex buffer, which are reused when exports 
+	// have the same size
+	std::pair<int, int> key((int)type, (int)format);
+	std::map<std::pair<int, int>, GL_ContourRenderer*>::iterator it = m_renderers.find(key);
+	if (it != m_renderers.end()) return it->second;
+	GL_ContourRenderer* renderer = new GL_ContourRenderer(type, format);
+	m_renderers[key] = renderer;
+	return renderer;
+}
+
+bool GL_Exporter::setupGL()
+{
+	try {
+		// Share resources with the application's contexts so shader programs that are
+		// already compiled are reused
+		if (m_isSharingResources) m_context.setShareContext(QOpenGLContext::globalShareContext());
+		if (!m_context.create()) {
+			throw std::runtime_error("Can't create GL context.");
+		}
+		m_surface.setFormat(m_context.format());
+		m_surface.create();
+		if (!m_surface.isValid()) {
+			throw std::runtime_error("GL surface not valid.");
+		}
+		if (!m_context.makeCurrent(&m_surface)) {
+			throw std::runtime_error("Can't make GL context current.");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		return false;
+	}
+
+	initializeOpenGLFunctions();
+	return true;
+}
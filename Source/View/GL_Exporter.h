@@ -1,43 +1,153 @@
-//
-// GL_Exporter.h
-// QOpenGL context and functionality for rendering and exporting segmentations.
-// 
-// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
-// 
-// This code is free software : you can redistribute it and /or modify it under
-// the terms of the GNU General Public License as published by the Free Software 
-// Foundation, either version 3 of the License, or (at your option) any later version.
-// 
-// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
-// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
-// PARTICULAR PURPOSE. See the GNU General Public License for more details.
-// 
-// You may have received a copy of the GNU General Public License along with this 
-// program. If not, see < http://www.gnu.org/licenses/>.
-// 
-
-#pragma once
-
-#include <QOpenGLFunctions>
-#include <QOpenGLContext>
-#include <QOffscreenSurface>
-
-class Model;
-
-class GL_Exporter : protected QOpenGLFunctions
-{
-public:
-    GL_Exporter(Model* model);
-    ~GL_Exporter();
-
-    enum class ExportType { SourceImage, Binary, DistToCenterline, DistToVesselEdge };
-    void exportSegmentation(const char* filename, float imageToExportScale, ExportType type);
-
-private:
-    Model* m_model;
-
-    bool m_isGLSetup;
-    bool setupGL();
-    QOpenGLContext m_context;
-    QOffscreenSurface m_surface;
+//
+// GL_Exporter.h
+// QOpenGL context and functionality for rendering and exporting segmentations.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <QOpenGLFunctions>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+
+#include "GL_ContourRenderer.h"
+#include "../Model/Curve.h"
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+class Model;
+class RenderState;
+class RasterFileWriter;
+class QThread;
+class QOpenGLTexture;
+
+class GL_Exporter : protected QOpenGLFunctions
+{
+public:
+    GL_Exporter(Model* model);
+    ~GL_Exporter();
+
+    // AllProducts exports the binary mask and both distance maps in one pass, saved to the
+    // given filename with _binary, _vessel_distance and _centerline_distance appended.
+    // LabelMap exports the position of each pixel's curve in the contour plus one, or 0 
+    // for background, as 16-bit PNG, TIFF or raw labels. Overlaps keep the curve with the 
+    // nearest centerline. Label maps require OpenGL.
+    enum class ExportType { SourceImage, Binary, DistToCenterline, DistToVesselEdge, AntialiasedMask,
+        AllProducts, LabelMap };
+    static std::string productFilename(const char* filename, const char* product);
+
+    // RGBA8 exports are saved through QImage to any format it supports. UInt16 exports
+    // are saved as 16-bit PNG or TIFF with distances normalized as for RGBA8. Float32 
+    // exports are saved as float TIFF with distances in source image pixels. Raw files
+    // are supported for both. Source images are exported as RGBA8 only.
+    enum class PixelFormat { RGBA8, UInt16, Float32 };
+    void exportSegmentation(const char* filename, float imageToExportScale, ExportType type,
+        PixelFormat format = PixelFormat::RGBA8);
+
+    // Distance exports are clamped to maxDistance in source image pixels
+    void setMaxDistance(float maxDistance) { m_maxDistance = maxDistance; };
+
+    // Exact distances are computed on the CPU with a Euclidean distance transform of the
+    // rasterized vessels or centerlines, so they have no range limit. Float32 exports hold
+    // unclamped distances. 8- and 16-bit exports are normalized with the max distance.
+    void setExactDistances(bool isExact) { m_isExactDistance = isExact; };
+
+    // Auto renders with OpenGL and falls back to the CPU renderer when no OpenGL context
+    // can be created, e.g., on servers without a GPU or display. The CPU renderer exports
+    // masks and exact distances.
+    enum class Backend { Auto, OpenGL, CPU };
+    void setBackend(Backend backend) { m_backend = backend; };
+    static bool isCPUExportSupported(ExportType type);
+
+    // An exporter can be reused for many models, e.g., for batch exports. Its context, 
+    // shader programs and render targets are kept between exports. initialize() creates
+    // the OpenGL context up front so the exporter can then be moved to a worker thread, 
+    // which must call releaseResources() before the exporter is deleted on another thread.
+    void setModel(Model* model) { m_model = model; };
+    bool initialize();
+
+    // Exporters share shader programs and textures with the application's contexts by 
+    // default. Exporters used on other threads must not share them, so that their 
+    // contexts are in their own share groups (see GL_ResourceManager). Call before the
+    // context is created.
+    void setSharesResources(bool isShared) { m_isSharingResources = isShared; };
+    void moveToThread(QThread* thread);
+    void releaseResources();
+
+    // Source images are rendered from this texture, e.g., the view's, instead of being
+    // uploaded again when the exporter's context shares resources with the owner's. The
+    // exporter sets the texture's filtering, so it must only be shared with exports that
+    // run on the owner's thread.
+    void setSharedImageTexture(QOpenGLTexture* texture, QOpenGLContext* owner);
+
+    // Masks and OpenGL distances larger than the tile size in either dimension are 
+    // rendered tile by tile and streamed to PNG, TIFF or raw files, so exports are not
+    // limited by OpenGL texture sizes or memory. Tiles are clamped to the OpenGL limits.
+    void setTileSize(int tileSize) { m_tileSize = std::max(1, tileSize); };
+
+    // Tiles of the last tiled export, and those skipped because no curve was in range.
+    // Rendered tiles are also timed by the profiler.
+    int numTiles() const { return m_numTiles; };
+    int numSkippedTiles() const { return m_numSkippedTiles; };
+
+private:
+    Model* m_model;
+    float m_maxDistance;
+    Backend m_backend;
+    bool m_isExactDistance;
+    int m_tileSize;
+    int m_numTiles;
+    int m_numSkippedTiles;
+    QOpenGLTexture* m_sharedImageTexture;
+    QOpenGLContext* m_sharedImageContext;
+    std::list<Curve::PointVector> sampledCurves(float maxPointSpacing);
+    void exportWithCPU(const char* filename, float imageToExportScale, ExportType type, PixelFormat format);
+    std::vector<float> exactDistances(ExportType type, std::list<Curve::PointVector>& curvePoints,
+        int width, int height, float imageToPixelScale, float offsetX, float offsetY);
+    void exportAllProducts(const char* filename, float imageToExportScale, PixelFormat format);
+    void exportTransform(float imageToExportScale, int* width, int* height, float* imageToPixelScale,
+        float* offsetX, float* offsetY);
+
+    // Tiles with no curve bounds in range are skipped
+    void exportTiled(const char* filename, float imageToExportScale, ExportType type, PixelFormat format,
+        bool useCPU);
+    typedef struct {
+        float minX, minY, maxX, maxY;
+    } Bounds;
+    std::vector<Bounds> curveBounds(const std::list<Curve::PointVector>& curvePoints, float imageToPixelScale,
+        float offsetX, float offsetY, float halo);
+    // Returns the number of curves in the region. With keepPositions, curves out of the 
+    // region are kept as empty curves, so that labels match those of the whole contour.
+    int curvesInRegion(const std::list<Curve::PointVector>& curvePoints, const std::vector<Bounds>& bounds,
+        float minX, float minY, float maxX, float maxY, bool keepPositions, std::list<Curve::PointVector>& curves);
+    bool writeRows(RasterFileWriter& writer, const float* values, int numRows, int width, PixelFormat format,
+        bool isLabel = false);
+    void saveValues(const char* filename, int width, int height, const float* values, PixelFormat format);
+    bool saveRenderTarget(GL_ContourRenderer* renderer, const char* filename, int width, int height,
+        PixelFormat format);
+
+    bool m_isGLSetup;
+    bool m_isSharingResources;
+    bool setupGL();
+    std::map<std::pair<int, int>, GL_ContourRenderer*> m_renderers;
+    GL_ContourRenderer* contourRenderer(GL_ContourRenderer::RendererType type, 
+        GL_ContourRenderer::TargetFormat format);
+    QOpenGLContext m_context;
+    QOffscreenSurface m_surface;
 };
\ No newline at end of file
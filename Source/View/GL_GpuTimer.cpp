@@ -0,0 +1,83 @@
+//
+// GL_GpuTimer.cpp
+// Implementation of GL_GpuTimer.
+//
+
+#include "GL_GpuTimer.h"
+
+#include <QOpenGLContext>
+
+// GL_TIME_ELAPSED is core in OpenGL 3.3 and has the same value in 
+// EXT_disjoint_timer_query, but is missing from OpenGL ES headers
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+
+//
+// Public
+//
+GL_GpuTimer::GL_GpuTimer() :
+	m_isSupported(false),
+	m_isActive(false),
+	m_maxPendingQueries(64)
+{
+	initializeOpenGLFunctions();
+	QOpenGLContext* context = QOpenGLContext::currentContext();
+	if (context) {
+		m_isSupported = context->hasExtension("GL_ARB_timer_query") ||
+			context->hasExtension("GL_EXT_disjoint_timer_query") ||
+			(!context->isOpenGLES() && context->format().version() >= qMakePair(3, 3));
+	}
+}
+GL_GpuTimer::~GL_GpuTimer()
+{
+	for (const PendingQuery& pending : m_pendingQueries) {
+		glDeleteQueries(1, &pending.query);
+	}
+	if (m_freeQueries.size() > 0) {
+		glDeleteQueries((GLsizei)m_freeQueries.size(), m_freeQueries.data());
+	}
+}
+
+void GL_GpuTimer::begin(const char* name, const char* category)
+{
+	// Drop the measurement rather than stall if results are not being collected
+	if (!m_isSupported || m_isActive) return;
+	if ((int)m_pendingQueries.size() >= m_maxPendingQueries) return;
+
+	GLuint query = 0;
+	if (m_freeQueries.size() > 0) {
+		query = m_freeQueries.back();
+		m_freeQueries.pop_back();
+	}
+	else {
+		glGenQueries(1, &query);
+	}
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	m_pendingQueries.push_back({ query, name, category, Profiler::instance().now() });
+	m_isActive = true;
+}
+void GL_GpuTimer::end()
+{
+	if (!m_isActive) return;
+	glEndQuery(GL_TIME_ELAPSED);
+	m_isActive = false;
+}
+
+void GL_GpuTimer::collect()
+{
+	// Queries complete in order, so stop at the first one that is not available
+	while (m_pendingQueries.size() > 0) {
+		const PendingQuery& pending = m_pendingQueries.front();
+		if (m_isActive && m_pendingQueries.size() == 1) break;
+		GLuint isAvailable = GL_FALSE;
+		glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (!isAvailable) break;
+		GLuint elapsedNanoseconds = 0;
+		glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT, &elapsedNanoseconds);
+		Profiler::instance().addEvent(pending.name, pending.category, pending.submitTime,
+			elapsedNanoseconds / 1000, Profiler::gpuThreadID);
+		m_freeQueries.push_back(pending.query);
+		m_pendingQueries.pop_front();
+	}
+}
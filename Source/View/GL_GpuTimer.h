@@ -0,0 +1,79 @@
+//
+// GL_GpuTimer.h
+// Measures GPU time of render passes with OpenGL timer queries and records the results
+// in the Profiler. Queries are read back a few frames later to avoid stalling the 
+// pipeline. Timer queries can't be nested, so passes must be timed one after another.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include "../Util/Profiler.h"
+
+#include <QOpenGLExtraFunctions>
+
+#include <deque>
+#include <vector>
+
+#ifdef VESCL_PROFILING
+#define VESCL_PROFILE_GPU_SCOPE(timer, name, category) \
+	GL_GpuTimer::Scope VESCL_PROFILE_CONCAT(gpuProfileScope, __LINE__)(timer, name, category)
+#else
+#define VESCL_PROFILE_GPU_SCOPE(timer, name, category)
+#endif
+
+class GL_GpuTimer : protected QOpenGLExtraFunctions
+{
+public:
+	// An OpenGL context must be current when the timer is created, used and deleted
+	GL_GpuTimer();
+	~GL_GpuTimer();
+
+	// Timer queries require OpenGL 3.3, ARB_timer_query or EXT_disjoint_timer_query
+	bool isSupported() const { return m_isSupported; };
+
+	void begin(const char* name, const char* category);
+	void end();
+
+	// Records the results of completed queries. Call once per frame.
+	void collect();
+
+	// Times the lifetime of the scope. timer may be null.
+	class Scope
+	{
+	public:
+		Scope(GL_GpuTimer* timer, const char* name, const char* category) : m_timer(timer) {
+			if (m_timer) m_timer->begin(name, category);
+		};
+		~Scope() { if (m_timer) m_timer->end(); };
+	private:
+		GL_GpuTimer* m_timer;
+	};
+
+private:
+	bool m_isSupported;
+	bool m_isActive;
+
+	// GPU durations are placed on the trace at the CPU time the pass was submitted
+	typedef struct {
+		GLuint query;
+		const char* name;
+		const char* category;
+		long long submitTime;
+	} PendingQuery;
+	std::deque<PendingQuery> m_pendingQueries;
+	std::vector<GLuint> m_freeQueries;
+	int m_maxPendingQueries;
+};
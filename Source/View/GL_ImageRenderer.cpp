@@ -1,209 +1,379 @@
-//
-// GL_ImageRenderer.cpp
-// Implementation of ImageRenderer.
-//
-
-#include "GL_ImageRenderer.h"
-
-#include <QOpenGLFramebufferObject>
-#include <QOpenGLTexture>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLPixelTransferOptions>
-
-#include <assert.h>
-
-// 
-// Public
-//
-GL_ImageRenderer::GL_ImageRenderer() :
-	m_imageData(nullptr),
-	m_imageWidth(0),
-	m_imageHeight(0),
-	m_imageDataFormat(Image::DataFormat::NotSupported),
-	m_imageTexture(nullptr),
-	m_fboWidth(0),
-	m_fboHeight(0),
-	m_fboDoInterpolate(false),
-	m_fbo(nullptr),
-	m_shaderProgram(nullptr)
-{
-	// Set up the shader programs
-	try {
-		m_shaderProgram = new QOpenGLShaderProgram;
-		if (!m_shaderProgram) {
-			throw std::runtime_error("Can't create GL shader program.");
-		}
-		m_shaderProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader);
-		m_shaderProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader);
-		if (!m_shaderProgram->link()) {
-			throw std::runtime_error("GL shader program failed to link.");
-		}
-	}
-	catch (const std::exception& e) {
-		std::cout << "Exception " << e.what() << std::endl;
-		delete m_shaderProgram;
-		m_shaderProgram = nullptr;
-		return;
-	}
-
-	// Set up OpenGL
-	initializeOpenGLFunctions();
-}
-GL_ImageRenderer::~GL_ImageRenderer()
-{
-	m_vertexBuffer.destroy();
-	delete m_imageTexture;
-	delete m_shaderProgram;
-	delete m_fbo;
-}
-
-// Get the texture ID of the fbo's color buffer. Return's false if the fbo is invalid.
-bool GL_ImageRenderer::textureID(GLuint* textureID)
-{
-	if (m_fbo) {
-		*textureID = m_fbo->texture();
-		return true;
-	}
-	return false;
-}
-QImage GL_ImageRenderer::renderedImage()
-{
-	return(m_fbo->toImage(true));
-}
-
-void GL_ImageRenderer::setImage(const Image& image)
-{
-	if (!image.isValid()) return;
-	m_imageWidth = image.width();
-	m_imageHeight = image.height();
-	m_imageDataFormat = image.dataFormat();
-	m_imageData = image.data();
-	setVertexBuffer();
-
-	// Create a new texture to hold the image data for rendering
-	if (m_imageTexture) {
-		delete m_imageTexture;
-		m_imageTexture = nullptr;
-	}
-
-	QOpenGLTexture::TextureFormat texFormat;
-	QOpenGLTexture::PixelType pixelType;
-	switch (m_imageDataFormat) {
-	case Image::DataFormat::UChar:
-		texFormat = QOpenGLTexture::R8_UNorm;
-		pixelType = QOpenGLTexture::UInt8;
-		break;
-
-	case Image::DataFormat::UShort:
-		texFormat = QOpenGLTexture::R16_UNorm;
-		pixelType = QOpenGLTexture::UInt16;
-		break;
-
-	default:
-		return;
-	}
-
-	m_imageTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-	m_imageTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-	m_imageTexture->setMagnificationFilter(QOpenGLTexture::Nearest);
-	m_imageTexture->setSize(m_imageWidth, m_imageHeight);
-	m_imageTexture->setAutoMipMapGenerationEnabled(false);
-	m_imageTexture->setFormat(texFormat);
-	m_imageTexture->allocateStorage();
-
-	QOpenGLPixelTransferOptions options;
-	options.setAlignment(1);
-	m_imageTexture->setData(QOpenGLTexture::Red, pixelType, m_imageData, &options);
-}
-
-// Updates the fbo's color buffer 
-void GL_ImageRenderer::update(int winWidth, int winHeight, RenderState* renderState)
-{
-	// Check for required data
-	if (!m_shaderProgram) return;
-	if (!m_imageData || !m_imageTexture) return;
-
-	// Update the FBO if necessary
-	if (winWidth != m_fboWidth || winHeight != m_fboHeight) {
-		delete m_fbo;
-		m_fboWidth = winWidth;
-		m_fboHeight = winHeight;
-		m_fbo = new QOpenGLFramebufferObject(m_fboWidth, m_fboHeight, GL_TEXTURE_2D);
-	}
-	if (renderState->imageInterpolation() != m_fboDoInterpolate) {
-		m_fboDoInterpolate = renderState->imageInterpolation();
-		if (m_imageTexture) {
-			if (m_fboDoInterpolate) m_imageTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-			else m_imageTexture->setMagnificationFilter(QOpenGLTexture::Nearest);
-		}
-	}
-
-	m_fbo->bind();
-	glClearColor(0, 0, 0, 1);
-	glClear(GL_COLOR_BUFFER_BIT);
-
-	// Set shader data
-	m_shaderProgram->bind();
-	int mvpLocation = m_shaderProgram->uniformLocation("u_mvpMatrix");
-	assert(mvpLocation != -1);
-	m_shaderProgram->setUniformValue(mvpLocation, renderState->mvpMatrix());
-
-	float windowingLevel;
-	float windowingWidth;
-	int levelLocation = m_shaderProgram->uniformLocation("u_winLevel");
-	int widthLocation = m_shaderProgram->uniformLocation("u_winWidth");
-	assert(levelLocation != -1);
-	assert(widthLocation != -1);
-	m_shaderProgram->setUniformValue(levelLocation, renderState->windowingLevel());
-	m_shaderProgram->setUniformValue(widthLocation, renderState->windowingWidth());
-
-	// Tell OpenGL programmable pipeline how to locate the vertex data
-	m_vertexBuffer.bind();
-	quintptr offset = 0;
-	int numFloatsPerVertex = 3;
-	int numFloatsPerTexCoord = 2;
-	int stride = (numFloatsPerVertex + numFloatsPerTexCoord) * sizeof(GLfloat);
-
-	int posLocation = m_shaderProgram->attributeLocation("a_position");
-	assert(posLocation != -1);
-	m_shaderProgram->enableAttributeArray(posLocation);
-	m_shaderProgram->setAttributeBuffer(posLocation, GL_FLOAT, offset, numFloatsPerVertex, stride);
-
-	offset += numFloatsPerVertex * sizeof(GLfloat);
-	int texLocation = m_shaderProgram->attributeLocation("a_texCoord");
-	assert(texLocation != -1);
-	m_shaderProgram->enableAttributeArray(texLocation);
-	m_shaderProgram->setAttributeBuffer(texLocation, GL_FLOAT, offset, numFloatsPerTexCoord, stride);
-
-	// Perform the rendering
-	m_imageTexture->bind();
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-	m_imageTexture->release();
-	m_vertexBuffer.release();
-	m_shaderProgram->release();
-	m_fbo->release();
-}
-
-// 
-// Private
-//
-void GL_ImageRenderer::setVertexBuffer()
-{
-	// Vertex data in image coordinates. Format is (x,y,x,s,t), position and texture coords.
-	if (!m_imageData) return;
-	float w = m_imageWidth;
-	float h = m_imageHeight;
-
-	GLfloat vertData[]{
-		0, 0, 0, 0, 0,
-		w, 0, 0, 1, 0,
-		w, h, 0, 1, 1,
-		0, h, 0, 0, 1
-	};
-	if (!m_vertexBuffer.isCreated()) {
-		m_vertexBuffer.create();
-	}
-	m_vertexBuffer.bind();
-	m_vertexBuffer.allocate(vertData, sizeof(vertData));
-	m_vertexBuffer.release();
-}
+//
+// GL_ImageRenderer.cpp
+// Implementation of ImageRenderer.
+//
+
+#include "GL_ImageRenderer.h"
+#include "GL_ResourceManager.h"
+#include "../Util/Profiler.h"
+
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTexture>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLPixelTransferOptions>
+
+#include <algorithm>
+#include <vector>
+#include <assert.h>
+
+// 
+// Public
+//
+GL_ImageRenderer::GL_ImageRenderer() :
+	m_imageData(nullptr),
+	m_imageWidth(0),
+	m_imageHeight(0),
+	m_imageDataFormat(Image::DataFormat::NotSupported),
+	m_imageTexture(nullptr),
+	m_isTextureShared(false),
+	m_proxyTexture(nullptr),
+	m_proxyMaxDimension(256),
+	m_numRowsUploaded(0),
+	m_uploadChunkSize(4 * 1024 * 1024),
+	m_uploadBuffer(QOpenGLBuffer::PixelUnpackBuffer),
+	m_maxFrameTextures(4),
+	m_frameClock(0),
+	m_fboWidth(0),
+	m_fboHeight(0),
+	m_fboDoInterpolate(false),
+	m_fbo(nullptr),
+	m_shaderProgram(nullptr),
+	m_mvpLocation(-1),
+	m_posLocation(-1),
+	m_texLocation(-1),
+	m_levelLocation(-1),
+	m_widthLocation(-1)
+{
+	// Set up OpenGL
+	initializeOpenGLFunctions();
+
+	// Get the shader program and its variable locations from the shared resources
+	GL_ResourceManager* resources = GL_ResourceManager::instance();
+	if (!resources) return;
+	m_shaderProgram = resources->program(vertexShader, fragmentShader);
+	if (!m_shaderProgram) return;
+	m_mvpLocation = resources->uniformLocation(m_shaderProgram, "u_mvpMatrix");
+	m_posLocation = resources->attributeLocation(m_shaderProgram, "a_position");
+	m_texLocation = resources->attributeLocation(m_shaderProgram, "a_texCoord");
+	m_levelLocation = resources->uniformLocation(m_shaderProgram, "u_winLevel");
+	m_widthLocation = resources->uniformLocation(m_shaderProgram, "u_winWidth");
+	assert(m_mvpLocation != -1);
+	assert(m_posLocation != -1);
+	assert(m_texLocation != -1);
+	assert(m_levelLocation != -1);
+	assert(m_widthLocation != -1);
+}
+GL_ImageRenderer::~GL_ImageRenderer()
+{
+	m_vertexBuffer.destroy();
+	m_uploadBuffer.destroy();
+	deleteTextures();
+	clearFrames();
+	delete m_fbo;
+}
+
+// Get the texture ID of the fbo's color buffer. Return's false if the fbo is invalid.
+bool GL_ImageRenderer::textureID(GLuint* textureID)
+{
+	if (m_fbo) {
+		*textureID = m_fbo->texture();
+		return true;
+	}
+	return false;
+}
+QImage GL_ImageRenderer::renderedImage()
+{
+	return(m_fbo->toImage(true));
+}
+
+void GL_ImageRenderer::setImage(const Image& image)
+{
+	if (!image.isValid()) return;
+	m_imageWidth = image.width();
+	m_imageHeight = image.height();
+	m_imageDataFormat = image.dataFormat();
+	m_imageData = image.data();
+	setVertexBuffer();
+
+	// Create new textures to hold the image data for rendering
+	deleteTextures();
+	clearFrames();
+	m_numRowsUploaded = 0;
+
+	// Upload a low resolution proxy of the image immediately so something can be 
+	// displayed at once. The full resolution texture is uploaded in row chunks over 
+	// several frames (see uploadNextChunk()).
+	int proxyStep = 1 + std::max(m_imageWidth, m_imageHeight) / m_proxyMaxDimension;
+	int proxyWidth = (m_imageWidth + proxyStep - 1) / proxyStep;
+	int proxyHeight = (m_imageHeight + proxyStep - 1) / proxyStep;
+	int numBytesPerPixel = (m_imageDataFormat == Image::DataFormat::UShort) ? 2 : 1;
+	std::vector<unsigned char> proxyData((size_t)proxyWidth * proxyHeight * numBytesPerPixel);
+	unsigned char* pProxy = proxyData.data();
+	for (int j = 0; j < proxyHeight; j++) {
+		const unsigned char* pRow = m_imageData + (size_t)j * proxyStep * m_imageWidth * numBytesPerPixel;
+		for (int i = 0; i < proxyWidth; i++) {
+			const unsigned char* pPixel = pRow + (size_t)i * proxyStep * numBytesPerPixel;
+			for (int b = 0; b < numBytesPerPixel; b++) *pProxy++ = pPixel[b];
+		}
+	}
+	m_proxyTexture = createTexture(proxyWidth, proxyHeight);
+	if (!m_proxyTexture) return;
+	QOpenGLPixelTransferOptions options;
+	options.setAlignment(1);
+	m_proxyTexture->setData(QOpenGLTexture::Red, pixelType(), proxyData.data(), &options);
+
+	// Allocate storage for the full resolution image
+	m_imageTexture = createTexture(m_imageWidth, m_imageHeight);
+}
+
+void GL_ImageRenderer::setSharedImage(const Image& image, QOpenGLTexture* texture)
+{
+	if (!image.isValid() || !texture) return;
+	m_imageWidth = image.width();
+	m_imageHeight = image.height();
+	m_imageDataFormat = image.dataFormat();
+	m_imageData = image.data();
+	setVertexBuffer();
+
+	// The shared texture is complete, so it also serves as the proxy
+	deleteTextures();
+	m_imageTexture = texture;
+	m_proxyTexture = texture;
+	m_isTextureShared = true;
+	m_numRowsUploaded = m_imageHeight;
+}
+
+void GL_ImageRenderer::setFrame(int frame, const Image& image)
+{
+	if (!image.isValid()) return;
+	VESCL_PROFILE_SCOPE("GL_ImageRenderer::setFrame", "upload");
+	if (image.width() != m_imageWidth || image.height() != m_imageHeight || 
+		image.dataFormat() != m_imageDataFormat) {
+		clearFrames();
+	}
+	m_imageWidth = image.width();
+	m_imageHeight = image.height();
+	m_imageDataFormat = image.dataFormat();
+	m_imageData = image.data();
+	setVertexBuffer();
+
+	// Frame textures are owned by the ring, so they are treated as shared textures. A 
+	// complete frame texture also serves as the proxy.
+	deleteTextures();
+	FrameTexture* slot = nullptr;
+	for (FrameTexture& frameTexture : m_frameTextures) {
+		if (frameTexture.frame == frame) slot = &frameTexture;
+	}
+	bool isCached = (slot != nullptr);
+	if (!isCached) {
+		if ((int)m_frameTextures.size() < m_maxFrameTextures) {
+			QOpenGLTexture* texture = createTexture(m_imageWidth, m_imageHeight);
+			if (!texture) return;
+			m_frameTextures.push_back({ frame, texture, 0 });
+			slot = &m_frameTextures.back();
+		}
+		else {
+			slot = &*std::min_element(m_frameTextures.begin(), m_frameTextures.end(),
+				[](const FrameTexture& a, const FrameTexture& b) { return a.lastUsed < b.lastUsed; });
+			slot->frame = frame;
+		}
+	}
+	slot->lastUsed = ++m_frameClock;
+	m_imageTexture = slot->texture;
+	m_proxyTexture = slot->texture;
+	m_isTextureShared = true;
+	m_numRowsUploaded = isCached ? m_imageHeight : 0;
+	finishUpload();
+}
+void GL_ImageRenderer::clearFrames()
+{
+	for (FrameTexture& frameTexture : m_frameTextures) {
+		if (m_imageTexture == frameTexture.texture) {
+			m_imageTexture = nullptr;
+			m_proxyTexture = nullptr;
+			m_isTextureShared = false;
+		}
+		delete frameTexture.texture;
+	}
+	m_frameTextures.clear();
+}
+
+bool GL_ImageRenderer::isUploadComplete() const
+{
+	return (!m_imageTexture || m_numRowsUploaded >= m_imageHeight);
+}
+bool GL_ImageRenderer::uploadNextChunk()
+{
+	if (isUploadComplete()) return true;
+	VESCL_PROFILE_SCOPE("GL_ImageRenderer::uploadNextChunk", "upload");
+
+	// Copy the next rows into a pixel buffer object and upload them from there so the
+	// driver can transfer the data asynchronously. The buffer is re-allocated for each 
+	// chunk so mapping it never waits on the previous transfer.
+	int numBytesPerPixel = (m_imageDataFormat == Image::DataFormat::UShort) ? 2 : 1;
+	size_t rowSize = (size_t)m_imageWidth * numBytesPerPixel;
+	int numRows = std::max(1, (int)(m_uploadChunkSize / rowSize));
+	numRows = std::min(numRows, m_imageHeight - m_numRowsUploaded);
+	size_t chunkSize = rowSize * numRows;
+	const unsigned char* pChunk = m_imageData + rowSize * m_numRowsUploaded;
+
+	if (!m_uploadBuffer.isCreated()) {
+		m_uploadBuffer.create();
+		m_uploadBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+	}
+	m_uploadBuffer.bind();
+	m_uploadBuffer.allocate((int)chunkSize);
+	void* pMapped = m_uploadBuffer.map(QOpenGLBuffer::WriteOnly);
+	const void* pixels = nullptr;
+	if (pMapped) {
+		memcpy(pMapped, pChunk, chunkSize);
+		m_uploadBuffer.unmap();
+	}
+	else {
+		// Pixel buffers can't be mapped (e.g., OpenGL ES 2), so upload from client memory
+		m_uploadBuffer.release();
+		pixels = pChunk;
+	}
+
+	GLenum type = (m_imageDataFormat == Image::DataFormat::UShort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	m_imageTexture->bind();
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_numRowsUploaded, m_imageWidth, numRows, GL_RED, type, pixels);
+	m_imageTexture->release();
+	if (pMapped) m_uploadBuffer.release();
+	m_numRowsUploaded += numRows;
+
+	// Free the staging memory when done
+	if (isUploadComplete()) {
+		m_uploadBuffer.destroy();
+		return true;
+	}
+	return false;
+}
+void GL_ImageRenderer::finishUpload()
+{
+	while (!uploadNextChunk());
+}
+
+// Updates the fbo's color buffer 
+void GL_ImageRenderer::update(int winWidth, int winHeight, RenderState* renderState)
+{
+	VESCL_PROFILE_SCOPE("GL_ImageRenderer::update", "render");
+	// Check for required data
+	if (!m_shaderProgram) return;
+	if (!m_imageData || !m_imageTexture || !m_proxyTexture) return;
+
+	// Update the FBO if necessary
+	if (winWidth != m_fboWidth || winHeight != m_fboHeight) {
+		delete m_fbo;
+		m_fboWidth = winWidth;
+		m_fboHeight = winHeight;
+		m_fbo = new QOpenGLFramebufferObject(m_fboWidth, m_fboHeight, GL_TEXTURE_2D);
+	}
+	// The filter of a shared texture is restored after rendering for its owner
+	QOpenGLTexture::Filter ownerFilter = m_imageTexture->magnificationFilter();
+	if (renderState->imageInterpolation() != m_fboDoInterpolate || m_isTextureShared) {
+		m_fboDoInterpolate = renderState->imageInterpolation();
+		QOpenGLTexture::Filter filter = m_fboDoInterpolate ? QOpenGLTexture::Linear : QOpenGLTexture::Nearest;
+		m_imageTexture->setMagnificationFilter(filter);
+		m_proxyTexture->setMagnificationFilter(filter);
+	}
+
+	m_fbo->bind();
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// Set shader data
+	m_shaderProgram->bind();
+	m_shaderProgram->setUniformValue(m_mvpLocation, renderState->mvpMatrix());
+	m_shaderProgram->setUniformValue(m_levelLocation, renderState->windowingLevel());
+	m_shaderProgram->setUniformValue(m_widthLocation, renderState->windowingWidth());
+
+	// Tell OpenGL programmable pipeline how to locate the vertex data
+	m_vertexBuffer.bind();
+	quintptr offset = 0;
+	int numFloatsPerVertex = 3;
+	int numFloatsPerTexCoord = 2;
+	int stride = (numFloatsPerVertex + numFloatsPerTexCoord) * sizeof(GLfloat);
+
+	m_shaderProgram->enableAttributeArray(m_posLocation);
+	m_shaderProgram->setAttributeBuffer(m_posLocation, GL_FLOAT, offset, numFloatsPerVertex, stride);
+
+	offset += numFloatsPerVertex * sizeof(GLfloat);
+	m_shaderProgram->enableAttributeArray(m_texLocation);
+	m_shaderProgram->setAttributeBuffer(m_texLocation, GL_FLOAT, offset, numFloatsPerTexCoord, stride);
+
+	// Perform the rendering. Render the proxy until the full image is uploaded.
+	QOpenGLTexture* texture = isUploadComplete() ? m_imageTexture : m_proxyTexture;
+	texture->bind();
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	texture->release();
+	if (m_isTextureShared) m_imageTexture->setMagnificationFilter(ownerFilter);
+	m_vertexBuffer.release();
+	m_shaderProgram->release();
+	m_fbo->release();
+}
+
+// 
+// Private
+//
+void GL_ImageRenderer::deleteTextures()
+{
+	if (!m_isTextureShared) {
+		delete m_imageTexture;
+		delete m_proxyTexture;
+	}
+	m_imageTexture = nullptr;
+	m_proxyTexture = nullptr;
+	m_isTextureShared = false;
+}
+QOpenGLTexture* GL_ImageRenderer::createTexture(int width, int height)
+{
+	QOpenGLTexture::TextureFormat texFormat;
+	switch (m_imageDataFormat) {
+	case Image::DataFormat::UChar:
+		texFormat = QOpenGLTexture::R8_UNorm;
+		break;
+
+	case Image::DataFormat::UShort:
+		texFormat = QOpenGLTexture::R16_UNorm;
+		break;
+
+	default:
+		return nullptr;
+	}
+
+	QOpenGLTexture* texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+	texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+	texture->setMagnificationFilter(m_fboDoInterpolate ? QOpenGLTexture::Linear : QOpenGLTexture::Nearest);
+	texture->setSize(width, height);
+	texture->setAutoMipMapGenerationEnabled(false);
+	texture->setFormat(texFormat);
+	texture->allocateStorage();
+	return texture;
+}
+QOpenGLTexture::PixelType GL_ImageRenderer::pixelType() const
+{
+	return (m_imageDataFormat == Image::DataFormat::UShort) ? QOpenGLTexture::UInt16 : QOpenGLTexture::UInt8;
+}
+
+void GL_ImageRenderer::setVertexBuffer()
+{
+	// Vertex data in image coordinates. Format is (x,y,x,s,t), position and texture coords.
+	if (!m_imageData) return;
+	float w = m_imageWidth;
+	float h = m_imageHeight;
+
+	GLfloat vertData[]{
+		0, 0, 0, 0, 0,
+		w, 0, 0, 1, 0,
+		w, h, 0, 1, 1,
+		0, h, 0, 0, 1
+	};
+	if (!m_vertexBuffer.isCreated()) {
+		m_vertexBuffer.create();
+	}
+	m_vertexBuffer.bind();
+	m_vertexBuffer.allocate(vertData, sizeof(vertData));
+	m_vertexBuffer.release();
+}
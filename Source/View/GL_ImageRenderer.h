@@ -1,86 +1,135 @@
-//
-// GL_ImageRenderer.h
-// Renders image onto the texture of an OpenGL framebuffer object.
-// 
-// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
-// 
-// This code is free software : you can redistribute it and /or modify it under
-// the terms of the GNU General Public License as published by the Free Software 
-// Foundation, either version 3 of the License, or (at your option) any later version.
-// 
-// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
-// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
-// PARTICULAR PURPOSE. See the GNU General Public License for more details.
-// 
-// You may have received a copy of the GNU General Public License along with this 
-// program. If not, see < http://www.gnu.org/licenses/>.
-// 
-
-#pragma once
-
-#include <QObject>
-#include <QOpenGLFunctions>
-#include <QOpenGLBuffer>
-#include <QMatrix4x4>
-
-class QOpenGLTexture;
-class QOpenGLFramebufferObject;
-class QOpenGLShaderProgram;
-
-#include "../Model/Image.h"
-#include "../Controller/RenderState.h"
-
-class GL_ImageRenderer : public QObject, protected QOpenGLFunctions
-{
-	Q_OBJECT
-
-public:
-	GL_ImageRenderer();
-	~GL_ImageRenderer();
-
-	void setImage(const Image& image);
-
-	// OpenGL context must be set prior to update
-	void update(int winWidth, int winHeight, RenderState* renderState);
-	bool textureID(GLuint* textureID);
-	QImage renderedImage();
-
-private:
-	// Image data
-	unsigned char* m_imageData;
-	int m_imageWidth;
-	int m_imageHeight;
-	Image::DataFormat m_imageDataFormat;
-	QOpenGLTexture* m_imageTexture;
-
-	// Rendering
-	int m_fboWidth;
-	int m_fboHeight;
-	bool m_fboDoInterpolate;
-	QOpenGLFramebufferObject* m_fbo;
-	QOpenGLShaderProgram* m_shaderProgram;
-	QOpenGLBuffer m_vertexBuffer;
-	void setVertexBuffer();
-
-	// OpenGL shaders for rendering a grey-scale image with brightness and contrast
-	// modulation (via windowing level and width)
-	const char* const vertexShader =
-		"attribute highp vec3 a_position;\n"
-		"attribute mediump vec4 a_texCoord;\n"
-		"varying mediump vec4 v_texCoord;\n"
-		"uniform highp mat4 u_mvpMatrix;\n"
-		"void main() {\n"
-		"   gl_Position = u_mvpMatrix * vec4(a_position, 1.0);\n"
-		"   v_texCoord = a_texCoord;\n"
-		"}\n";
-	const char* const fragmentShader =
-		"uniform sampler2D texture;\n"
-		"uniform mediump float u_winLevel;\n"
-		"uniform mediump float u_winWidth;\n"
-		"varying mediump vec4 v_texCoord;\n"
-		"void main() {\n"
-		"	vec4 texColor = texture2D(texture, v_texCoord.st);\n"
-		"   texColor = clamp((texColor - u_winLevel) / u_winWidth + 0.5, 0.0, 1.0);\n"
-		"   gl_FragColor = vec4(texColor.r, texColor.r, texColor.r, 1.0);\n"
-		"}\n";
+//
+// GL_ImageRenderer.h
+// Renders image onto the texture of an OpenGL framebuffer object.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <QObject>
+#include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <QOpenGLTexture>
+#include <QMatrix4x4>
+
+#include <vector>
+
+class QOpenGLFramebufferObject;
+class QOpenGLShaderProgram;
+
+#include "../Model/Image.h"
+#include "../Controller/RenderState.h"
+
+class GL_ImageRenderer : public QObject, protected QOpenGLFunctions
+{
+	Q_OBJECT
+
+public:
+	GL_ImageRenderer();
+	~GL_ImageRenderer();
+
+	// Sets the image to render. A low resolution proxy is uploaded immediately. The 
+	// full resolution image is uploaded by uploadNextChunk(), which should be called 
+	// once per frame until it returns true, or by finishUpload(). The image data must 
+	// remain valid until the upload is complete. OpenGL context must be set.
+	void setImage(const Image& image);
+	bool isUploadComplete() const;
+	bool uploadNextChunk();
+	void finishUpload();
+
+	// The full resolution texture, or nullptr until the upload is complete. Renderers with
+	// contexts in the same share group can render the image from this texture with 
+	// setSharedImage() instead of uploading it again. The texture is owned by this 
+	// renderer and is deleted when the image changes.
+	QOpenGLTexture* texture() const { return isUploadComplete() ? m_imageTexture : nullptr; };
+	void setSharedImage(const Image& image, QOpenGLTexture* texture);
+
+	// Sets a frame of an image sequence. Frames are uploaded in full at once into a small
+	// ring of textures, so stepping back to a recently shown frame renders it without 
+	// uploading it again. The ring is cleared by setImage() and when the frame size or
+	// format changes. OpenGL context must be set.
+	void setFrame(int frame, const Image& image);
+	void clearFrames();
+
+	// OpenGL context must be set prior to update
+	void update(int winWidth, int winHeight, RenderState* renderState);
+	bool textureID(GLuint* textureID);
+	QImage renderedImage();
+
+private:
+	// Image data
+	unsigned char* m_imageData;
+	int m_imageWidth;
+	int m_imageHeight;
+	Image::DataFormat m_imageDataFormat;
+	QOpenGLTexture* m_imageTexture;
+	bool m_isTextureShared;
+	void deleteTextures();
+	QOpenGLTexture* createTexture(int width, int height);
+	QOpenGLTexture::PixelType pixelType() const;
+
+	// Progressive image upload
+	QOpenGLTexture* m_proxyTexture;
+	int m_proxyMaxDimension;
+	int m_numRowsUploaded;
+	size_t m_uploadChunkSize;
+	QOpenGLBuffer m_uploadBuffer;
+
+	// Frame textures of an image sequence, reused least recently used first
+	typedef struct {
+		int frame;
+		QOpenGLTexture* texture;
+		unsigned long long lastUsed;
+	} FrameTexture;
+	std::vector<FrameTexture> m_frameTextures;
+	int m_maxFrameTextures;
+	unsigned long long m_frameClock;
+
+	// Rendering
+	int m_fboWidth;
+	int m_fboHeight;
+	bool m_fboDoInterpolate;
+	QOpenGLFramebufferObject* m_fbo;
+	QOpenGLShaderProgram* m_shaderProgram;
+	int m_mvpLocation;
+	int m_posLocation;
+	int m_texLocation;
+	int m_levelLocation;
+	int m_widthLocation;
+	QOpenGLBuffer m_vertexBuffer;
+	void setVertexBuffer();
+
+	// OpenGL shaders for rendering a grey-scale image with brightness and contrast
+	// modulation (via windowing level and width)
+	const char* const vertexShader =
+		"attribute highp vec3 a_position;\n"
+		"attribute mediump vec4 a_texCoord;\n"
+		"varying mediump vec4 v_texCoord;\n"
+		"uniform highp mat4 u_mvpMatrix;\n"
+		"void main() {\n"
+		"   gl_Position = u_mvpMatrix * vec4(a_position, 1.0);\n"
+		"   v_texCoord = a_texCoord;\n"
+		"}\n";
+	const char* const fragmentShader =
+		"uniform sampler2D texture;\n"
+		"uniform mediump float u_winLevel;\n"
+		"uniform mediump float u_winWidth;\n"
+		"varying mediump vec4 v_texCoord;\n"
+		"void main() {\n"
+		"	vec4 texColor = texture2D(texture, v_texCoord.st);\n"
+		"   texColor = clamp((texColor - u_winLevel) / u_winWidth + 0.5, 0.0, 1.0);\n"
+		"   gl_FragColor = vec4(texColor.r, texColor.r, texColor.r, 1.0);\n"
+		"}\n";
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+//
+// GL_PixelReader.cpp
+// Implementation of GL_PixelReader.
+//
+
+#include "GL_PixelReader.h"
+#include "../Util/Profiler.h"
+
+#include <QOpenGLContext>
+
+#include <algorithm>
+#include <vector>
+
+// GL_RED is missing from OpenGL ES 2.0 headers
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+
+//
+// Public
+//
+GL_PixelReader::GL_PixelReader() :
+	m_isPBOSupported(false),
+	m_maxBandSize(4 * 1024 * 1024),
+	m_buffers{ QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer), QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer) }
+{
+	initializeOpenGLFunctions();
+	QOpenGLContext* context = QOpenGLContext::currentContext();
+	if (context) {
+		m_isPBOSupported = context->hasExtension("GL_ARB_map_buffer_range") ||
+			context->format().majorVersion() >= 3;
+	}
+}
+GL_PixelReader::~GL_PixelReader()
+{
+	m_buffers[0].destroy();
+	m_buffers[1].destroy();
+}
+
+bool GL_PixelReader::read(int width, int height, PixelType type, 
+	const std::function<bool(const void* row)>& writeRow)
+{
+	VESCL_PROFILE_SCOPE("GL_PixelReader::read", "export");
+	if (width <= 0 || height <= 0) return false;
+
+	GLenum format = GL_RGBA;
+	GLenum dataType = GL_UNSIGNED_BYTE;
+	int bytesPerPixel = 4;
+	switch (type) {
+	case PixelType::UInt16:
+		format = GL_RED;
+		dataType = GL_UNSIGNED_SHORT;
+		bytesPerPixel = 2;
+		break;
+	case PixelType::Float32:
+		format = GL_RED;
+		dataType = GL_FLOAT;
+		bytesPerPixel = 4;
+		break;
+	case PixelType::RGBA8:
+	default:
+		break;
+	}
+
+	// Bands are taken from the top of the image. The OpenGL origin is the bottom left
+	// corner, so rows within a band are passed to writeRow in reverse order.
+	int rowSize = width * bytesPerPixel;
+	int bandHeight = std::max(1, std::min(height, m_maxBandSize / rowSize));
+	int numBands = (height + bandHeight - 1) / bandHeight;
+	int bandSize = bandHeight * rowSize;
+	auto bandStart = [=](int band) { return std::max(0, height - (band + 1) * bandHeight); };
+	auto bandRows = [=](int band) { return height - band * bandHeight - bandStart(band); };
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	bool isOK = true;
+	if (!m_isPBOSupported) {
+		std::vector<unsigned char> band(bandSize);
+		for (int b = 0; b < numBands && isOK; b++) {
+			glReadPixels(0, bandStart(b), width, bandRows(b), format, dataType, band.data());
+			for (int row = bandRows(b) - 1; row >= 0 && isOK; row--) {
+				isOK = writeRow(band.data() + row * rowSize);
+			}
+		}
+		return isOK;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		if (!m_buffers[i].isCreated()) m_buffers[i].create();
+		m_buffers[i].bind();
+		if (m_buffers[i].size() < bandSize) {
+			m_buffers[i].setUsagePattern(QOpenGLBuffer::StreamRead);
+			m_buffers[i].allocate(bandSize);
+		}
+		m_buffers[i].release();
+	}
+
+	// Start the transfer of the next band before mapping the previous one
+	for (int b = 0; b <= numBands && isOK; b++) {
+		if (b < numBands) {
+			m_buffers[b % 2].bind();
+			glReadPixels(0, bandStart(b), width, bandRows(b), format, dataType, nullptr);
+			m_buffers[b % 2].release();
+		}
+		if (b > 0) {
+			QOpenGLBuffer& buffer = m_buffers[(b - 1) % 2];
+			int numRows = bandRows(b - 1);
+			buffer.bind();
+			const unsigned char* band = (const unsigned char*) buffer.mapRange(0, numRows * rowSize, 
+				QOpenGLBuffer::RangeRead);
+			if (!band) {
+				isOK = false;
+			}
+			else {
+				for (int row = numRows - 1; row >= 0 && isOK; row--) {
+					isOK = writeRow(band + row * rowSize);
+				}
+				buffer.unmap();
+			}
+			buffer.release();
+		}
+	}
+	return isOK;
+}
@@ -0,0 +1,51 @@
+//
+// GL_PixelReader.h
+// Reads the color buffer of the bound framebuffer in bands of rows through a pair of 
+// pixel buffer objects, so the transfer of one band overlaps processing of the previous 
+// one and rows can be streamed to disk without a full image copy.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLBuffer>
+
+#include <functional>
+
+class GL_PixelReader : protected QOpenGLExtraFunctions
+{
+public:
+	// RGBA8 reads 4 unsigned bytes per pixel. UInt16 and Float32 read the red channel only.
+	enum class PixelType { RGBA8, UInt16, Float32 };
+
+	// An OpenGL context must be current when the reader is created, used and deleted
+	GL_PixelReader();
+	~GL_PixelReader();
+
+	// Rows are passed to writeRow from the top of the image to the bottom, i.e., in the
+	// order used by image files. Returns false if reading fails or writeRow returns false.
+	bool read(int width, int height, PixelType type, const std::function<bool(const void* row)>& writeRow);
+
+	// Pixel buffer objects are mapped with glMapBufferRange, which requires OpenGL 3.0,
+	// OpenGL ES 3.0 or ARB_map_buffer_range. Otherwise bands are read synchronously into
+	// client memory.
+	bool isPBOSupported() const { return m_isPBOSupported; };
+
+private:
+	bool m_isPBOSupported;
+	int m_maxBandSize;
+	QOpenGLBuffer m_buffers[2];
+};
@@ -0,0 +1,216 @@
+//
+// GL_ResourceManager.cpp
+// Implementation of GL_ResourceManager.
+//
+
+#include "GL_ResourceManager.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+
+#include <iostream>
+#include <mutex>
+
+// Program binary enums are core in OpenGL 4.1 and OpenGL ES 3.0 but may be missing
+// from older headers
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+std::map<QOpenGLContextGroup*, GL_ResourceManager*> GL_ResourceManager::s_managers;
+std::mutex GL_ResourceManager::s_mutex;
+
+//
+// Public
+//
+GL_ResourceManager* GL_ResourceManager::instance()
+{
+	QOpenGLContext* context = QOpenGLContext::currentContext();
+	if (!context) return nullptr;
+
+	// One manager per share group. The manager is deleted with the group, i.e., when
+	// the last context in the group is destroyed. Contexts on other threads, e.g., of 
+	// batch export workers, must be in their own share groups.
+	QOpenGLContextGroup* group = context->shareGroup();
+	std::lock_guard<std::mutex> lock(s_mutex);
+	std::map<QOpenGLContextGroup*, GL_ResourceManager*>::iterator it = s_managers.find(group);
+	if (it != s_managers.end()) return it->second;
+
+	GL_ResourceManager* manager = new GL_ResourceManager(context);
+	s_managers[group] = manager;
+	QObject::connect(group, &QObject::destroyed, [group]() {
+		std::lock_guard<std::mutex> lock(s_mutex);
+		std::map<QOpenGLContextGroup*, GL_ResourceManager*>::iterator it = s_managers.find(group);
+		if (it != s_managers.end()) {
+			delete it->second;
+			s_managers.erase(it);
+		}
+	});
+	return manager;
+}
+
+QOpenGLShaderProgram* GL_ResourceManager::program(const char* vertexShader, const char* fragmentShader)
+{
+	QByteArray key = programKey(vertexShader, fragmentShader);
+	std::map<QByteArray, ProgramEntry>::iterator it = m_programs.find(key);
+	if (it != m_programs.end()) return it->second.program;
+
+	QOpenGLShaderProgram* program = nullptr;
+	try {
+		program = new QOpenGLShaderProgram;
+		if (!program) {
+			throw std::runtime_error("Can't create GL shader program.");
+		}
+
+		// Try the cached binary first and fall back to compiling the shader sources
+		if (!loadProgramBinary(program, key)) {
+			program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader);
+			program->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader);
+			if (m_isBinaryCacheSupported && program->create()) {
+				glProgramParameteri(program->programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			}
+			if (!program->link()) {
+				throw std::runtime_error("GL shader program failed to link.");
+			}
+			saveProgramBinary(program, key);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Exception " << e.what() << std::endl;
+		delete program;
+		return nullptr;
+	}
+
+	m_programs[key] = { program, {}, {} };
+	return program;
+}
+
+int GL_ResourceManager::attributeLocation(QOpenGLShaderProgram* program, const char* name)
+{
+	ProgramEntry* programEntry = entry(program);
+	if (!programEntry) return -1;
+	std::map<std::string, int>::iterator it = programEntry->attributeLocations.find(name);
+	if (it != programEntry->attributeLocations.end()) return it->second;
+	int location = program->attributeLocation(name);
+	programEntry->attributeLocations[name] = location;
+	return location;
+}
+int GL_ResourceManager::uniformLocation(QOpenGLShaderProgram* program, const char* name)
+{
+	ProgramEntry* programEntry = entry(program);
+	if (!programEntry) return -1;
+	std::map<std::string, int>::iterator it = programEntry->uniformLocations.find(name);
+	if (it != programEntry->uniformLocations.end()) return it->second;
+	int location = program->uniformLocation(name);
+	programEntry->uniformLocations[name] = location;
+	return location;
+}
+
+//
+// Private
+//
+GL_ResourceManager::GL_ResourceManager(QOpenGLContext* context) :
+	m_isBinaryCacheSupported(false)
+{
+	initializeOpenGLFunctions();
+
+	// Program binaries are available in OpenGL 4.1+, OpenGL ES 3.0+ or with the
+	// ARB_get_program_binary extension, and only if the driver exposes a binary format
+	QSurfaceFormat format = context->format();
+	bool hasProgramBinary = context->hasExtension("GL_ARB_get_program_binary") ||
+		(context->isOpenGLES() && format.majorVersion() >= 3) ||
+		(!context->isOpenGLES() && format.version() >= qMakePair(4, 1));
+	if (hasProgramBinary) {
+		GLint numBinaryFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+		m_isBinaryCacheSupported = (numBinaryFormats > 0);
+	}
+
+	m_cacheDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/programs";
+	m_driverID.append((const char*)glGetString(GL_VENDOR));
+	m_driverID.append((const char*)glGetString(GL_RENDERER));
+	m_driverID.append((const char*)glGetString(GL_VERSION));
+}
+GL_ResourceManager::~GL_ResourceManager()
+{
+	for (std::map<QByteArray, ProgramEntry>::iterator it = m_programs.begin(); it != m_programs.end(); it++) {
+		delete it->second.program;
+	}
+}
+
+GL_ResourceManager::ProgramEntry* GL_ResourceManager::entry(QOpenGLShaderProgram* program)
+{
+	if (!program) return nullptr;
+	for (std::map<QByteArray, ProgramEntry>::iterator it = m_programs.begin(); it != m_programs.end(); it++) {
+		if (it->second.program == program) return &it->second;
+	}
+	return nullptr;
+}
+
+QByteArray GL_ResourceManager::programKey(const char* vertexShader, const char* fragmentShader)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(QByteArray(vertexShader));
+	hash.addData(QByteArray(fragmentShader));
+	return hash.result().toHex();
+}
+bool GL_ResourceManager::loadProgramBinary(QOpenGLShaderProgram* program, const QByteArray& key)
+{
+	if (!m_isBinaryCacheSupported) return false;
+
+	// Binary file format is the binary format enum followed by the driver ID and the
+	// program binary. Binaries built by a different driver are ignored.
+	QFile file(m_cacheDirectory + "/" + QString::fromLatin1(key) + ".bin");
+	if (!file.open(QIODevice::ReadOnly)) return false;
+	QByteArray data = file.readAll();
+	file.close();
+	int headerSize = sizeof(GLenum) + m_driverID.size();
+	if (data.size() <= headerSize || data.mid(sizeof(GLenum), m_driverID.size()) != m_driverID) {
+		return false;
+	}
+	GLenum binaryFormat = *(const GLenum*)data.constData();
+
+	if (!program->create()) return false;
+	glProgramBinary(program->programId(), binaryFormat, data.constData() + headerSize, data.size() - headerSize);
+	GLint isLinked = GL_FALSE;
+	glGetProgramiv(program->programId(), GL_LINK_STATUS, &isLinked);
+	if (!isLinked) {
+		// Stale binary, e.g., after a driver update. It is rebuilt from source.
+		QFile::remove(file.fileName());
+		return false;
+	}
+
+	// The program has no shaders attached, so link() only checks the link status
+	return program->link();
+}
+void GL_ResourceManager::saveProgramBinary(QOpenGLShaderProgram* program, const QByteArray& key)
+{
+	if (!m_isBinaryCacheSupported) return;
+
+	GLint binaryLength = 0;
+	glGetProgramiv(program->programId(), GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0) return;
+	QByteArray binary(binaryLength, 0);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(program->programId(), binaryLength, nullptr, &binaryFormat, binary.data());
+
+	// Failing to write the cache is not an error, the program is simply compiled from
+	// source next time
+	if (!QDir().mkpath(m_cacheDirectory)) return;
+	QFile file(m_cacheDirectory + "/" + QString::fromLatin1(key) + ".bin");
+	if (!file.open(QIODevice::WriteOnly)) return;
+	file.write((const char*)&binaryFormat, sizeof(GLenum));
+	file.write(m_driverID);
+	file.write(binary);
+	file.close();
+}
@@ -0,0 +1,76 @@
+//
+// GL_ResourceManager.h
+// OpenGL resources shared by all contexts in a share group. Compiles each shader
+// program once, caches its attribute and uniform locations and persists linked program
+// binaries to disk so later sessions can skip shader compilation.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QByteArray>
+#include <QString>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+class QOpenGLContext;
+class QOpenGLContextGroup;
+class QOpenGLShaderProgram;
+
+class GL_ResourceManager : protected QOpenGLExtraFunctions
+{
+public:
+	// Returns the manager for the share group of the current context. An OpenGL
+	// context must be current.
+	static GL_ResourceManager* instance();
+
+	// Returns a linked program built from the given shader sources, or nullptr if the
+	// program could not be built. Programs are owned by the manager.
+	QOpenGLShaderProgram* program(const char* vertexShader, const char* fragmentShader);
+
+	// Locations are resolved once per program and name. Returns -1 if not found.
+	int attributeLocation(QOpenGLShaderProgram* program, const char* name);
+	int uniformLocation(QOpenGLShaderProgram* program, const char* name);
+
+	// Directory holding program binaries. Defaults to the application cache directory.
+	QString cacheDirectory() const { return m_cacheDirectory; };
+	void setCacheDirectory(const QString& directory) { m_cacheDirectory = directory; };
+
+private:
+	GL_ResourceManager(QOpenGLContext* context);
+	~GL_ResourceManager();
+	static std::map<QOpenGLContextGroup*, GL_ResourceManager*> s_managers;
+	static std::mutex s_mutex;
+
+	typedef struct {
+		QOpenGLShaderProgram* program;
+		std::map<std::string, int> attributeLocations;
+		std::map<std::string, int> uniformLocations;
+	} ProgramEntry;
+	std::map<QByteArray, ProgramEntry> m_programs;
+	ProgramEntry* entry(QOpenGLShaderProgram* program);
+
+	// On-disk program binary cache. Binaries are keyed by the shader sources and the
+	// driver that built them, since binaries are not portable across drivers.
+	bool m_isBinaryCacheSupported;
+	QString m_cacheDirectory;
+	QByteArray m_driverID;
+	QByteArray programKey(const char* vertexShader, const char* fragmentShader);
+	bool loadProgramBinary(QOpenGLShaderProgram* program, const QByteArray& key);
+	void saveProgramBinary(QOpenGLShaderProgram* program, const QByteArray& key);
+};
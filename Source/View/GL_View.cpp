@@ -1,314 +1,524 @@
-//
-// GL_View.cpp
-// Implementation of GL_View.
-//
-
-#include "GL_View.h"
-#include "GL_BltRenderer.h"
-#include "GL_ImageRenderer.h"
-#include "GL_ContourRenderer.h"
-#include "../Model/Model.h"
-#include "../Controller/RenderState.h"
-
-#include <QMouseEvent>
-#include <QScreen>
-#include <QVector3D>
-
-// 
-// Public
-//
-GL_View::GL_View(Model* model, RenderState* renderState) :
-	m_model(model),
-	m_renderState(renderState),
-	m_currentAction(MouseAction::None),
-	m_mouseDownWinLevel(0.5), 
-	m_mouseDownWinWidth(1),
-	m_mouseDownCursorSize(8),
-	m_bltRenderer(nullptr),
-	m_contourRenderer(nullptr),
-	m_activeCurveRenderer(nullptr),
-	m_imageRenderer(nullptr)
-{
-}
-GL_View::~GL_View()
-{
-	delete m_imageRenderer;
-	delete m_contourRenderer;
-	delete m_activeCurveRenderer;
-	delete m_bltRenderer;
-}
-
-void GL_View::setImage(const Image& image)
-{
-	m_imageRenderer->setImage(image);
-}
-
-void GL_View::initCursor()
-{
-	m_cursor.init();
-}
-float GL_View::cursorRadius() const
-{
-	return m_cursor.radius();
-}
-void GL_View::setCursorRadius(float radius)
-{
-	m_cursor.setRadius(radius);
-	setCursor(*m_cursor.qCursor());
-}
-void GL_View::setCursorColor(QColor color)
-{
-	m_cursor.setColor(color);
-	setCursor(*m_cursor.qCursor());
-}
-
-// 
-// Protected
-//
-void GL_View::mousePressEvent(QMouseEvent* e)
-{
-	if (e->buttons() & Qt::LeftButton && e->modifiers()) {
-
-		// Modify view transforms
-		m_mouseDownPos = QVector2D(e->pos());
-		QVector3D worldPoint = m_renderState->convertWindowToWorld(QVector3D(m_mouseDownPos, 0));
-		m_mouseDownWorld = QVector2D(worldPoint);
-		m_mouseDownWorldToView = m_renderState->worldToView();
-		m_mouseDownWinLevel = m_renderState->windowingLevel();
-		m_mouseDownWinWidth = m_renderState->windowingWidth();
-		m_mouseDownCursorSize = m_cursor.radius();
-		if (e->modifiers() & Qt::ShiftModifier) {
-			m_currentAction = MouseAction::Pan;
-		}
-		else if (e->modifiers() & Qt::ControlModifier) {
-			m_currentAction = MouseAction::Zoom;
-		}
-		else if (e->modifiers() & Qt::AltModifier) {
-			m_currentAction = MouseAction::Windowing;
-		}
-	}
-	else {
-
-		// Interact with model
-		if (e->buttons() & Qt::LeftButton) {
-			m_currentAction = MouseAction::Draw;
-			QSize windowSize = size();
-			QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
-			QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
-			Math::Vec2D p(pImage[0], pImage[1]);
-			float curveRadius = m_cursor.radius() * m_renderState->windowToContourScale();
-			m_model->startDraw(CurvePoint(p, curveRadius));
-			update();
-		}
-		else if (e->buttons() & Qt::RightButton) {
-			m_currentAction = MouseAction::None;
-			QSize windowSize = size();
-			QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
-			QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
-			float p[2] = { pImage[0], pImage[1] };
-			m_model->select(p);
-			update();
-		}
-	}
-}
-void GL_View::mouseReleaseEvent(QMouseEvent* e)
-{
-	if (m_currentAction == MouseAction::Draw) {
-		QSize windowSize = size();
-		QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
-		QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
-		Math::Vec2D p(pImage[0], pImage[1]);
-		float curveRadius = m_cursor.radius() * m_renderState->windowToContourScale();
-		m_model->endDraw(CurvePoint(p, curveRadius));
-		update();
-	}
-	m_currentAction = MouseAction::None;
-}
-void GL_View::mouseMoveEvent(QMouseEvent* e)
-{
-	switch (m_currentAction) {
-	case MouseAction::Draw:
-	{
-		QSize windowSize = size();
-		QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
-		QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
-		Math::Vec2D p(pImage[0], pImage[1]);
-		float curveRadius = m_cursor.radius() * m_renderState->windowToContourScale();
-		m_model->updateDraw(CurvePoint(p, curveRadius));
-		update();
-		break;
-	}
-	case MouseAction::Pan:
-	{
-		int dx = e->x() - m_mouseDownPos[0];
-		int dy = m_mouseDownPos[1] - e->y();
-		float x = dx * m_renderState->windowToWorldScale();
-		float y = dy * m_renderState->windowToWorldScale();
-		QMatrix4x4 worldToView = m_mouseDownWorldToView;
-		worldToView.translate(x, y, 0);
-		m_renderState->setWorldToView(worldToView);
-		m_renderState->setNeedsFullUpdate(true);
-		update();
-		break;
-	}
-	case MouseAction::Zoom:
-	{
-		// Zoom about the mouse down point
-		QSize windowSize = size();
-		float minDim = windowSize.width() < windowSize.height() ? (float)windowSize.width() : (float)windowSize.height();
-		float dy = e->y() - m_mouseDownPos[1];
-		float scale = 1.0 - (float)dy / (float)(std::max(1, windowSize.height()));
-		float minScale = 0.1f;
-		float maxScale = 100.0f;
-		if (scale < minScale) scale = minScale;
-		if (scale > maxScale) scale = maxScale;
-		QMatrix4x4 worldToView = m_mouseDownWorldToView;
-		worldToView.translate(m_mouseDownWorld[0], m_mouseDownWorld[1], 0);
-		worldToView.scale(scale, scale, 1);
-		worldToView.translate(-m_mouseDownWorld[0], -m_mouseDownWorld[1], 0);
-		m_renderState->setWorldToView(worldToView);
-		m_renderState->setNeedsFullUpdate(true);
-		m_cursor.setRadius(m_mouseDownCursorSize * scale);
-		setCursor(*m_cursor.qCursor());
-		update();
-		break;
-	}
-	case MouseAction::Windowing:
-	{
-		// Change windowing about the mouse down point
-		QSize windowSize = size();
-		float minDim = windowSize.width() < windowSize.height() ? (float)windowSize.width() : (float)windowSize.height();
-		int dx = e->x() - m_mouseDownPos[0];
-		int dy = e->y() - m_mouseDownPos[1];
-		float contrastIncr = float(dx) / (float)(std::max(1, windowSize.width()));
-		float brightnessIncr = float(dy) / (float)(std::max(1, windowSize.height()));
-		m_renderState->setWindowing(m_mouseDownWinLevel, m_mouseDownWinWidth);
-		m_renderState->incrementWindowing(brightnessIncr, contrastIncr);
-		m_renderState->setImageNeedsUpdate(true);
-		update();
-		break;
-	}
-	}
-}
-void GL_View::wheelEvent(QWheelEvent* e)
-{
-	QPoint numPixels = e->pixelDelta();
-	QPoint numDegrees = e->angleDelta() / 8;
-	int numSteps = 0;
-	if (!numPixels.isNull()) {
-		numSteps = numPixels.y();
-	}
-	else if (!numDegrees.isNull()) {
-		numSteps = numDegrees.y() / 15;
-	}
-	if (!numSteps) return;
-	m_cursor.setRadius(m_cursor.radius() + numSteps);
-	setCursor(*m_cursor.qCursor());
-}
-
-void GL_View::initializeGL()
-{
-	makeCurrent();
-
-	// Set up OpenGL
-	initializeOpenGLFunctions();
-
-	// Set the projection matrix
-	QSize glWindowSize = size();
-	resizeGL(glWindowSize.width(), glWindowSize.height());
-
-	// Set up the renderers when the context is set and before paintGL is called
-	m_bltRenderer = new GL_BltRenderer;
-	m_imageRenderer = new GL_ImageRenderer;
-	GL_ContourRenderer::RendererType type = GL_ContourRenderer::RendererType::Antialiased;
-	m_contourRenderer = new GL_ContourRenderer(type);
-	m_activeCurveRenderer = new GL_ContourRenderer(type);
-
-	// Initialize the world to view transform
-	m_renderState->resetWorldToView();
-	m_renderState->setNeedsFullUpdate(true);
-
-	// Initialize the cursor
-	m_cursor.init();
-	setCursor(*m_cursor.qCursor());
-}
-void GL_View::resizeGL(int w, int h)
-{
-	m_renderState->resetProjectionMatrix(w, h);
-	m_renderState->setNeedsFullUpdate(true);
-	update();
-}
-void GL_View::paintGL()
-{
-	// Clear the viewport
-	makeCurrent();
-	glClearColor(0, 0, 0, 1);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-
-	QSize glViewportSize = this->size();
-	//if (QT_VERSION < 0x060000) {   // Handle high def displays
-		glViewportSize *= screen()->devicePixelRatio();
-	//}
-
-	// Render the image if required and blt to screen
-	GLuint textureID;
-	if (m_renderState->imageNeedsUpdate() || m_renderState->needsFullUpdate()) {
-		m_imageRenderer->update(glViewportSize.width(), glViewportSize.height(), m_renderState);
-		m_renderState->setImageNeedsUpdate(false);
-	}
-	if (m_imageRenderer->textureID(&textureID)) {
-		if (m_bltRenderer) m_bltRenderer->render(textureID, 1);
-	}
-
-	// Render the contour if required and blt to screen
-	if (m_renderState->isContourVisible())
-	{
-		std::list<Curve*>* curves = m_model->contour()->curves();
-		int idActiveCurve = m_model->contour()->idActiveCurve();
-		if (m_renderState->contourNeedsUpdate() || m_renderState->needsFullUpdate()) {
-
-			// Get curve points to render
-			std::list<Curve::PointVector> curvePoints;
-			for (std::list<Curve*>::iterator it = curves->begin(); it != curves->end(); it++) {
-				if ((*it)->id() == idActiveCurve) continue;
-				float maxPointSpacing = m_renderState->maxPointSpacing() * m_renderState->windowToContourScale();
-				Curve::PointVector pv = (*it)->getSampledCurvePoints(maxPointSpacing);
-				curvePoints.push_back(pv);
-			}
-
-			m_contourRenderer->update(curvePoints, m_renderState->contourColor(),
-				glViewportSize.width(), glViewportSize.height(),
-				m_renderState->mvpMatrix(), m_renderState->windowToContourScale());
-		}
-		if (m_contourRenderer->textureID(&textureID)) {
-			if (m_bltRenderer) m_bltRenderer->render(textureID, 1);
-		}
-
-		// Render the active curve if required and blt to screen
-		if (m_renderState->activeCurveNeedsUpdate() ||
-			m_renderState->contourNeedsUpdate() || m_renderState->needsFullUpdate()) {
-
-			// Get curve points to render
-			std::list<Curve::PointVector> activeCurvePoints;
-			for (std::list<Curve*>::iterator it = curves->begin(); it != curves->end(); it++) {
-				if ((*it)->id() == idActiveCurve) {
-					float maxPointSpacing = m_renderState->maxPointSpacing() * m_renderState->windowToContourScale();
-					Curve::PointVector pv = (*it)->getSampledCurvePoints(maxPointSpacing);
-					activeCurvePoints.push_back(pv);
-					break;
-				}
-			}
-
-			m_activeCurveRenderer->update(activeCurvePoints, m_renderState->activeCurveColor(),
-				glViewportSize.width(), glViewportSize.height(),
-				m_renderState->mvpMatrix(), m_renderState->windowToContourScale());
-		}
-		if (m_activeCurveRenderer->textureID(&textureID)) {
-			if (m_bltRenderer) m_bltRenderer->render(textureID, 1);
-		}
-
-		m_renderState->setActiveCurveNeedsUpdate(false);
-		m_renderState->setContourNeedsUpdate(false);
-	}
-	m_renderState->setNeedsFullUpdate(false);
-}
+//
+// GL_View.cpp
+// Implementation of GL_View.
+//
+
+#include "GL_View.h"
+#include "GL_BltRenderer.h"
+#include "GL_ImageRenderer.h"
+#include "GL_ContourRenderer.h"
+#include "GL_GpuTimer.h"
+#include "../Model/Model.h"
+#include "../Controller/RenderState.h"
+#include "../Util/Profiler.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScreen>
+#include <QVector3D>
+
+// 
+// Public
+//
+GL_View::GL_View(Model* model, RenderState* renderState) :
+	m_model(model),
+	m_renderState(renderState),
+	m_currentAction(MouseAction::None),
+	m_mouseDownWinLevel(0.5), 
+	m_mouseDownWinWidth(1),
+	m_mouseDownCursorSize(8),
+	m_isInteractive(false),
+	m_interactiveRenderScale(0.5),
+	m_refineDelay(150),
+	m_isVesselTracing(false),
+	m_hasTraceStart(false),
+	m_bltRenderer(nullptr),
+	m_contourRenderer(nullptr),
+	m_activeCurveRenderer(nullptr),
+	m_imageRenderer(nullptr),
+	m_isProfilerOverlayVisible(false),
+	m_gpuTimer(nullptr)
+{
+	m_refineTimer.setSingleShot(true);
+	m_refineTimer.setInterval(m_refineDelay);
+	connect(&m_refineTimer, &QTimer::timeout, this, &GL_View::onRefine);
+	m_snapTimer.setSingleShot(true);
+	m_snapTimer.setInterval(0);
+	connect(&m_snapTimer, &QTimer::timeout, this, &GL_View::onSnapPending);
+}
+GL_View::~GL_View()
+{
+	delete m_imageRenderer;
+	delete m_contourRenderer;
+	delete m_activeCurveRenderer;
+	delete m_bltRenderer;
+	if (m_gpuTimer) {
+		makeCurrent();
+		delete m_gpuTimer;
+		doneCurrent();
+	}
+}
+
+void GL_View::setImage(const Image& image)
+{
+	makeCurrent();
+	m_imageRenderer->setImage(image);
+	doneCurrent();
+}
+void GL_View::setFrame(int frame, const Image& image)
+{
+	makeCurrent();
+	m_imageRenderer->setFrame(frame, image);
+	doneCurrent();
+	m_renderState->setImageNeedsUpdate(true);
+	update();
+}
+QOpenGLTexture* GL_View::imageTexture() const
+{
+	return m_imageRenderer ? m_imageRenderer->texture() : nullptr;
+}
+
+void GL_View::initCursor()
+{
+	m_cursor.init();
+}
+float GL_View::cursorRadius() const
+{
+	return m_cursor.radius();
+}
+void GL_View::setCursorRadius(float radius)
+{
+	m_cursor.setRadius(radius);
+	setCursor(*m_cursor.qCursor());
+}
+void GL_View::setCursorColor(QColor color)
+{
+	m_cursor.setColor(color);
+	setCursor(*m_cursor.qCursor());
+}
+
+void GL_View::setProfilerOverlayVisible(bool visible)
+{
+	m_isProfilerOverlayVisible = visible;
+	update();
+}
+
+void GL_View::setVesselTracing(bool isTracing)
+{
+	m_isVesselTracing = isTracing;
+	m_hasTraceStart = false;
+}
+
+void GL_View::startTraceRecording()
+{
+	m_trace.startRecording(m_model->contour(), m_model->imageWidth(), m_model->imageHeight());
+}
+bool GL_View::stopTraceRecording(const QString& filename)
+{
+	m_trace.stopRecording();
+	if (filename.isEmpty()) return false;
+	return m_trace.save(filename);
+}
+
+// 
+// Protected
+//
+void GL_View::mousePressEvent(QMouseEvent* e)
+{
+	recordTraceEvent(InteractionTrace::EventType::Press, e);
+	if (e->buttons() & Qt::LeftButton && e->modifiers()) {
+
+		// Modify view transforms
+		m_mouseDownPos = QVector2D(e->pos());
+		QVector3D worldPoint = m_renderState->convertWindowToWorld(QVector3D(m_mouseDownPos, 0));
+		m_mouseDownWorld = QVector2D(worldPoint);
+		m_mouseDownWorldToView = m_renderState->worldToView();
+		m_mouseDownWinLevel = m_renderState->windowingLevel();
+		m_mouseDownWinWidth = m_renderState->windowingWidth();
+		m_mouseDownCursorSize = m_cursor.radius();
+		if (e->modifiers() & Qt::ShiftModifier) {
+			m_currentAction = MouseAction::Pan;
+		}
+		else if (e->modifiers() & Qt::ControlModifier) {
+			m_currentAction = MouseAction::Zoom;
+		}
+		else if (e->modifiers() & Qt::AltModifier) {
+			m_currentAction = MouseAction::Windowing;
+		}
+		startInteraction();
+	}
+	else {
+
+		// Interact with model
+		if (e->buttons() & Qt::LeftButton && m_isVesselTracing) {
+			m_currentAction = MouseAction::None;
+			QSize windowSize = size();
+			QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
+			QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
+			if (!m_hasTraceStart) {
+				m_traceStart = QVector2D(pImage);
+				m_hasTraceStart = true;
+			}
+			else {
+				Math::Vec2D start(m_traceStart[0], m_traceStart[1]);
+				Math::Vec2D end(pImage[0], pImage[1]);
+				float curveRadius = m_cursor.radius() * m_renderState->windowToContourScale();
+				m_model->traceVessel(start, end, curveRadius);
+				m_hasTraceStart = false;
+				update();
+			}
+		}
+		else if (e->buttons() & Qt::LeftButton) {
+			m_currentAction = MouseAction::Draw;
+			QSize windowSize = size();
+			QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
+			QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
+			Math::Vec2D p(pImage[0], pImage[1]);
+			float curveRadius = m_cursor.radius() * m_renderState->windowToContourScale();
+			m_model->startDraw(CurvePoint(p, curveRadius));
+			update();
+		}
+		else if (e->buttons() & Qt::RightButton) {
+			m_currentAction = MouseAction::None;
+			QSize windowSize = size();
+			QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
+			QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
+			float p[2] = { pImage[0], pImage[1] };
+			m_model->select(p);
+			update();
+		}
+	}
+}
+void GL_View::mouseReleaseEvent(QMouseEvent* e)
+{
+	recordTraceEvent(InteractionTrace::EventType::Release, e);
+	if (m_isInteractive) {
+		m_refineTimer.stop();
+		onRefine();
+	}
+	if (m_currentAction == MouseAction::Draw) {
+		QSize windowSize = size();
+		QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
+		QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
+		Math::Vec2D p(pImage[0], pImage[1]);
+		float curveRadius = m_cursor.radius() * m_renderState->windowToContourScale();
+		m_snapTimer.stop();
+		m_model->endDraw(CurvePoint(p, curveRadius));
+		update();
+	}
+	m_currentAction = MouseAction::None;
+}
+void GL_View::mouseMoveEvent(QMouseEvent* e)
+{
+	recordTraceEvent(InteractionTrace::EventType::Move, e);
+	switch (m_currentAction) {
+	case MouseAction::Draw:
+	{
+		QSize windowSize = size();
+		QVector3D pWindow((float)e->pos().x(), (float)(windowSize.height() - e->pos().y()), 0);
+		QVector3D pImage = m_renderState->convertWindowToImage(pWindow);
+		Math::Vec2D p(pImage[0], pImage[1]);
+		float curveRadius = m_cursor.radius() * m_renderState->windowToContourScale();
+		m_model->updateDraw(CurvePoint(p, curveRadius));
+		if (m_model->hasPendingSnaps()) m_snapTimer.start();
+		update();
+		break;
+	}
+	case MouseAction::Pan:
+	{
+		int dx = e->x() - m_mouseDownPos[0];
+		int dy = m_mouseDownPos[1] - e->y();
+		float x = dx * m_renderState->windowToWorldScale();
+		float y = dy * m_renderState->windowToWorldScale();
+		QMatrix4x4 worldToView = m_mouseDownWorldToView;
+		worldToView.translate(x, y, 0);
+		m_renderState->setWorldToView(worldToView);
+		m_renderState->setNeedsFullUpdate(true);
+		continueInteraction();
+		update();
+		break;
+	}
+	case MouseAction::Zoom:
+	{
+		// Zoom about the mouse down point
+		QSize windowSize = size();
+		float minDim = windowSize.width() < windowSize.height() ? (float)windowSize.width() : (float)windowSize.height();
+		float dy = e->y() - m_mouseDownPos[1];
+		float scale = 1.0 - (float)dy / (float)(std::max(1, windowSize.height()));
+		float minScale = 0.1f;
+		float maxScale = 100.0f;
+		if (scale < minScale) scale = minScale;
+		if (scale > maxScale) scale = maxScale;
+		QMatrix4x4 worldToView = m_mouseDownWorldToView;
+		worldToView.translate(m_mouseDownWorld[0], m_mouseDownWorld[1], 0);
+		worldToView.scale(scale, scale, 1);
+		worldToView.translate(-m_mouseDownWorld[0], -m_mouseDownWorld[1], 0);
+		m_renderState->setWorldToView(worldToView);
+		m_renderState->setNeedsFullUpdate(true);
+		m_cursor.setRadius(m_mouseDownCursorSize * scale);
+		setCursor(*m_cursor.qCursor());
+		continueInteraction();
+		update();
+		break;
+	}
+	case MouseAction::Windowing:
+	{
+		// Change windowing about the mouse down point
+		QSize windowSize = size();
+		float minDim = windowSize.width() < windowSize.height() ? (float)windowSize.width() : (float)windowSize.height();
+		int dx = e->x() - m_mouseDownPos[0];
+		int dy = e->y() - m_mouseDownPos[1];
+		float contrastIncr = float(dx) / (float)(std::max(1, windowSize.width()));
+		float brightnessIncr = float(dy) / (float)(std::max(1, windowSize.height()));
+		m_renderState->setWindowing(m_mouseDownWinLevel, m_mouseDownWinWidth);
+		m_renderState->incrementWindowing(brightnessIncr, contrastIncr);
+		m_renderState->setImageNeedsUpdate(true);
+		continueInteraction();
+		update();
+		break;
+	}
+	}
+}
+void GL_View::wheelEvent(QWheelEvent* e)
+{
+	QPoint numPixels = e->pixelDelta();
+	QPoint numDegrees = e->angleDelta() / 8;
+	int numSteps = 0;
+	if (!numPixels.isNull()) {
+		numSteps = numPixels.y();
+	}
+	else if (!numDegrees.isNull()) {
+		numSteps = numDegrees.y() / 15;
+	}
+	if (!numSteps) return;
+	if (m_trace.isRecording()) {
+		m_trace.recordView(size(), m_renderState->worldToView(), m_cursor.radius());
+		m_trace.recordWheel(e->position(), numSteps, e->modifiers());
+	}
+	m_cursor.setRadius(m_cursor.radius() + numSteps);
+	setCursor(*m_cursor.qCursor());
+}
+
+void GL_View::initializeGL()
+{
+	makeCurrent();
+
+	// Set up OpenGL
+	initializeOpenGLFunctions();
+
+	// Set the projection matrix
+	QSize glWindowSize = size();
+	resizeGL(glWindowSize.width(), glWindowSize.height());
+
+	// Set up the renderers when the context is set and before paintGL is called
+	m_bltRenderer = new GL_BltRenderer;
+	m_imageRenderer = new GL_ImageRenderer;
+	GL_ContourRenderer::RendererType type = GL_ContourRenderer::RendererType::Antialiased;
+	m_contourRenderer = new GL_ContourRenderer(type);
+	m_activeCurveRenderer = new GL_ContourRenderer(type);
+#ifdef VESCL_PROFILING
+	m_gpuTimer = new GL_GpuTimer;
+#endif
+
+	// Initialize the world to view transform
+	m_renderState->resetWorldToView();
+	m_renderState->setNeedsFullUpdate(true);
+
+	// Initialize the cursor
+	m_cursor.init();
+	setCursor(*m_cursor.qCursor());
+}
+void GL_View::resizeGL(int w, int h)
+{
+	m_renderState->resetProjectionMatrix(w, h);
+	m_renderState->setNeedsFullUpdate(true);
+	update();
+}
+void GL_View::paintGL()
+{
+	VESCL_PROFILE_SCOPE("paintGL", "render");
+
+	// Clear the viewport
+	makeCurrent();
+	if (m_gpuTimer) m_gpuTimer->collect();
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+	QSize glViewportSize = this->size();
+	//if (QT_VERSION < 0x060000) {   // Handle high def displays
+		glViewportSize *= screen()->devicePixelRatio();
+	//}
+
+	// Layers are rendered into their framebuffers at a reduced resolution during 
+	// interaction and blt'ed to the full viewport. Contour scales are in window pixels 
+	// and so are adjusted for the larger render pixels.
+	float renderScale = m_isInteractive ? m_interactiveRenderScale : 1.0f;
+	QSize renderSize = glViewportSize * renderScale;
+	renderSize = renderSize.expandedTo(QSize(1, 1));
+	float windowToContourScale = m_renderState->windowToContourScale() / renderScale;
+	float maxPointSpacing = m_renderState->maxPointSpacing() * windowToContourScale;
+
+	// Continue uploading the image. The image is rendered from a low resolution proxy 
+	// until the upload is complete, and then re-rendered at full resolution.
+	if (!m_imageRenderer->isUploadComplete()) {
+		if (m_imageRenderer->uploadNextChunk()) m_renderState->setImageNeedsUpdate(true);
+		else update();
+	}
+
+	// Render the image if required and blt to screen
+	GLuint textureID;
+	if (m_renderState->imageNeedsUpdate() || m_renderState->needsFullUpdate()) {
+		VESCL_PROFILE_SCOPE("Image pass", "render");
+		VESCL_PROFILE_GPU_SCOPE(m_gpuTimer, "Image pass (GPU)", "gpu");
+		glViewport(0, 0, renderSize.width(), renderSize.height());
+		m_imageRenderer->update(renderSize.width(), renderSize.height(), m_renderState);
+		m_renderState->setImageNeedsUpdate(false);
+		glViewport(0, 0, glViewportSize.width(), glViewportSize.height());
+	}
+	if (m_imageRenderer->textureID(&textureID)) {
+		VESCL_PROFILE_GPU_SCOPE(m_gpuTimer, "Blt (GPU)", "gpu");
+		if (m_bltRenderer) m_bltRenderer->render(textureID, 1);
+	}
+
+	// Render the contour if required and blt to screen. While the view is disabled, e.g.,
+	// while a background job reads the contour, curves are not sampled and the contour is
+	// shown as last rendered.
+	if (m_renderState->isContourVisible())
+	{
+		std::list<Curve*>* curves = m_model->contour()->curves();
+		int idActiveCurve = m_model->contour()->idActiveCurve();
+		bool canSampleCurves = isEnabled();
+		if (canSampleCurves && (m_renderState->contourNeedsUpdate() || m_renderState->needsFullUpdate())) {
+
+			VESCL_PROFILE_SCOPE("Contour pass", "render");
+
+			// Get curve points to render
+			std::list<Curve::PointVector> curvePoints;
+			{
+				VESCL_PROFILE_SCOPE("Sample curves", "tessellate");
+				for (std::list<Curve*>::iterator it = curves->begin(); it != curves->end(); it++) {
+					if ((*it)->id() == idActiveCurve) continue;
+					Curve::PointVector pv = (*it)->getSampledCurvePoints(maxPointSpacing);
+					curvePoints.push_back(pv);
+				}
+			}
+
+			VESCL_PROFILE_GPU_SCOPE(m_gpuTimer, "Contour pass (GPU)", "gpu");
+			glViewport(0, 0, renderSize.width(), renderSize.height());
+			m_contourRenderer->update(curvePoints, m_renderState->contourColor(),
+				renderSize.width(), renderSize.height(),
+				m_renderState->mvpMatrix(), windowToContourScale);
+			glViewport(0, 0, glViewportSize.width(), glViewportSize.height());
+		}
+		if (m_contourRenderer->textureID(&textureID)) {
+			VESCL_PROFILE_GPU_SCOPE(m_gpuTimer, "Blt (GPU)", "gpu");
+			if (m_bltRenderer) m_bltRenderer->render(textureID, 1);
+		}
+
+		// Render the active curve if required and blt to screen
+		if (canSampleCurves && (m_renderState->activeCurveNeedsUpdate() ||
+			m_renderState->contourNeedsUpdate() || m_renderState->needsFullUpdate())) {
+
+			VESCL_PROFILE_SCOPE("Active curve pass", "render");
+
+			// Get curve points to render
+			std::list<Curve::PointVector> activeCurvePoints;
+			for (std::list<Curve*>::iterator it = curves->begin(); it != curves->end(); it++) {
+				if ((*it)->id() == idActiveCurve) {
+					Curve::PointVector pv = (*it)->getSampledCurvePoints(maxPointSpacing);
+					activeCurvePoints.push_back(pv);
+					break;
+				}
+			}
+
+			VESCL_PROFILE_GPU_SCOPE(m_gpuTimer, "Active curve pass (GPU)", "gpu");
+			glViewport(0, 0, renderSize.width(), renderSize.height());
+			m_activeCurveRenderer->update(activeCurvePoints, m_renderState->activeCurveColor(),
+				renderSize.width(), renderSize.height(),
+				m_renderState->mvpMatrix(), windowToContourScale);
+			glViewport(0, 0, glViewportSize.width(), glViewportSize.height());
+		}
+		if (m_activeCurveRenderer->textureID(&textureID)) {
+			VESCL_PROFILE_GPU_SCOPE(m_gpuTimer, "Blt (GPU)", "gpu");
+			if (m_bltRenderer) m_bltRenderer->render(textureID, 1);
+		}
+
+		m_renderState->setActiveCurveNeedsUpdate(false);
+		m_renderState->setContourNeedsUpdate(false);
+	}
+	m_renderState->setNeedsFullUpdate(false);
+
+	if (m_isProfilerOverlayVisible) drawProfilerOverlay();
+}
+
+//
+// Private slots
+//
+void GL_View::onRefine()
+{
+	// Re-render the layers that were rendered at reduced resolution
+	if (!m_isInteractive) return;
+	m_isInteractive = false;
+	m_renderState->setNeedsFullUpdate(true);
+	update();
+}
+void GL_View::onSnapPending()
+{
+	// Snap within one budget and come back if more points remain, so input is not held up
+	if (m_currentAction != MouseAction::Draw) return;
+	if (m_model->snapPendingPoints()) m_snapTimer.start();
+	update();
+}
+
+//
+// Private
+//
+void GL_View::startInteraction()
+{
+	if (m_currentAction == MouseAction::Pan || m_currentAction == MouseAction::Zoom ||
+		m_currentAction == MouseAction::Windowing) {
+		m_isInteractive = true;
+		m_refineTimer.start();
+	}
+}
+void GL_View::continueInteraction()
+{
+	// Return to reduced resolution rendering if input resumes after a refine pass 
+	// and restart the idle timer
+	m_isInteractive = true;
+	m_refineTimer.start();
+}
+void GL_View::recordTraceEvent(InteractionTrace::EventType type, QMouseEvent* e)
+{
+	// Record the view state the event is handled in, then the event. The button that
+	// changed is recorded for releases.
+	if (!m_trace.isRecording()) return;
+	m_trace.recordView(size(), m_renderState->worldToView(), m_cursor.radius());
+	Qt::MouseButtons buttons = (type == InteractionTrace::EventType::Release) ? 
+		Qt::MouseButtons(e->button()) : e->buttons();
+	m_trace.recordMouse(type, e->localPos(), buttons, e->modifiers());
+}
+void GL_View::drawProfilerOverlay()
+{
+	// Mean timings of recent events, drawn over the rendered layers. QPainter changes
+	// OpenGL state, so the overlay is drawn last.
+	std::vector<Profiler::Summary> summaries = Profiler::instance().summarize(30);
+	QPainter painter(this);
+	painter.setFont(QFont("Courier", 9));
+	QFontMetrics metrics = painter.fontMetrics();
+	int lineHeight = metrics.height();
+	int numLines = std::max(1, (int)summaries.size());
+	QRect panel(8, 8, 40 * metrics.averageCharWidth(), (numLines + 1) * lineHeight);
+	painter.fillRect(panel, QColor(0, 0, 0, 160));
+	painter.setPen(Qt::white);
+	int y = panel.top() + lineHeight;
+	if (summaries.size() == 0) {
+		painter.drawText(panel.left() + 4, y, "No profiling data");
+	}
+	for (const Profiler::Summary& summary : summaries) {
+		QString text = QString("%1 %2 ms").arg(QString::fromLatin1(summary.name), -28).arg(summary.meanDuration / 1000.0, 7, 'f', 2);
+		painter.drawText(panel.left() + 4, y, text);
+		y += lineHeight;
+	}
+	painter.end();
+}
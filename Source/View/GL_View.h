@@ -1,84 +1,142 @@
-//
-// GL_View.h
-// A QOpenGL widget that provides an interface for rendering and mouse input.
-// 
-// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
-// 
-// This code is free software : you can redistribute it and /or modify it under
-// the terms of the GNU General Public License as published by the Free Software 
-// Foundation, either version 3 of the License, or (at your option) any later version.
-// 
-// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
-// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
-// PARTICULAR PURPOSE. See the GNU General Public License for more details.
-// 
-// You may have received a copy of the GNU General Public License along with this 
-// program. If not, see < http://www.gnu.org/licenses/>.
-// 
-
-#pragma once
-
-#include <QOpenGLWidget>
-#include <QOpenGLFunctions>
-#include <QVector2D>
-#include <QMatrix4x4>
-
-#include "Cursor.h"
-#include "../Controller/RenderState.h"
-#include "../Model/Image.h"
-
-class Model;
-class GL_BltRenderer;
-class GL_ImageRenderer;
-class GL_ContourRenderer;
-class RenderState;
-
-class GL_View : public QOpenGLWidget, protected QOpenGLFunctions
-{
-    Q_OBJECT
-
-public:
-    GL_View(Model* model, RenderState* renderState);
-    ~GL_View();
-
-    void setImage(const Image& image);
-
-    void initCursor();
-    float cursorRadius() const;
-    void setCursorRadius(float radius);
-    void setCursorColor(QColor color);
-
-protected:
-    void mousePressEvent(QMouseEvent* e) Q_DECL_OVERRIDE;
-    void mouseReleaseEvent(QMouseEvent* e) Q_DECL_OVERRIDE;
-    void mouseMoveEvent(QMouseEvent* e) Q_DECL_OVERRIDE;
-    void wheelEvent(QWheelEvent* e) Q_DECL_OVERRIDE;
-
-    void initializeGL() Q_DECL_OVERRIDE;
-    void resizeGL(int w, int h) Q_DECL_OVERRIDE;
-    void paintGL() Q_DECL_OVERRIDE;
-
-private:
-	Model* m_model;
-    RenderState* m_renderState;
-    Cursor m_cursor;
-
-    // Mouse input
-    enum class MouseAction { None, Draw, Zoom, Pan, Windowing };
-    MouseAction m_currentAction;
-    QVector2D m_lastMousePos;
-    QVector2D m_mouseDownPos;
-    QVector2D m_mouseDownWorld;
-    QMatrix4x4 m_mouseDownWorldToView;
-    float m_mouseDownWinLevel;
-    float m_mouseDownWinWidth;
-    float m_mouseDownCursorSize;
-
-    // Renderers take advantage of QOpenGLWidget functionality and thus 
-    // are located in the view. Renderers can't be created until context is set (i.e., 
-    // until OpenGL is initialzied).
-    GL_BltRenderer* m_bltRenderer;
-    GL_ImageRenderer* m_imageRenderer;
-    GL_ContourRenderer* m_contourRenderer;
-    GL_ContourRenderer* m_activeCurveRenderer;
+//
+// GL_View.h
+// A QOpenGL widget that provides an interface for rendering and mouse input.
+// 
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QVector2D>
+#include <QMatrix4x4>
+#include <QTimer>
+
+#include "Cursor.h"
+#include "../Controller/RenderState.h"
+#include "../Controller/InteractionTrace.h"
+#include "../Model/Image.h"
+
+class Model;
+class QOpenGLTexture;
+class GL_BltRenderer;
+class GL_ImageRenderer;
+class GL_ContourRenderer;
+class GL_GpuTimer;
+class RenderState;
+
+class GL_View : public QOpenGLWidget, protected QOpenGLFunctions
+{
+    Q_OBJECT
+
+public:
+    GL_View(Model* model, RenderState* renderState);
+    ~GL_View();
+
+    void setImage(const Image& image);
+
+    // Shows a frame of an image sequence. Recently shown frames are kept on the GPU.
+    void setFrame(int frame, const Image& image);
+
+    // The full resolution image texture for renderers that share the view's context, 
+    // or nullptr until the image is uploaded
+    QOpenGLTexture* imageTexture() const;
+
+    void initCursor();
+    float cursorRadius() const;
+    void setCursorRadius(float radius);
+    void setCursorColor(QColor color);
+
+    // Profiler overlay. Timings are only recorded when built with VESCL_PROFILING.
+    bool isProfilerOverlayVisible() const { return m_isProfilerOverlayVisible; };
+    void setProfilerOverlayVisible(bool visible);
+
+    // Interaction trace recording. Mouse and wheel input is recorded from start until 
+    // stop, when the trace is saved. Returns false if the trace could not be saved.
+    void startTraceRecording();
+    bool stopTraceRecording(const QString& filename);
+    bool isTraceRecording() const { return m_trace.isRecording(); };
+
+    // Vessel tracing. The first left click sets the start of the vessel and the second
+    // traces the vessel from the start to the clicked point.
+    void setVesselTracing(bool isTracing);
+    bool isVesselTracing() const { return m_isVesselTracing; };
+
+protected:
+    void mousePressEvent(QMouseEvent* e) Q_DECL_OVERRIDE;
+    void mouseReleaseEvent(QMouseEvent* e) Q_DECL_OVERRIDE;
+    void mouseMoveEvent(QMouseEvent* e) Q_DECL_OVERRIDE;
+    void wheelEvent(QWheelEvent* e) Q_DECL_OVERRIDE;
+
+    void initializeGL() Q_DECL_OVERRIDE;
+    void resizeGL(int w, int h) Q_DECL_OVERRIDE;
+    void paintGL() Q_DECL_OVERRIDE;
+
+private slots:
+    void onRefine();
+    void onSnapPending();
+
+private:
+	Model* m_model;
+    RenderState* m_renderState;
+    Cursor m_cursor;
+
+    // Mouse input
+    enum class MouseAction { None, Draw, Zoom, Pan, Windowing };
+    MouseAction m_currentAction;
+    QVector2D m_lastMousePos;
+    QVector2D m_mouseDownPos;
+    QVector2D m_mouseDownWorld;
+    QMatrix4x4 m_mouseDownWorldToView;
+    float m_mouseDownWinLevel;
+    float m_mouseDownWinWidth;
+    float m_mouseDownCursorSize;
+
+    // Interaction quality. While panning, zooming or windowing, layers are rendered at
+    // a reduced internal resolution. A full resolution refine pass is rendered when
+    // the mouse is released or when input has been idle for m_refineDelay msecs.
+    bool m_isInteractive;
+    float m_interactiveRenderScale;
+    int m_refineDelay;
+    QTimer m_refineTimer;
+    void startInteraction();
+    void continueInteraction();
+
+    // Points that were not snapped to vessels within the budget of a draw update are 
+    // snapped when the event loop is idle
+    QTimer m_snapTimer;
+
+    // Start of the next vessel trace, in image coordinates
+    bool m_isVesselTracing;
+    bool m_hasTraceStart;
+    QVector2D m_traceStart;
+
+    // Renderers take advantage of QOpenGLWidget functionality and thus 
+    // are located in the view. Renderers can't be created until context is set (i.e., 
+    // until OpenGL is initialzied).
+    GL_BltRenderer* m_bltRenderer;
+    GL_ImageRenderer* m_imageRenderer;
+    GL_ContourRenderer* m_contourRenderer;
+    GL_ContourRenderer* m_activeCurveRenderer;
+
+    // Profiling
+    bool m_isProfilerOverlayVisible;
+    GL_GpuTimer* m_gpuTimer;
+    void drawProfilerOverlay();
+
+    // Interaction trace recording
+    InteractionTrace m_trace;
+    void recordTraceEvent(InteractionTrace::EventType type, QMouseEvent* e);
 };
\ No newline at end of file
@@ -1,22 +1,22 @@
-//
-// Class.cpp
-// Implementation of Class.
-//
-
-#include "Class.h"
-
-// 
-// Public
-//
-Class::Class()
-{
-
-}
-Class::~Class()
-{
-
-}
-
-// 
-// Public
-//
+//
+// Class.cpp
+// Implementation of Class.
+//
+
+#include "Class.h"
+
+// 
+// Public
+//
+Class::Class()
+{
+
+}
+Class::~Class()
+{
+
+}
+
+// 
+// Public
+//
@@ -1,28 +1,68 @@
-//
-// main.cpp
-// Main entry point for the contouring application
-//
-// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
-// 
-// This code is free software : you can redistribute it and /or modify it under
-// the terms of the GNU General Public License as published by the Free Software 
-// Foundation, either version 3 of the License, or (at your option) any later version.
-// 
-// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
-// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
-// PARTICULAR PURPOSE. See the GNU General Public License for more details.
-// 
-// You may have received a copy of the GNU General Public License along with this 
-// program. If not, see < http://www.gnu.org/licenses/>.
-// 
-
-#include <QtWidgets/QApplication>
-#include "Controller/Controller.h"
-
-int main(int argc, char *argv[])
-{
-    QApplication a(argc, argv);
-    Controller mainWindow(nullptr);
-    mainWindow.show();
-    return a.exec();
-}
+//
+// main.cpp
+// Main entry point for the contouring application
+//
+// Copyright(C) 2024 Sarah F. Frisken, Brigham and Women's Hospital
+// 
+// This code is free software : you can redistribute it and /or modify it under
+// the terms of the GNU General Public License as published by the Free Software 
+// Foundation, either version 3 of the License, or (at your option) any later version.
+// 
+// This code is distributed in the hope that it will be useful, but WITHOUT ANY 
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+// PARTICULAR PURPOSE. See the GNU General Public License for more details.
+// 
+// You may have received a copy of the GNU General Public License along with this 
+// program. If not, see < http://www.gnu.org/licenses/>.
+// 
+
+#include <QtWidgets/QApplication>
+#include "Controller/Controller.h"
+#include "Benchmark/Benchmark.h"
+#include "Benchmark/RenderBenchmark.h"
+#include "Benchmark/TraceReplay.h"
+#include "Controller/BatchExporter.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    // Run the benchmarks without opening the user interface
+    bool doRenderBenchmark = false;
+    bool doBatchExport = false;
+    BatchExporter::Spec batchSpec;
+    std::vector<std::string> batchFilenames;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--benchmark") == 0) {
+            return Benchmark::run(std::cout) ? 0 : 1;
+        }
+        if (strcmp(argv[i], "--replay") == 0) {
+            std::vector<std::string> filenames(argv + i + 1, argv + argc);
+            return TraceReplay::run(filenames, std::cout) ? 0 : 1;
+        }
+        if (strcmp(argv[i], "--batch-export") == 0) {
+            std::vector<std::string> args(argv + i + 1, argv + argc);
+            if (!BatchExporter::parseArguments(args, &batchSpec, &batchFilenames, std::cout)) return 1;
+            doBatchExport = true;
+            break;
+        }
+        if (strcmp(argv[i], "--benchmark-render") == 0) doRenderBenchmark = true;
+    }
+
+    // Share OpenGL resources (e.g., shader programs) between the view and exporters. 
+    // Batch export workers each keep their own resources.
+    if (!doBatchExport) QApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    QApplication a(argc, argv);
+    if (doBatchExport) {
+        return BatchExporter::run(batchSpec, batchFilenames, std::cout) ? 0 : 1;
+    }
+    if (doRenderBenchmark) {
+        RenderBenchmark renderBenchmark;
+        return renderBenchmark.run(std::cout) ? 0 : 1;
+    }
+    Controller mainWindow(nullptr);
+    mainWindow.show();
+    return a.exec();
+}